@@ -28,36 +28,61 @@ void AdnlExtConnection::send_uninit(td::BufferSlice data) {
 }
 
 void AdnlExtConnection::send(td::BufferSlice data) {
-  LOG(DEBUG) << "sending packet of size " << data.size();
-  auto data_size = td::narrow_cast<td::uint32>(data.size()) + 32 + 32;
-  if (data_size < 32 || data_size > (1 << 24)) {
-    LOG(WARNING) << "bad packet size " << data_size;
+  append_packet(td::Slice(), std::move(data), td::Slice());
+}
+
+void AdnlExtConnection::send_parts(td::Slice prefix, td::Slice body, td::Slice suffix) {
+  append_packet(prefix, td::BufferSlice(body), suffix);
+}
+
+void AdnlExtConnection::append_packet(td::Slice prefix, td::BufferSlice body, td::Slice suffix) {
+  auto size = prefix.size() + body.size() + suffix.size();
+  LOG(DEBUG) << "sending packet of size " << size;
+  if (size > (1 << 24) - 64) {
+    LOG(WARNING) << "bad packet size " << size + 64;
     return;
   }
+  auto data_size = td::narrow_cast<td::uint32>(size) + 32 + 32;
 
-  td::BufferSlice d{data.size() + 4 + 32 + 32};
-  auto S = d.as_slice();
-
+  // Packet is written as three buffers: length, nonce and prefix; body; suffix and hash.
+  // Large bodies are appended to the output buffer as is, without copying them into one packet.
+  td::BufferSlice head{4 + 32 + prefix.size()};
+  auto S = head.as_slice();
   S.copy_from(td::Slice(reinterpret_cast<const td::uint8 *>(&data_size), 4));
   S.remove_prefix(4);
-  auto Sc = S;
   td::Random::secure_bytes(S.copy().truncate(32));
   S.remove_prefix(32);
-  S.copy_from(data.as_slice());
-  S.remove_prefix(data.size());
-
-  td::sha256(Sc.truncate(32 + data.size()), S);
-
-  td::BufferSlice e{d.size()};
-
-  out_ctr_.encrypt(d.as_slice(), e.as_slice());
-
-  buffered_fd_.output_buffer().append(std::move(e));
-  loop();
+  S.copy_from(prefix);
+
+  td::BufferSlice tail{suffix.size() + 32};
+  tail.as_slice().copy_from(suffix);
+
+  td::Sha256State sha256;
+  sha256.init();
+  sha256.feed(head.as_slice().remove_prefix(4));
+  sha256.feed(body.as_slice());
+  sha256.feed(suffix);
+  sha256.extract(tail.as_slice().remove_prefix(suffix.size()));
+
+  out_ctr_.encrypt(head.as_slice(), head.as_slice());
+  out_ctr_.encrypt(body.as_slice(), body.as_slice());
+  out_ctr_.encrypt(tail.as_slice(), tail.as_slice());
+
+  auto &output = buffered_fd_.output_buffer();
+  output.append(std::move(head));
+  if (!body.empty()) {
+    output.append(std::move(body));
+  }
+  output.append(std::move(tail));
+  // Packets sent in one batch of messages are written with one writev
+  if (!flush_scheduled_) {
+    flush_scheduled_ = true;
+    notify();
+  }
 }
 
 td::Status AdnlExtConnection::receive(td::ChainBufferReader &input, bool &exit_loop) {
-  if (stop_read_) {
+  if (read_paused()) {
     exit_loop = true;
     return td::Status::OK();
   }
@@ -90,13 +115,12 @@ td::Status AdnlExtConnection::receive(td::ChainBufferReader &input, bool &exit_l
     auto data = input.cut_head(len_).move_as_buffer_slice();
     update_timer();
 
-    td::BufferSlice dec_data{data.size()};
-    in_ctr_.encrypt(data.as_slice(), dec_data.as_slice());
+    in_ctr_.encrypt(data.as_slice(), data.as_slice());
 
     exit_loop = false;
     read_len_ = false;
     len_ = 0;
-    return receive_packet(std::move(dec_data));
+    return receive_packet(std::move(data));
   } else {
     if (input.size() < 256) {
       exit_loop = true;
@@ -112,8 +136,13 @@ td::Status AdnlExtConnection::receive(td::ChainBufferReader &input, bool &exit_l
 }
 
 void AdnlExtConnection::loop() {
+  flush_scheduled_ = false;
   auto status = [&] {
-    TRY_STATUS(buffered_fd_.flush_read());
+    TRY_STATUS(buffered_fd_.flush_write());
+    // While reading is paused, data is left in the socket, so TCP flow control slows the peer down
+    if (!read_paused()) {
+      TRY_STATUS(buffered_fd_.flush_read());
+    }
     auto &input = buffered_fd_.input_buffer();
     bool exit_loop = false;
     while (!exit_loop) {
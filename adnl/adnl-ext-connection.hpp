@@ -48,7 +48,10 @@ class AdnlExtConnection : public td::actor::Actor, public td::ObserverBase {
   AdnlExtConnection(td::SocketFd fd, std::unique_ptr<Callback> callback, bool is_client)
       : buffered_fd_(std::move(fd)), callback_(std::move(callback)), is_client_(is_client) {
   }
+  // Data is encrypted in place, so it must not be shared with other buffers
   void send(td::BufferSlice data);
+  // Sends prefix + body + suffix as one packet without copying them together; body is left unchanged
+  void send_parts(td::Slice prefix, td::Slice body, td::Slice suffix);
   void send_uninit(td::BufferSlice data);
   td::Status receive(td::ChainBufferReader &input, bool &exit_loop);
   virtual td::Status process_packet(td::BufferSlice data) = 0;
@@ -65,6 +68,13 @@ class AdnlExtConnection : public td::actor::Actor, public td::ObserverBase {
   void resume_read() {
     stop_read_ = false;
   }
+  bool read_paused() {
+    // Answers of a server connection are not buffered without limit when the peer does not read them
+    return stop_read_ || (!is_client_ && buffered_fd_.ready_for_flush_write() > max_pending_write());
+  }
+  static constexpr size_t max_pending_write() {
+    return 8 << 20;
+  }
   bool check_ready() const {
     return received_bytes_ && inited_ && authorized() && !td::can_close(buffered_fd_);
   }
@@ -110,12 +120,15 @@ class AdnlExtConnection : public td::actor::Actor, public td::ObserverBase {
   bool inited_ = false;
   bool stop_read_ = false;
   bool read_len_ = false;
+  bool flush_scheduled_ = false;
   td::uint32 len_;
   td::uint32 received_bytes_ = 0;
   td::Timestamp fail_at_;
   td::Timestamp send_ping_at_;
   bool ping_sent_ = false;
 
+  void append_packet(td::Slice prefix, td::BufferSlice body, td::Slice suffix);
+
   void on_net() {
     loop();
   }
@@ -19,6 +19,7 @@
 #include "adnl-ext-server.hpp"
 #include "keys/encryptor.h"
 #include "utils.hpp"
+#include "td/utils/tl_storers.h"
 
 namespace ton {
 
@@ -29,19 +30,56 @@ td::Status AdnlInboundConnection::process_packet(td::BufferSlice data) {
 
   auto P =
       td::PromiseCreator::lambda([SelfId = actor_id(this), query_id = f->query_id_](td::Result<td::BufferSlice> R) {
-        if (R.is_error()) {
-          auto S = R.move_as_error();
-          LOG(WARNING) << "failed ext query: " << S;
-        } else {
-          auto B = create_tl_object<ton_api::adnl_message_answer>(query_id, R.move_as_ok());
-          td::actor::send_closure(SelfId, &AdnlInboundConnection::send, serialize_tl_object(B, true));
-        }
+        td::actor::send_closure(SelfId, &AdnlInboundConnection::finished_query, query_id, std::move(R));
       });
   td::actor::send_closure(peer_table_, &AdnlPeerTable::deliver_query, remote_id_, local_id_, std::move(f->query_),
                           std::move(P));
+  if (++active_queries_ == max_active_queries()) {
+    stop_read();
+  }
   return td::Status::OK();
 }
 
+void AdnlInboundConnection::finished_query(td::Bits256 query_id, td::Result<td::BufferSlice> R) {
+  if (R.is_error()) {
+    auto S = R.move_as_error();
+    LOG(WARNING) << "failed ext query: " << S;
+  } else {
+    send_answer(query_id, R.move_as_ok());
+  }
+  CHECK(active_queries_ > 0);
+  if (active_queries_-- == max_active_queries()) {
+    resume_read();
+    notify();
+  }
+}
+
+void AdnlInboundConnection::send_answer(td::Bits256 query_id, td::BufferSlice answer) {
+  // Serialized adnl.message.answer is sent in parts, so that large answers are not copied once more.
+  // The answer itself may be shared (e.g. with liteserver cache), it is encrypted into a new buffer.
+  size_t len = answer.size();
+  if (len >= (1 << 24)) {
+    LOG(WARNING) << "too big ext query answer: " << len;
+    return;
+  }
+  td::uint8 prefix[4 + 32 + 4];
+  td::TlStorerUnsafe storer{prefix};
+  storer.store_int(ton_api::adnl_message_answer::ID);
+  storer.store_binary(query_id);
+  size_t prefix_size = 4 + 32;
+  if (len < 254) {
+    prefix[prefix_size++] = static_cast<td::uint8>(len);
+  } else {
+    prefix[prefix_size++] = 254;
+    prefix[prefix_size++] = static_cast<td::uint8>(len & 255);
+    prefix[prefix_size++] = static_cast<td::uint8>((len >> 8) & 255);
+    prefix[prefix_size++] = static_cast<td::uint8>(len >> 16);
+  }
+  static const td::uint8 padding[3] = {0, 0, 0};
+  size_t padding_size = (4 - (prefix_size - 36 + len) % 4) % 4;
+  send_parts(td::Slice(prefix, prefix_size), answer.as_slice(), td::Slice(padding, padding_size));
+}
+
 td::Status AdnlInboundConnection::process_init_packet(td::BufferSlice data) {
   if (data.size() < 32) {
     return td::Status::Error(ErrorCode::protoviolation, "too small init packet");
@@ -136,29 +174,50 @@ void AdnlExtServerImpl::add_tcp_port(td::uint16 port) {
 
   class Callback : public td::TcpListener::Callback {
    private:
+    td::actor::ActorId<AdnlPeerTable> peer_table_;
     td::actor::ActorId<AdnlExtServerImpl> id_;
 
    public:
-    Callback(td::actor::ActorId<AdnlExtServerImpl> id) : id_(id) {
+    Callback(td::actor::ActorId<AdnlPeerTable> peer_table, td::actor::ActorId<AdnlExtServerImpl> id)
+        : peer_table_(peer_table), id_(id) {
     }
     void accept(td::SocketFd fd) override {
-      td::actor::send_closure(id_, &AdnlExtServerImpl::accepted, std::move(fd));
+      // Connection stays on the scheduler of the listener, which accepted it
+      td::actor::create_actor<AdnlInboundConnection>(td::actor::ActorOptions().with_name("inconn").with_poll(),
+                                                     std::move(fd), peer_table_, id_)
+          .release();
     }
   };
 
-  auto act = td::actor::create_actor<td::TcpInfiniteListener>(
-      td::actor::ActorOptions().with_name("listener").with_poll(), port, std::make_unique<Callback>(actor_id(this)));
-  listeners_.emplace(port, std::move(act));
+  auto &listeners = listeners_[port];
+  if (io_schedulers_.empty()) {
+    listeners.push_back(td::actor::create_actor<td::TcpInfiniteListener>(
+        td::actor::ActorOptions().with_name("listener").with_poll(), port,
+        std::make_unique<Callback>(peer_table_, actor_id(this))));
+    return;
+  }
+  // All listeners are bound to the same port with SO_REUSEPORT
+  for (auto &scheduler : io_schedulers_) {
+    listeners.push_back(td::actor::create_actor<td::TcpInfiniteListener>(
+        td::actor::ActorOptions().with_name("listener").with_poll().on_scheduler(scheduler), port,
+        std::make_unique<Callback>(peer_table_, actor_id(this))));
+  }
 }
 
 void AdnlExtServerImpl::add_local_id(AdnlNodeIdShort id) {
   local_ids_.insert(id);
 }
 
-void AdnlExtServerImpl::accepted(td::SocketFd fd) {
-  td::actor::create_actor<AdnlInboundConnection>(td::actor::ActorOptions().with_name("inconn").with_poll(),
-                                                 std::move(fd), peer_table_, actor_id(this))
-      .release();
+void AdnlExtServerImpl::set_io_schedulers(std::vector<td::actor::SchedulerId> schedulers) {
+  io_schedulers_ = std::move(schedulers);
+  std::vector<td::uint16> ports;
+  for (auto &it : listeners_) {
+    ports.push_back(it.first);
+  }
+  listeners_.clear();
+  for (auto port : ports) {
+    add_tcp_port(port);
+  }
 }
 
 void AdnlExtServerImpl::decrypt_init_packet(AdnlNodeIdShort dst, td::BufferSlice data,
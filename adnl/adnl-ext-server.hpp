@@ -45,11 +45,19 @@ class AdnlInboundConnection : public AdnlExtConnection {
   td::Status process_init_packet(td::BufferSlice data) override;
   td::Status process_custom_packet(td::BufferSlice &data, bool &processed) override;
   void inited_crypto(td::Result<td::BufferSlice> R);
+  void finished_query(td::Bits256 query_id, td::Result<td::BufferSlice> R);
+  void send_answer(td::Bits256 query_id, td::BufferSlice answer);
+
+  // Reading from the socket is paused while this many queries of the connection are in progress
+  static constexpr td::uint32 max_active_queries() {
+    return 16;
+  }
 
  private:
   td::actor::ActorId<AdnlPeerTable> peer_table_;
   td::actor::ActorId<AdnlExtServerImpl> ext_server_;
   AdnlNodeIdShort local_id_;
+  td::uint32 active_queries_ = 0;
 
   td::SecureString nonce_;
   AdnlNodeIdShort remote_id_ = AdnlNodeIdShort::zero();
@@ -59,7 +67,7 @@ class AdnlExtServerImpl : public AdnlExtServer {
  public:
   void add_tcp_port(td::uint16 port) override;
   void add_local_id(AdnlNodeIdShort id) override;
-  void accepted(td::SocketFd fd);
+  void set_io_schedulers(std::vector<td::actor::SchedulerId> schedulers) override;
   void decrypt_init_packet(AdnlNodeIdShort dst, td::BufferSlice data, td::Promise<td::BufferSlice> promise);
 
   void start_up() override {
@@ -87,7 +95,8 @@ class AdnlExtServerImpl : public AdnlExtServer {
   td::actor::ActorId<AdnlPeerTable> peer_table_;
   std::set<AdnlNodeIdShort> local_ids_;
   std::set<td::uint16> ports_;
-  std::map<td::uint16, td::actor::ActorOwn<td::TcpInfiniteListener>> listeners_;
+  std::vector<td::actor::SchedulerId> io_schedulers_;
+  std::map<td::uint16, std::vector<td::actor::ActorOwn<td::TcpInfiniteListener>>> listeners_;
 };
 
 }  // namespace adnl
@@ -42,6 +42,8 @@ class AdnlExtServer : public td::actor::Actor {
  public:
   virtual void add_local_id(AdnlNodeIdShort id) = 0;
   virtual void add_tcp_port(td::uint16 port) = 0;
+  // Accept and serve connections on these schedulers (one listener per scheduler, kernel balances the port)
+  virtual void set_io_schedulers(std::vector<td::actor::SchedulerId> schedulers) = 0;
   virtual ~AdnlExtServer() = default;
 };
 
@@ -46,7 +46,6 @@ CatChainReceiverSourceImpl::CatChainReceiverSourceImpl(CatChainReceiver *chain,
     : chain_(chain), id_(id), adnl_id_(adnl_id) {
   src_ = source.compute_short_id();
 
-  encryptor_ = source.create_encryptor_async().move_as_ok();
   encryptor_sync_ = source.create_encryptor().move_as_ok();
   full_id_ = std::move(source);
 }
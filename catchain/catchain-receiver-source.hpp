@@ -62,9 +62,6 @@ class CatChainReceiverSourceImpl : public CatChainReceiverSource {
     return blamed_heights_;
   }
 
-  td::actor::ActorId<EncryptorAsync> get_encryptor() const {
-    return encryptor_.get();
-  }
   Encryptor *get_encryptor_sync() const override {
     return encryptor_sync_.get();
   }
@@ -124,7 +121,6 @@ class CatChainReceiverSourceImpl : public CatChainReceiverSource {
   adnl::AdnlNodeIdShort adnl_id_;
 
   std::vector<td::uint32> fork_ids_;
-  td::actor::ActorOwn<EncryptorAsync> encryptor_;
   std::unique_ptr<Encryptor> encryptor_sync_;
   std::vector<CatChainBlockHeight> blamed_heights_;
   std::map<CatChainBlockHeight, CatChainReceivedBlock *> blocks_;
@@ -19,9 +19,11 @@
 #include <set>
 #include <utility>
 #include "td/actor/PromiseFuture.h"
+#include "td/actor/MultiPromise.h"
 #include "td/utils/Random.h"
 #include "td/db/RocksDb.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/overloaded.h"
 #include "common/delay.h"
 
@@ -87,39 +89,194 @@ void CatChainReceiverImpl::deliver_block(CatChainReceivedBlock *block) {
 
 void CatChainReceiverImpl::receive_block(adnl::AdnlNodeIdShort src, tl_object_ptr<ton_api::catchain_block> block,
                                          td::BufferSlice payload) {
-  CatChainBlockHash id = CatChainReceivedBlock::block_hash(this, block, payload);
-  CatChainReceivedBlock *B = get_block(id);
-  if (B && B->initialized()) {
+  if (block->src_ < 0 || static_cast<td::uint32>(block->src_) >= get_sources_cnt()) {
+    VLOG(CATCHAIN_WARNING) << this << ": received broken block from " << src << ": bad src " << block->src_;
     return;
   }
-
   if (block->incarnation_ != incarnation_) {
-    VLOG(CATCHAIN_WARNING) << this << ": dropping broken block from " << src << ": bad incarnation "
-                           << block->incarnation_;
+    receive_block_cont(src, std::move(block), std::move(payload));
+    return;
+  }
+  CatChainReceivedBlock *B = get_block(CatChainReceivedBlock::block_hash(this, block, payload));
+  if (B && B->initialized()) {
+    return;
+  }
+  td::Status S = check_block_limits(block, B);
+  if (S.is_error()) {
+    VLOG(CATCHAIN_WARNING) << this << ": dropping block from " << src << ": " << S;
     return;
   }
+  received_blocks_.push_back(ReceivedBlock{src, std::move(block), std::move(payload)});
+  check_received_blocks();
+}
 
+td::Status CatChainReceiverImpl::check_block_limits(const tl_object_ptr<ton_api::catchain_block> &block,
+                                                    const CatChainReceivedBlock *B) const {
+  if (block->src_ < 0 || static_cast<td::uint32>(block->src_) >= get_sources_cnt()) {
+    return td::Status::Error(ErrorCode::protoviolation, PSTRING() << "bad src " << block->src_);
+  }
+  if (block->height_ <= 0) {
+    return td::Status::Error(ErrorCode::protoviolation, PSTRING() << "bad height " << block->height_);
+  }
   td::uint64 max_block_height = get_max_block_height(opts_, sources_.size());
-  if ((td::uint32)block->height_ > max_block_height) {
-    VLOG(CATCHAIN_WARNING) << this << ": received too many blocks from " << src
-                           << " (limit=" << max_block_height << ")";
-    return;
+  if (static_cast<td::uint64>(block->height_) > max_block_height) {
+    return td::Status::Error(ErrorCode::protoviolation, PSTRING() << "too many blocks from source " << block->src_
+                                                                  << " (limit=" << max_block_height << ")");
+  }
+  if (block->data_->deps_.size() > opts_.max_deps) {
+    return td::Status::Error(ErrorCode::protoviolation, "too many deps");
   }
+  if (get_source(block->src_)->fork_is_found() && (B == nullptr || !B->has_rev_deps())) {
+    return td::Status::Error(ErrorCode::protoviolation, PSTRING() << "source " << block->src_ << " has a fork");
+  }
+  return td::Status::OK();
+}
 
-  td::uint32 src_id = block->src_;
-  if (src_id >= get_sources_cnt()) {
-    VLOG(CATCHAIN_WARNING) << this << ": received broken block from " << src << ": bad src " << block->src_;
+td::Status CatChainReceiverImpl::add_signature_checks(const tl_object_ptr<ton_api::catchain_block> &block,
+                                                      const td::Slice &payload, std::set<CatChainBlockHash> &ids,
+                                                      std::vector<CatChainSignatureChecker::Check> &checks) {
+  auto id = CatChainReceivedBlock::block_id(this, block, payload);
+  td::BufferSlice data = serialize_tl_object(id, true);
+  CatChainBlockHash hash = sha256_bits256(data);
+  TRY_STATUS(check_block_limits(block, get_block(hash)));
+  if (ids.insert(hash).second) {
+    checks.push_back({hash, static_cast<td::uint32>(block->src_), std::move(data), block->signature_.clone()});
+  }
+  auto add_dep = [&](const tl_object_ptr<ton_api::catchain_block_dep> &dep) {
+    if (dep->height_ <= 0 || dep->src_ < 0 || static_cast<td::uint32>(dep->src_) >= get_sources_cnt()) {
+      return;
+    }
+    auto dep_id = CatChainReceivedBlock::block_id(this, dep);
+    td::BufferSlice dep_data = serialize_tl_object(dep_id, true);
+    CatChainBlockHash dep_hash = sha256_bits256(dep_data);
+    if (!get_block(dep_hash) && ids.insert(dep_hash).second) {
+      checks.push_back({dep_hash, static_cast<td::uint32>(dep->src_), std::move(dep_data), dep->signature_.clone()});
+    }
+  };
+  add_dep(block->data_->prev_);
+  for (const auto &dep : block->data_->deps_) {
+    add_dep(dep);
+  }
+  return td::Status::OK();
+}
+
+void CatChainReceiverImpl::check_signatures(std::vector<CatChainSignatureChecker::Check> checks,
+                                            td::Promise<std::vector<CatChainBlockHash>> promise) {
+  // Small batches are not split, so that a single block does not wake up all checkers
+  size_t parts = std::min(signature_checkers_.size(), (checks.size() + 15) / 16);
+  if (parts == 0) {
+    promise.set_value({});
     return;
   }
-  CatChainReceiverSource *source = get_source(src_id);
-  if (source->fork_is_found()) {
-    if (B == nullptr || !B->has_rev_deps()) {
-      VLOG(CATCHAIN_WARNING) << this << ": dropping block from source " << src_id << ": source has a fork";
+  auto results = std::make_shared<std::vector<std::vector<CatChainBlockHash>>>(parts);
+  td::MultiPromise mp;
+  auto ig = mp.init_guard();
+  ig.add_promise([results, promise = std::move(promise)](td::Result<td::Unit> R) mutable {
+    if (R.is_error()) {
+      promise.set_error(R.move_as_error());
       return;
     }
+    std::vector<CatChainBlockHash> verified;
+    for (auto &v : *results) {
+      verified.insert(verified.end(), v.begin(), v.end());
+    }
+    promise.set_value(std::move(verified));
+  });
+  size_t begin = 0;
+  for (size_t i = 0; i < parts; i++) {
+    size_t end = begin + (checks.size() - begin) / (parts - i);
+    std::vector<CatChainSignatureChecker::Check> part;
+    part.reserve(end - begin);
+    for (size_t j = begin; j < end; j++) {
+      part.push_back(std::move(checks[j]));
+    }
+    begin = end;
+    auto &checker = signature_checkers_[next_signature_checker_];
+    next_signature_checker_ = (next_signature_checker_ + 1) % signature_checkers_.size();
+    td::actor::send_closure(checker, &CatChainSignatureChecker::check, std::move(part),
+                            [results, i, promise = ig.get_promise()](
+                                td::Result<std::vector<CatChainBlockHash>> R) mutable {
+                              TRY_RESULT_PROMISE(promise, verified, std::move(R));
+                              results->at(i) = std::move(verified);
+                              promise.set_value(td::Unit());
+                            });
+  }
+}
+
+void CatChainReceiverImpl::check_received_blocks() {
+  if (checking_received_blocks_ || received_blocks_.empty()) {
+    return;
+  }
+  // All blocks received while the previous batch was checked are checked together
+  checking_received_blocks_ = true;
+  auto received = std::move(received_blocks_);
+  received_blocks_.clear();
+  std::vector<ReceivedBlock> blocks;
+  std::set<CatChainBlockHash> ids;
+  std::vector<CatChainSignatureChecker::Check> checks;
+  for (auto &b : received) {
+    // A fork of the source may have been found since the block was queued
+    td::Status S = add_signature_checks(b.block, b.payload.as_slice(), ids, checks);
+    if (S.is_error()) {
+      VLOG(CATCHAIN_WARNING) << this << ": dropping block from " << b.src << ": " << S;
+      continue;
+    }
+    blocks.push_back(std::move(b));
+  }
+  if (blocks.size() == 1) {
+    // A single block has only a few signatures, they are checked here without a round trip to a checker
+    std::vector<CatChainBlockHash> verified;
+    for (const auto &c : checks) {
+      auto encryptor = get_source(c.src)->get_encryptor_sync();
+      if (encryptor->check_signature(c.data.as_slice(), c.signature.as_slice()).is_ok()) {
+        verified.push_back(c.id);
+      }
+    }
+    checked_received_blocks(std::move(blocks), std::move(verified));
+    return;
+  }
+  check_signatures(std::move(checks),
+                   [SelfId = actor_id(this), blocks = std::move(blocks)](
+                       td::Result<std::vector<CatChainBlockHash>> R) mutable {
+                     R.ensure();
+                     td::actor::send_closure(SelfId, &CatChainReceiverImpl::checked_received_blocks,
+                                             std::move(blocks), R.move_as_ok());
+                   });
+}
+
+void CatChainReceiverImpl::checked_received_blocks(std::vector<ReceivedBlock> blocks,
+                                                   std::vector<CatChainBlockHash> verified) {
+  verified_signatures_.insert(verified.begin(), verified.end());
+  for (auto &b : blocks) {
+    receive_block_cont(b.src, std::move(b.block), std::move(b.payload));
   }
+  // Verified blocks are in blocks_ now, or were rejected for other reasons
+  verified_signatures_.clear();
+  checking_received_blocks_ = false;
+  check_received_blocks();
+}
 
-  td::Status S = validate_block_sync(block, payload.as_slice());
+void CatChainReceiverImpl::receive_block_cont(adnl::AdnlNodeIdShort src, tl_object_ptr<ton_api::catchain_block> block,
+                                              td::BufferSlice payload) {
+  CatChainBlockHash id = CatChainReceivedBlock::block_hash(this, block, payload);
+  CatChainReceivedBlock *B = get_block(id);
+  if (B && B->initialized()) {
+    return;
+  }
+
+  if (block->incarnation_ != incarnation_) {
+    VLOG(CATCHAIN_WARNING) << this << ": dropping broken block from " << src << ": bad incarnation "
+                           << block->incarnation_;
+    return;
+  }
+
+  td::Status S = check_block_limits(block, B);
+  if (S.is_error()) {
+    VLOG(CATCHAIN_WARNING) << this << ": dropping block from " << src << ": " << S;
+    return;
+  }
+
+  S = validate_block_sync(block, payload.as_slice());
 
   if (S.is_error()) {
     VLOG(CATCHAIN_WARNING) << this << ": received broken block from " << src << ": " << S.move_as_error();
@@ -232,8 +389,8 @@ td::Status CatChainReceiverImpl::validate_block_sync(const tl_object_ptr<ton_api
   if (dep->height_ > 0) {
     auto id = CatChainReceivedBlock::block_id(this, dep);
     td::BufferSlice B = serialize_tl_object(id, true);
-    CatChainReceivedBlock *block = get_block(get_tl_object_sha_bits256(id));
-    if (block) {
+    CatChainBlockHash hash = get_tl_object_sha_bits256(id);
+    if (get_block(hash) || verified_signatures_.count(hash)) {
       return td::Status::OK();
     }
 
@@ -253,6 +410,9 @@ td::Status CatChainReceiverImpl::validate_block_sync(const tl_object_ptr<ton_api
   // After pre_validate_block, block->height_ > 0
   auto id = CatChainReceivedBlock::block_id(this, block, payload);
   td::BufferSlice B = serialize_tl_object(id, true);
+  if (verified_signatures_.count(sha256_bits256(B))) {
+    return td::Status::OK();
+  }
 
   CatChainReceiverSource *S = get_source_by_hash(PublicKeyHash{id->src_});
   CHECK(S != nullptr);
@@ -302,43 +462,27 @@ void CatChainReceiverImpl::add_block_cont_3(tl_object_ptr<ton_api::catchain_bloc
   }
 }
 
-void CatChainReceiverImpl::add_block_cont_2(tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload) {
-  if (opts_.debug_disable_db) {
-    add_block_cont_3(std::move(block), std::move(payload));
-    return;
-  }
-
-  CatChainBlockHash id = CatChainReceivedBlock::block_hash(this, block, payload);
-
-  td::BufferSlice raw_data{id.as_array().size()};
-  raw_data.as_slice().copy_from(as_slice(id));
-
-  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), block = std::move(block),
-                                       payload = std::move(payload)](td::Result<td::Unit> R) mutable {
-    R.ensure();
-    td::actor::send_closure(SelfId, &CatChainReceiverImpl::add_block_cont_3, std::move(block), std::move(payload));
-  });
-
-  db_.set(CatChainBlockHash::zero(), std::move(raw_data), std::move(P), 0);
-}
-
 void CatChainReceiverImpl::add_block_cont(tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload) {
   validate_block_sync(block, payload.as_slice()).ensure();
   if (opts_.debug_disable_db) {
-    add_block_cont_2(std::move(block), std::move(payload));
+    add_block_cont_3(std::move(block), std::move(payload));
     return;
   }
   CatChainBlockHash id = CatChainReceivedBlock::block_hash(this, block, payload.as_slice());
 
   td::BufferSlice raw_data = serialize_tl_object(block, true, payload.as_slice());
+  td::BufferSlice root_data{id.as_array().size()};
+  root_data.as_slice().copy_from(as_slice(id));
 
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), block = std::move(block),
                                        payload = std::move(payload)](td::Result<td::Unit> R) mutable {
     R.ensure();
-    td::actor::send_closure(SelfId, &CatChainReceiverImpl::add_block_cont_2, std::move(block), std::move(payload));
+    td::actor::send_closure(SelfId, &CatChainReceiverImpl::add_block_cont_3, std::move(block), std::move(payload));
   });
 
-  db_.set(id, std::move(raw_data), std::move(P), 0);
+  // The block and the new root pointer normally go to the same transaction; the root is never written before the block
+  db_.set(id, std::move(raw_data), {}, 0);
+  db_.set(CatChainBlockHash::zero(), std::move(root_data), std::move(P), 0);
 }
 
 void CatChainReceiverImpl::add_block(td::BufferSlice payload, std::vector<CatChainBlockHash> deps) {
@@ -517,6 +661,16 @@ CatChainReceiverImpl::CatChainReceiverImpl(std::unique_ptr<Callback> callback,
 }
 
 void CatChainReceiverImpl::start_up() {
+  std::vector<PublicKey> keys;
+  for (td::uint32 i = 0; i < get_sources_cnt(); i++) {
+    keys.push_back(get_source(i)->get_full_id());
+  }
+  size_t checkers = std::min<size_t>(std::max<size_t>(td::thread::hardware_concurrency() / 4, 1), 8);
+  for (size_t i = 0; i < checkers; i++) {
+    signature_checkers_.push_back(td::actor::create_actor<CatChainSignatureChecker>(
+        td::actor::ActorOptions().with_name("sigchecker").with_high_priority(), keys));
+  }
+
   std::vector<adnl::AdnlNodeIdShort> ids;
   ids.reserve(get_sources_cnt());
   for (td::uint32 i = 0; i < get_sources_cnt(); i++) {
@@ -559,79 +713,102 @@ void CatChainReceiverImpl::start_up() {
   }
 }
 
+void CatChainSignatureChecker::start_up() {
+  for (const auto &key : sources_) {
+    encryptors_.push_back(key.create_encryptor().move_as_ok());
+  }
+}
+
+void CatChainSignatureChecker::check(std::vector<Check> checks, td::Promise<std::vector<CatChainBlockHash>> promise) {
+  std::vector<CatChainBlockHash> verified;
+  for (const auto &c : checks) {
+    CHECK(c.src < encryptors_.size());
+    if (encryptors_[c.src]->check_signature(c.data.as_slice(), c.signature.as_slice()).is_ok()) {
+      verified.push_back(c.id);
+    }
+  }
+  promise.set_value(std::move(verified));
+}
+
 void CatChainReceiverImpl::tear_down() {
   td::actor::send_closure(overlay_manager_, &overlay::Overlays::delete_overlay, get_source(local_idx_)->get_adnl_id(),
                           overlay_id_);
 }
 
 void CatChainReceiverImpl::read_db_from(CatChainBlockHash id) {
-  pending_in_db_ = 1;
   db_root_block_ = id;
 
-  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), id](td::Result<DbType::GetResult> R) {
+  // The database holds only the blocks of this catchain, so it is read by one scan instead of a query per dependency
+  db_.get_all([SelfId = actor_id(this)](td::Result<std::vector<std::pair<CatChainBlockHash, td::BufferSlice>>> R) {
     R.ensure();
-    DbType::GetResult g = R.move_as_ok();
-    CHECK(g.status == td::KeyValue::GetStatus::Ok);
-
-    td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_block_from_db, id, std::move(g.value));
+    td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_blocks_from_db, R.move_as_ok());
   });
-
-  db_.get(id, std::move(P));
 }
 
-void CatChainReceiverImpl::read_block_from_db(CatChainBlockHash id, td::BufferSlice data) {
-  pending_in_db_--;
-
-  auto F = fetch_tl_prefix<ton_api::catchain_block>(data, true);
-  F.ensure();
-
-  auto block = F.move_as_ok();
-  td::BufferSlice payload = std::move(data);
-
-  CatChainBlockHash block_id = CatChainReceivedBlock::block_hash(this, block, payload);
-  CHECK(block_id == id);
-
-  CatChainReceivedBlock *B = get_block(id);
-  if (B && B->initialized()) {
-    CHECK(B->in_db());
-    if (!pending_in_db_) {
-      read_db();
+void CatChainReceiverImpl::read_blocks_from_db(std::vector<std::pair<CatChainBlockHash, td::BufferSlice>> data) {
+  std::map<CatChainBlockHash, td::BufferSlice> raw_blocks;
+  for (auto &p : data) {
+    raw_blocks.emplace(p.first, std::move(p.second));
+  }
+  data.clear();
+
+  // Only blocks reachable from the root (the last block of this node) are loaded, as before
+  std::vector<DbBlock> blocks;
+  std::set<CatChainBlockHash> visited{db_root_block_};
+  std::vector<CatChainBlockHash> queue{db_root_block_};
+  while (!queue.empty()) {
+    CatChainBlockHash id = queue.back();
+    queue.pop_back();
+    auto it = raw_blocks.find(id);
+    CHECK(it != raw_blocks.end());
+    td::BufferSlice payload = std::move(it->second);
+
+    auto F = fetch_tl_prefix<ton_api::catchain_block>(payload, true);
+    F.ensure();
+    auto block = F.move_as_ok();
+    CHECK(block->incarnation_ == incarnation_);
+    CHECK(CatChainReceivedBlock::block_hash(this, block, payload) == id);
+
+    auto add_dep = [&](const tl_object_ptr<ton_api::catchain_block_dep> &dep) {
+      if (dep->height_ == 0) {
+        return;
+      }
+      CatChainBlockHash dep_id = CatChainReceivedBlock::block_hash(this, dep);
+      if (visited.insert(dep_id).second) {
+        queue.push_back(dep_id);
+      }
+    };
+    add_dep(block->data_->prev_);
+    for (const auto &dep : block->data_->deps_) {
+      add_dep(dep);
     }
-    return;
+    blocks.push_back(DbBlock{id, std::move(block), std::move(payload)});
   }
 
-  CatChainReceiverSource *source = get_source(block->src_);
-  CHECK(source != nullptr);
-
-  CHECK(block->incarnation_ == incarnation_);
-
-  validate_block_sync(block, payload).ensure();
-
-  B = create_block(std::move(block), td::SharedSlice{payload.as_slice()});
-  CHECK(B);
-  B->written();
-
-  std::vector<CatChainBlockHash> deps = B->get_dep_hashes();
-  deps.push_back(B->get_prev_hash());
-  for (const CatChainBlockHash &dep : deps) {
-    CatChainReceivedBlock *dep_block = get_block(dep);
-    if (!dep_block || !dep_block->initialized()) {
-      pending_in_db_++;
-      auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), dep](td::Result<DbType::GetResult> R) {
-        R.ensure();
-        DbType::GetResult g = R.move_as_ok();
-        CHECK(g.status == td::KeyValue::GetStatus::Ok);
-
-        td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_block_from_db, dep, std::move(g.value));
-      });
-
-      db_.get(dep, std::move(P));
-    }
+  std::set<CatChainBlockHash> ids;
+  std::vector<CatChainSignatureChecker::Check> checks;
+  for (const auto &b : blocks) {
+    add_signature_checks(b.block, b.payload.as_slice(), ids, checks).ensure();
   }
+  VLOG(CATCHAIN_INFO) << this << ": read " << blocks.size() << " blocks from db, checking " << checks.size()
+                      << " signatures";
+  check_signatures(std::move(checks), [SelfId = actor_id(this), blocks = std::move(blocks)](
+                                          td::Result<std::vector<CatChainBlockHash>> R) mutable {
+    R.ensure();
+    td::actor::send_closure(SelfId, &CatChainReceiverImpl::add_blocks_from_db, std::move(blocks), R.move_as_ok());
+  });
+}
 
-  if (!pending_in_db_) {
-    read_db();
+void CatChainReceiverImpl::add_blocks_from_db(std::vector<DbBlock> blocks, std::vector<CatChainBlockHash> verified) {
+  verified_signatures_.insert(verified.begin(), verified.end());
+  for (auto &b : blocks) {
+    validate_block_sync(b.block, b.payload.as_slice()).ensure();
+    CatChainReceivedBlock *B = create_block(std::move(b.block), td::SharedSlice{b.payload.as_slice()});
+    CHECK(B);
+    B->written();
   }
+  verified_signatures_.clear();
+  read_db();
 }
 
 void CatChainReceiverImpl::read_db() {
@@ -660,8 +837,9 @@ td::actor::ActorOwn<CatChainReceiverInterface> CatChainReceiverInterface::create
     const std::vector<CatChainNode> &ids, const PublicKeyHash &local_id, const CatChainSessionId &unique_hash,
     std::string db_root, std::string db_suffix, bool allow_unsafe_self_blocks_resync) {
   auto A = td::actor::create_actor<CatChainReceiverImpl>(
-      "catchainreceiver", std::move(callback), opts, std::move(keyring), std::move(adnl), std::move(overlay_manager),
-      ids, local_id, unique_hash, std::move(db_root), std::move(db_suffix), allow_unsafe_self_blocks_resync);
+      td::actor::ActorOptions().with_name("catchainreceiver").with_high_priority(), std::move(callback), opts,
+      std::move(keyring), std::move(adnl), std::move(overlay_manager), ids, local_id, unique_hash, std::move(db_root),
+      std::move(db_suffix), allow_unsafe_self_blocks_resync);
   return std::move(A);
 }
 
@@ -21,6 +21,7 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
 
 #include "catchain-types.h"
 #include "catchain-receiver.h"
@@ -33,6 +34,27 @@ namespace ton {
 
 namespace catchain {
 
+// Checks signatures of catchain blocks. A receiver has several checkers, so bursts of blocks are checked in parallel.
+class CatChainSignatureChecker : public td::actor::Actor {
+ public:
+  struct Check {
+    CatChainBlockHash id;
+    td::uint32 src;
+    td::BufferSlice data;
+    td::BufferSlice signature;
+  };
+
+  explicit CatChainSignatureChecker(std::vector<PublicKey> sources) : sources_(std::move(sources)) {
+  }
+  void start_up() override;
+  // Returns ids of the blocks with valid signatures
+  void check(std::vector<Check> checks, td::Promise<std::vector<CatChainBlockHash>> promise);
+
+ private:
+  std::vector<PublicKey> sources_;
+  std::vector<std::unique_ptr<Encryptor>> encryptors_;
+};
+
 class CatChainReceiverImpl final : public CatChainReceiver {
  public:
   PrintId print_id() const override {
@@ -80,7 +102,16 @@ class CatChainReceiverImpl final : public CatChainReceiver {
   void receive_broadcast_from_overlay(const PublicKeyHash &src, td::BufferSlice data);
 
   void receive_block(adnl::AdnlNodeIdShort src, tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload);
+  void receive_block_cont(adnl::AdnlNodeIdShort src, tl_object_ptr<ton_api::catchain_block> block,
+                          td::BufferSlice payload);
   void receive_block_answer(adnl::AdnlNodeIdShort src, td::BufferSlice);
+  // Checks that need no signatures: source, height limit, number of deps, forks of the source
+  td::Status check_block_limits(const tl_object_ptr<ton_api::catchain_block> &block,
+                                const CatChainReceivedBlock *B) const;
+  // Adds signature checks of the block and of its unknown deps, unless the block fails check_block_limits
+  td::Status add_signature_checks(const tl_object_ptr<ton_api::catchain_block> &block, const td::Slice &payload,
+                                  std::set<CatChainBlockHash> &ids,
+                                  std::vector<CatChainSignatureChecker::Check> &checks);
 
   CatChainReceivedBlock *create_block(tl_object_ptr<ton_api::catchain_block> block, td::SharedSlice payload) override;
   CatChainReceivedBlock *create_block(tl_object_ptr<ton_api::catchain_block_dep> block) override;
@@ -100,7 +131,6 @@ class CatChainReceiverImpl final : public CatChainReceiver {
   void run_scheduler();
   void add_block(td::BufferSlice data, std::vector<CatChainBlockHash> deps) override;
   void add_block_cont(tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload);
-  void add_block_cont_2(tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload);
   void add_block_cont_3(tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload);
   void debug_add_fork(td::BufferSlice payload, CatChainBlockHeight height,
                       std::vector<CatChainBlockHash> deps) override;
@@ -121,7 +151,23 @@ class CatChainReceiverImpl final : public CatChainReceiver {
   void tear_down() override;
   void read_db();
   void read_db_from(CatChainBlockHash id);
-  void read_block_from_db(CatChainBlockHash id, td::BufferSlice data);
+  struct DbBlock {
+    CatChainBlockHash id;
+    tl_object_ptr<ton_api::catchain_block> block;
+    td::BufferSlice payload;
+  };
+  void read_blocks_from_db(std::vector<std::pair<CatChainBlockHash, td::BufferSlice>> data);
+  void add_blocks_from_db(std::vector<DbBlock> blocks, std::vector<CatChainBlockHash> verified);
+
+  struct ReceivedBlock {
+    adnl::AdnlNodeIdShort src;
+    tl_object_ptr<ton_api::catchain_block> block;
+    td::BufferSlice payload;
+  };
+  void check_signatures(std::vector<CatChainSignatureChecker::Check> checks,
+                        td::Promise<std::vector<CatChainBlockHash>> promise);
+  void check_received_blocks();
+  void checked_received_blocks(std::vector<ReceivedBlock> blocks, std::vector<CatChainBlockHash> verified);
 
   void block_written_to_db(CatChainBlockHash hash);
 
@@ -177,7 +223,6 @@ class CatChainReceiverImpl final : public CatChainReceiver {
   std::list<std::unique_ptr<PendingBlock>> pending_blocks_;
   bool active_send_ = false;
   bool read_db_ = false;
-  td::uint32 pending_in_db_ = 0;
   CatChainBlockHash db_root_block_ = CatChainBlockHash::zero();
 
   void choose_neighbours();
@@ -222,6 +267,14 @@ class CatChainReceiverImpl final : public CatChainReceiver {
 
   std::list<CatChainReceivedBlock *> to_run_;
 
+  std::vector<td::actor::ActorOwn<CatChainSignatureChecker>> signature_checkers_;
+  size_t next_signature_checker_ = 0;
+  // Received blocks wait here while signatures of the previous batch are checked
+  std::vector<ReceivedBlock> received_blocks_;
+  bool checking_received_blocks_ = false;
+  // Block ids with checked signatures, valid while the checked batch is processed
+  std::set<CatChainBlockHash> verified_signatures_;
+
   std::vector<bool> blame_processed_;
   std::map<td::uint32, td::BufferSlice> pending_fork_proofs_;
 };
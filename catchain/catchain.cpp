@@ -303,9 +303,10 @@ td::actor::ActorOwn<CatChain> CatChain::create(std::unique_ptr<Callback> callbac
                                                std::vector<CatChainNode> ids, const PublicKeyHash &local_id,
                                                const CatChainSessionId &unique_hash, std::string db_root,
                                                std::string db_suffix, bool allow_unsafe_self_blocks_resync) {
-  return td::actor::create_actor<CatChainImpl>("catchain", std::move(callback), opts, std::move(keyring),
-                                               std::move(adnl), std::move(overlay_manager), std::move(ids),
-                                               local_id, unique_hash, std::move(db_root), std::move(db_suffix),
+  return td::actor::create_actor<CatChainImpl>(td::actor::ActorOptions().with_name("catchain").with_high_priority(),
+                                               std::move(callback), opts, std::move(keyring), std::move(adnl),
+                                               std::move(overlay_manager), std::move(ids), local_id, unique_hash,
+                                               std::move(db_root), std::move(db_suffix),
                                                allow_unsafe_self_blocks_resync);
 }
 
@@ -245,7 +245,9 @@ td::Result<AccountState::Info> AccountState::validate(ton::BlockIdExt ref_blk, b
                                       << " that cannot contain requested account");
   }
 
-  TRY_STATUS(block::check_shard_proof(blk, shard_blk, shard_proof.as_slice()));
+  if (!shard_proof_checked) {
+    TRY_STATUS(block::check_shard_proof(blk, shard_blk, shard_proof.as_slice()));
+  }
 
   Info res;
   TRY_STATUS(block::check_account_proof(proof.as_slice(), shard_blk, addr, root, &res.last_trans_lt,
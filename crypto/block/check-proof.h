@@ -45,6 +45,8 @@ struct AccountState {
   td::BufferSlice proof;
   td::BufferSlice state;
   bool is_virtualized{false};
+  // set when shard_proof was already checked for (blk, shard_blk), e.g. while validating another account
+  bool shard_proof_checked{false};
 
   struct Info {
     td::Ref<vm::Cell> root, true_root;
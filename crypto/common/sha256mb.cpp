@@ -0,0 +1,450 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "common/sha256mb.h"
+
+#include "td/utils/common.h"
+#include "td/utils/crypto.h"
+#include "td/utils/port/platform.h"
+
+#include <cstring>
+
+#if (TD_GCC || TD_CLANG) && defined(__x86_64__)
+#define TON_SHA256MB_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define TON_SHA256MB_X86 0
+#endif
+
+namespace td {
+namespace sha256mb {
+
+namespace {
+const uint32 init_state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                              0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+alignas(16) const uint32 round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+uint32 load_be32(const unsigned char* ptr) {
+  return (static_cast<uint32>(ptr[0]) << 24) | (static_cast<uint32>(ptr[1]) << 16) |
+         (static_cast<uint32>(ptr[2]) << 8) | static_cast<uint32>(ptr[3]);
+}
+
+void store_be32(unsigned char* ptr, uint32 x) {
+  ptr[0] = static_cast<unsigned char>(x >> 24);
+  ptr[1] = static_cast<unsigned char>(x >> 16);
+  ptr[2] = static_cast<unsigned char>(x >> 8);
+  ptr[3] = static_cast<unsigned char>(x);
+}
+
+void store_digest(unsigned char* digest, const uint32 state[8]) {
+  for (int i = 0; i < 8; i++) {
+    store_be32(digest + 4 * i, state[i]);
+  }
+}
+
+// Padded message: whole blocks are read in place, the last one or two blocks are built in tail
+struct Message {
+  const unsigned char* data;
+  size_t full_blocks;
+  size_t blocks;
+  unsigned char tail[128];
+
+  void init(const Job& job) {
+    data = job.data;
+    full_blocks = job.size / 64;
+    size_t rest = job.size % 64;
+    blocks = full_blocks + (rest < 56 ? 1 : 2);
+    size_t tail_size = (blocks - full_blocks) * 64;
+    std::memset(tail, 0, tail_size);
+    if (rest != 0) {
+      std::memcpy(tail, job.data + full_blocks * 64, rest);
+    }
+    tail[rest] = 0x80;
+    uint64 bit_size = static_cast<uint64>(job.size) * 8;
+    for (int i = 0; i < 8; i++) {
+      tail[tail_size - 1 - i] = static_cast<unsigned char>(bit_size >> (8 * i));
+    }
+  }
+  const unsigned char* block(size_t i) const {
+    return i < full_blocks ? data + 64 * i : tail + 64 * (i - full_blocks);
+  }
+};
+
+uint32 rotr(uint32 x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+void compress_generic(uint32 state[8], const unsigned char* block) {
+  uint32 w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = load_be32(block + 4 * i);
+  }
+  for (int i = 16; i < 64; i++) {
+    uint32 s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32 s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32 a = state[0], b = state[1], c = state[2], d = state[3];
+  uint32 e = state[4], f = state[5], g = state[6], h = state[7];
+  for (int i = 0; i < 64; i++) {
+    uint32 s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+    uint32 ch = (e & f) ^ (~e & g);
+    uint32 t1 = h + s1 + ch + round_constants[i] + w[i];
+    uint32 s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+    uint32 maj = (a & b) ^ (a & c) ^ (b & c);
+    uint32 t2 = s0 + maj;
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+void hash_generic(const Job* jobs, size_t count) {
+  Message msg;
+  for (size_t i = 0; i < count; i++) {
+    msg.init(jobs[i]);
+    uint32 state[8];
+    std::memcpy(state, init_state, sizeof(state));
+    for (size_t j = 0; j < msg.blocks; j++) {
+      compress_generic(state, msg.block(j));
+    }
+    store_digest(jobs[i].digest, state);
+  }
+}
+
+#if TON_SHA256MB_X86
+__attribute__((target("sha,sse4.1"))) inline __m128i shani_schedule(__m128i w0, __m128i w1, __m128i w2, __m128i w3) {
+  __m128i t = _mm_add_epi32(_mm_sha256msg1_epu32(w0, w1), _mm_alignr_epi8(w3, w2, 4));
+  return _mm_sha256msg2_epu32(t, w3);
+}
+
+__attribute__((target("sha,sse4.1"))) inline void shani_rounds(__m128i& state0, __m128i& state1, __m128i w, int i) {
+  __m128i t = _mm_add_epi32(w, _mm_load_si128(reinterpret_cast<const __m128i*>(round_constants + 4 * i)));
+  state1 = _mm_sha256rnds2_epu32(state1, state0, t);
+  t = _mm_shuffle_epi32(t, 0x0e);
+  state0 = _mm_sha256rnds2_epu32(state0, state1, t);
+}
+
+__attribute__((target("sha,sse4.1"))) void hash_shani(const Job* jobs, size_t count) {
+  const __m128i bswap_mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  // state is kept as ABEF / CDGH, as expected by sha256rnds2
+  const __m128i init_abef = _mm_set_epi32(init_state[0], init_state[1], init_state[4], init_state[5]);
+  const __m128i init_cdgh = _mm_set_epi32(init_state[2], init_state[3], init_state[6], init_state[7]);
+  Message msg;
+  for (size_t k = 0; k < count; k++) {
+    msg.init(jobs[k]);
+    __m128i state0 = init_abef;
+    __m128i state1 = init_cdgh;
+    for (size_t j = 0; j < msg.blocks; j++) {
+      auto* block = reinterpret_cast<const __m128i*>(msg.block(j));
+      __m128i save0 = state0;
+      __m128i save1 = state1;
+      __m128i w0 = _mm_shuffle_epi8(_mm_loadu_si128(block), bswap_mask);
+      shani_rounds(state0, state1, w0, 0);
+      __m128i w1 = _mm_shuffle_epi8(_mm_loadu_si128(block + 1), bswap_mask);
+      shani_rounds(state0, state1, w1, 1);
+      __m128i w2 = _mm_shuffle_epi8(_mm_loadu_si128(block + 2), bswap_mask);
+      shani_rounds(state0, state1, w2, 2);
+      __m128i w3 = _mm_shuffle_epi8(_mm_loadu_si128(block + 3), bswap_mask);
+      shani_rounds(state0, state1, w3, 3);
+      for (int i = 4; i < 16; i += 4) {
+        w0 = shani_schedule(w0, w1, w2, w3);
+        shani_rounds(state0, state1, w0, i);
+        w1 = shani_schedule(w1, w2, w3, w0);
+        shani_rounds(state0, state1, w1, i + 1);
+        w2 = shani_schedule(w2, w3, w0, w1);
+        shani_rounds(state0, state1, w2, i + 2);
+        w3 = shani_schedule(w3, w0, w1, w2);
+        shani_rounds(state0, state1, w3, i + 3);
+      }
+      state0 = _mm_add_epi32(state0, save0);
+      state1 = _mm_add_epi32(state1, save1);
+    }
+    // ABEF / CDGH -> ABCD / EFGH
+    __m128i feba = _mm_shuffle_epi32(state0, 0x1b);
+    __m128i dchg = _mm_shuffle_epi32(state1, 0xb1);
+    __m128i dcba = _mm_blend_epi16(feba, dchg, 0xf0);
+    __m128i hgfe = _mm_alignr_epi8(dchg, feba, 8);
+    alignas(16) uint32 state[8];
+    _mm_store_si128(reinterpret_cast<__m128i*>(state), dcba);
+    _mm_store_si128(reinterpret_cast<__m128i*>(state + 4), hgfe);
+    store_digest(jobs[k].digest, state);
+  }
+}
+
+#define SHA256MB_AVX2 __attribute__((target("avx2")))
+
+SHA256MB_AVX2 inline __m256i avx2_rotr(__m256i x, int n) {
+  return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+// one block of each of the eight lanes; state[i] holds word i of all lanes
+SHA256MB_AVX2 void compress_avx2(__m256i state[8], const unsigned char* const blocks[8]) {
+  __m256i w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = _mm256_set_epi32(load_be32(blocks[7] + 4 * i), load_be32(blocks[6] + 4 * i), load_be32(blocks[5] + 4 * i),
+                            load_be32(blocks[4] + 4 * i), load_be32(blocks[3] + 4 * i), load_be32(blocks[2] + 4 * i),
+                            load_be32(blocks[1] + 4 * i), load_be32(blocks[0] + 4 * i));
+  }
+  for (int i = 16; i < 64; i++) {
+    __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(avx2_rotr(w[i - 15], 7), avx2_rotr(w[i - 15], 18)),
+                                  _mm256_srli_epi32(w[i - 15], 3));
+    __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(avx2_rotr(w[i - 2], 17), avx2_rotr(w[i - 2], 19)),
+                                  _mm256_srli_epi32(w[i - 2], 10));
+    w[i] = _mm256_add_epi32(_mm256_add_epi32(w[i - 16], s0), _mm256_add_epi32(w[i - 7], s1));
+  }
+  __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+  __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+  for (int i = 0; i < 64; i++) {
+    __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(avx2_rotr(e, 6), avx2_rotr(e, 11)), avx2_rotr(e, 25));
+    __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+    __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, s1),
+                                  _mm256_add_epi32(_mm256_add_epi32(ch, w[i]),
+                                                   _mm256_set1_epi32(static_cast<int>(round_constants[i]))));
+    __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(avx2_rotr(a, 2), avx2_rotr(a, 13)), avx2_rotr(a, 22));
+    __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+    __m256i t2 = _mm256_add_epi32(s0, maj);
+    h = g;
+    g = f;
+    f = e;
+    e = _mm256_add_epi32(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = _mm256_add_epi32(t1, t2);
+  }
+  state[0] = _mm256_add_epi32(state[0], a);
+  state[1] = _mm256_add_epi32(state[1], b);
+  state[2] = _mm256_add_epi32(state[2], c);
+  state[3] = _mm256_add_epi32(state[3], d);
+  state[4] = _mm256_add_epi32(state[4], e);
+  state[5] = _mm256_add_epi32(state[5], f);
+  state[6] = _mm256_add_epi32(state[6], g);
+  state[7] = _mm256_add_epi32(state[7], h);
+}
+
+// Lanes are refilled with the next job as soon as their message is done, so messages of
+// different lengths share the registers without idle lanes. Once fewer than min_lanes
+// messages remain, they are finished one by one.
+SHA256MB_AVX2 void hash_avx2(const Job* jobs, size_t count) {
+  constexpr int lanes = 8;
+  constexpr int min_lanes = 3;
+  static const unsigned char idle_block[64] = {};
+
+  Message msg[lanes];
+  const Job* lane_job[lanes] = {};
+  size_t lane_block[lanes] = {};
+  alignas(32) uint32 words[8][lanes];
+  __m256i state[8];
+  for (int i = 0; i < 8; i++) {
+    state[i] = _mm256_set1_epi32(static_cast<int>(init_state[i]));
+  }
+
+  size_t next = 0;
+  while (true) {
+    int active = 0;
+    bool refilled = false;
+    for (int l = 0; l < lanes; l++) {
+      if (!lane_job[l] && next < count) {
+        if (!refilled) {
+          for (int i = 0; i < 8; i++) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+          }
+          refilled = true;
+        }
+        lane_job[l] = &jobs[next++];
+        lane_block[l] = 0;
+        msg[l].init(*lane_job[l]);
+        for (int i = 0; i < 8; i++) {
+          words[i][l] = init_state[i];
+        }
+      }
+      active += lane_job[l] != nullptr;
+    }
+    if (refilled) {
+      for (int i = 0; i < 8; i++) {
+        state[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(words[i]));
+      }
+    }
+    if (active < min_lanes) {
+      break;
+    }
+
+    const unsigned char* blocks[lanes];
+    for (int l = 0; l < lanes; l++) {
+      blocks[l] = lane_job[l] ? msg[l].block(lane_block[l]) : idle_block;
+    }
+    compress_avx2(state, blocks);
+
+    bool stored = false;
+    for (int l = 0; l < lanes; l++) {
+      if (lane_job[l] && ++lane_block[l] == msg[l].blocks) {
+        if (!stored) {
+          for (int i = 0; i < 8; i++) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+          }
+          stored = true;
+        }
+        uint32 lane_state[8];
+        for (int i = 0; i < 8; i++) {
+          lane_state[i] = words[i][l];
+        }
+        store_digest(lane_job[l]->digest, lane_state);
+        lane_job[l] = nullptr;
+      }
+    }
+  }
+
+  for (int i = 0; i < 8; i++) {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+  }
+  for (int l = 0; l < lanes; l++) {
+    if (!lane_job[l]) {
+      continue;
+    }
+    uint32 lane_state[8];
+    for (int i = 0; i < 8; i++) {
+      lane_state[i] = words[i][l];
+    }
+    for (size_t j = lane_block[l]; j < msg[l].blocks; j++) {
+      compress_generic(lane_state, msg[l].block(j));
+    }
+    store_digest(lane_job[l]->digest, lane_state);
+  }
+}
+#undef SHA256MB_AVX2
+
+bool cpu_has_shani() {
+  unsigned a, b, c, d;
+  if (!__get_cpuid_count(7, 0, &a, &b, &c, &d)) {
+    return false;
+  }
+  return (b & (1u << 29)) != 0 && __builtin_cpu_supports("sse4.1");
+}
+
+bool cpu_has_avx2() {
+  return __builtin_cpu_supports("avx2");
+}
+#endif
+
+Backend detect_backend() {
+  if (is_supported(Backend::ShaNi)) {
+    return Backend::ShaNi;
+  }
+  if (is_supported(Backend::Avx2)) {
+    return Backend::Avx2;
+  }
+  return Backend::Generic;
+}
+}  // namespace
+
+bool is_supported(Backend backend) {
+  switch (backend) {
+    case Backend::Auto:
+    case Backend::Generic:
+      return true;
+#if TON_SHA256MB_X86
+    case Backend::ShaNi: {
+      static const bool res = cpu_has_shani();
+      return res;
+    }
+    case Backend::Avx2: {
+      static const bool res = cpu_has_avx2();
+      return res;
+    }
+#endif
+    default:
+      return false;
+  }
+}
+
+Backend get_backend() {
+  static const Backend backend = detect_backend();
+  return backend;
+}
+
+const char* backend_name(Backend backend) {
+  switch (backend) {
+    case Backend::Auto:
+      return backend_name(get_backend());
+    case Backend::Generic:
+      return "generic";
+    case Backend::ShaNi:
+      return "sha-ni";
+    case Backend::Avx2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+void hash(const Job* jobs, size_t count, Backend backend) {
+  CHECK(is_supported(backend));
+  switch (backend) {
+#if TON_SHA256MB_X86
+    case Backend::ShaNi:
+      hash_shani(jobs, count);
+      return;
+    case Backend::Avx2:
+      hash_avx2(jobs, count);
+      return;
+#endif
+    case Backend::Generic:
+      hash_generic(jobs, count);
+      return;
+    default:
+      hash(jobs, count);
+      return;
+  }
+}
+
+void hash(const Job* jobs, size_t count) {
+  auto backend = get_backend();
+  // Only real batches are worth the multi-buffer code, a few messages (e.g. a single new cell) and CPUs without
+  // x86 extensions are served by OpenSSL, which uses the hardware SHA instructions of other architectures
+  if (backend == Backend::ShaNi || (backend == Backend::Avx2 && count >= 4)) {
+    hash(jobs, count, backend);
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    sha256(Slice(jobs[i].data, jobs[i].size), MutableSlice(jobs[i].digest, 32));
+  }
+}
+
+}  // namespace sha256mb
+}  // namespace td
@@ -0,0 +1,47 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include <cstddef>
+
+namespace td {
+namespace sha256mb {
+
+// Multi-buffer SHA-256 for many small independent messages (cell representations).
+// The backend is chosen once at runtime from the CPU features:
+//   ShaNi   - x86 SHA extensions, one message at a time
+//   Avx2    - eight messages in the lanes of 256-bit registers
+//   Generic - portable implementation
+// Without ShaNi, batches of less than four messages and all messages on CPUs without these extensions
+// are hashed by td::sha256 (OpenSSL).
+enum class Backend { Auto, Generic, ShaNi, Avx2 };
+
+struct Job {
+  const unsigned char* data;
+  std::size_t size;
+  unsigned char* digest;  // 32 bytes
+};
+
+void hash(const Job* jobs, std::size_t count);
+// forces the backend, which must be supported; for tests and benchmarks
+void hash(const Job* jobs, std::size_t count, Backend backend);
+
+bool is_supported(Backend backend);
+Backend get_backend();
+const char* backend_name(Backend backend);
+
+}  // namespace sha256mb
+}  // namespace td
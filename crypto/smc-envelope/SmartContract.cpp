@@ -222,9 +222,14 @@ SmartContract::Answer run_smartcont(SmartContract::State state, td::Ref<vm::Stac
     stack->dump(os, 2);
     LOG(DEBUG) << "VM stack:\n" << os.str();
   }
+  std::unique_ptr<vm::CellArena> cell_arena;
+  if (vm::CellArena::is_enabled()) {
+    cell_arena = std::make_unique<vm::CellArena>();
+  }
   vm::VmState vm{state.code, std::move(stack), gas, 1, state.data, log};
   vm.set_c7(std::move(c7));
   vm.set_chksig_always_succeed(ignore_chksig);
+  vm.set_cell_arena(cell_arena.get());
   if (!libraries.is_null()) {
     vm.register_library_collection(libraries);
   }
@@ -346,6 +351,10 @@ SmartContract::Answer SmartContract::run_get_method(Args args) const {
                        args.vm_log_verbosity_level, args.debug_enabled, args.config ? args.config.value() : nullptr);
 }
 
+td::Ref<vm::Tuple> SmartContract::prepare_c7(const Args& args) const {
+  return prepare_vm_c7(args, state_.code);
+}
+
 SmartContract::Answer SmartContract::run_get_method(td::Slice method, Args args) const {
   return run_get_method(args.set_method_id(method));
 }
@@ -164,6 +164,8 @@ class SmartContract : public td::CntObject {
   Answer run_get_method(td::Slice method, Args args = {}) const;
   Answer send_external_message(td::Ref<vm::Cell> cell, Args args = {});
   Answer send_internal_message(td::Ref<vm::Cell> cell, Args args = {});
+  // c7 that run_get_method builds from args; can be prepared once and reused with Args::set_c7
+  td::Ref<vm::Tuple> prepare_c7(const Args& args) const;
 
   size_t code_size() const;
   size_t data_size() const;
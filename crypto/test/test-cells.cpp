@@ -33,10 +33,14 @@
 #include "common/util.h"
 #include "vm/cells.h"
 #include "vm/cellslice.h"
+#include "vm/dict.h"
+#include "vm/cells/CellArena.h"
 
 #include "td/utils/tests.h"
 #include "td/utils/crypto.h"
 #include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/Span.h"
 
 static std::stringstream create_ss() {
   std::stringstream ss;
@@ -654,3 +658,103 @@ TEST(uint64_exp, main) {
   }
   REGRESSION_VERIFY(os.str());
 }
+
+TEST(Dictionary, batch) {
+  td::Random::Xorshift128plus rnd(123);
+  const int n = 16;
+  auto make_value = [&](td::uint64 x) {
+    vm::CellBuilder cb;
+    cb.store_long(x, 64);
+    return vm::load_cell_slice_ref(cb.finalize());
+  };
+  for (int iter = 0; iter < 100; iter++) {
+    std::vector<td::BitArray<n>> keys(rnd.fast(1, 300));
+    for (auto& key : keys) {
+      key.bits().store_uint(rnd.fast(0, 1023) << rnd.fast(0, 6), n);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    vm::Dictionary dict1{n}, dict2{n};
+    for (auto& key : keys) {
+      if (rnd.fast(0, 1)) {
+        CHECK(dict1.set(key, make_value(rnd())));
+      }
+    }
+    dict2 = dict1;
+
+    std::vector<td::ConstBitPtr> lookup_keys;
+    for (auto& key : keys) {
+      lookup_keys.push_back(key.cbits());
+      lookup_keys.push_back(key.cbits());
+    }
+    auto found = dict1.lookup_batch(lookup_keys, n);
+    CHECK(found.size() == lookup_keys.size());
+    for (std::size_t i = 0; i < lookup_keys.size(); i++) {
+      auto expected = dict1.lookup(lookup_keys[i], n);
+      CHECK(expected.is_null() == found[i].is_null());
+      CHECK(expected.is_null() || expected->contents_equal(*found[i]));
+    }
+
+    std::vector<vm::DictionaryFixed::BatchOp> ops;
+    for (auto& key : keys) {
+      if (rnd.fast(0, 2)) {
+        continue;
+      }
+      bool exists = dict1.key_exists(key);
+      vm::DictionaryFixed::BatchOp op{key.cbits()};
+      if (exists && rnd.fast(0, 1)) {
+        CHECK(dict1.lookup_delete(key).not_null());
+      } else {
+        op.value = make_value(rnd());
+        op.mode = exists ? vm::Dictionary::SetMode::Replace : vm::Dictionary::SetMode::Add;
+        CHECK(dict1.set(key, op.value, op.mode));
+      }
+      ops.push_back(std::move(op));
+    }
+    td::random_shuffle(td::as_mutable_span(ops), rnd);
+    auto orig_root = dict2.get_root_cell();
+    if (!ops.empty() && ops[0].value.not_null()) {
+      // an operation violating its mode makes the whole batch fail
+      auto bad_ops = ops;
+      bad_ops[0].mode =
+          bad_ops[0].mode == vm::Dictionary::SetMode::Add ? vm::Dictionary::SetMode::Replace : vm::Dictionary::SetMode::Add;
+      CHECK(!dict2.apply_batch(std::move(bad_ops), n));
+      CHECK(dict2.get_root_cell().get() == orig_root.get());
+    }
+    CHECK(dict2.apply_batch(std::move(ops), n));
+    CHECK(dict1.is_empty() == dict2.is_empty());
+    CHECK(dict1.is_empty() || dict1.get_root_cell()->get_hash() == dict2.get_root_cell()->get_hash());
+  }
+}
+
+TEST(Cells, arena) {
+  auto cells_before = vm::DataCell::get_total_data_cells();
+  std::vector<td::Ref<vm::Cell>> escaped;
+  {
+    vm::CellArena arena{1 << 10};
+    vm::CellArenaScope scope{&arena};
+    td::Ref<vm::Cell> prev;
+    for (int i = 0; i < 1000; i++) {
+      vm::CellBuilder cb;
+      cb.store_long(i, 32);
+      if (prev.not_null()) {
+        cb.store_ref(prev);
+      }
+      prev = cb.finalize();
+      if (i % 100 == 0) {
+        escaped.push_back(prev);
+      }
+    }
+    CHECK(arena.get_stats().allocs == 1000);
+    CHECK(arena.get_stats().chunks > 1);
+  }
+  CHECK(vm::CellArena::current() == nullptr);
+  // cells created in the scope outlive the arena
+  for (std::size_t i = 0; i < escaped.size(); i++) {
+    auto cs = vm::load_cell_slice(escaped[i]);
+    CHECK(cs.fetch_ulong(32) == i * 100);
+    CHECK(escaped[i]->get_depth() == i * 100);
+  }
+  escaped.clear();
+  CHECK(vm::DataCell::get_total_data_cells() == cells_before);
+}
@@ -20,6 +20,7 @@
 #include "vm/cellslice.h"
 #include "vm/cells.h"
 #include "common/AtomicRef.h"
+#include "common/sha256mb.h"
 #include "vm/cells/CellString.h"
 #include "vm/cells/MerkleProof.h"
 #include "vm/cells/MerkleUpdate.h"
@@ -269,6 +270,35 @@ class BenchSha256Tdlib : public BenchSha {
   }
 };
 
+class BenchSha256Multi : public BenchSha {
+ public:
+  BenchSha256Multi(size_t n, td::sha256mb::Backend backend, size_t batch_size)
+      : BenchSha(n), backend_(backend), batch_size_(batch_size) {
+  }
+
+  std::string get_name() const override {
+    return PSTRING() << "SHA256 multi-buffer " << td::sha256mb::backend_name(backend_) << " batch=" << batch_size_;
+  }
+
+  void run(int n) override {
+    int res = 0;
+    std::vector<unsigned char> buf(batch_size_ * 32);
+    std::vector<td::sha256mb::Job> jobs(batch_size_);
+    for (size_t i = 0; i < batch_size_; i++) {
+      jobs[i] = td::sha256mb::Job{td::Slice(str_).ubegin(), str_.size(), buf.data() + 32 * i};
+    }
+    for (int i = 0; i < n; i += static_cast<int>(batch_size_)) {
+      td::sha256mb::hash(jobs.data(), batch_size_, backend_);
+      res += buf[0];
+    }
+    td::do_not_optimize_away(res);
+  }
+
+ private:
+  td::sha256mb::Backend backend_;
+  size_t batch_size_;
+};
+
 template <class F>
 void bench_threaded(F &&f) {
   class Threaded : public td::Benchmark {
@@ -314,6 +344,36 @@ TEST(Cell, sha_benchmark) {
     bench(BenchSha256Low(n));
     bench(BenchSha256Reuse(n));
     bench(BenchSha256(n));
+    for (auto backend : {td::sha256mb::Backend::Generic, td::sha256mb::Backend::ShaNi, td::sha256mb::Backend::Avx2}) {
+      if (!td::sha256mb::is_supported(backend)) {
+        continue;
+      }
+      for (size_t batch_size : {1, 8, 64}) {
+        bench(BenchSha256Multi(n, backend, batch_size));
+      }
+    }
+  }
+}
+TEST(Cell, sha256mb) {
+  td::Random::Xorshift128plus rnd(123);
+  for (auto backend : {td::sha256mb::Backend::Generic, td::sha256mb::Backend::ShaNi, td::sha256mb::Backend::Avx2}) {
+    if (!td::sha256mb::is_supported(backend)) {
+      continue;
+    }
+    for (int t = 0; t < 100; t++) {
+      size_t count = rnd.fast(0, 40);
+      std::vector<std::string> data(count);
+      std::vector<unsigned char> digests(count * 32);
+      std::vector<td::sha256mb::Job> jobs(count);
+      for (size_t i = 0; i < count; i++) {
+        data[i] = td::rand_string(0, 255, rnd.fast(0, 300));
+        jobs[i] = td::sha256mb::Job{td::Slice(data[i]).ubegin(), data[i].size(), digests.data() + 32 * i};
+      }
+      td::sha256mb::hash(jobs.data(), count, backend);
+      for (size_t i = 0; i < count; i++) {
+        ASSERT_EQ(td::sha256(data[i]), td::Slice(digests.data() + 32 * i, 32));
+      }
+    }
   }
 }
 TEST(Cell, sha_benchmark_threaded) {
@@ -643,6 +703,27 @@ TEST(Cell, MerkleProof) {
   }
 };
 
+TEST(Cell, MerkleProofBuilder) {
+  td::Random::Xorshift128plus rnd{123};
+  for (int t = 0; t < 1000; t++) {
+    auto cell = gen_random_cell(rnd.fast(1, 1000), rnd, true);
+    MerkleProofBuilder mpb{cell};
+    for (int i = 0; i < 3; i++) {
+      auto exploration = CellExplorer::random_explore(cell, rnd);
+      auto exploration2 = CellExplorer::explore(mpb.root(), exploration.ops);
+      ASSERT_EQ(exploration.log, exploration2.log);
+
+      auto is_prunned = [&](const Ref<Cell> &cell) { return exploration.visited.count(cell->get_hash()) == 0; };
+      auto proof = MerkleProof::generate(cell, is_prunned);
+      auto proof2 = mpb.extract_proof().move_as_ok();
+      ASSERT_EQ(proof->get_hash(), proof2->get_hash());
+      auto exploration3 = CellExplorer::explore(MerkleProof::virtualize(proof2, 1), exploration.ops);
+      ASSERT_EQ(exploration.log, exploration3.log);
+      mpb.restart();
+    }
+  }
+};
+
 TEST(Cell, MerkleProofCombine) {
   td::Random::Xorshift128plus rnd{123};
   for (int t = 0; t < 1000; t++) {
@@ -764,6 +845,22 @@ TEST(Cell, MerkleUpdate) {
   }
 };
 
+TEST(Cell, MerkleUpdateParallel) {
+  td::Random::Xorshift128plus rnd{123};
+  MerkleUpdate::set_extra_threads(3);
+  SCOPE_EXIT {
+    MerkleUpdate::set_extra_threads(0);
+  };
+  for (int t = 0; t < 100; t++) {
+    auto A = gen_random_cell(rnd.fast(1, 1000), rnd, true);
+
+    Ref<Cell> B;
+    Ref<Cell> AB;
+    std::tie(B, AB, std::ignore) = gen_merkle_update(A, rnd, true);
+    check_merkle_update(A, B, AB);
+  }
+};
+
 TEST(Cell, MerkleUpdateCombine) {
   td::Random::Xorshift128plus rnd{123};
   for (int t = 0; t < 1000; t++) {
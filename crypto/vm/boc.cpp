@@ -89,14 +89,22 @@ td::Result<int> CellSerializationInfo::get_bits(td::Slice cell) const {
 // TODO: check usage when result is empty
 td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell_slice,
                                                                   td::Span<Ref<Cell>> refs) const {
-  CellBuilder cb;
+  TRY_RESULT(res, create_data_cell_unhashed(cell_slice, refs));
+  DataCell::finalize_hashes(td::Span<Ref<DataCell>>(&res, 1));
+  TRY_STATUS(check_hashes(cell_slice, res));
+  return res;
+}
+
+td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell_unhashed(td::Slice cell_slice,
+                                                                           td::Span<Ref<Cell>> refs) const {
   TRY_RESULT(bits, get_bits(cell_slice));
-  cb.store_bits(cell_slice.ubegin() + data_offset, bits);
   DCHECK(refs_cnt == (td::int64)refs.size());
+  std::array<Ref<Cell>, Cell::max_refs> refs_buf;
   for (int k = 0; k < refs_cnt; k++) {
-    cb.store_ref(std::move(refs[k]));
+    refs_buf[k] = refs[k];
   }
-  TRY_RESULT(res, cb.finalize_novm_nothrow(special));
+  TRY_RESULT(res, DataCell::create_unhashed(td::ConstBitPtr{cell_slice.ubegin() + data_offset}, bits,
+                                            td::MutableSpan<Ref<Cell>>(refs_buf.data(), refs_cnt), special));
   CHECK(!res.is_null());
   if (res->is_special() != special) {
     return td::Status::Error("is_special mismatch");
@@ -104,7 +112,10 @@ td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell
   if (res->get_level_mask() != level_mask) {
     return td::Status::Error("level mask mismatch");
   }
-  //return res;
+  return res;
+}
+
+td::Status CellSerializationInfo::check_hashes(td::Slice cell_slice, const Ref<DataCell>& res) const {
   if (with_hashes) {
     auto hash_n = level_mask.get_hashes_count();
     if (res->get_hash().as_slice() !=
@@ -136,7 +147,7 @@ td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell
       hash_i++;
     }
   }
-  return res;
+  return td::Status::OK();
 }
 
 void BagOfCells::clear() {
@@ -764,19 +775,16 @@ td::Result<td::Slice> BagOfCells::get_cell_slice(int idx, td::Slice data) {
   return data.substr(offs, td::narrow_cast<size_t>(offs_end - offs));
 }
 
-td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slice cells_slice,
-                                                               td::Span<td::Ref<DataCell>> cells_span,
-                                                               std::vector<td::uint8>* cell_should_cache) {
+td::Result<int> BagOfCells::get_cell_height(int idx, td::Slice cells_slice, td::Span<td::uint16> heights,
+                                            std::vector<td::uint8>* cell_should_cache) {
   TRY_RESULT(cell_slice, get_cell_slice(idx, cells_slice));
-  std::array<td::Ref<Cell>, 4> refs_buf;
-
   CellSerializationInfo cell_info;
   TRY_STATUS(cell_info.init(cell_slice, info.ref_byte_size));
   if (cell_info.end_offset != cell_slice.size()) {
     return td::Status::Error("unused space in cell serialization");
   }
 
-  auto refs = td::MutableSpan<td::Ref<Cell>>(refs_buf).substr(0, cell_info.refs_cnt);
+  int height = 0;
   for (int k = 0; k < cell_info.refs_cnt; k++) {
     int ref_idx = (int)info.read_ref(cell_slice.ubegin() + cell_info.refs_offset + k * info.ref_byte_size);
     if (ref_idx <= idx) {
@@ -788,7 +796,7 @@ td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slic
                                         << " is to non-existent cell #" << ref_idx << ", only " << cell_count
                                         << " cells are defined");
     }
-    refs[k] = cells_span[cell_count - ref_idx - 1];
+    height = std::max(height, heights[cell_count - ref_idx - 1] + 1);
     if (cell_should_cache) {
       auto& cnt = (*cell_should_cache)[ref_idx];
       if (cnt < 2) {
@@ -796,8 +804,28 @@ td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slic
       }
     }
   }
+  // the depth of a cell is never less than its height
+  if (height > Cell::max_depth) {
+    return td::Status::Error("Depth is too big");
+  }
+  return height;
+}
 
-  return cell_info.create_data_cell(cell_slice, refs);
+// returns a cell without hashes, see DataCell::create_unhashed; references are checked by get_cell_height
+td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slice cells_slice,
+                                                               td::Span<td::Ref<DataCell>> cells_span,
+                                                               CellSerializationInfo& cell_info) {
+  TRY_RESULT(cell_slice, get_cell_slice(idx, cells_slice));
+  std::array<td::Ref<Cell>, 4> refs_buf;
+  TRY_STATUS(cell_info.init(cell_slice, info.ref_byte_size));
+
+  auto refs = td::MutableSpan<td::Ref<Cell>>(refs_buf).substr(0, cell_info.refs_cnt);
+  for (int k = 0; k < cell_info.refs_cnt; k++) {
+    int ref_idx = (int)info.read_ref(cell_slice.ubegin() + cell_info.refs_offset + k * info.ref_byte_size);
+    refs[k] = cells_span[cell_count - ref_idx - 1];
+  }
+
+  return cell_info.create_data_cell_unhashed(cell_slice, refs);
 }
 
 td::Result<long long> BagOfCells::deserialize(const td::Slice& data, int max_roots) {
@@ -882,19 +910,69 @@ td::Result<long long> BagOfCells::deserialize(const td::Slice& data, int max_roo
     }
   }
   auto cells_slice = data.substr(info.data_offset, info.data_size);
-  std::vector<Ref<DataCell>> cell_list;
-  cell_list.reserve(cell_count);
-  std::array<td::Ref<Cell>, 4> refs_buf;
+  // cells are created height by height (leaves first): cells of the same height cannot reference
+  // each other, so their hashes are computed together by DataCell::finalize_hashes
+  std::vector<td::uint16> heights(cell_count);
+  int max_height = 0;
   for (int i = 0; i < cell_count; i++) {
-    // reconstruct cell with index cell_count - 1 - i
+    // cell with index cell_count - 1 - i
     int idx = cell_count - 1 - i;
-    auto r_cell = deserialize_cell(idx, cells_slice, cell_list, info.has_cache_bits ? &cell_should_cache : nullptr);
-    if (r_cell.is_error()) {
+    auto r_height = get_cell_height(idx, cells_slice, heights, info.has_cache_bits ? &cell_should_cache : nullptr);
+    if (r_height.is_error()) {
       return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
-                                        << r_cell.error());
+                                        << r_height.error());
+    }
+    heights[i] = static_cast<td::uint16>(r_height.ok());
+    max_height = std::max(max_height, r_height.ok());
+  }
+  std::vector<int> height_begin(max_height + 2, 0);
+  for (auto height : heights) {
+    height_begin[height + 1]++;
+  }
+  for (int height = 0; height <= max_height; height++) {
+    height_begin[height + 1] += height_begin[height];
+  }
+  std::vector<int> order(cell_count);
+  {
+    auto pos = height_begin;
+    for (int i = 0; i < cell_count; i++) {
+      order[pos[heights[i]]++] = i;
+    }
+  }
+  heights.clear();
+
+  std::vector<Ref<DataCell>> cell_list(cell_count);
+  std::vector<Ref<DataCell>> batch;
+  std::vector<CellSerializationInfo> batch_info;
+  for (int height = 0; height <= max_height; height++) {
+    batch.clear();
+    batch_info.resize(height_begin[height + 1] - height_begin[height]);
+    for (int j = height_begin[height]; j < height_begin[height + 1]; j++) {
+      // reconstruct cell with index cell_count - 1 - i
+      int i = order[j];
+      int idx = cell_count - 1 - i;
+      auto r_cell = deserialize_cell(idx, cells_slice, cell_list, batch_info[batch.size()]);
+      if (r_cell.is_error()) {
+        return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
+                                          << r_cell.error());
+      }
+      batch.push_back(r_cell.move_as_ok());
+      DCHECK(batch.back().not_null());
+    }
+    DataCell::finalize_hashes(batch);
+    for (int j = height_begin[height]; j < height_begin[height + 1]; j++) {
+      int i = order[j];
+      int idx = cell_count - 1 - i;
+      auto k = j - height_begin[height];
+      if (batch_info[k].with_hashes) {
+        auto status = batch_info[k].check_hashes(get_cell_slice(idx, cells_slice).move_as_ok(), batch[k]);
+        if (status.is_error()) {
+          return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
+                                            << status);
+        }
+      }
+      cell_list[i] = std::move(batch[k]);
     }
-    cell_list.push_back(r_cell.move_as_ok());
-    DCHECK(cell_list.back().not_null());
   }
   if (info.has_cache_bits) {
     for (int idx = 0; idx < cell_count; idx++) {
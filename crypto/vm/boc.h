@@ -199,6 +199,9 @@ struct CellSerializationInfo {
   td::Result<int> get_bits(td::Slice cell) const;
 
   td::Result<Ref<DataCell>> create_data_cell(td::Slice data, td::Span<Ref<Cell>> refs) const;
+  // for batched hashing, see DataCell::create_unhashed
+  td::Result<Ref<DataCell>> create_data_cell_unhashed(td::Slice data, td::Span<Ref<Cell>> refs) const;
+  td::Status check_hashes(td::Slice data, const Ref<DataCell>& cell) const;
 };
 
 class BagOfCellsLogger {
@@ -377,8 +380,10 @@ class BagOfCells {
   unsigned long long get_idx_entry(int index);
   bool get_cache_entry(int index);
   td::Result<td::Slice> get_cell_slice(int index, td::Slice data);
+  td::Result<int> get_cell_height(int index, td::Slice data, td::Span<td::uint16> heights,
+                                  std::vector<td::uint8>* cell_should_cache);
   td::Result<td::Ref<vm::DataCell>> deserialize_cell(int index, td::Slice data, td::Span<td::Ref<DataCell>> cells,
-                                                     std::vector<td::uint8>* cell_should_cache);
+                                                     CellSerializationInfo& cell_info);
 };
 
 td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty = false, bool allow_nonzero_level = false);
@@ -0,0 +1,77 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "vm/cells/CellArena.h"
+
+#include "td/utils/logging.h"
+
+#include <new>
+
+namespace vm {
+
+thread_local CellArena* CellArena::current_ = nullptr;
+std::atomic<bool> CellArena::enabled_{false};
+
+struct CellArena::Chunk {
+  // one reference is held by the arena while it allocates from the chunk, one by each live allocation
+  std::atomic<td::uint64> refcnt{1};
+
+  void release() {
+    if (refcnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      this->~Chunk();
+      ::operator delete(static_cast<void*>(this));
+    }
+  }
+};
+
+CellArena::~CellArena() {
+  if (chunk_) {
+    chunk_->release();
+  }
+}
+
+void CellArena::new_chunk(size_t min_size) {
+  if (chunk_) {
+    chunk_->release();
+  }
+  size_t size = td::max(chunk_size_, min_size + sizeof(Chunk));
+  void* ptr = ::operator new(size);
+  chunk_ = new (ptr) Chunk();
+  begin_ = static_cast<char*>(ptr) + sizeof(Chunk);
+  end_ = static_cast<char*>(ptr) + size;
+  stats_.chunks++;
+}
+
+void* CellArena::alloc(size_t size) {
+  // every allocation is prefixed with a pointer to its chunk, which is used by free()
+  size_t total = sizeof(Chunk*) + (size + 7) / 8 * 8;
+  if (static_cast<size_t>(end_ - begin_) < total) {
+    new_chunk(total);
+  }
+  auto* header = reinterpret_cast<Chunk**>(begin_);
+  *header = chunk_;
+  chunk_->refcnt.fetch_add(1, std::memory_order_relaxed);
+  begin_ += total;
+  stats_.allocs++;
+  stats_.bytes += total;
+  return header + 1;
+}
+
+void CellArena::free(void* ptr) {
+  reinterpret_cast<Chunk**>(ptr)[-1]->release();
+}
+
+}  // namespace vm
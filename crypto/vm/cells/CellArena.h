@@ -0,0 +1,99 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <atomic>
+
+namespace vm {
+
+// Bump allocator for cells created by short-lived work, whose results are serialized and discarded
+// (get-method runs).
+// Cells are allocated from chunks; every chunk counts the live cells allocated from it and is freed when the last
+// of them dies and the arena has moved to another chunk (or has been destroyed). Cells that outlive the arena
+// thus stay valid, they only keep their chunk allocated, so arenas must not be used where cells are kept for long
+// (e.g. new shard states of collation and validation).
+// An arena is used by one thread at a time; cells allocated from it may be freed by any thread.
+class CellArena {
+ public:
+  static constexpr size_t default_chunk_size = 1 << 16;
+
+  struct Stats {
+    td::uint64 allocs{0};
+    td::uint64 bytes{0};
+    td::uint64 chunks{0};
+  };
+
+  explicit CellArena(size_t chunk_size = default_chunk_size) : chunk_size_(chunk_size) {
+  }
+  CellArena(const CellArena&) = delete;
+  CellArena& operator=(const CellArena&) = delete;
+  ~CellArena();
+
+  void* alloc(size_t size);
+  static void free(void* ptr);
+
+  const Stats& get_stats() const {
+    return stats_;
+  }
+
+  // arena used by DataCell::create() in the current thread (nullptr - allocate cells on the heap)
+  static CellArena* current() {
+    return current_;
+  }
+
+  // arenas are created by get-method runs only when enabled
+  static void set_enabled(bool value) {
+    enabled_.store(value, std::memory_order_relaxed);
+  }
+  static bool is_enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Chunk;
+  size_t chunk_size_;
+  Chunk* chunk_{nullptr};
+  char* begin_{nullptr};
+  char* end_{nullptr};
+  Stats stats_;
+
+  void new_chunk(size_t min_size);
+
+  static thread_local CellArena* current_;
+  static std::atomic<bool> enabled_;
+  friend class CellArenaScope;
+};
+
+// Makes cells created in the current thread come from `arena` until the end of the scope
+class CellArenaScope {
+ public:
+  explicit CellArenaScope(CellArena* arena) : prev_(CellArena::current_) {
+    CellArena::current_ = arena;
+  }
+  CellArenaScope(const CellArenaScope&) = delete;
+  CellArenaScope& operator=(const CellArenaScope&) = delete;
+  ~CellArenaScope() {
+    CellArena::current_ = prev_;
+  }
+
+ private:
+  CellArena* prev_;
+};
+
+}  // namespace vm
@@ -18,11 +18,15 @@
 */
 #include "vm/cells/DataCell.h"
 
-#include "openssl/digest.hpp"
+#include "common/sha256mb.h"
 
 #include "td/utils/ScopeGuard.h"
+#include "td/utils/crypto.h"
+
+#include <cstring>
 
 #include "vm/cells/CellWithStorage.h"
+#include "vm/cells/CellArena.h"
 
 namespace vm {
 thread_local bool DataCell::use_arena = false;
@@ -53,6 +57,26 @@ private:
     return res;
   }
 };
+
+// cell allocated from a CellArena, its memory is returned to the arena chunk on deletion
+template <class T>
+class CellArenaCell final : public T {
+ public:
+  using T::T;
+  static void operator delete(void* ptr) {
+    CellArena::free(ptr);
+  }
+};
+
+template <class CellT>
+struct CellArenaAllocator {
+  CellArena* arena;
+  template <class T, class... ArgsT>
+  std::unique_ptr<CellT> make_unique(ArgsT&&... args) {
+    void* ptr = arena->alloc(sizeof(CellArenaCell<T>));
+    return std::unique_ptr<CellT>(new (ptr) CellArenaCell<T>(std::forward<ArgsT>(args)...));
+  }
+};
 }
 std::unique_ptr<DataCell> DataCell::create_empty_data_cell(Info info) {
   if (use_arena) {
@@ -62,6 +86,10 @@ std::unique_ptr<DataCell> DataCell::create_empty_data_cell(Info info) {
     Ref<DataCell>(res.get()).release();
     return res;
   }
+  if (auto* arena = CellArena::current()) {
+    return detail::CellWithArrayStorage<DataCell>::create(CellArenaAllocator<DataCell>{arena},
+                                                          info.get_storage_size(), info);
+  }
 
   return detail::CellWithUniquePtrStorage<DataCell>::create(info.get_storage_size(), info);
 }
@@ -97,8 +125,8 @@ DataCell::SpecialType DataCell::special_type() const {
   return SpecialType::Ordinary;
 }
 
-td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
-                                           bool special) {
+td::Result<Ref<DataCell>> DataCell::create_unhashed(td::ConstBitPtr data, unsigned bits,
+                                                    td::MutableSpan<Ref<Cell>> refs, bool special) {
   for (auto& ref : refs) {
     if (ref.is_null()) {
       return td::Status::Error("Has null cell reference");
@@ -247,8 +275,7 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
     refs_ptr[i] = refs[i].release();
   }
 
-  // init hashes and depth
-  auto* hashes_ptr = info.get_hashes(storage);
+  // init depth, hashes are computed by finalize_hashes()
   auto* depth_ptr = info.get_depth(storage);
 
   // NB: be careful with special cells
@@ -264,24 +291,6 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
     if (hash_i < hash_i_offset) {
       continue;
     }
-    unsigned char tmp[2];
-    tmp[0] = info.d1(level_mask.apply(level_i));
-    tmp[1] = info.d2();
-
-    static TD_THREAD_LOCAL digest::SHA256* hasher;
-    td::init_thread_local<digest::SHA256>(hasher);
-    hasher->reset();
-
-    hasher->feed(td::Slice(tmp, 2));
-
-    if (hash_i == hash_i_offset) {
-      DCHECK(level_i == 0 || type == SpecialType::PrunnedBranch);
-      hasher->feed(td::Slice(data_ptr, (bits + 7) >> 3));
-    } else {
-      DCHECK(level_i != 0 && type != SpecialType::PrunnedBranch);
-      hasher->feed(hashes_ptr[hash_i - hash_i_offset - 1].as_slice());
-    }
-
     auto dest_i = hash_i - hash_i_offset;
 
     // calc depth
@@ -293,12 +302,6 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
       } else {
         child_depth = refs_ptr[i]->get_depth(level_i);
       }
-
-      // add depth into hash
-      td::uint8 child_depth_buf[depth_bytes];
-      store_depth(child_depth_buf, child_depth);
-      hasher->feed(td::Slice(child_depth_buf, depth_bytes));
-
       depth = std::max(depth, child_depth);
     }
     if (info.refs_count_ != 0) {
@@ -308,20 +311,102 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
       depth++;
     }
     depth_ptr[dest_i] = depth;
+  }
 
-    // children hash
-    for (int i = 0; i < info.refs_count_; i++) {
-      if (type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate) {
-        hasher->feed(refs_ptr[i]->get_hash(level_i + 1).as_slice());
-      } else {
-        hasher->feed(refs_ptr[i]->get_hash(level_i).as_slice());
+  return Ref<DataCell>(data_cell.release(), Ref<DataCell>::acquire_t{});
+}
+
+size_t DataCell::get_hash_input(unsigned dest_i, unsigned char* buff) const {
+  auto* storage = get_storage();
+  auto level_mask = get_level_mask();
+  auto type = special_type();
+  auto hash_i_offset = level_mask.get_hashes_count() - info_.hash_count_;
+  td::uint32 level_i = 0;
+  for (td::uint32 hash_i = 0;; level_i++) {
+    if (level_mask.is_significant(level_i) && hash_i++ == hash_i_offset + dest_i) {
+      break;
+    }
+  }
+
+  auto* ptr = buff;
+  *ptr++ = info_.d1(level_mask.apply(level_i));
+  *ptr++ = info_.d2();
+
+  if (dest_i == 0) {
+    DCHECK(level_i == 0 || type == SpecialType::PrunnedBranch);
+    auto size = (info_.bits_ + 7) >> 3;
+    std::memcpy(ptr, info_.get_data(storage), size);
+    ptr += size;
+  } else {
+    DCHECK(level_i != 0 && type != SpecialType::PrunnedBranch);
+    std::memcpy(ptr, info_.get_hashes(storage)[dest_i - 1].as_slice().data(), hash_bytes);
+    ptr += hash_bytes;
+  }
+
+  auto child_level = level_i;
+  if (type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate) {
+    child_level++;
+  }
+  auto* refs_ptr = info_.get_refs(storage);
+  for (int i = 0; i < info_.refs_count_; i++) {
+    store_depth(ptr, refs_ptr[i]->get_depth(child_level));
+    ptr += depth_bytes;
+  }
+  for (int i = 0; i < info_.refs_count_; i++) {
+    std::memcpy(ptr, refs_ptr[i]->get_hash(child_level).as_slice().data(), hash_bytes);
+    ptr += hash_bytes;
+  }
+  return ptr - buff;
+}
+
+void DataCell::finalize_hashes(td::Span<Ref<DataCell>> cells) {
+  constexpr size_t max_hash_input = 2 + max_bytes + max_refs * (depth_bytes + hash_bytes);
+  if (cells.size() == 1) {
+    // a single new cell (every CellBuilder::finalize) does not need the batch buffers
+    auto& cell = const_cast<DataCell&>(*cells[0]);
+    unsigned char buff[max_hash_input];
+    for (unsigned dest_i = 0; dest_i < cell.info_.hash_count_; dest_i++) {
+      auto size = cell.get_hash_input(dest_i, buff);
+      td::sha256(td::Slice(buff, size), cell.info_.get_hashes(cell.get_storage())[dest_i].as_slice());
+    }
+    return;
+  }
+  constexpr size_t batch_size = 64;
+  unsigned char buff[batch_size][max_hash_input];
+  td::sha256mb::Job jobs[batch_size];
+  size_t cnt = 0;
+  auto flush = [&] {
+    td::sha256mb::hash(jobs, cnt);
+    cnt = 0;
+  };
+  // higher level hashes of a cell include its lower level hashes, so they go in separate rounds
+  for (unsigned dest_i = 0; dest_i <= max_level; dest_i++) {
+    bool found = false;
+    for (auto& ref : cells) {
+      auto& cell = const_cast<DataCell&>(*ref);
+      if (dest_i >= cell.info_.hash_count_) {
+        continue;
+      }
+      found = true;
+      auto size = cell.get_hash_input(dest_i, buff[cnt]);
+      auto* digest = cell.info_.get_hashes(cell.get_storage())[dest_i].as_slice().ubegin();
+      jobs[cnt] = td::sha256mb::Job{buff[cnt], size, digest};
+      if (++cnt == batch_size) {
+        flush();
       }
     }
-    auto extracted_size = hasher->extract(hashes_ptr[dest_i].as_slice());
-    DCHECK(extracted_size == hash_bytes);
+    if (!found) {
+      break;
+    }
+    flush();
   }
+}
 
-  return Ref<DataCell>(data_cell.release(), Ref<DataCell>::acquire_t{});
+td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
+                                           bool special) {
+  TRY_RESULT(cell, create_unhashed(std::move(data), bits, refs, special));
+  finalize_hashes(td::Span<Ref<DataCell>>(&cell, 1));
+  return std::move(cell);
 }
 
 const DataCell::Hash DataCell::do_get_hash(td::uint32 level) const {
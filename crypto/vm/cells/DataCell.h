@@ -196,6 +196,13 @@ class DataCell : public Cell {
     return get_thread_safe_counter().sum();
   }
 
+  // Two-phase creation for bulk loaders: cells returned by create_unhashed() have no hashes yet,
+  // finalize_hashes() computes them for the whole span with the multi-buffer SHA-256 backend.
+  // Cells of one span must not reference each other, and an unhashed cell must not be used otherwise.
+  static td::Result<Ref<DataCell>> create_unhashed(td::ConstBitPtr data, unsigned bits,
+                                                   td::MutableSpan<Ref<Cell>> refs, bool special);
+  static void finalize_hashes(td::Span<Ref<DataCell>> cells);
+
   template <class StorerT>
   void store(StorerT& storer) const {
     storer.template store_binary<td::uint8>(info_.d1());
@@ -215,6 +222,7 @@ class DataCell : public Cell {
 
   const Hash do_get_hash(td::uint32 level) const override;
   td::uint16 do_get_depth(td::uint32 level) const override;
+  size_t get_hash_input(unsigned dest_i, unsigned char* buff) const;
 
   friend class CellBuilder;
   static td::Result<Ref<DataCell>> create(td::ConstBitPtr data, unsigned bits, td::Span<Ref<Cell>> refs, bool special);
@@ -32,9 +32,12 @@ class MerkleProofImpl {
   }
   explicit MerkleProofImpl(CellUsageTree *usage_tree) : usage_tree_(usage_tree) {
   }
+  MerkleProofImpl(const MerkleProof::LoadedCells *loaded_cells, MerkleProof::PrunnedCells *prunned_cells)
+      : loaded_cells_(loaded_cells), prunned_cells_(prunned_cells) {
+  }
 
   Ref<Cell> create_from(Ref<Cell> cell) {
-    if (!is_prunned_) {
+    if (!is_prunned_ && !loaded_cells_) {
       CHECK(usage_tree_);
       dfs_usage_tree(cell, usage_tree_->root_id());
       is_prunned_ = [this](const Ref<Cell> &cell) { return visited_cells_.count(cell->get_hash()) == 0; };
@@ -54,6 +57,15 @@ class MerkleProofImpl {
   td::HashSet<Cell::Hash> visited_cells_;
   CellUsageTree *usage_tree_{nullptr};
   MerkleProof::IsPrunnedFunction is_prunned_;
+  const MerkleProof::LoadedCells *loaded_cells_{nullptr};
+  MerkleProof::PrunnedCells *prunned_cells_{nullptr};
+
+  bool is_prunned(const Ref<Cell> &cell) const {
+    if (loaded_cells_) {
+      return loaded_cells_->count(cell->get_hash()) == 0;
+    }
+    return is_prunned_(cell);
+  }
 
   void dfs_usage_tree(Ref<Cell> cell, CellUsageTree::NodeId node_id) {
     if (!usage_tree_->is_loaded(node_id)) {
@@ -77,10 +89,20 @@ class MerkleProofImpl {
       }
     }
 
-    if (is_prunned_(cell)) {
+    if (is_prunned(cell)) {
+      if (prunned_cells_) {
+        auto it = prunned_cells_->find(key);
+        if (it != prunned_cells_->end()) {
+          cells_.emplace(key, it->second);
+          return it->second;
+        }
+      }
       auto res = CellBuilder::create_pruned_branch(cell, merkle_depth + 1);
       CHECK(res.not_null());
       cells_.emplace(key, res);
+      if (prunned_cells_) {
+        prunned_cells_->emplace(key, res);
+      }
       return res;
     }
     CellSlice cs(NoVm(), cell);
@@ -106,6 +128,10 @@ Ref<Cell> MerkleProof::generate_raw(Ref<Cell> cell, CellUsageTree *usage_tree) {
   return detail::MerkleProofImpl(usage_tree).create_from(cell);
 }
 
+Ref<Cell> MerkleProof::generate_raw(Ref<Cell> cell, const LoadedCells &loaded_cells, PrunnedCells *prunned_cells) {
+  return detail::MerkleProofImpl(&loaded_cells, prunned_cells).create_from(cell);
+}
+
 Ref<Cell> MerkleProof::virtualize_raw(Ref<Cell> cell, Cell::VirtualizationParameters virt) {
   return cell->virtualize(virt);
 }
@@ -374,15 +400,31 @@ Ref<Cell> MerkleProof::combine_fast_raw(Ref<Cell> a, Ref<Cell> b) {
   return res.move_as_ok();
 }
 
-MerkleProofBuilder::MerkleProofBuilder(Ref<Cell> root)
-    : usage_tree(std::make_shared<CellUsageTree>()), orig_root(std::move(root)) {
+MerkleProofBuilder::MerkleProofBuilder(Ref<Cell> root) {
+  init(std::move(root));
+}
+
+void MerkleProofBuilder::init_usage_tree() {
+  usage_tree = std::make_shared<CellUsageTree>();
   usage_root = UsageCell::create(orig_root, usage_tree->root_ptr());
+  loaded_cells.reset();
+  // hashes of the data cells match the hashes seen from orig_root only without virtualization
+  if (orig_root.not_null() && orig_root->get_virtualization() == 0) {
+    loaded_cells = std::make_shared<MerkleProof::LoadedCells>();
+  }
+  set_cell_load_callback(std::move(cell_load_callback));
 }
 
 Ref<Cell> MerkleProofBuilder::init(Ref<Cell> root) {
-  usage_tree = std::make_shared<CellUsageTree>();
   orig_root = std::move(root);
-  usage_root = UsageCell::create(orig_root, usage_tree->root_ptr());
+  prunned_cells = std::make_shared<MerkleProof::PrunnedCells>();
+  cell_load_callback = {};
+  init_usage_tree();
+  return usage_root;
+}
+
+Ref<Cell> MerkleProofBuilder::restart() {
+  init_usage_tree();
   return usage_root;
 }
 
@@ -390,11 +432,36 @@ bool MerkleProofBuilder::clear() {
   usage_tree.reset();
   orig_root.clear();
   usage_root.clear();
+  loaded_cells.reset();
+  prunned_cells.reset();
+  cell_load_callback = {};
   return true;
 }
 
+void MerkleProofBuilder::set_cell_load_callback(std::function<void(const td::Ref<vm::DataCell> &)> f) {
+  cell_load_callback = std::move(f);
+  if (!loaded_cells) {
+    usage_tree->set_cell_load_callback(cell_load_callback);
+    return;
+  }
+  usage_tree->set_cell_load_callback([loaded_cells = loaded_cells, f = cell_load_callback](const Ref<DataCell> &cell) {
+    loaded_cells->insert(cell->get_hash());
+    if (f) {
+      f(cell);
+    }
+  });
+}
+
 td::Result<Ref<Cell>> MerkleProofBuilder::extract_proof() const {
-  Ref<Cell> proof = MerkleProof::generate(orig_root, usage_tree.get());
+  Ref<Cell> proof;
+  if (loaded_cells && orig_root->get_level() == 0) {
+    auto raw = MerkleProof::generate_raw(orig_root, *loaded_cells, prunned_cells.get());
+    if (raw.not_null()) {
+      proof = CellBuilder::create_merkle_proof(std::move(raw));
+    }
+  } else {
+    proof = MerkleProof::generate(orig_root, usage_tree.get());
+  }
   if (proof.is_null()) {
     return td::Status::Error("cannot create Merkle proof");
   }
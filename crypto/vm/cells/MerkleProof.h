@@ -19,6 +19,8 @@
 #pragma once
 #include "vm/cells/Cell.h"
 #include "td/utils/buffer.h"
+#include "td/utils/HashMap.h"
+#include "td/utils/HashSet.h"
 
 #include <utility>
 #include <functional>
@@ -28,6 +30,8 @@ namespace vm {
 class MerkleProof {
  public:
   using IsPrunnedFunction = std::function<bool(const Ref<Cell> &)>;
+  using LoadedCells = td::HashSet<Cell::Hash>;
+  using PrunnedCells = td::HashMap<std::pair<Cell::Hash, int>, Ref<Cell>>;
 
   // works with proofs wrapped in MerkleProof special cell
   // cells must have zero level
@@ -46,6 +50,9 @@ class MerkleProof {
   // works fine with cell of non-zero level, but this is not supported (yet?) in MerkeProof special cell
   static Ref<Cell> generate_raw(Ref<Cell> cell, IsPrunnedFunction is_prunned);
   static Ref<Cell> generate_raw(Ref<Cell> cell, CellUsageTree *usage_tree);
+  // cells whose hashes are not in loaded_cells are pruned; created pruned branches are stored in prunned_cells
+  // and taken from there by later calls
+  static Ref<Cell> generate_raw(Ref<Cell> cell, const LoadedCells &loaded_cells, PrunnedCells *prunned_cells);
   static Ref<Cell> virtualize_raw(Ref<Cell> cell, Cell::VirtualizationParameters virt);
   static Ref<Cell> combine_raw(Ref<Cell> a, Ref<Cell> b);
   static Ref<Cell> combine_fast_raw(Ref<Cell> a, Ref<Cell> b);
@@ -54,11 +61,21 @@ class MerkleProof {
 class MerkleProofBuilder {
   std::shared_ptr<CellUsageTree> usage_tree;
   Ref<vm::Cell> orig_root, usage_root;
+  // hashes of the cells loaded through usage_root, recorded while they are accessed,
+  // so that extract_proof() does not walk the usage tree again
+  std::shared_ptr<MerkleProof::LoadedCells> loaded_cells;
+  // pruned branches are kept by restart() for the next proof of the same root
+  std::shared_ptr<MerkleProof::PrunnedCells> prunned_cells;
+  std::function<void(const td::Ref<vm::DataCell>&)> cell_load_callback;
+
+  void init_usage_tree();
 
  public:
   MerkleProofBuilder() = default;
   MerkleProofBuilder(Ref<Cell> root);
   Ref<Cell> init(Ref<Cell> root);
+  // starts a new proof of the same root; cells loaded before are not included into it
+  Ref<Cell> restart();
   bool clear();
   Ref<Cell> root() const {
     return usage_root;
@@ -67,9 +84,7 @@ class MerkleProofBuilder {
   bool extract_proof_to(Ref<Cell> &proof_root) const;
   td::Result<td::BufferSlice> extract_proof_boc() const;
 
-  void set_cell_load_callback(std::function<void(const td::Ref<vm::DataCell>&)> f) {
-    usage_tree->set_cell_load_callback(std::move(f));
-  }
+  void set_cell_load_callback(std::function<void(const td::Ref<vm::DataCell>&)> f);
 };
 
 }  // namespace vm
@@ -18,31 +18,213 @@
 */
 #include "vm/cells/MerkleUpdate.h"
 #include "vm/cells/MerkleProof.h"
+#include "vm/excno.hpp"
 
 #include "td/utils/HashMap.h"
 #include "td/utils/HashSet.h"
+#include "td/utils/port/thread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
 
 namespace vm {
+namespace {
+std::atomic<size_t> merkle_update_extra_threads{0};
+
+// Threads are started once and live until the process exits: the pool is never destroyed, so detached workers
+// can't outlive it. Every submitted task is waited for by the caller of parallel_run.
+class MerkleUpdateWorkers {
+ public:
+  static MerkleUpdateWorkers &get() {
+    static auto *workers = new MerkleUpdateWorkers();
+    return *workers;
+  }
+
+  void reserve(size_t threads_n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (; threads_n_ < threads_n; threads_n_++) {
+      td::thread([this] { run(); }).detach();
+    }
+  }
+
+  void add_task(std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push(std::move(task));
+    cond_.notify_one();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::queue<std::function<void()>> tasks_;
+  size_t threads_n_{0};
+
+  void run() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.wait(lock, [&] { return !tasks_.empty(); });
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+      task();
+    }
+  }
+};
+}  // namespace
+
 namespace detail {
+// Runs run_task(0), ..., run_task(n - 1) on the calling thread and on up to extra_threads_n pool workers.
+// Returns only after every started task has finished; the first exception thrown by a task is rethrown then.
+template <class F>
+void parallel_run(size_t n, F &&run_task, size_t extra_threads_n) {
+  std::atomic<size_t> next_task_id{0};
+  std::mutex mutex;
+  std::condition_variable finished;
+  size_t running = 0;
+  std::exception_ptr error;
+  auto loop = [&] {
+    try {
+      while (true) {
+        auto task_id = next_task_id++;
+        if (task_id >= n) {
+          break;
+        }
+        run_task(task_id);
+      }
+    } catch (...) {
+      next_task_id = n;
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  };
+
+  auto &workers = MerkleUpdateWorkers::get();
+  workers.reserve(extra_threads_n);
+  for (size_t i = 0; i < extra_threads_n; i++) {
+    std::unique_lock<std::mutex> running_lock(mutex);
+    running++;
+    running_lock.unlock();
+    try {
+      workers.add_task([&] {
+        loop();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--running == 0) {
+          finished.notify_all();
+        }
+      });
+    } catch (...) {
+      // the tasks submitted before are still waited for below
+      running_lock.lock();
+      running--;
+      error = std::current_exception();
+      next_task_id = n;
+      break;
+    }
+  }
+  loop();
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return running == 0; });
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+// Splits the top of the tree into at least min_count distinct subtrees (if the tree is big enough),
+// which can be processed independently. Pruned branches are not split.
+std::vector<std::pair<Ref<Cell>, int>> split_subtrees(Ref<Cell> root, int merkle_depth, size_t min_count) {
+  constexpr int max_split_depth = 16;
+  std::vector<std::pair<Ref<Cell>, int>> res{{std::move(root), merkle_depth}};
+  for (int i = 0; i < max_split_depth && res.size() < min_count; i++) {
+    std::vector<std::pair<Ref<Cell>, int>> next;
+    td::HashSet<std::pair<Cell::Hash, int>> seen;
+    bool split = false;
+    for (auto &subtree : res) {
+      CellSlice cs(NoVm(), subtree.first);
+      if (cs.special_type() == Cell::SpecialType::PrunnedBranch || cs.size_refs() == 0) {
+        if (seen.emplace(subtree.first->get_hash(), subtree.second).second) {
+          next.push_back(subtree);
+        }
+        continue;
+      }
+      split = true;
+      int child_merkle_depth = cs.child_merkle_depth(subtree.second);
+      for (unsigned j = 0; j < cs.size_refs(); j++) {
+        auto child = cs.prefetch_ref(j);
+        if (seen.emplace(child->get_hash(), child_merkle_depth).second) {
+          next.emplace_back(std::move(child), child_merkle_depth);
+        }
+      }
+    }
+    if (!split) {
+      break;
+    }
+    res = std::move(next);
+  }
+  return res;
+}
+
 class MerkleUpdateApply {
  public:
+  MerkleUpdateApply() = default;
+  explicit MerkleUpdateApply(const MerkleUpdateApply *parent) : known_cells_(parent->known_cells_) {
+  }
+
   Ref<Cell> apply(Ref<Cell> from, Ref<Cell> update_from, Ref<Cell> update_to, td::uint32 from_level,
-                  td::uint32 to_level) {
+                  td::uint32 to_level, size_t extra_threads) {
     if (from_level != from->get_level()) {
       return {};
     }
+    // cells of from are loaded here, on the calling thread only
     dfs_both(from, update_from, from_level);
+    if (extra_threads != 0) {
+      // new cells of independent subtrees of update_to are created concurrently, the top of the tree
+      // is then built by dfs() from the ready subtrees
+      auto subtrees = split_subtrees(update_to, to_level, (extra_threads + 1) * 16);
+      std::vector<Ref<Cell>> results(subtrees.size());
+      parallel_run(
+          subtrees.size(),
+          [&](size_t i) {
+            // a failed subtree fails the whole update, as in the single-threaded dfs()
+            try {
+              results[i] = MerkleUpdateApply(this).dfs(subtrees[i].first, subtrees[i].second);
+            } catch (CellBuilder::CellWriteError &) {
+              results[i] = {};
+            } catch (VmError &) {
+              results[i] = {};
+            } catch (VmVirtError &) {
+              results[i] = {};
+            }
+          },
+          std::min(extra_threads, subtrees.size() - 1));
+      for (size_t i = 0; i < subtrees.size(); i++) {
+        if (results[i].is_null()) {
+          return {};
+        }
+        ready_cells_.emplace(Key{subtrees[i].first->get_hash(), subtrees[i].second}, std::move(results[i]));
+      }
+    }
     return dfs(update_to, to_level);
   }
 
  private:
   using Key = std::pair<Cell::Hash, int>;
-  td::HashMap<Cell::Hash, Ref<Cell>> known_cells_;
+  std::shared_ptr<td::HashMap<Cell::Hash, Ref<Cell>>> known_cells_ =
+      std::make_shared<td::HashMap<Cell::Hash, Ref<Cell>>>();
   td::HashMap<Key, Ref<Cell>> ready_cells_;
 
   void dfs_both(Ref<Cell> original, Ref<Cell> update_from, int merkle_depth) {
     CellSlice cs_update_from(NoVm(), update_from);
-    known_cells_.emplace(original->get_hash(merkle_depth), original);
+    known_cells_->emplace(original->get_hash(merkle_depth), original);
     if (cs_update_from.special_type() == Cell::SpecialType::PrunnedBranch) {
       return;
     }
@@ -58,8 +240,8 @@ class MerkleUpdateApply {
     CellSlice cs(NoVm(), cell);
     if (cs.special_type() == Cell::SpecialType::PrunnedBranch) {
       if ((int)cell->get_level() == merkle_depth + 1) {
-        auto it = known_cells_.find(cell->get_hash(merkle_depth));
-        if (it != known_cells_.end()) {
+        auto it = known_cells_->find(cell->get_hash(merkle_depth));
+        if (it != known_cells_->end()) {
           return it->second;
         }
         return {};
@@ -93,13 +275,38 @@ class MerkleUpdateApply {
 
 class MerkleUpdateValidator {
  public:
-  td::Status validate(Ref<Cell> update_from, Ref<Cell> update_to, td::uint32 from_level, td::uint32 to_level) {
+  MerkleUpdateValidator() = default;
+  explicit MerkleUpdateValidator(const MerkleUpdateValidator *parent) : known_cells_(parent->known_cells_) {
+  }
+
+  td::Status validate(Ref<Cell> update_from, Ref<Cell> update_to, td::uint32 from_level, td::uint32 to_level,
+                      size_t extra_threads) {
     dfs_from(update_from, from_level);
-    return dfs_to(update_to, to_level);
+    if (extra_threads == 0) {
+      return dfs_to(update_to, to_level);
+    }
+    auto subtrees = split_subtrees(update_to, to_level, (extra_threads + 1) * 16);
+    std::vector<td::Status> results(subtrees.size());
+    parallel_run(
+        subtrees.size(),
+        [&](size_t i) {
+          try {
+            results[i] = MerkleUpdateValidator(this).dfs_to(subtrees[i].first, subtrees[i].second);
+          } catch (VmError &err) {
+            results[i] = err.as_status("error while validating Merkle update: ");
+          } catch (VmVirtError &err) {
+            results[i] = err.as_status("error while validating Merkle update: ");
+          }
+        },
+        std::min(extra_threads, subtrees.size() - 1));
+    for (auto &status : results) {
+      TRY_STATUS(std::move(status));
+    }
+    return td::Status::OK();
   }
 
  private:
-  td::HashSet<Cell::Hash> known_cells_;
+  std::shared_ptr<td::HashSet<Cell::Hash>> known_cells_ = std::make_shared<td::HashSet<Cell::Hash>>();
   using Key = std::pair<Cell::Hash, int>;
   td::HashSet<Key> visited_from_;
   td::HashSet<Key> visited_to_;
@@ -109,7 +316,7 @@ class MerkleUpdateValidator {
       return;
     }
     CellSlice cs(NoVm(), cell);
-    known_cells_.insert(cell->get_hash(merkle_depth));
+    known_cells_->insert(cell->get_hash(merkle_depth));
     if (cs.special_type() == Cell::SpecialType::PrunnedBranch) {
       return;
     }
@@ -126,7 +333,7 @@ class MerkleUpdateValidator {
     CellSlice cs(NoVm(), cell);
     if (cs.special_type() == Cell::SpecialType::PrunnedBranch) {
       if ((int)cell->get_level() == merkle_depth + 1) {
-        if (known_cells_.count(cell->get_hash(merkle_depth)) == 0) {
+        if (known_cells_->count(cell->get_hash(merkle_depth)) == 0) {
           return td::Status::Error(PSLICE()
                                    << "Unknown prunned cell (validate): " << cell->get_hash(merkle_depth).to_hex());
         }
@@ -143,6 +350,14 @@ class MerkleUpdateValidator {
 };
 }  // namespace detail
 
+void MerkleUpdate::set_extra_threads(size_t extra_threads) {
+  merkle_update_extra_threads.store(extra_threads, std::memory_order_relaxed);
+}
+
+size_t MerkleUpdate::get_extra_threads() {
+  return merkle_update_extra_threads.load(std::memory_order_relaxed);
+}
+
 td::Status MerkleUpdate::may_apply(Ref<Cell> from, Ref<Cell> update) {
   if (update->get_level() != 0 || from->get_level() != 0) {
     return td::Status::Error("Level of update of from is not zero");
@@ -178,7 +393,8 @@ Ref<Cell> MerkleUpdate::apply_raw(Ref<Cell> from, Ref<Cell> update_from, Ref<Cel
                << ", applied to value with hash = " << from->get_hash(from_level).to_hex();
     return {};
   }
-  return detail::MerkleUpdateApply().apply(from, std::move(update_from), std::move(update_to), from_level, to_level);
+  return detail::MerkleUpdateApply().apply(from, std::move(update_from), std::move(update_to), from_level, to_level,
+                                           get_extra_threads());
 }
 
 std::pair<Ref<Cell>, Ref<Cell>> MerkleUpdate::generate_raw(Ref<Cell> from, Ref<Cell> to, CellUsageTree *usage_tree) {
@@ -198,7 +414,8 @@ std::pair<Ref<Cell>, Ref<Cell>> MerkleUpdate::generate_raw(Ref<Cell> from, Ref<C
 
 td::Status MerkleUpdate::validate_raw(Ref<Cell> update_from, Ref<Cell> update_to, td::uint32 from_level,
                                       td::uint32 to_level) {
-  return detail::MerkleUpdateValidator().validate(std::move(update_from), std::move(update_to), from_level, to_level);
+  return detail::MerkleUpdateValidator().validate(std::move(update_from), std::move(update_to), from_level, to_level,
+                                                  get_extra_threads());
 }
 
 td::Status MerkleUpdate::validate(Ref<Cell> update) {
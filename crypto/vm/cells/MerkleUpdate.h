@@ -46,5 +46,10 @@ class MerkleUpdate {
                                  td::uint32 to_level);
 
   static Ref<Cell> combine(Ref<Cell> ab, Ref<Cell> bc);
+
+  // Number of additional threads used by apply() and validate() to process independent subtrees of the new value.
+  // Cells of the old value are loaded only by the calling thread. 0 (default) means single-threaded.
+  static void set_extra_threads(size_t extra_threads);
+  static size_t get_extra_threads();
 };
 }  // namespace vm
@@ -25,6 +25,9 @@
 
 #include "td/utils/bits.h"
 
+#include <algorithm>
+#include <numeric>
+
 namespace vm {
 
 /*
@@ -1203,6 +1206,234 @@ Ref<Cell> Dictionary::lookup_delete_ref(td::ConstBitPtr key, int key_len) {
   return extract_value_ref(lookup_delete(key, key_len));
 }
 
+/*
+ *
+ *   Batched lookups and updates
+ *
+ *   Keys are sorted once, so that all keys passing through a dictionary node form a contiguous range;
+ *   every node on the union of their paths is loaded (and, for updates, rebuilt) exactly once.
+ *
+ */
+
+void DictionaryFixed::dict_lookup_batch(Ref<Cell> dict, const td::ConstBitPtr* keys, const unsigned* idx,
+                                        std::size_t cnt, int offs, int n, std::vector<Ref<CellSlice>>& res) const {
+  LabelParser label{std::move(dict), n, label_mode()};
+  unsigned char buffer[Dictionary::max_key_bytes];
+  td::BitPtr label_bits{buffer};
+  int l = label.copy_label_prefix_to(label_bits, n);
+  // keys having the label as a prefix form a contiguous subrange
+  std::size_t lo = std::partition_point(keys, keys + cnt,
+                                        [&](td::ConstBitPtr key) { return (key + offs).compare(label_bits, l) < 0; }) -
+                   keys;
+  std::size_t hi = std::partition_point(keys + lo, keys + cnt,
+                                        [&](td::ConstBitPtr key) { return !(key + offs).compare(label_bits, l); }) -
+                   keys;
+  if (lo == hi) {
+    return;
+  }
+  n -= label.l_bits;
+  if (n <= 0) {
+    assert(!n);
+    label.skip_label();
+    for (std::size_t i = lo; i < hi; i++) {
+      res[idx[i]] = label.remainder;
+    }
+    return;
+  }
+  offs += label.l_bits;
+  std::size_t mid =
+      std::partition_point(keys + lo, keys + hi, [offs](td::ConstBitPtr key) { return !key[offs]; }) - keys;
+  auto c1 = label.remainder->prefetch_ref(0);
+  auto c2 = label.remainder->prefetch_ref(1);
+  label.remainder.clear();
+  if (lo < mid) {
+    dict_lookup_batch(std::move(c1), keys + lo, idx + lo, mid - lo, offs + 1, n - 1, res);
+  }
+  if (mid < hi) {
+    dict_lookup_batch(std::move(c2), keys + mid, idx + mid, hi - mid, offs + 1, n - 1, res);
+  }
+}
+
+// looks up several keys at once; the result contains the values (or nulls) in the order of `keys`
+std::vector<Ref<CellSlice>> DictionaryFixed::lookup_batch(const std::vector<td::ConstBitPtr>& keys, int key_len) {
+  force_validate();
+  std::vector<Ref<CellSlice>> res(keys.size());
+  if (key_len != get_key_bits() || is_empty() || keys.empty()) {
+    return res;
+  }
+  std::vector<unsigned> idx(keys.size());
+  std::iota(idx.begin(), idx.end(), 0);
+  std::sort(idx.begin(), idx.end(),
+            [&](unsigned i, unsigned j) { return keys[i].compare(keys[j], key_len) < 0; });
+  std::vector<td::ConstBitPtr> sorted_keys;
+  sorted_keys.reserve(keys.size());
+  for (unsigned i : idx) {
+    sorted_keys.push_back(keys[i]);
+  }
+  dict_lookup_batch(get_root_cell(), sorted_keys.data(), idx.data(), keys.size(), 0, key_len, res);
+  return res;
+}
+
+// creates a node with label `prefix` (of length pfx_len) above subdictionaries c1 and c2, either of which may be empty
+Ref<Cell> DictionaryFixed::dict_join_batch(td::ConstBitPtr prefix, int pfx_len, Ref<Cell> c1, Ref<Cell> c2,
+                                           int n) const {
+  if (c1.not_null() && c2.not_null()) {
+    CellBuilder cb;
+    append_dict_label(cb, prefix, pfx_len, n);
+    return finish_create_fork(cb, std::move(c1), std::move(c2), n - pfx_len);
+  }
+  if (c1.is_null() && c2.is_null()) {
+    return {};
+  }
+  // have to merge current edge with the edge leading to the only remaining child
+  bool sw_bit = c1.is_null();
+  unsigned char buffer[Dictionary::max_key_bytes];
+  td::BitPtr bw{buffer};
+  bw.concat(prefix, pfx_len);
+  bw.concat_same(sw_bit, 1);
+  LabelParser label2{sw_bit ? std::move(c2) : std::move(c1), n - pfx_len - 1, label_mode()};
+  bw += label2.extract_label_to(bw);
+  assert(bw.offs >= 0 && bw.offs <= Dictionary::max_key_bits);
+  CellBuilder cb;
+  append_dict_label(cb, td::ConstBitPtr{buffer}, bw.offs, n);
+  if (!cell_builder_add_slice_bool(cb, *label2.remainder)) {
+    throw VmError{Excno::cell_ov, "cannot change label of an old dictionary cell while merging edges"};
+  }
+  return cb.finalize();
+}
+
+// applies sorted operations with distinct keys to subdictionary `dict` (modified in place)
+// returns false if some operation cannot be performed because of its SetMode
+bool DictionaryFixed::dict_apply_batch(Ref<Cell>& dict, const BatchOp* ops, std::size_t cnt, int offs, int n) const {
+  if (!cnt) {
+    return true;
+  }
+  td::ConstBitPtr key = ops[0].key + offs;
+  if (dict.is_null()) {
+    if (cnt == 1) {
+      if (ops[0].value.is_null() || ops[0].mode == SetMode::Replace) {
+        // key not found
+        return false;
+      }
+      CellBuilder cb;
+      append_dict_label(cb, key, n, n);
+      dict = finish_create_leaf(cb, *ops[0].value);
+      return true;
+    }
+    // the keys diverge right after their common prefix
+    std::size_t pfx_len = 0;
+    key.compare(ops[cnt - 1].key + offs, n, &pfx_len);
+    assert(pfx_len < (std::size_t)n);
+    int p = (int)pfx_len;
+    std::size_t mid =
+        std::partition_point(ops, ops + cnt, [offs, p](const BatchOp& op) { return !op.key[offs + p]; }) - ops;
+    Ref<Cell> c1, c2;
+    if (!(dict_apply_batch(c1, ops, mid, offs + p + 1, n - p - 1) &&
+          dict_apply_batch(c2, ops + mid, cnt - mid, offs + p + 1, n - p - 1))) {
+      return false;
+    }
+    dict = dict_join_batch(key, p, std::move(c1), std::move(c2), n);
+    return true;
+  }
+  LabelParser label{dict, n, label_mode()};
+  // sorted keys have minimal common prefix with the label at one of the ends of the range
+  int pfx_len =
+      std::min(label.common_prefix_len(key, n), label.common_prefix_len(ops[cnt - 1].key + offs, n));
+  assert(pfx_len >= 0 && pfx_len <= label.l_bits && label.l_bits <= n);
+  if (pfx_len < label.l_bits) {
+    // some keys leave the current edge at position pfx_len, have to insert a new fork there
+    bool old_bit = label.l_same ? (label.l_same & 1) : label.bits()[pfx_len];
+    std::size_t mid = std::partition_point(ops, ops + cnt,
+                                           [offs, pfx_len](const BatchOp& op) { return !op.key[offs + pfx_len]; }) -
+                      ops;
+    // create the lower portion of the old edge
+    int m = n - pfx_len - 1;
+    int t = label.l_bits - pfx_len - 1;
+    CellBuilder cb;
+    auto cs = std::move(label.remainder);
+    if (label.l_same) {
+      append_dict_label_same(cb, label.l_same & 1, t, m);
+    } else {
+      cs.write().advance(pfx_len + 1);
+      append_dict_label(cb, cs->data_bits(), t, m);
+      cs.unique_write().advance(t);
+    }
+    if (!cell_builder_add_slice_bool(cb, *cs)) {
+      throw VmError{Excno::cell_ov, "cannot change label of an old dictionary cell (?)"};
+    }
+    Ref<Cell> c1 = cb.finalize(), c2;
+    const BatchOp *old_ops = ops, *new_ops = ops + mid;
+    std::size_t old_cnt = mid, new_cnt = cnt - mid;
+    if (old_bit) {
+      std::swap(old_ops, new_ops);
+      std::swap(old_cnt, new_cnt);
+    }
+    if (!(dict_apply_batch(c1, old_ops, old_cnt, offs + pfx_len + 1, m) &&
+          dict_apply_batch(c2, new_ops, new_cnt, offs + pfx_len + 1, m))) {
+      return false;
+    }
+    if (old_bit) {
+      c1.swap(c2);
+    }
+    dict = dict_join_batch(key, pfx_len, std::move(c1), std::move(c2), n);
+    return true;
+  }
+  if (label.l_bits == n) {
+    // the edge leads to a leaf node containing the value for the only key in range
+    assert(cnt == 1);
+    if (ops[0].value.is_null()) {
+      dict.clear();
+      return true;
+    }
+    if (ops[0].mode == SetMode::Add) {
+      return false;
+    }
+    CellBuilder cb;
+    append_dict_label(cb, key, n, n);
+    dict = finish_create_leaf(cb, *ops[0].value);
+    return true;
+  }
+  // main case: the edge leads to a fork, modify both subtrees and rebuild the fork only once
+  offs += label.l_bits;
+  std::size_t mid =
+      std::partition_point(ops, ops + cnt, [offs](const BatchOp& op) { return !op.key[offs]; }) - ops;
+  auto c1 = label.remainder->prefetch_ref(0);
+  auto c2 = label.remainder->prefetch_ref(1);
+  label.remainder.clear();
+  const Cell *old_c1 = c1.get(), *old_c2 = c2.get();
+  if (!(dict_apply_batch(c1, ops, mid, offs + 1, n - label.l_bits - 1) &&
+        dict_apply_batch(c2, ops + mid, cnt - mid, offs + 1, n - label.l_bits - 1))) {
+    return false;
+  }
+  if (c1.get() == old_c1 && c2.get() == old_c2) {
+    // unchanged
+    return true;
+  }
+  dict = dict_join_batch(key, label.l_bits, std::move(c1), std::move(c2), n);
+  return true;
+}
+
+// applies all operations atomically: either all of them succeed, or the dictionary is left unchanged
+bool DictionaryFixed::apply_batch(std::vector<BatchOp> ops, int key_len) {
+  force_validate();
+  if (key_len != get_key_bits()) {
+    return false;
+  }
+  std::sort(ops.begin(), ops.end(),
+            [key_len](const BatchOp& x, const BatchOp& y) { return x.key.compare(y.key, key_len) < 0; });
+  for (std::size_t i = 1; i < ops.size(); i++) {
+    if (ops[i - 1].key.equals(ops[i].key, key_len)) {
+      return false;
+    }
+  }
+  Ref<Cell> root = get_root_cell();
+  if (!dict_apply_batch(root, ops.data(), ops.size(), 0, key_len)) {
+    return false;
+  }
+  set_root_cell(std::move(root));
+  return true;
+}
+
 Ref<CellSlice> DictionaryFixed::dict_lookup_minmax(Ref<Cell> dict, td::BitPtr key_buffer, int n, int mode) const {
   if (dict.is_null()) {
     return {};
@@ -2701,6 +2932,19 @@ std::pair<Ref<CellSlice>, Ref<CellSlice>> AugmentedDictionary::lookup_delete_ext
   return decompose_value_extra(lookup_delete_with_extra(key, key_len));
 }
 
+std::vector<Ref<CellSlice>> AugmentedDictionary::lookup_with_extra_batch(const std::vector<td::ConstBitPtr>& keys,
+                                                                         int key_len) {
+  return DictionaryFixed::lookup_batch(keys, key_len);
+}
+
+std::vector<Ref<CellSlice>> AugmentedDictionary::lookup_batch(const std::vector<td::ConstBitPtr>& keys, int key_len) {
+  auto res = lookup_with_extra_batch(keys, key_len);
+  for (auto& value : res) {
+    value = extract_value(std::move(value));
+  }
+  return res;
+}
+
 bool AugmentedDictionary::check_leaf(CellSlice& cs, td::ConstBitPtr key, int key_len) const {
   vm::CellSlice extra;
   return aug.extract_extra_to(cs, extra) && aug.check_leaf_key_extra(cs, extra, key, key_len);
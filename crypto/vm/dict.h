@@ -22,6 +22,7 @@
 #include "vm/cellslice.h"
 #include "vm/stack.hpp"
 #include <functional>
+#include <vector>
 
 namespace vm {
 using td::BitSlice;
@@ -185,6 +186,12 @@ class DictionaryFixed : public DictionaryBase {
   typedef std::function<bool(CellBuilder&, Ref<CellSlice>, Ref<CellSlice>, td::ConstBitPtr, int)> combine_func_t;
   typedef std::function<bool(Ref<CellSlice>, td::ConstBitPtr, int)> foreach_func_t;
   typedef std::function<bool(td::ConstBitPtr, int, Ref<CellSlice>, Ref<CellSlice>)> scan_diff_func_t;
+  // one modification of a batch update; a null value deletes the key (mode is ignored then)
+  struct BatchOp {
+    td::ConstBitPtr key;
+    Ref<CellSlice> value;
+    SetMode mode{SetMode::Set};
+  };
 
   DictionaryFixed(int _n, bool validate = true) : DictionaryBase(_n, validate) {
   }
@@ -214,6 +221,8 @@ class DictionaryFixed : public DictionaryBase {
   bool uint_key_exists(unsigned long long key);
   Ref<CellSlice> lookup(td::ConstBitPtr key, int key_len);
   Ref<CellSlice> lookup_delete(td::ConstBitPtr key, int key_len);
+  std::vector<Ref<CellSlice>> lookup_batch(const std::vector<td::ConstBitPtr>& keys, int key_len);
+  bool apply_batch(std::vector<BatchOp> ops, int key_len);
   Ref<CellSlice> get_minmax_key(td::BitPtr key_buffer, int key_len, bool fetch_max = false, bool invert_first = false);
   Ref<CellSlice> extract_minmax_key(td::BitPtr key_buffer, int key_len, bool fetch_max = false,
                                     bool invert_first = false);
@@ -287,6 +296,10 @@ class DictionaryFixed : public DictionaryBase {
 
  private:
   std::pair<Ref<CellSlice>, Ref<Cell>> dict_lookup_delete(Ref<Cell> dict, td::ConstBitPtr key, int n) const;
+  void dict_lookup_batch(Ref<Cell> dict, const td::ConstBitPtr* keys, const unsigned* idx, std::size_t cnt, int offs,
+                         int n, std::vector<Ref<CellSlice>>& res) const;
+  bool dict_apply_batch(Ref<Cell>& dict, const BatchOp* ops, std::size_t cnt, int offs, int n) const;
+  Ref<Cell> dict_join_batch(td::ConstBitPtr prefix, int pfx_len, Ref<Cell> c1, Ref<Cell> c2, int n) const;
   Ref<CellSlice> dict_lookup_minmax(Ref<Cell> dict, td::BitPtr key_buffer, int n, int mode) const;
   Ref<CellSlice> dict_lookup_nearest(Ref<Cell> dict, td::BitPtr key_buffer, int n, bool allow_eq, int mode) const;
   std::pair<Ref<Cell>, bool> extract_prefix_subdict_internal(Ref<Cell> dict, td::ConstBitPtr prefix, int prefix_len,
@@ -584,6 +597,8 @@ class AugmentedDictionary final : public DictionaryFixed {
   Ref<CellSlice> lookup_delete_with_extra(td::ConstBitPtr key, int key_len);
   std::pair<Ref<CellSlice>, Ref<CellSlice>> lookup_delete_extra(td::ConstBitPtr key, int key_len);
   std::pair<Ref<Cell>, Ref<CellSlice>> lookup_delete_ref_extra(td::ConstBitPtr key, int key_len);
+  std::vector<Ref<CellSlice>> lookup_batch(const std::vector<td::ConstBitPtr>& keys, int key_len);
+  std::vector<Ref<CellSlice>> lookup_with_extra_batch(const std::vector<td::ConstBitPtr>& keys, int key_len);
   bool set(td::ConstBitPtr key, int key_len, const CellSlice& value, SetMode mode = SetMode::Set);
   bool set(td::ConstBitPtr key, int key_len, Ref<CellSlice> value, SetMode mode = SetMode::Set);
   bool set_ref(td::ConstBitPtr key, int key_len, Ref<Cell> val_ref, SetMode mode = SetMode::Set);
@@ -512,6 +512,7 @@ int VmState::run() {
     // throw VmError{Excno::fatal, "cannot run an uninitialized VM"};
     return (int)Excno::fatal;  // no ~ for unhandled exceptions
   }
+  CellArenaScope arena_scope{cell_arena ? cell_arena : CellArena::current()};
   int res = 0;
   bool restore_parent = false;
   while (true) {
@@ -24,6 +24,7 @@
 #include "vm/vmstate.h"
 #include "vm/log.h"
 #include "vm/continuation.h"
+#include "vm/cells/CellArena.h"
 #include "td/utils/HashSet.h"
 #include "td/utils/optional.h"
 
@@ -103,6 +104,7 @@ class VmState final : public VmStateInterface {
   td::uint16 max_data_depth = 512; // Default value
   int global_version{0};
   size_t chksgn_counter = 0;
+  CellArena* cell_arena{nullptr};
   std::unique_ptr<ParentVmState> parent = nullptr;
 
  public:
@@ -406,6 +408,10 @@ class VmState final : public VmStateInterface {
   void set_max_data_depth(td::uint16 depth) {
     max_data_depth = depth;
   }
+  // cells created by run() are allocated from the arena (by default - from the arena of the current thread, if any)
+  void set_cell_arena(CellArena* arena) {
+    cell_arena = arena;
+  }
   void run_child_vm(VmState&& new_state, bool return_data, bool return_actions, bool return_gas, bool isolate_gas,
                     int ret_vals);
   void restore_parent_vm(int res);
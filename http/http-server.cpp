@@ -37,7 +37,8 @@ void HttpServer::start_up() {
   };
 
   listener_ = td::actor::create_actor<td::TcpInfiniteListener>(
-      td::actor::ActorOptions().with_name("listener").with_poll(), port_, std::make_unique<Callback>(actor_id(this)));
+      td::actor::ActorOptions().with_name("listener").with_poll(), port_, std::make_unique<Callback>(actor_id(this)),
+      server_address_);
 }
 
 void HttpServer::accepted(td::SocketFd fd) {
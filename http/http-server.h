@@ -39,18 +39,21 @@ class HttpServer : public td::actor::Actor {
         td::Promise<std::pair<std::unique_ptr<HttpResponse>, std::shared_ptr<HttpPayload>>> promise) = 0;
   };
 
-  HttpServer(td::uint16 port, std::shared_ptr<Callback> callback) : port_(port), callback_(std::move(callback)) {
+  HttpServer(td::uint16 port, std::shared_ptr<Callback> callback, std::string server_address = "0.0.0.0")
+      : port_(port), server_address_(std::move(server_address)), callback_(std::move(callback)) {
   }
 
   void start_up() override;
   void accepted(td::SocketFd fd);
 
-  static td::actor::ActorOwn<HttpServer> create(td::uint16 port, std::shared_ptr<Callback> callback) {
-    return td::actor::create_actor<HttpServer>("httpserver", port, std::move(callback));
+  static td::actor::ActorOwn<HttpServer> create(td::uint16 port, std::shared_ptr<Callback> callback,
+                                                std::string server_address = "0.0.0.0") {
+    return td::actor::create_actor<HttpServer>("httpserver", port, std::move(callback), std::move(server_address));
   }
 
  private:
   td::uint16 port_;
+  std::string server_address_;
   std::shared_ptr<Callback> callback_;
 
   td::actor::ActorOwn<td::TcpInfiniteListener> listener_;
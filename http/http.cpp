@@ -882,6 +882,9 @@ void answer_error(HttpStatusCode code, std::string reason,
       case status_bad_request:
         reason = "Bad Request";
         break;
+      case status_not_found:
+        reason = "Not Found";
+        break;
       case status_method_not_allowed:
         reason = "Method Not Allowed";
         break;
@@ -64,8 +64,9 @@ OverlayOutboundFecBroadcast::OverlayOutboundFecBroadcast(td::BufferSlice data, t
 
 td::actor::ActorId<OverlayOutboundFecBroadcast> OverlayOutboundFecBroadcast::create(
     td::BufferSlice data, td::uint32 flags, td::actor::ActorId<OverlayImpl> overlay, PublicKeyHash local_id) {
-  return td::actor::create_actor<OverlayOutboundFecBroadcast>(td::actor::ActorOptions().with_name("bcast"),
-                                                              std::move(data), flags, overlay, local_id)
+  return td::actor::create_actor<OverlayOutboundFecBroadcast>(
+             td::actor::ActorOptions().with_name("bcast").with_high_priority(), std::move(data), flags, overlay,
+             local_id)
       .release();
 }
 
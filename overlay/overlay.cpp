@@ -60,10 +60,12 @@ td::actor::ActorOwn<Overlay> Overlay::create_private(
     td::actor::ActorId<OverlayManager> manager, td::actor::ActorId<dht::Dht> dht_node, adnl::AdnlNodeIdShort local_id,
     OverlayIdFull overlay_id, std::vector<adnl::AdnlNodeIdShort> nodes, std::unique_ptr<Overlays::Callback> callback,
     OverlayPrivacyRules rules, std::string scope, OverlayOptions opts) {
+  // Private overlays carry catchain traffic of validator groups
   return td::actor::create_actor<OverlayImpl>(
-      overlay_actor_name(overlay_id), keyring, adnl, manager, dht_node, local_id, std::move(overlay_id),
-      OverlayType::FixedMemberList, std::move(nodes), std::vector<PublicKeyHash>(), OverlayMemberCertificate{},
-      std::move(callback), std::move(rules), std::move(scope));
+      td::actor::ActorOptions().with_name(overlay_actor_name(overlay_id)).with_high_priority(), keyring, adnl, manager,
+      dht_node, local_id, std::move(overlay_id), OverlayType::FixedMemberList, std::move(nodes),
+      std::vector<PublicKeyHash>(), OverlayMemberCertificate{}, std::move(callback), std::move(rules),
+      std::move(scope));
 }
 
 td::actor::ActorOwn<Overlay> Overlay::create_semiprivate(
@@ -260,10 +260,20 @@ void NodeActor::loop() {
   }
 }
 
+void NodeActor::get_query_stats(td::Promise<QueryStats> promise) {
+  QueryStats stats;
+  for (auto &it : peers_) {
+    stats.peer_windows[it.first] = it.second.max_queries;
+  }
+  stats.endgame_queries = endgame_queries_;
+  promise.set_value(std::move(stats));
+}
+
 std::string NodeActor::get_stats_str() {
   td::StringBuilder sb;
   sb << "Node " << self_id_ << " " << torrent_.get_ready_parts_count() << "\t" << download_speed_;
   sb << "\toutq " << parts_.total_queries;
+  sb << "\tendgame " << endgame_queries_;
   sb << "\n";
   for (auto &it : peers_) {
     auto &state = it.second.state;
@@ -280,7 +290,7 @@ std::string NodeActor::get_stats_str() {
         sb << "\tcnt:" << parts_helper_.get_want_download_count(it.second.peer_token);
       }
     }
-    sb << "\toutq:" << state->node_queries_active_.size();
+    sb << "\toutq:" << state->node_queries_active_.size() << "/" << it.second.max_queries;
     auto node_state = state->node_state_.load();
     sb << "\tNup:" << node_state.will_upload;
     sb << "\tNdown:" << node_state.want_download;
@@ -528,35 +538,89 @@ void NodeActor::loop_queries() {
   for (auto &it : peers_) {
     auto peer_token = it.second.peer_token;
     auto &state = it.second.state;
-    if (!state->peer_state_ready_) {
-      parts_helper_.set_peer_limit(peer_token, 0);
-      continue;
-    }
-    if (!state->peer_state_.load().will_upload) {
+    if (!can_send_query(it.second)) {
       parts_helper_.set_peer_limit(peer_token, 0);
       continue;
     }
     parts_helper_.set_peer_limit(
-        peer_token, td::narrow_cast<td::uint32>(MAX_PEER_TOTAL_QUERIES - state->node_queries_active_.size()));
+        peer_token, td::narrow_cast<td::uint32>(it.second.max_queries - state->node_queries_active_.size()));
   }
 
-  auto parts = parts_helper_.get_rarest_parts(MAX_TOTAL_QUERIES);
+  // End-game queries count towards the node-wide limit too
+  auto parts = parts_helper_.get_rarest_parts(MAX_TOTAL_QUERIES - std::min(MAX_TOTAL_QUERIES, parts_.total_queries));
   for (auto &part : parts) {
     auto it = peers_.find(part.peer_id);
     CHECK(it != peers_.end());
-    auto &state = it->second.state;
-    CHECK(state->peer_state_ready_);
-    CHECK(state->peer_state_.load().will_upload);
-    CHECK(state->node_queries_active_.size() < MAX_PEER_TOTAL_QUERIES);
-    auto part_id = part.part_id;
-    if (state->node_queries_active_.insert(static_cast<td::uint32>(part_id)).second) {
-      state->node_queries_.add_element(static_cast<td::uint32>(part_id));
+    CHECK(can_send_query(it->second));
+    parts_helper_.lock_part(part.part_id);
+    send_part_query(it->second, part.part_id);
+  }
+  if (parts.empty()) {
+    loop_endgame_queries();
+  }
+}
+
+void NodeActor::loop_endgame_queries() {
+  // Nothing new can be requested. If only a few parts are left, ask other peers for the oldest queries too,
+  // so that the download is not stalled by a slow peer at the end
+  std::vector<std::pair<td::Timestamp, PartId>> in_flight;
+  for (auto &it : peers_) {
+    for (auto &query : it.second.queries_sent_at) {
+      if (!parts_.parts[query.first].ready && parts_.parts[query.first].queries_count < MAX_ENDGAME_PART_QUERIES) {
+        in_flight.emplace_back(query.second, query.first);
+      }
     }
-    parts_helper_.lock_part(part_id);
-    parts_.total_queries++;
-    parts_.parts[part_id].query_to_peer = part.peer_id;
-    state->notify_peer();
   }
+  if (in_flight.empty() || in_flight.size() > MAX_ENDGAME_PARTS || parts_.total_queries > MAX_ENDGAME_PARTS) {
+    return;
+  }
+  std::sort(in_flight.begin(), in_flight.end(),
+            [](const auto &a, const auto &b) { return a.first.at() < b.first.at(); });
+  for (auto &query : in_flight) {
+    auto part_id = query.second;
+    for (auto &it : peers_) {
+      auto &peer = it.second;
+      if (can_send_query(peer) && parts_helper_.get_ready_parts(peer.peer_token).get(part_id) &&
+          !peer.state->node_queries_active_.count(static_cast<td::uint32>(part_id))) {
+        LOG(DEBUG) << "End-game: request part " << part_id << " from " << it.first;
+        send_part_query(peer, part_id);
+        endgame_queries_++;
+        break;
+      }
+    }
+  }
+}
+
+bool NodeActor::can_send_query(const Peer &peer) const {
+  auto &state = peer.state;
+  return state->peer_state_ready_ && state->peer_state_.load().will_upload &&
+         state->node_queries_active_.size() < peer.max_queries;
+}
+
+void NodeActor::send_part_query(Peer &peer, PartId part_id) {
+  auto &state = peer.state;
+  if (state->node_queries_active_.insert(static_cast<td::uint32>(part_id)).second) {
+    state->node_queries_.add_element(static_cast<td::uint32>(part_id));
+  }
+  peer.queries_sent_at[part_id] = td::Timestamp::now();
+  parts_.total_queries++;
+  parts_.parts[part_id].queries_count++;
+  state->notify_peer();
+}
+
+void NodeActor::update_peer_window(Peer &peer, double latency, bool ok) {
+  if (!ok) {
+    peer.max_queries = td::max(MIN_PEER_QUERIES, peer.max_queries / 2);
+    return;
+  }
+  // Minimal latency approximates round-trip time without queueing. It is never reset to a later sample: with a full
+  // pipeline every sample includes the queue made by the window itself, and the window would keep growing
+  if (peer.min_latency < 0 || latency < peer.min_latency) {
+    peer.min_latency = latency;
+  }
+  double bdp = peer.download_speed.speed() * peer.min_latency / (double)torrent_.get_info().piece_size;
+  auto window = (td::uint32)std::min(bdp, (double)MAX_PEER_QUERIES) + 2;
+  peer.max_queries = td::clamp(window, MIN_PEER_QUERIES, MAX_PEER_QUERIES);
 }
 
 void NodeActor::loop_get_peers() {
@@ -621,12 +685,9 @@ void NodeActor::loop_peer(const PeerId &peer_id, Peer &peer) {
       if (!node_state.will_upload || !should_upload_) {
         return td::Status::Error("Won't upload");
       }
-      TRY_RESULT(proof, torrent_.get_piece_proof(part_id));
-      TRY_RESULT(data, torrent_.get_piece_data(part_id));
       PeerState::Part res;
-      TRY_RESULT(proof_serialized, vm::std_boc_serialize(std::move(proof)));
-      res.proof = std::move(proof_serialized);
-      res.data = td::BufferSlice(std::move(data));
+      TRY_RESULT_ASSIGN(res.proof, get_piece_proof_serialized(part_id));
+      TRY_RESULT_ASSIGN(res.data, torrent_.get_piece_buffer(part_id));
       td::uint64 size = res.data.size();
       upload_speed_.add(size);
       peer.upload_speed.add(size);
@@ -651,12 +712,22 @@ void NodeActor::loop_peer(const PeerId &peer_id, Peer &peer) {
       return td::Unit();
     });
 
-    parts_.parts[part_id].query_to_peer = {};
+    auto sent_at = peer.queries_sent_at.find(part_id);
+    if (sent_at != peer.queries_sent_at.end()) {
+      update_peer_window(peer, td::Timestamp::now().at() - sent_at->second.at(), r_unit.is_ok());
+      peer.queries_sent_at.erase(sent_at);
+    }
+    auto &part_info = parts_.parts[part_id];
+    CHECK(part_info.queries_count > 0);
+    part_info.queries_count--;
     parts_.total_queries--;
     state->node_queries_active_.erase(part_id);
-    parts_helper_.unlock_part(part_id);
+    if (part_info.queries_count == 0) {
+      parts_helper_.unlock_part(part_id);
+    }
 
-    if (r_unit.is_ok()) {
+    // in the end-game mode the part may already be received from another peer
+    if (r_unit.is_ok() && !part_info.ready) {
       on_part_ready(part_id);
     }
   }
@@ -683,6 +754,21 @@ void NodeActor::on_part_ready(PartId part_id) {
   ready_parts_.push_back(part_id);
 }
 
+td::Result<td::BufferSlice> NodeActor::get_piece_proof_serialized(PartId part_id) {
+  auto it = piece_proofs_.find(part_id);
+  if (it != piece_proofs_.end()) {
+    return it->second.clone();
+  }
+  TRY_RESULT(proof, torrent_.get_piece_proof(part_id));
+  TRY_RESULT(proof_serialized, vm::std_boc_serialize(std::move(proof)));
+  if (piece_proofs_.size() >= MAX_CACHED_PIECE_PROOFS) {
+    piece_proofs_.erase(piece_proofs_queue_.pop());
+  }
+  piece_proofs_queue_.push(part_id);
+  piece_proofs_[part_id] = proof_serialized.clone();
+  return std::move(proof_serialized);
+}
+
 void NodeActor::got_torrent_info_str(td::BufferSlice data) {
   if (torrent_.inited_info()) {
     return;
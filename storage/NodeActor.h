@@ -27,6 +27,7 @@
 
 #include "td/utils/Random.h"
 #include "td/utils/Variant.h"
+#include "td/utils/VectorQueue.h"
 
 #include <map>
 #include "db.h"
@@ -88,6 +89,14 @@ class NodeActor : public td::actor::Actor {
   }
   std::string get_stats_str();
 
+  struct QueryStats {
+    // pipeline size of each peer
+    std::map<PeerId, td::uint32> peer_windows;
+    // queries for parts that were already requested from another peer
+    td::uint64 endgame_queries{0};
+  };
+  void get_query_stats(td::Promise<QueryStats> promise);
+
   void set_should_download(bool should_download);
   void set_should_upload(bool should_upload);
 
@@ -139,13 +148,19 @@ class NodeActor : public td::actor::Actor {
     std::shared_ptr<PeerState> state;
     PartsHelper::PeerToken peer_token;
     LoadSpeed download_speed, upload_speed;
+
+    // Size of the pipeline of getPiece queries: bandwidth-delay product of the peer plus some headroom
+    td::uint32 max_queries{INITIAL_PEER_QUERIES};
+    std::map<PartId, td::Timestamp> queries_sent_at;
+    double min_latency{-1.0};
   };
 
   std::map<PeerId, Peer> peers_;
 
   struct PartsSet {
     struct Info {
-      td::optional<PeerId> query_to_peer;
+      // number of peers, which are asked for the part; more than one only in the end-game mode
+      td::uint32 queries_count{0};
       bool ready{false};
     };
     size_t total_queries{0};
@@ -153,7 +168,12 @@ class NodeActor : public td::actor::Actor {
   };
 
   PartsSet parts_;
+  td::uint64 endgame_queries_{0};
   PartsHelper parts_helper_;
+  // serialized proofs of recently uploaded pieces, they don't change once generated
+  std::map<PartId, td::BufferSlice> piece_proofs_;
+  td::VectorQueue<PartId> piece_proofs_queue_;
+  static constexpr size_t MAX_CACHED_PIECE_PROOFS = 1024;
   std::vector<PartId> ready_parts_;
   LoadSpeed download_speed_, upload_speed_;
 
@@ -189,13 +209,23 @@ class NodeActor : public td::actor::Actor {
 
   void loop_start_stop_peers();
 
-  static constexpr size_t MAX_TOTAL_QUERIES = 20;
-  static constexpr size_t MAX_PEER_TOTAL_QUERIES = 5;
+  static constexpr size_t MAX_TOTAL_QUERIES = 256;
+  static constexpr td::uint32 MIN_PEER_QUERIES = 2;
+  static constexpr td::uint32 INITIAL_PEER_QUERIES = 5;
+  static constexpr td::uint32 MAX_PEER_QUERIES = 64;
+  // end-game mode starts when all remaining parts are requested and at most this number of them is in flight
+  static constexpr size_t MAX_ENDGAME_PARTS = 32;
+  static constexpr td::uint32 MAX_ENDGAME_PART_QUERIES = 2;
   void loop_queries();
+  void loop_endgame_queries();
+  bool can_send_query(const Peer &peer) const;
+  void send_part_query(Peer &peer, PartId part_id);
+  void update_peer_window(Peer &peer, double latency, bool ok);
   void loop_get_peers();
   void got_peers(td::Result<std::vector<PeerId>> r_peers);
   void loop_peer(const PeerId &peer_id, Peer &peer);
   void on_part_ready(PartId part_id);
+  td::Result<td::BufferSlice> get_piece_proof_serialized(PartId part_id);
 
   void loop_will_upload();
 
@@ -0,0 +1,127 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PieceHasher.h"
+
+#include "td/utils/crypto.h"
+#include "td/utils/misc.h"
+
+namespace ton {
+
+PieceHasher::PieceHasher(td::uint64 piece_size, size_t threads) : piece_size_(piece_size) {
+  CHECK(piece_size_ > 0);
+  if (threads == 0) {
+    threads = td::clamp<size_t>(td::thread::hardware_concurrency(), 1, 8);
+  }
+  threads_count_ = threads;
+  batch_pieces_ = td::max<size_t>((size_t)((16 << 20) / piece_size_), threads_count_);
+  for (size_t t = 0; t < threads_count_; t++) {
+    threads_.emplace_back([this] { run_worker(); });
+  }
+}
+
+PieceHasher::~PieceHasher() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  work_cond_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+td::MutableSlice PieceHasher::prepare_piece(td::uint64 size) {
+  CHECK(size <= piece_size_);
+  if (batches_[cur_batch_].pieces.size() == batch_pieces_) {
+    wait_batch();
+    start_batch();
+  }
+  auto &batch = batches_[cur_batch_];
+  if (batch.buffer.empty()) {
+    batch.buffer = td::BufferSlice(batch_pieces_ * piece_size_);
+  }
+  prepared_size_ = size;
+  return batch.buffer.as_slice().substr(batch.pieces.size() * piece_size_, size);
+}
+
+void PieceHasher::confirm_piece(size_t piece_i) {
+  auto &batch = batches_[cur_batch_];
+  CHECK(batch.pieces.size() < batch_pieces_);
+  batch.pieces.push_back(Piece{piece_i, prepared_size_, {}});
+}
+
+std::vector<std::pair<size_t, td::Bits256>> PieceHasher::finish() {
+  wait_batch();
+  if (!batches_[cur_batch_].pieces.empty()) {
+    start_batch();
+    wait_batch();
+  }
+  return std::move(result_);
+}
+
+void PieceHasher::start_batch() {
+  auto &batch = batches_[cur_batch_];
+  cur_batch_ ^= 1;
+  if (batch.pieces.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    CHECK(work_batch_ == nullptr);
+    work_batch_ = &batch;
+    next_piece_ = 0;
+    pending_pieces_ = batch.pieces.size();
+  }
+  work_cond_.notify_all();
+}
+
+void PieceHasher::wait_batch() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cond_.wait(lock, [&] { return pending_pieces_ == 0; });
+    work_batch_ = nullptr;
+  }
+  auto &batch = batches_[cur_batch_ ^ 1];
+  for (auto &piece : batch.pieces) {
+    result_.emplace_back(piece.piece_i, piece.hash);
+  }
+  batch.pieces.clear();
+}
+
+void PieceHasher::run_worker() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    work_cond_.wait(lock, [&] {
+      return stop_ || (work_batch_ != nullptr && next_piece_ < work_batch_->pieces.size());
+    });
+    if (stop_) {
+      return;
+    }
+    auto &batch = *work_batch_;
+    size_t i = next_piece_++;
+    lock.unlock();
+    auto &piece = batch.pieces[i];
+    td::sha256(batch.buffer.as_slice().substr(i * piece_size_, piece.size), piece.hash.as_slice());
+    lock.lock();
+    if (--pending_pieces_ == 0) {
+      done_cond_.notify_one();
+    }
+  }
+}
+
+}  // namespace ton
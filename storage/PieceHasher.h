@@ -0,0 +1,82 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "td/utils/buffer.h"
+#include "td/utils/port/thread.h"
+#include "common/bitstring.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace ton {
+
+// Computes sha256 of torrent pieces on several threads.
+// The caller reads pieces into the buffers returned by prepare_piece. When a batch of pieces is full, it is hashed
+// in background while the next batch is read, so hashing overlaps with disk reads and at most two batches are kept
+// in memory. Worker threads live as long as the hasher.
+class PieceHasher {
+ public:
+  // threads = 0 means number of cpus (at most 8)
+  explicit PieceHasher(td::uint64 piece_size, size_t threads = 0);
+  PieceHasher(const PieceHasher &) = delete;
+  PieceHasher &operator=(const PieceHasher &) = delete;
+  ~PieceHasher();
+
+  // Buffer for the next piece. It is discarded if confirm_piece is not called before the next prepare_piece.
+  td::MutableSlice prepare_piece(td::uint64 size);
+  void confirm_piece(size_t piece_i);
+  // Returns (piece, hash) for all confirmed pieces in the order of confirmation
+  std::vector<std::pair<size_t, td::Bits256>> finish();
+
+ private:
+  struct Piece {
+    size_t piece_i;
+    td::uint64 size;
+    td::Bits256 hash;
+  };
+  struct Batch {
+    td::BufferSlice buffer;
+    std::vector<Piece> pieces;
+  };
+
+  td::uint64 piece_size_;
+  size_t threads_count_;
+  size_t batch_pieces_;
+  Batch batches_[2];
+  size_t cur_batch_ = 0;
+  td::uint64 prepared_size_ = 0;
+  std::vector<std::pair<size_t, td::Bits256>> result_;
+
+  std::mutex mutex_;
+  std::condition_variable work_cond_;
+  std::condition_variable done_cond_;
+  // batch, which is being hashed; guarded by mutex_
+  Batch *work_batch_ = nullptr;
+  size_t next_piece_ = 0;
+  size_t pending_pieces_ = 0;
+  bool stop_ = false;
+  std::vector<td::thread> threads_;
+
+  void start_batch();
+  void wait_batch();
+  void run_worker();
+};
+
+}  // namespace ton
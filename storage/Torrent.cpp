@@ -18,6 +18,7 @@
 */
 
 #include "Torrent.h"
+#include "PieceHasher.h"
 
 #include "td/utils/Status.h"
 #include "td/utils/crypto.h"
@@ -230,13 +231,12 @@ void Torrent::validate() {
     pieces.clear();
   };
 
-  td::BufferSlice buf(info_.piece_size);
+  PieceHasher hasher(info_.piece_size);
   ChunkState::Cache cache;
   cache.slice = td::BufferSlice(td::max(8u << 20, info_.piece_size));
   for (size_t piece_i = 0; piece_i < info_.pieces_count(); piece_i++) {
     auto piece = info_.get_piece_info(piece_i);
-    td::Sha256State sha256;
-    sha256.init();
+    auto piece_data = hasher.prepare_piece(piece.size);
     bool skipped = false;
     auto is_ok = iterate_piece(piece, [&](auto it, auto info) {
       if (!it->data) {
@@ -246,23 +246,20 @@ void Torrent::validate() {
       if (!it->has_piece(info.chunk_offset, info.size)) {
         return td::Status::Error("Don't have piece");
       }
-      auto dest = buf.as_slice().truncate(info.size);
-      TRY_STATUS(it->get_piece(dest, info.chunk_offset, &cache));
-      sha256.feed(dest);
+      TRY_STATUS(it->get_piece(piece_data.substr(info.piece_offset, info.size), info.chunk_offset, &cache));
       return td::Status::OK();
     });
     if (is_ok.is_error()) {
       LOG_IF(ERROR, !skipped) << "Failed: " << is_ok;
       continue;
     }
-    td::Bits256 hash;
-    sha256.extract(hash.as_slice());
-    pieces.emplace_back(piece_i, hash);
+    hasher.confirm_piece(piece_i);
   }
+  pieces = hasher.finish();
   flush();
 }
 
-td::Result<std::string> Torrent::get_piece_data(td::uint64 piece_i) {
+td::Status Torrent::check_piece_ready(td::uint64 piece_i) const {
   if (!inited_info_) {
     return td::Status::Error("Torrent info not inited");
   }
@@ -272,6 +269,17 @@ td::Result<std::string> Torrent::get_piece_data(td::uint64 piece_i) {
   if (!piece_is_ready_[piece_i]) {
     return td::Status::Error("Piece is not ready");
   }
+  return td::Status::OK();
+}
+
+td::Status Torrent::read_piece(td::uint64 piece_i, td::MutableSlice dest) {
+  return iterate_piece(info_.get_piece_info(piece_i), [&](auto it, auto info) {
+    return it->get_piece(dest.substr(info.piece_offset, info.size), info.chunk_offset);
+  });
+}
+
+td::Result<std::string> Torrent::get_piece_data(td::uint64 piece_i) {
+  TRY_STATUS(check_piece_ready(piece_i));
   auto it = pending_pieces_.find(piece_i);
   if (it != pending_pieces_.end()) {
     return it->second;
@@ -280,15 +288,26 @@ td::Result<std::string> Torrent::get_piece_data(td::uint64 piece_i) {
   if (it2 != in_memory_pieces_.end()) {
     return it2->second.data;
   }
-  auto piece = info_.get_piece_info(piece_i);
-
-  std::string res(piece.size, '\0');
-  iterate_piece(piece, [&](auto it, auto info) {
-    return it->get_piece(td::MutableSlice(res).substr(info.piece_offset, info.size), info.chunk_offset);
-  });
+  std::string res(info_.get_piece_info(piece_i).size, '\0');
+  TRY_STATUS(read_piece(piece_i, res));
   return res;
 }
 
+td::Result<td::BufferSlice> Torrent::get_piece_buffer(td::uint64 piece_i) {
+  TRY_STATUS(check_piece_ready(piece_i));
+  auto it = pending_pieces_.find(piece_i);
+  if (it != pending_pieces_.end()) {
+    return td::BufferSlice(it->second);
+  }
+  auto it2 = in_memory_pieces_.find(piece_i);
+  if (it2 != in_memory_pieces_.end()) {
+    return td::BufferSlice(it2->second.data);
+  }
+  td::BufferSlice res(info_.get_piece_info(piece_i).size);
+  TRY_STATUS(read_piece(piece_i, res.as_slice()));
+  return std::move(res);
+}
+
 td::Result<td::Ref<vm::Cell>> Torrent::get_piece_proof(td::uint64 piece_i) {
   if (!inited_info_) {
     return td::Status::Error("Torrent info not inited");
@@ -649,8 +668,9 @@ void Torrent::load_from_files(std::string files_path) {
       new_blobs.push_back(R.move_as_ok());
     }
   }
-  auto load_new_piece = [&](size_t piece_i) -> td::Result<std::string> {
+  auto load_new_piece = [&](size_t piece_i, td::MutableSlice data) -> td::Status {
     auto piece = info_.get_piece_info(piece_i);
+    CHECK(data.size() == piece.size);
     bool included = false;
     TRY_STATUS(iterate_piece(piece, [&](auto it, IterateInfo info) {
       if (!it->excluded) {
@@ -661,41 +681,37 @@ void Torrent::load_from_files(std::string files_path) {
     if (!included) {
       return td::Status::Error("Piece is excluded");
     }
-    std::string data(piece.size, '\0');
     TRY_STATUS(iterate_piece(piece, [&](auto it, IterateInfo info) {
       size_t chunk_i = it - chunks_.begin();
       if (!new_blobs[chunk_i]) {
         return td::Status::Error("No such file");
       }
-      TRY_RESULT(s, new_blobs[chunk_i].value().view_copy(td::MutableSlice(data).substr(info.piece_offset, info.size),
+      TRY_RESULT(s, new_blobs[chunk_i].value().view_copy(data.substr(info.piece_offset, info.size),
                                                          info.chunk_offset));
       if (s != info.size) {
         return td::Status::Error("Can't read file");
       }
       return td::Status::OK();
     }));
-    return data;
+    return td::Status::OK();
   };
-  std::vector<std::pair<size_t, td::Bits256>> new_pieces;
+  PieceHasher hasher(info_.piece_size);
   for (size_t i = 0; i < piece_is_ready_.size(); ++i) {
     if (piece_is_ready_[i]) {
       continue;
     }
-    auto r_data = load_new_piece(i);
-    if (r_data.is_error()) {
+    if (load_new_piece(i, hasher.prepare_piece(info_.get_piece_info(i).size)).is_error()) {
       continue;
     }
-    td::Bits256 hash;
-    td::sha256(r_data.ok(), hash.as_slice());
-    new_pieces.emplace_back(i, hash);
+    hasher.confirm_piece(i);
   }
   size_t added_cnt = 0;
-  for (size_t i : merkle_tree_.add_pieces(std::move(new_pieces))) {
-    auto r_data = load_new_piece(i);
-    if (r_data.is_error()) {
+  for (size_t i : merkle_tree_.add_pieces(hasher.finish())) {
+    std::string data(info_.get_piece_info(i).size, '\0');
+    if (load_new_piece(i, data).is_error()) {
       continue;
     }
-    if (add_piece(i, r_data.ok(), {}).is_ok()) {
+    if (add_piece(i, data, {}).is_ok()) {
       ++added_cnt;
     }
   }
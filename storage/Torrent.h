@@ -52,6 +52,8 @@ class Torrent {
 
   // get piece and proof
   td::Result<std::string> get_piece_data(td::uint64 piece_i);
+  // same as get_piece_data, but pieces from files are read directly into the result
+  td::Result<td::BufferSlice> get_piece_buffer(td::uint64 piece_i);
   td::Result<td::Ref<vm::Cell>> get_piece_proof(td::uint64 piece_i);
 
   // add piece (with an optional proof)
@@ -235,6 +237,8 @@ class Torrent {
   td::Status iterate_piece(Info::PieceInfo piece, F &&f);
   void add_pending_pieces();
 
+  td::Status check_piece_ready(td::uint64 piece_i) const;
+  td::Status read_piece(td::uint64 piece_i, td::MutableSlice dest);
   td::Status add_pending_piece(td::uint64 piece_i, td::Slice data);
   td::Status add_validated_piece(td::uint64 piece_i, td::Slice data);
 };
@@ -19,7 +19,7 @@
 
 #include "TorrentCreator.h"
 
-#include "td/db/utils/CyclicBuffer.h"
+#include "PieceHasher.h"
 
 #include "td/utils/crypto.h"
 #include "td/utils/PathView.h"
@@ -135,49 +135,12 @@ td::Result<Torrent> Torrent::Creator::finalize() {
     header.dir_name = options_.dir_name.value();
   }
 
-  // Now we should stream all data to calculate sha256 of all pieces
-
-  std::string buffer;
-  td::CyclicBuffer::Options cb_options;
-  cb_options.chunk_size = td::max(options_.piece_size * 16, (1 << 20) / options_.piece_size * options_.piece_size);
-  cb_options.count = 2;
-
-  auto reader_writer = td::CyclicBuffer::create(cb_options);
-  auto reader = std::move(reader_writer.first);
-  auto writer = std::move(reader_writer.second);
-
   auto header_size = header.serialization_size();
   auto file_size = header_size + data_offset;
   auto pieces_count = (file_size + options_.piece_size - 1) / options_.piece_size;
   std::vector<Torrent::ChunkState> chunks;
-  std::vector<td::Bits256> pieces;
-  auto flush_reader = [&](bool force) {
-    while (true) {
-      auto slice = reader.prepare_read();
-      slice.truncate(options_.piece_size);
-      if (slice.empty() || (slice.size() != options_.piece_size && !force)) {
-        break;
-      }
-      td::Bits256 hash;
-      sha256(slice, hash.as_slice());
-      pieces.push_back(hash);
-      reader.confirm_read(slice.size());
-    }
-  };
   td::uint64 offset = 0;
-  auto add_blob = [&](auto data, td::Slice name) {
-    td::uint64 data_offset = 0;
-    while (data_offset < data.size()) {
-      auto dest = writer.prepare_write();
-      CHECK(dest.size() != 0);
-      dest.truncate(data.size() - data_offset);
-      TRY_RESULT(got_size, data.view_copy(dest, data_offset));
-      CHECK(got_size != 0);
-      data_offset += got_size;
-      writer.confirm_write(got_size);
-      flush_reader(false);
-    }
-
+  auto add_chunk = [&](td::BlobView data, td::Slice name) {
     Torrent::ChunkState chunk;
     chunk.name = name.str();
     chunk.offset = offset;
@@ -187,7 +150,6 @@ td::Result<Torrent> Torrent::Creator::finalize() {
 
     offset += chunk.size;
     chunks.push_back(std::move(chunk));
-    return td::Status::OK();
   };
 
   Torrent::Info info;
@@ -196,13 +158,41 @@ td::Result<Torrent> Torrent::Creator::finalize() {
   info.header_size = header_str.size();
   td::sha256(header_str, info.header_hash.as_slice());
 
-  add_blob(td::BufferSliceBlobView::create(td::BufferSlice(header_str)), "").ensure();
+  add_chunk(td::BufferSliceBlobView::create(td::BufferSlice(header_str)), "");
   for (auto& file : files_) {
-    add_blob(std::move(file.data), file.name).ensure();
+    add_chunk(std::move(file.data), file.name);
   }
-  flush_reader(true);
-  CHECK(pieces.size() == pieces_count);
   CHECK(offset == file_size);
+
+  // Now we should stream all data to calculate sha256 of all pieces
+  PieceHasher hasher(options_.piece_size);
+  size_t chunk_i = 0;
+  td::uint64 chunk_offset = 0;
+  for (td::uint64 piece_i = 0; piece_i < pieces_count; piece_i++) {
+    auto dest = hasher.prepare_piece(td::min<td::uint64>(options_.piece_size, file_size - piece_i * options_.piece_size));
+    while (!dest.empty()) {
+      auto& chunk = chunks[chunk_i];
+      if (chunk_offset == chunk.size) {
+        chunk_i++;
+        chunk_offset = 0;
+        continue;
+      }
+      auto part = dest;
+      part.truncate(chunk.size - chunk_offset);
+      TRY_RESULT(got_size, chunk.data.view_copy(part, chunk_offset));
+      if (got_size == 0) {
+        return td::Status::Error(PSLICE() << "Failed to read " << chunk.name);
+      }
+      chunk_offset += got_size;
+      dest.remove_prefix(got_size);
+    }
+    hasher.confirm_piece(piece_i);
+  }
+  std::vector<td::Bits256> pieces;
+  for (auto& piece : hasher.finish()) {
+    pieces.push_back(piece.second);
+  }
+  CHECK(pieces.size() == pieces_count);
   MerkleTree tree(std::move(pieces));
 
   info.header_size = header.serialization_size();
@@ -23,6 +23,7 @@
 #include "td/utils/misc.h"
 #include "td/utils/optional.h"
 #include "td/utils/overloaded.h"
+#include "td/utils/Random.h"
 #include "td/utils/Status.h"
 #include "td/utils/Span.h"
 #include "td/utils/tests.h"
@@ -45,6 +46,8 @@
 
 #include "td/db/utils/CyclicBuffer.h"
 
+#include "common/delay.h"
+
 #include "vm/boc.h"
 #include "vm/cells.h"
 #include "vm/cellslice.h"
@@ -60,6 +63,7 @@
 #include "PeerState.h"
 #include "Torrent.h"
 #include "TorrentCreator.h"
+#include "PieceHasher.h"
 
 #include "NodeActor.h"
 #include "PeerActor.h"
@@ -1045,6 +1049,43 @@ TEST(Torrent, OneFile) {
   }
 };
 
+TEST(Torrent, PieceHasher) {
+  auto check = [](td::uint64 piece_size, size_t threads, size_t pieces_count) {
+    td::Random::Xorshift128plus rnd(123);
+    std::vector<std::pair<size_t, td::Bits256>> expected;
+    ton::PieceHasher hasher(piece_size, threads);
+    for (size_t i = 0; i < pieces_count; i++) {
+      // the last piece is short
+      auto size = i + 1 == pieces_count ? piece_size / 3 + 1 : piece_size;
+      auto slice = hasher.prepare_piece(size);
+      ASSERT_EQ(size, slice.size());
+      for (auto &c : slice) {
+        c = static_cast<char>(rnd());
+      }
+      // every fifth piece is skipped: its buffer is reused by the next one
+      if (i % 5 == 3) {
+        continue;
+      }
+      td::Bits256 hash;
+      td::sha256(slice, hash.as_slice());
+      expected.emplace_back(i, hash);
+      hasher.confirm_piece(i);
+    }
+    auto result = hasher.finish();
+    ASSERT_EQ(expected.size(), result.size());
+    for (size_t i = 0; i < result.size(); i++) {
+      ASSERT_EQ(expected[i].first, result[i].first);
+      ASSERT_TRUE(expected[i].second == result[i].second);
+    }
+  };
+  // 16 pieces per batch
+  check(1 << 20, 3, 70);
+  // 256 pieces per batch
+  check(1 << 16, 1, 1000);
+  check(1 << 16, 0, 1);
+  check(1 << 16, 4, 0);
+}
+
 TEST(Torrent, PartsHelper) {
   int parts_count = 100;
   ton::PartsHelper parts(parts_count);
@@ -1073,208 +1114,221 @@ void print_debug(ton::Torrent *torrent) {
   LOG(ERROR) << torrent->get_stats_str();
 }
 
-TEST(Torrent, Peer) {
-  class PeerManager : public td::actor::Actor {
-   public:
-    void send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Promise<td::BufferSlice> promise) {
-      send_closure(get_outbound_channel(src), &NetChannel::send, query.size(),
-                   promise.send_closure(actor_id(this), &PeerManager::do_send_query, src, dst, std::move(query)));
-    }
+class PeerManager : public td::actor::Actor {
+ public:
+  // Channels of peers that are not in channel_options are fast and have no latency
+  explicit PeerManager(std::map<ton::PeerId, NetChannel::Options> channel_options = {})
+      : channel_options_(std::move(channel_options)) {
+  }
 
-    void do_send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
-                       td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      send_closure(get_inbound_channel(dst), &NetChannel::send, query.size(),
-                   promise.send_closure(actor_id(this), &PeerManager::execute_query, src, dst, std::move(query)));
-    }
+  void send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Promise<td::BufferSlice> promise) {
+    auto size = query.size();
+    send_closure(get_outbound_channel(src), &NetChannel::send, size,
+                 promise.send_closure(actor_id(this), &PeerManager::do_send_query, src, dst, std::move(query)));
+  }
 
-    void execute_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
-                       td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      promise = promise.send_closure(actor_id(this), &PeerManager::send_response, src, dst);
-      auto it = peers_.find(std::make_pair(dst, src));
-      if (it == peers_.end()) {
-        LOG(ERROR) << "No such peer";
-        auto node_it = nodes_.find(dst);
-        if (node_it == nodes_.end()) {
-          LOG(ERROR) << "Unknown query destination";
-          promise.set_error(td::Status::Error("Unknown query destination"));
-          return;
-        }
-        send_closure(node_it->second, &ton::NodeActor::start_peer, src,
-                     [promise = std::move(promise),
-                      query = std::move(query)](td::Result<td::actor::ActorId<ton::PeerActor>> r_peer) mutable {
-                       TRY_RESULT_PROMISE(promise, peer, std::move(r_peer));
-                       send_closure(peer, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
-                     });
+  void do_send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
+                     td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    auto size = query.size();
+    send_closure(get_inbound_channel(dst), &NetChannel::send, size,
+                 promise.send_closure(actor_id(this), &PeerManager::execute_query, src, dst, std::move(query)));
+  }
+
+  void execute_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
+                     td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    promise = promise.send_closure(actor_id(this), &PeerManager::send_response, src, dst);
+    auto it = peers_.find(std::make_pair(dst, src));
+    if (it == peers_.end()) {
+      LOG(ERROR) << "No such peer";
+      auto node_it = nodes_.find(dst);
+      if (node_it == nodes_.end()) {
+        LOG(ERROR) << "Unknown query destination";
+        promise.set_error(td::Status::Error("Unknown query destination"));
         return;
       }
-      send_closure(it->second, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
+      send_closure(node_it->second, &ton::NodeActor::start_peer, src,
+                   [promise = std::move(promise),
+                    query = std::move(query)](td::Result<td::actor::ActorId<ton::PeerActor>> r_peer) mutable {
+                     TRY_RESULT_PROMISE(promise, peer, std::move(r_peer));
+                     send_closure(peer, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
+                   });
+      return;
     }
+    send_closure(it->second, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
+  }
 
-    void send_response(ton::PeerId src, ton::PeerId dst, td::Result<td::BufferSlice> r_response,
-                       td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, response, std::move(r_response));
-      send_closure(get_outbound_channel(dst), &NetChannel::send, response.size(),
-                   promise.send_closure(actor_id(this), &PeerManager::do_send_response, src, dst, std::move(response)));
-    }
+  void send_response(ton::PeerId src, ton::PeerId dst, td::Result<td::BufferSlice> r_response,
+                     td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, response, std::move(r_response));
+    auto size = response.size();
+    send_closure(get_outbound_channel(dst), &NetChannel::send, size,
+                 promise.send_closure(actor_id(this), &PeerManager::do_send_response, src, dst, std::move(response)));
+  }
 
-    void do_send_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
-                          td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      send_closure(
-          get_inbound_channel(src), &NetChannel::send, response.size(),
-          promise.send_closure(actor_id(this), &PeerManager::do_execute_response, src, dst, std::move(response)));
-    }
+  void do_send_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
+                        td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    auto size = response.size();
+    send_closure(
+        get_inbound_channel(src), &NetChannel::send, size,
+        promise.send_closure(actor_id(this), &PeerManager::do_execute_response, src, dst, std::move(response)));
+  }
 
-    void do_execute_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
-                             td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      promise.set_value(std::move(response));
-    }
+  void do_execute_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
+                           td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    promise.set_value(std::move(response));
+  }
 
-    void register_peer(ton::PeerId src, ton::PeerId dst, td::actor::ActorId<ton::PeerActor> peer) {
-      peers_[std::make_pair(src, dst)] = std::move(peer);
-    }
+  void register_peer(ton::PeerId src, ton::PeerId dst, td::actor::ActorId<ton::PeerActor> peer) {
+    peers_[std::make_pair(src, dst)] = std::move(peer);
+  }
 
-    void register_node(ton::PeerId src, td::actor::ActorId<ton::NodeActor> node) {
-      nodes_[src] = std::move(node);
+  void register_node(ton::PeerId src, td::actor::ActorId<ton::NodeActor> node) {
+    nodes_[src] = std::move(node);
+  }
+  ~PeerManager() {
+    for (auto &it : inbound_channel_) {
+      LOG(ERROR) << it.first << " received " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
     }
-    ~PeerManager() {
-      for (auto &it : inbound_channel_) {
-        LOG(ERROR) << it.first << " received " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
-      }
-      for (auto &it : outbound_channel_) {
-        LOG(ERROR) << it.first << " sent " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
-      }
+    for (auto &it : outbound_channel_) {
+      LOG(ERROR) << it.first << " sent " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
     }
+  }
 
-   private:
-    std::map<std::pair<ton::PeerId, ton::PeerId>, td::actor::ActorId<ton::PeerActor>> peers_;
-    std::map<ton::PeerId, td::actor::ActorId<ton::NodeActor>> nodes_;
-    std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> inbound_channel_;
-    std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> outbound_channel_;
+ private:
+  std::map<std::pair<ton::PeerId, ton::PeerId>, td::actor::ActorId<ton::PeerActor>> peers_;
+  std::map<ton::PeerId, td::actor::ActorId<ton::NodeActor>> nodes_;
+  std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> inbound_channel_;
+  std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> outbound_channel_;
+  std::map<ton::PeerId, NetChannel::Options> channel_options_;
+
+  td::actor::ActorOwn<Sleep> sleep_;
+  void start_up() override {
+    sleep_ = Sleep::create();
+  }
 
-    td::actor::ActorOwn<Sleep> sleep_;
-    void start_up() override {
-      sleep_ = Sleep::create();
+  NetChannel::Options get_channel_options(ton::PeerId peer_id) const {
+    auto it = channel_options_.find(peer_id);
+    if (it != channel_options_.end()) {
+      return it->second;
     }
-
-    td::actor::ActorId<NetChannel> get_outbound_channel(ton::PeerId peer_id) {
-      auto &res = outbound_channel_[peer_id];
-      if (res.empty()) {
-        NetChannel::Options options;
-        options.speed = 1000 * MegaByte;
-        options.buffer = 1000 * MegaByte;
-        options.rtt = 0;
-        res = NetChannel::create(options, sleep_.get());
-      }
-      return res.get();
+    NetChannel::Options options;
+    options.speed = 1000 * MegaByte;
+    options.buffer = 1000 * MegaByte;
+    options.rtt = 0;
+    return options;
+  }
+  td::actor::ActorId<NetChannel> get_outbound_channel(ton::PeerId peer_id) {
+    auto &res = outbound_channel_[peer_id];
+    if (res.empty()) {
+      res = NetChannel::create(get_channel_options(peer_id), sleep_.get());
     }
-    td::actor::ActorId<NetChannel> get_inbound_channel(ton::PeerId peer_id) {
-      auto &res = inbound_channel_[peer_id];
-      if (res.empty()) {
-        NetChannel::Options options;
-        options.speed = 1000 * MegaByte;
-        options.buffer = 1000 * MegaByte;
-        options.rtt = 0;
-        res = NetChannel::create(options, sleep_.get());
-      }
-      return res.get();
+    return res.get();
+  }
+  td::actor::ActorId<NetChannel> get_inbound_channel(ton::PeerId peer_id) {
+    auto &res = inbound_channel_[peer_id];
+    if (res.empty()) {
+      res = NetChannel::create(get_channel_options(peer_id), sleep_.get());
     }
-  };
+    return res.get();
+  }
+};
 
-  class PeerCreator : public ton::NodeActor::NodeCallback {
-   public:
-    PeerCreator(td::actor::ActorId<PeerManager> peer_manager, ton::PeerId self_id, std::vector<ton::PeerId> peers)
-        : peer_manager_(std::move(peer_manager)), peers_(std::move(peers)), self_id_(self_id) {
-    }
-    void get_peers(ton::PeerId src, td::Promise<std::vector<ton::PeerId>> promise) override {
-      auto peers = peers_;
-      promise.set_value(std::move(peers));
-    }
-    void register_self(td::actor::ActorId<ton::NodeActor> self) override {
-      self_ = self;
-      send_closure(peer_manager_, &PeerManager::register_node, self_id_, self_);
-    }
-    td::actor::ActorOwn<ton::PeerActor> create_peer(ton::PeerId self_id, ton::PeerId peer_id,
-                                                    std::shared_ptr<ton::PeerState> state) override {
-      class PeerCallback : public ton::PeerActor::Callback {
-       public:
-        PeerCallback(ton::PeerId self_id, ton::PeerId peer_id, td::actor::ActorId<PeerManager> peer_manager)
-            : self_id_{self_id}, peer_id_{peer_id}, peer_manager_(peer_manager) {
-        }
-        void register_self(td::actor::ActorId<ton::PeerActor> self) override {
-          self_ = std::move(self);
-          send_closure(peer_manager_, &PeerManager::register_peer, self_id_, peer_id_, self_);
-        }
-        void send_query(td::uint64 query_id, td::BufferSlice query) override {
-          CHECK(!self_.empty());
-          class X : public td::actor::Actor {
-           public:
-            void start_up() override {
-              //LOG(ERROR) << "start";
-              alarm_timestamp() = td::Timestamp::in(4);
-            }
-            void tear_down() override {
-              //LOG(ERROR) << "finish";
-            }
-            void alarm() override {
-              //LOG(FATAL) << "WTF?";
-              alarm_timestamp() = td::Timestamp::in(4);
-            }
-          };
-          send_closure(
-              peer_manager_, &PeerManager::send_query, self_id_, peer_id_, std::move(query),
-              [self = self_, query_id,
-               tmp = td::actor::create_actor<X>(PSLICE() << self_id_ << "->" << peer_id_ << " : " << query_id)](
-                  auto x) { promise_send_closure(self, &ton::PeerActor::on_query_result, query_id)(std::move(x)); });
-        }
+class PeerCreator : public ton::NodeActor::NodeCallback {
+ public:
+  PeerCreator(td::actor::ActorId<PeerManager> peer_manager, ton::PeerId self_id, std::vector<ton::PeerId> peers)
+      : peer_manager_(std::move(peer_manager)), peers_(std::move(peers)), self_id_(self_id) {
+  }
+  void get_peers(ton::PeerId src, td::Promise<std::vector<ton::PeerId>> promise) override {
+    auto peers = peers_;
+    promise.set_value(std::move(peers));
+  }
+  void register_self(td::actor::ActorId<ton::NodeActor> self) override {
+    self_ = self;
+    send_closure(peer_manager_, &PeerManager::register_node, self_id_, self_);
+  }
+  td::actor::ActorOwn<ton::PeerActor> create_peer(ton::PeerId self_id, ton::PeerId peer_id,
+                                                  std::shared_ptr<ton::PeerState> state) override {
+    class PeerCallback : public ton::PeerActor::Callback {
+     public:
+      PeerCallback(ton::PeerId self_id, ton::PeerId peer_id, td::actor::ActorId<PeerManager> peer_manager)
+          : self_id_{self_id}, peer_id_{peer_id}, peer_manager_(peer_manager) {
+      }
+      void register_self(td::actor::ActorId<ton::PeerActor> self) override {
+        self_ = std::move(self);
+        send_closure(peer_manager_, &PeerManager::register_peer, self_id_, peer_id_, self_);
+      }
+      void send_query(td::uint64 query_id, td::BufferSlice query) override {
+        CHECK(!self_.empty());
+        class X : public td::actor::Actor {
+         public:
+          void start_up() override {
+            //LOG(ERROR) << "start";
+            alarm_timestamp() = td::Timestamp::in(4);
+          }
+          void tear_down() override {
+            //LOG(ERROR) << "finish";
+          }
+          void alarm() override {
+            //LOG(FATAL) << "WTF?";
+            alarm_timestamp() = td::Timestamp::in(4);
+          }
+        };
+        send_closure(
+            peer_manager_, &PeerManager::send_query, self_id_, peer_id_, std::move(query),
+            [self = self_, query_id,
+             tmp = td::actor::create_actor<X>(PSLICE() << self_id_ << "->" << peer_id_ << " : " << query_id)](
+                auto x) { promise_send_closure(self, &ton::PeerActor::on_query_result, query_id)(std::move(x)); });
+      }
 
-       private:
-        ton::PeerId self_id_;
-        ton::PeerId peer_id_;
-        td::actor::ActorId<ton::PeerActor> self_;
-        td::actor::ActorId<PeerManager> peer_manager_;
-      };
+     private:
+      ton::PeerId self_id_;
+      ton::PeerId peer_id_;
+      td::actor::ActorId<ton::PeerActor> self_;
+      td::actor::ActorId<PeerManager> peer_manager_;
+    };
 
-      return td::actor::create_actor<ton::PeerActor>(PSLICE() << "ton::PeerActor " << self_id << "->" << peer_id,
-                                                     td::make_unique<PeerCallback>(self_id, peer_id, peer_manager_),
-                                                     std::move(state));
-    }
+    return td::actor::create_actor<ton::PeerActor>(PSLICE() << "ton::PeerActor " << self_id << "->" << peer_id,
+                                                   td::make_unique<PeerCallback>(self_id, peer_id, peer_manager_),
+                                                   std::move(state));
+  }
 
-   private:
-    td::actor::ActorId<PeerManager> peer_manager_;
-    std::vector<ton::PeerId> peers_;
-    ton::PeerId self_id_;
-    td::actor::ActorId<ton::NodeActor> self_;
-  };
+ private:
+  td::actor::ActorId<PeerManager> peer_manager_;
+  std::vector<ton::PeerId> peers_;
+  ton::PeerId self_id_;
+  td::actor::ActorId<ton::NodeActor> self_;
+};
 
-  class TorrentCallback : public ton::NodeActor::Callback {
-   public:
-    TorrentCallback(std::shared_ptr<td::Destructor> stop_watcher, std::shared_ptr<td::Destructor> complete_watcher)
-        : stop_watcher_(stop_watcher), complete_watcher_(complete_watcher) {
-    }
+class TorrentCallback : public ton::NodeActor::Callback {
+ public:
+  TorrentCallback(std::shared_ptr<td::Destructor> stop_watcher, std::shared_ptr<td::Destructor> complete_watcher)
+      : stop_watcher_(stop_watcher), complete_watcher_(complete_watcher) {
+  }
 
-    void on_completed() override {
-      complete_watcher_.reset();
-    }
+  void on_completed() override {
+    complete_watcher_.reset();
+  }
 
-    void on_closed(ton::Torrent torrent) override {
-      CHECK(torrent.is_completed());
-      //TODO: validate torrent
-      stop_watcher_.reset();
-    }
+  void on_closed(ton::Torrent torrent) override {
+    CHECK(torrent.is_completed());
+    //TODO: validate torrent
+    stop_watcher_.reset();
+  }
 
-   private:
-    std::shared_ptr<td::Destructor> stop_watcher_;
-    std::shared_ptr<td::Destructor> complete_watcher_;
-  };
+ private:
+  std::shared_ptr<td::Destructor> stop_watcher_;
+  std::shared_ptr<td::Destructor> complete_watcher_;
+};
 
+TEST(Torrent, Peer) {
   size_t peers_n = 20;
   td::uint64 file_size = 200 * MegaByte;
   td::Random::Xorshift128plus rnd(123);
@@ -1362,3 +1416,94 @@ TEST(Torrent, Peer) {
   complete_watcher.reset();
   scheduler.run();
 }
+
+TEST(Torrent, PeerWindows) {
+  // Node 3 downloads from a fast peer 1 and a slow peer 2
+  class DownloadCallback : public ton::NodeActor::Callback {
+   public:
+    DownloadCallback(std::shared_ptr<td::Destructor> stop_watcher, std::shared_ptr<td::Destructor> complete_watcher,
+                     std::shared_ptr<td::actor::ActorId<ton::NodeActor>> node,
+                     std::shared_ptr<ton::NodeActor::QueryStats> stats)
+        : stop_watcher_(std::move(stop_watcher))
+        , complete_watcher_(std::move(complete_watcher))
+        , node_(std::move(node))
+        , stats_(std::move(stats)) {
+    }
+
+    void on_completed() override {
+      send_closure(*node_, &ton::NodeActor::get_query_stats,
+                   [stats = stats_, complete_watcher = std::move(complete_watcher_)](
+                       td::Result<ton::NodeActor::QueryStats> r_stats) mutable {
+                     *stats = r_stats.move_as_ok();
+                     // Answers to end-game queries may still be in flight, nodes are closed after they arrive
+                     ton::delay_action([complete_watcher = std::move(complete_watcher)] {}, td::Timestamp::in(5.0));
+                   });
+    }
+
+    void on_closed(ton::Torrent torrent) override {
+      CHECK(torrent.is_completed());
+      stop_watcher_.reset();
+    }
+
+   private:
+    std::shared_ptr<td::Destructor> stop_watcher_;
+    std::shared_ptr<td::Destructor> complete_watcher_;
+    std::shared_ptr<td::actor::ActorId<ton::NodeActor>> node_;
+    std::shared_ptr<ton::NodeActor::QueryStats> stats_;
+  };
+
+  td::uint64 file_size = 32 * MegaByte;
+  td::Random::Xorshift128plus rnd1(123);
+  td::Random::Xorshift128plus rnd2(123);
+  auto torrent1 = create_random_torrent(rnd1, file_size, 128 * KiloByte).torrent.unwrap();
+  auto torrent2 = create_random_torrent(rnd2, file_size, 128 * KiloByte).torrent.unwrap();
+  auto info = torrent1.get_info();
+  CHECK(info.get_hash() == torrent2.get_info().get_hash());
+  LOG(INFO) << "Torrent size " << td::format::as_size(info.file_size);
+
+  std::map<ton::PeerId, NetChannel::Options> channel_options;
+  // Download speed is averaged over at least 5 seconds, so the download must take longer than that
+  channel_options[1] = NetChannel::Options().with_buffer(1000 * MegaByte).with_rtt(0.1).with_speed(4 * MegaByte);
+  channel_options[2] = NetChannel::Options().with_buffer(1000 * MegaByte).with_rtt(0.1).with_speed(256 * KiloByte);
+
+  auto stats = std::make_shared<ton::NodeActor::QueryStats>();
+  auto node_id = std::make_shared<td::actor::ActorId<ton::NodeActor>>();
+  auto stop_watcher = td::create_shared_destructor([] { td::actor::SchedulerContext::get()->stop(); });
+  auto guard = std::make_shared<std::vector<td::actor::ActorOwn<>>>();
+  auto complete_watcher = td::create_shared_destructor([guard] {});
+
+  td::actor::Scheduler scheduler({0}, true);
+
+  scheduler.run_in_context([&] {
+    auto peer_manager = td::actor::create_actor<PeerManager>("PeerManager", std::move(channel_options));
+    guard->push_back(td::actor::create_actor<ton::NodeActor>(
+        "Node#1", 1, std::move(torrent1), td::make_unique<TorrentCallback>(stop_watcher, complete_watcher),
+        td::make_unique<PeerCreator>(peer_manager.get(), 1, std::vector<ton::PeerId>{}), nullptr,
+        ton::SpeedLimiters{}));
+    guard->push_back(td::actor::create_actor<ton::NodeActor>(
+        "Node#2", 2, std::move(torrent2), td::make_unique<TorrentCallback>(stop_watcher, complete_watcher),
+        td::make_unique<PeerCreator>(peer_manager.get(), 2, std::vector<ton::PeerId>{}), nullptr,
+        ton::SpeedLimiters{}));
+    ton::Torrent::Options options;
+    options.in_memory = true;
+    auto torrent3 = ton::Torrent::open(options, ton::TorrentMeta(info)).move_as_ok();
+    auto node_actor = td::actor::create_actor<ton::NodeActor>(
+        "Node#3", 3, std::move(torrent3),
+        td::make_unique<DownloadCallback>(stop_watcher, complete_watcher, node_id, stats),
+        td::make_unique<PeerCreator>(peer_manager.get(), 3, std::vector<ton::PeerId>{1, 2}), nullptr,
+        ton::SpeedLimiters{});
+    *node_id = node_actor.get();
+    guard->push_back(std::move(node_actor));
+    guard->push_back(std::move(peer_manager));
+  });
+  node_id.reset();
+  stop_watcher.reset();
+  guard.reset();
+  complete_watcher.reset();
+  scheduler.run();
+
+  LOG(INFO) << "Windows: fast peer " << stats->peer_windows[1] << ", slow peer " << stats->peer_windows[2]
+            << ", end-game queries " << stats->endgame_queries;
+  ASSERT_TRUE(stats->peer_windows[1] > stats->peer_windows[2]);
+  ASSERT_TRUE(stats->endgame_queries > 0);
+}
@@ -150,6 +150,31 @@ std::string ActorStats::prepare_stats() {
     sb() << ""
          << "alive: " << stat_forever.alive << " executing: " << stat_forever.executing
          << " max_executing_for: " << executing_for << "s\n";
+
+    // quantiles are printed as p50/p90/p99 for 10s, 10m and since start
+    auto quantiles = [&](td::Slice name, auto get, double scale, td::Slice unit) {
+      auto &out = sb() << name << ":\t";
+      bool first = true;
+      for (auto *stat : {&stat_10s, &stat_10m, &stat_forever}) {
+        auto &hist = get(*stat);
+        out << (first ? "" : " ") << double(hist.get_quantile(0.5)) * scale << unit << "/"
+            << double(hist.get_quantile(0.9)) * scale << unit << "/" << double(hist.get_quantile(0.99)) * scale
+            << unit;
+        first = false;
+      }
+      out << "\n";
+    };
+    quantiles("delay_p50/p90/p99", [](const ActorTypeStat &x) -> auto & { return x.delay_ticks; },
+              estimated_inv_ticks_per_second, "s");
+    quantiles("execute_p50/p90/p99", [](const ActorTypeStat &x) -> auto & { return x.execute_ticks; },
+              estimated_inv_ticks_per_second, "s");
+    quantiles("execute_messages_p50/p90/p99",
+              [](const ActorTypeStat &x) -> auto & { return x.execute_messages; }, 1.0, "");
+    quantiles("messages_per_drain_p50/p90/p99",
+              [](const ActorTypeStat &x) -> auto & { return x.messages_per_drain; }, 1.0, "");
+    sb() << "max_messages_per_drain:\t" << stat_forever.max_messages_per_drain.value_10s << " "
+         << stat_forever.max_messages_per_drain.value_10m << " "
+         << stat_forever.max_messages_per_drain.value_forever << "\n";
   };
 
   auto describe = [&](td::StringBuilder &sb, std::type_index actor_type_index) {
@@ -197,6 +222,14 @@ std::string ActorStats::prepare_stats() {
   });
   top_k_by(stats_forever, 10, "max_execute_messages_10m",
            [](Entry &x) { return cutoff(x.second.max_execute_messages.value_10m, 10u); });
+  top_k_by(stats_10m, 10, "execute_p99_10m", [&](Entry &x) {
+    return cutoff(double(x.second.execute_ticks.get_quantile(0.99)) * estimated_inv_ticks_per_second, 0.01);
+  });
+  top_k_by(stats_10m, 10, "delay_p99_10m", [&](Entry &x) {
+    return cutoff(double(x.second.delay_ticks.get_quantile(0.99)) * estimated_inv_ticks_per_second, 0.01);
+  });
+  top_k_by(stats_forever, 10, "max_messages_per_drain_10m",
+           [](Entry &x) { return cutoff(x.second.max_messages_per_drain.value_10m, 100u); });
 
   auto stats = td::transform(stats_forever, [](auto &it) { return std::make_pair(it.first, it.second); });
 
@@ -211,6 +244,11 @@ std::string ActorStats::prepare_stats() {
             [&](auto &left, auto &right) { return main_key(left.first) > main_key(right.first); });
   auto debug = Debug(SchedulerContext::get()->scheduler_group());
   debug.dump(sb);
+  sb << "worker utilization:\n";
+  for (auto &it : get_worker_utilization()) {
+    sb << "\t" << it.first << "\t" << it.second << "\n";
+  }
+  sb << "\n";
   sb << "All actors:\n";
   for (auto &it : stats) {
     sb << "\t" << ActorTypeStatManager::get_class_name(it.first.name()) << "\n";
@@ -227,6 +265,141 @@ ActorStats::PefStat::PefStat() {
   }
 }
 
+namespace {
+void escape_label(td::StringBuilder &sb, td::Slice value) {
+  for (auto c : value) {
+    if (c == '\\' || c == '"') {
+      sb << '\\' << c;
+    } else if (c == '\n') {
+      sb << "\\n";
+    } else {
+      sb << c;
+    }
+  }
+}
+
+template <class HistogramT>
+void prometheus_histogram(td::StringBuilder &sb, td::Slice metric, td::Slice actor, const HistogramT &hist,
+                          const std::vector<double> &bounds, double scale) {
+  // le bounds are fixed so that series are stable, so each bucket is counted in the first bound not below its end
+  size_t bucket = 0;
+  td::uint64 cumulative = 0;
+  for (auto bound : bounds) {
+    while (bucket < HistogramT::size && double(HistogramT::get_upper_bound(bucket)) * scale <= bound) {
+      cumulative += hist.buckets[bucket++];
+    }
+    sb << metric << "_bucket{actor=\"";
+    escape_label(sb, actor);
+    sb << "\",le=\"" << bound << "\"} " << cumulative << "\n";
+  }
+  sb << metric << "_bucket{actor=\"";
+  escape_label(sb, actor);
+  sb << "\",le=\"+Inf\"} " << hist.count << "\n";
+  sb << metric << "_sum{actor=\"";
+  escape_label(sb, actor);
+  sb << "\"} " << double(hist.sum) * scale << "\n";
+  sb << metric << "_count{actor=\"";
+  escape_label(sb, actor);
+  sb << "\"} " << hist.count << "\n";
+}
+}  // namespace
+
+std::string ActorStats::prepare_prometheus_stats() {
+  auto inv_ticks_per_second = estimate_inv_ticks_per_second();
+  auto stats = td::actor::ActorTypeStatManager::get_stats(inv_ticks_per_second);
+
+  std::vector<std::pair<std::string, const ActorTypeStat *>> actors;
+  for (auto &it : stats.stats) {
+    actors.emplace_back(ActorTypeStatManager::get_class_name(it.first.name()), &it.second);
+  }
+  std::sort(actors.begin(), actors.end(), [](auto &a, auto &b) { return a.first < b.first; });
+
+  static const std::vector<double> seconds_bounds = {1e-5, 1e-4, 1e-3, 0.005, 0.01, 0.05, 0.1, 0.2, 0.5, 1, 2, 5, 10};
+  static const std::vector<double> count_bounds = {1, 3, 7, 15, 31, 63, 127, 255, 1023, 4095, 16383, 65535};
+
+  td::StringBuilder sb;
+  auto gauge = [&](td::Slice metric, td::Slice type, td::Slice help, auto get) {
+    sb << "# HELP " << metric << " " << help << "\n";
+    sb << "# TYPE " << metric << " " << type << "\n";
+    for (auto &actor : actors) {
+      sb << metric << "{actor=\"";
+      escape_label(sb, actor.first);
+      sb << "\"} " << get(*actor.second) << "\n";
+    }
+  };
+  gauge("ton_actor_created_total", "counter", "Number of created actors",
+        [](const ActorTypeStat &x) { return x.created; });
+  gauge("ton_actor_alive", "gauge", "Number of alive actors", [](const ActorTypeStat &x) { return x.alive; });
+  gauge("ton_actor_messages_total", "counter", "Number of handled messages",
+        [](const ActorTypeStat &x) { return x.messages; });
+  gauge("ton_actor_busy_seconds_total", "counter", "Time spent handling messages",
+        [](const ActorTypeStat &x) { return x.seconds; });
+  gauge("ton_actor_max_messages_per_drain_10s", "gauge",
+        "Max number of messages taken from a mailbox in one drain in 10s (not the mailbox length)",
+        [](const ActorTypeStat &x) { return x.max_messages_per_drain.value_10s; });
+  gauge("ton_actor_max_execute_seconds_10s", "gauge", "Max duration of one activation in 10s",
+        [](const ActorTypeStat &x) { return x.max_execute_seconds.value_10s; });
+
+  auto histogram = [&](td::Slice metric, td::Slice help, auto get, const std::vector<double> &bounds, double scale) {
+    sb << "# HELP " << metric << " " << help << "\n";
+    sb << "# TYPE " << metric << " histogram\n";
+    for (auto &actor : actors) {
+      prometheus_histogram(sb, metric, actor.first, get(*actor.second), bounds, scale);
+    }
+  };
+  histogram(
+      "ton_actor_queue_delay_seconds", "Time between scheduling of an actor and start of its activation",
+      [](const ActorTypeStat &x) -> auto & { return x.delay_ticks; }, seconds_bounds, inv_ticks_per_second);
+  histogram(
+      "ton_actor_execute_seconds", "Duration of one activation of an actor",
+      [](const ActorTypeStat &x) -> auto & { return x.execute_ticks; }, seconds_bounds, inv_ticks_per_second);
+  histogram(
+      "ton_actor_execute_messages", "Messages handled in one activation of an actor",
+      [](const ActorTypeStat &x) -> auto & { return x.execute_messages; }, count_bounds, 1.0);
+  histogram(
+      "ton_actor_messages_per_drain", "Messages taken from a mailbox in one drain (not the mailbox length)",
+      [](const ActorTypeStat &x) -> auto & { return x.messages_per_drain; }, count_bounds, 1.0);
+
+  sb << "# HELP ton_actor_worker_busy_seconds_total Time spent by a scheduler worker in actors\n";
+  sb << "# TYPE ton_actor_worker_busy_seconds_total counter\n";
+  for (auto &it : sample_workers()) {
+    sb << "ton_actor_worker_busy_seconds_total{worker=\"" << it.first << "\"} "
+       << double(it.second.busy_ticks) * inv_ticks_per_second << "\n";
+  }
+  sb << "# HELP ton_actor_worker_utilization Share of time spent by a scheduler worker in actors recently\n";
+  sb << "# TYPE ton_actor_worker_utilization gauge\n";
+  for (auto &it : get_worker_utilization()) {
+    sb << "ton_actor_worker_utilization{worker=\"" << it.first << "\"} " << it.second << "\n";
+  }
+  return sb.as_cslice().str();
+}
+
+std::map<std::string, ActorStats::WorkerSample> ActorStats::sample_workers() {
+  std::map<std::string, WorkerSample> res;
+  auto now = Clocks::rdtsc();
+  Debug(SchedulerContext::get()->scheduler_group()).for_each_worker([&](std::string name, core::Debug &debug) {
+    res[std::move(name)] = WorkerSample{.busy_ticks = debug.get_busy_ticks(), .at = now};
+  });
+  return res;
+}
+
+std::map<std::string, double> ActorStats::get_worker_utilization() {
+  std::map<std::string, double> res;
+  for (auto &it : sample_workers()) {
+    WorkerSample since{.busy_ticks = 0, .at = begin_ticks_};
+    for (auto &samples : worker_samples_) {
+      auto it2 = samples.find(it.first);
+      if (it2 != samples.end()) {
+        since = it2->second;
+        break;
+      }
+    }
+    auto elapsed = it.second.at - since.at;
+    res[it.first] = elapsed == 0 ? 0.0 : double(it.second.busy_ticks - since.busy_ticks) / double(elapsed);
+  }
+  return res;
+}
+
 void ActorStats::update(td::Timestamp now) {
   auto stat = td::actor::ActorTypeStatManager::get_stats(estimate_inv_ticks_per_second());
   for (auto &timed_stat : stat_) {
@@ -11,6 +11,8 @@ class ActorStats : public td::actor::Actor {
   void start_up() override;
   double estimate_inv_ticks_per_second();
   std::string prepare_stats();
+  // Same statistics in Prometheus text exposition format
+  std::string prepare_prometheus_stats();
 
  private:
   template <class T>
@@ -41,11 +43,22 @@ class ActorStats : public td::actor::Actor {
   std::map<std::string, PefStat> pef_stats_;
   td::Timestamp begin_ts_;
   td::uint64 begin_ticks_{};
+  struct WorkerSample {
+    td::uint64 busy_ticks{0};
+    td::uint64 at{0};
+  };
+  // two last samples of busy time of workers, taken with interval of 5 seconds
+  std::map<std::string, WorkerSample> worker_samples_[2];
   void loop() override {
     alarm_timestamp() = td::Timestamp::in(5.0);
     update(td::Timestamp::now());
+    worker_samples_[0] = std::move(worker_samples_[1]);
+    worker_samples_[1] = sample_workers();
   }
   void update(td::Timestamp now);
+  static std::map<std::string, WorkerSample> sample_workers();
+  // share of time each worker spent in actors during last 5-10 seconds
+  std::map<std::string, double> get_worker_utilization();
 };
 
 }  // namespace actor
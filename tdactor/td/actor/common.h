@@ -26,6 +26,7 @@
 
 #include "td/actor/PromiseFuture.h"
 
+#include "td/utils/port/cpu_topology.h"
 #include "td/utils/Timer.h"
 
 namespace td {
@@ -63,6 +64,7 @@ class ActorSignals {
 // TODO: proper interface
 using core::Actor;
 using core::SchedulerContext;
+using core::SchedulerHintGuard;
 using core::SchedulerId;
 using core::set_debug;
 
@@ -102,6 +104,20 @@ struct Debug {
     sb << "\n";
   }
 
+  // f(name, debug) for every worker, names are "#<scheduler>:io" and "#<scheduler>:cpu#<i>"
+  template <class F>
+  void for_each_worker(F &&f) {
+    for (size_t i = 0; i < group_info_->schedulers.size(); i++) {
+      auto &scheduler = group_info_->schedulers[i];
+      if (scheduler.io_worker) {
+        f(PSTRING() << "#" << i << ":io", scheduler.io_worker->debug);
+      }
+      for (size_t j = 0; j < scheduler.cpu_workers.size(); j++) {
+        f(PSTRING() << "#" << i << ":cpu#" << j, scheduler.cpu_workers[j]->debug);
+      }
+    }
+  }
+
  private:
   core::SchedulerGroupInfo *group_info_;
 };
@@ -113,10 +129,30 @@ class Scheduler {
     }
     NodeInfo(size_t cpu_threads, size_t io_threads) : cpu_threads_(cpu_threads), io_threads_(io_threads) {
     }
+    NodeInfo &with_cpus(std::vector<unsigned> cpus) {
+      cpus_ = std::move(cpus);
+      return *this;
+    }
     size_t cpu_threads_;
     size_t io_threads_{1};
+    std::vector<unsigned> cpus_;  // threads are pinned to these cpus, if not empty
   };
 
+  // One scheduler per NUMA node, threads of each scheduler are pinned to the cpus of its node.
+  // Actors never move between schedulers, so work stealing stays inside one node.
+  static std::vector<NodeInfo> numa_nodes(size_t cpu_threads) {
+    auto nodes = td::get_numa_nodes();
+    if (nodes.size() > cpu_threads) {
+      nodes.resize(std::max<size_t>(cpu_threads, 1));
+    }
+    std::vector<NodeInfo> res;
+    for (size_t i = 0; i < nodes.size(); i++) {
+      size_t threads = cpu_threads / nodes.size() + (i < cpu_threads % nodes.size() ? 1 : 0);
+      res.push_back(NodeInfo(threads).with_cpus(std::move(nodes[i].cpus)));
+    }
+    return res;
+  }
+
   enum Mode { Running, Paused };
   Scheduler(std::vector<NodeInfo> infos, bool skip_timeouts = false, Mode mode = Paused)
       : infos_(std::move(infos)), skip_timeouts_(skip_timeouts) {
@@ -148,6 +184,9 @@ class Scheduler {
           }
         });
         thread.set_name(PSLICE() << "#" << it << ":io");
+        if (!infos_[it].cpus_.empty()) {
+          thread.set_affinity(infos_[it].cpus_).ignore();
+        }
         thread.detach();
       }
     }
@@ -205,8 +244,8 @@ class Scheduler {
     group_info_ = std::make_shared<core::SchedulerGroupInfo>(infos_.size());
     td::uint8 id = 0;
     for (const auto &info : infos_) {
-      schedulers_.emplace_back(
-          td::make_unique<core::Scheduler>(group_info_, core::SchedulerId{id}, info.cpu_threads_, skip_timeouts_));
+      schedulers_.emplace_back(td::make_unique<core::Scheduler>(group_info_, core::SchedulerId{id}, info.cpu_threads_,
+                                                                skip_timeouts_, info.cpus_));
       id++;
     }
   }
@@ -266,6 +305,15 @@ T &current_actor() {
   return static_cast<T &>(core::ActorExecuteContext::get()->actor());
 }
 
+// Messages inherit priority of the sender, so messages between two actors stay in one mailbox lane.
+// Must be called before the executor of the receiver replaces the current execute context.
+inline void inherit_priority(core::ActorMessage &message) {
+  auto *context = core::ActorExecuteContext::get();
+  if (context != nullptr && context->is_high_priority()) {
+    message.set_high_priority();
+  }
+}
+
 inline void send_message(core::ActorInfo &actor_info, core::ActorMessage message) {
   auto scheduler_context_ptr = core::SchedulerContext::get();
   if (scheduler_context_ptr == nullptr) {
@@ -273,6 +321,7 @@ inline void send_message(core::ActorInfo &actor_info, core::ActorMessage message
     return;
   }
   auto &scheduler_context = *scheduler_context_ptr;
+  inherit_priority(message);
   core::ActorExecutor executor(actor_info, scheduler_context,
                                core::ActorExecutor::Options().with_has_poll(scheduler_context.has_poll()));
   executor.send(std::move(message));
@@ -290,6 +339,7 @@ inline void send_message_later(core::ActorInfo &actor_info, core::ActorMessage m
     return;
   }
   auto &scheduler_context = *scheduler_context_ptr;
+  inherit_priority(message);
   core::ActorExecutor executor(actor_info, scheduler_context,
                                core::ActorExecutor::Options().with_has_poll(scheduler_context.has_poll()));
   message.set_big();
@@ -309,6 +359,8 @@ void send_immediate(ActorRef actor_ref, ExecuteF &&execute, ToMessageF &&to_mess
     return;
   }
   auto &scheduler_context = *scheduler_context_ptr;
+  auto *context = core::ActorExecuteContext::get();
+  bool high_priority = context != nullptr && context->is_high_priority();
   core::ActorExecutor executor(actor_ref.actor_info, scheduler_context,
                                core::ActorExecutor::Options().with_has_poll(scheduler_context.has_poll()));
   if (executor.can_send_immediate()) {
@@ -316,6 +368,9 @@ void send_immediate(ActorRef actor_ref, ExecuteF &&execute, ToMessageF &&to_mess
   }
   auto message = to_message();
   message.set_link_token(actor_ref.link_token);
+  if (high_priority) {
+    message.set_high_priority();
+  }
   executor.send(std::move(message));
 }
 
@@ -420,7 +475,8 @@ template <class T, class... ArgsT>
 core::ActorInfoPtr create_actor(core::ActorOptions &options, ArgsT &&...args) noexcept {
   auto *scheduler_context = core::SchedulerContext::get();
   if (!options.has_scheduler()) {
-    options.on_scheduler(scheduler_context->get_scheduler_id());
+    auto hint = core::SchedulerHintGuard::get();
+    options.on_scheduler(hint.is_valid() ? hint : scheduler_context->get_scheduler_id());
   }
   options.with_actor_stat_id(core::ActorTypeStatImpl::get_unique_id<T>());
   auto res =
@@ -81,6 +81,13 @@ class ActorExecuteContext : public Context<ActorExecuteContext> {
   Timestamp get_alarm_timestamp() const {
     return alarm_timestamp_;
   }
+  // priority of the actor being executed, messages sent by it inherit the priority
+  void set_high_priority(bool high_priority) {
+    high_priority_ = high_priority;
+  }
+  bool is_high_priority() const {
+    return high_priority_;
+  }
   void set_yield() {
     flags_ |= 1 << Yield;
   }
@@ -93,6 +100,7 @@ class ActorExecuteContext : public Context<ActorExecuteContext> {
   uint32 flags_{0};
   uint64 link_token_{EmptyLinkToken};
   Timestamp alarm_timestamp_;
+  bool high_priority_{false};
   enum { Stop, Pause, Alarm, Yield };
 };
 
@@ -29,7 +29,7 @@ void ActorExecutor::send_immediate(ActorMessage message) {
     return;
   }
   if (message.is_big()) {
-    actor_info_.mailbox().reader().delay(std::move(message));
+    actor_info_.mailbox().delay(std::move(message));
     pending_signals_.add_signal(ActorSignals::Message);
     actor_execute_context_.set_pause();
     return;
@@ -113,6 +113,7 @@ void ActorExecutor::start() noexcept {
   }
 
   actor_execute_context_.set_actor(&actor_info_.actor());
+  actor_execute_context_.set_high_priority(actor_info_.is_high_priority());
 
   actor_stats_ = actor_info_.actor_type_stat();
   auto execute_timer = actor_stats_.create_execute_timer();
@@ -234,7 +235,7 @@ bool ActorExecutor::flush_one_signal(ActorSignals &signals) {
       break;
     case ActorSignals::Message:
       pending_signals_.add_signal(ActorSignals::Message);
-      actor_info_.mailbox().pop_all();
+      actor_stats_.pop_from_mailbox(actor_info_.mailbox().pop_all());
       break;
     case ActorSignals::Pop:
       flags().set_in_queue(false);
@@ -247,14 +248,14 @@ bool ActorExecutor::flush_one_signal(ActorSignals &signals) {
 }
 
 bool ActorExecutor::flush_one_message() {
-  auto message = actor_info_.mailbox().reader().read();
+  auto message = actor_info_.mailbox().read();
   //LOG(ERROR) << "flush one message " << !!message << " " << actor_info_.get_name();
   if (!message) {
     pending_signals_.clear_signal(ActorSignals::Message);
     return false;
   }
   if (message.is_big() && !options_.from_queue) {
-    actor_info_.mailbox().reader().delay(std::move(message));
+    actor_info_.mailbox().delay(std::move(message));
     actor_execute_context_.set_pause();
     return false;
   }
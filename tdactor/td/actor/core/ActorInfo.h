@@ -35,8 +35,12 @@ class ActorInfo;
 using ActorInfoPtr = SharedObjectPool<ActorInfo>::Ptr;
 class ActorInfo : private HeapNode, private ListNode {
  public:
-  ActorInfo(std::unique_ptr<Actor> actor, ActorState::Flags state_flags, Slice name, td::uint32 actor_stat_id)
-      : actor_(std::move(actor)), name_(name.begin(), name.size()), actor_stat_id_(actor_stat_id) {
+  ActorInfo(std::unique_ptr<Actor> actor, ActorState::Flags state_flags, Slice name, td::uint32 actor_stat_id,
+            bool high_priority = false)
+      : actor_(std::move(actor))
+      , name_(name.begin(), name.size())
+      , actor_stat_id_(actor_stat_id)
+      , high_priority_(high_priority) {
     state_.set_flags_unsafe(state_flags);
     VLOG(actor) << "Create actor [" << name_ << "]";
   }
@@ -83,6 +87,9 @@ class ActorInfo : private HeapNode, private ListNode {
   CSlice get_name() const {
     return name_;
   }
+  bool is_high_priority() const {
+    return high_priority_;
+  }
 
   HeapNode *as_heap_node() {
     return this;
@@ -118,6 +125,7 @@ class ActorInfo : private HeapNode, private ListNode {
   ActorInfoPtr pin_;
   td::uint64 in_queue_since_{0};
   td::uint32 actor_stat_id_{0};
+  const bool high_priority_{false};
 };
 
 }  // namespace core
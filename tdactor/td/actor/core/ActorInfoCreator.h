@@ -46,6 +46,13 @@ class ActorInfoCreator {
       return *this;
     }
 
+    // Actors of high priority are executed before other actors of the scheduler, and messages sent by them
+    // are handled before other messages in mailboxes. Meant for consensus actors, which must not wait behind bulk work.
+    Options &with_high_priority(bool new_high_priority = true) {
+      high_priority = new_high_priority;
+      return *this;
+    }
+
     Options& with_actor_stat_id(td::uint32 new_id) {
       actor_stat_id = new_id;
       return *this;
@@ -58,6 +65,7 @@ class ActorInfoCreator {
     td::uint32 actor_stat_id{0};
     bool is_shared{true};
     bool in_queue{true};
+    bool high_priority{false};
     //TODO: rename
   };
 
@@ -71,7 +79,7 @@ class ActorInfoCreator {
     flags.set_in_queue(args.in_queue);
     flags.set_signals(ActorSignals::one(ActorSignals::StartUp));
 
-    auto actor_info_ptr = pool_.alloc(std::move(actor), flags, args.name, args.actor_stat_id);
+    auto actor_info_ptr = pool_.alloc(std::move(actor), flags, args.name, args.actor_stat_id, args.high_priority);
     actor_info_ptr->actor().set_actor_info_ptr(actor_info_ptr);
     return actor_info_ptr;
   }
@@ -34,34 +34,53 @@ class ActorMailbox {
   ~ActorMailbox() {
     clear();
   }
+  // Messages of high priority are kept in a separate lane, which is read first.
+  // Order of messages inside one lane is preserved.
   void push(ActorMessage message) {
-    queue_.push(std::move(message));
+    lane(message).queue.push(std::move(message));
   }
   void push_unsafe(ActorMessage message) {
-    queue_.push_unsafe(std::move(message));
+    lane(message).queue.push_unsafe(std::move(message));
   }
 
-  td::MpscLinkQueue<ActorMessage>::Reader &reader() {
-    return reader_;
+  ActorMessage read() {
+    auto message = high_.reader.read();
+    if (message) {
+      return message;
+    }
+    return normal_.reader.read();
+  }
+  // puts message back to the head of its lane
+  void delay(ActorMessage message) {
+    lane(message).reader.delay(std::move(message));
   }
 
-  void pop_all() {
-    queue_.pop_all(reader_);
+  // returns number of messages moved to the readers
+  size_t pop_all() {
+    return high_.queue.pop_all(high_.reader) + normal_.queue.pop_all(normal_.reader);
   }
-  void pop_all_unsafe() {
-    queue_.pop_all_unsafe(reader_);
+  size_t pop_all_unsafe() {
+    return high_.queue.pop_all_unsafe(high_.reader) + normal_.queue.pop_all_unsafe(normal_.reader);
   }
 
   void clear() {
     pop_all();
-    while (reader_.read()) {
+    while (read()) {
       // skip
     }
   }
 
  private:
-  td::MpscLinkQueue<ActorMessage> queue_;
-  td::MpscLinkQueue<ActorMessage>::Reader reader_;
+  struct Lane {
+    td::MpscLinkQueue<ActorMessage> queue;
+    td::MpscLinkQueue<ActorMessage>::Reader reader;
+  };
+  Lane high_;
+  Lane normal_;
+
+  Lane &lane(ActorMessage &message) {
+    return message.is_high_priority() ? high_ : normal_;
+  }
 };
 }  // namespace core
 }  // namespace actor
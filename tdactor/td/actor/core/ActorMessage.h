@@ -50,6 +50,7 @@ class ActorMessageImpl : private MpscLinkQueueImpl::Node {
 
   uint64 link_token_{EmptyLinkToken};
   bool is_big_{false};
+  bool is_high_priority_{false};
 };
 
 class ActorMessage {
@@ -78,6 +79,12 @@ class ActorMessage {
   void set_big() {
     impl_->is_big_ = true;
   }
+  bool is_high_priority() const {
+    return impl_->is_high_priority_;
+  }
+  void set_high_priority() {
+    impl_->is_high_priority_ = true;
+  }
 
  private:
   std::unique_ptr<ActorMessageImpl> impl_;
@@ -1,7 +1,9 @@
 #pragma once
+#include "td/utils/bits.h"
 #include "td/utils/int_types.h"
 #include "td/utils/port/Clocks.h"
 #include <algorithm>
+#include <array>
 #include <typeindex>
 #include <map>
 
@@ -10,6 +12,72 @@ namespace actor {
 namespace core {
 class Actor;
 
+// Log-linear (HDR-like) histogram: values below 4 have own buckets, every next power of two is split into 4 buckets,
+// so the relative error of a bucket is at most 25%. Values of 2^MaxBits and more go to the last bucket.
+template <int MaxBits>
+struct StatHistogram {
+  static constexpr size_t size = 4 * (MaxBits - 1);
+  std::array<td::uint64, size> buckets{};
+  td::uint64 count{0};
+  td::uint64 sum{0};
+
+  static size_t get_bucket(td::uint64 value) {
+    if (value < 4) {
+      return static_cast<size_t>(value);
+    }
+    int e = 63 - td::count_leading_zeroes64(value);
+    if (e >= MaxBits) {
+      return size - 1;
+    }
+    return static_cast<size_t>(4 * (e - 1) + ((value >> (e - 2)) & 3));
+  }
+  // largest value in the bucket
+  static td::uint64 get_upper_bound(size_t bucket) {
+    if (bucket < 4) {
+      return bucket;
+    }
+    int e = static_cast<int>(bucket / 4) + 1;
+    return ((td::uint64(4 + bucket % 4) + 1) << (e - 2)) - 1;
+  }
+
+  // upper bound of the bucket with the given quantile
+  td::uint64 get_quantile(double q) const {
+    if (count == 0) {
+      return 0;
+    }
+    auto rank = static_cast<td::uint64>(q * double(count - 1)) + 1;
+    td::uint64 seen = 0;
+    for (size_t i = 0; i < size; i++) {
+      seen += buckets[i];
+      if (seen >= rank) {
+        return get_upper_bound(i);
+      }
+    }
+    return get_upper_bound(size - 1);
+  }
+
+  StatHistogram &operator+=(const StatHistogram &other) {
+    for (size_t i = 0; i < size; i++) {
+      buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    sum += other.sum;
+    return *this;
+  }
+  StatHistogram &operator-=(const StatHistogram &other) {
+    for (size_t i = 0; i < size; i++) {
+      buckets[i] -= other.buckets[i];
+    }
+    count -= other.count;
+    sum -= other.sum;
+    return *this;
+  }
+};
+
+// up to 2^44 ticks, i.e. hours
+using TicksHistogram = StatHistogram<44>;
+using CountHistogram = StatHistogram<20>;
+
 struct ActorTypeStat {
   // diff (speed)
   double created{0};
@@ -39,6 +107,13 @@ struct ActorTypeStat {
   MaxStatGroup<double> max_message_seconds;
   MaxStatGroup<double> max_execute_seconds;
   MaxStatGroup<double> max_delay_seconds;
+  MaxStatGroup<td::uint32> max_messages_per_drain;
+
+  // distributions (in rdtsc ticks for durations), since start or for the window after -=
+  TicksHistogram delay_ticks;         // time in scheduler queue
+  TicksHistogram execute_ticks;       // one activation of an actor
+  CountHistogram execute_messages;    // messages handled in one activation
+  CountHistogram messages_per_drain;  // messages taken from the mailbox at once, not its length
 
   ActorTypeStat &operator+=(const ActorTypeStat &other) {
     created += other.created;
@@ -54,6 +129,12 @@ struct ActorTypeStat {
     max_message_seconds += other.max_message_seconds;
     max_execute_seconds += other.max_execute_seconds;
     max_delay_seconds += other.max_delay_seconds;
+    max_messages_per_drain += other.max_messages_per_drain;
+
+    delay_ticks += other.delay_ticks;
+    execute_ticks += other.execute_ticks;
+    execute_messages += other.execute_messages;
+    messages_per_drain += other.messages_per_drain;
     return *this;
   }
 
@@ -62,6 +143,11 @@ struct ActorTypeStat {
     executions -= other.executions;
     messages -= other.messages;
     seconds -= other.seconds;
+
+    delay_ticks -= other.delay_ticks;
+    execute_ticks -= other.execute_ticks;
+    execute_messages -= other.execute_messages;
+    messages_per_drain -= other.messages_per_drain;
     return *this;
   }
   ActorTypeStat &operator/=(double t) {
@@ -124,6 +210,11 @@ struct ActorTypeStatImpl {
   }
   void on_delay(td::uint64 ts, td::uint64 ticks) {
     max_delay_ticks_.update(ts, ticks);
+    delay_ticks_.add(ticks);
+  }
+  void on_mailbox(td::uint64 ts, td::uint32 size) {
+    max_messages_per_drain_.update(ts, size);
+    messages_per_drain_.add(size);
   }
 
   void execute_start(td::uint64 ts) {
@@ -137,8 +228,12 @@ struct ActorTypeStatImpl {
   void execute_finish(td::uint64 ts) {
     CHECK(executing_ > 0);
     if (dec(executing_) == 0) {
-      max_execute_messages_.update(ts, load(execute_messages_));
-      max_execute_ticks_.update(ts, ts - load(execute_start_));
+      auto execute_messages = load(execute_messages_);
+      auto execute_ticks = ts - load(execute_start_);
+      max_execute_messages_.update(ts, execute_messages);
+      max_execute_ticks_.update(ts, execute_ticks);
+      execute_messages_hist_.add(execute_messages);
+      execute_ticks_.add(execute_ticks);
 
       inc(total_executions_);
       store(execute_start_, 0);
@@ -175,7 +270,12 @@ struct ActorTypeStatImpl {
                          .max_execute_messages = load(max_execute_messages_),
                          .max_message_seconds = load_seconds(max_message_ticks_, inv_ticks_per_second),
                          .max_execute_seconds = load_seconds(max_execute_ticks_, inv_ticks_per_second),
-                         .max_delay_seconds = load_seconds(max_delay_ticks_, inv_ticks_per_second)};
+                         .max_delay_seconds = load_seconds(max_delay_ticks_, inv_ticks_per_second),
+                         .max_messages_per_drain = load(max_messages_per_drain_),
+                         .delay_ticks = delay_ticks_.load(),
+                         .execute_ticks = execute_ticks_.load(),
+                         .execute_messages = execute_messages_hist_.load(),
+                         .messages_per_drain = messages_per_drain_.load()};
   }
 
  private:
@@ -256,6 +356,31 @@ struct ActorTypeStatImpl {
     }
   };
 
+  // written only by the owning thread, like the other counters
+  template <class HistogramT>
+  class AtomicHistogram {
+   public:
+    void add(td::uint64 value) {
+      ActorTypeStatImpl::inc(buckets_[HistogramT::get_bucket(value)]);
+      ActorTypeStatImpl::inc(count_);
+      ActorTypeStatImpl::add(sum_, value);
+    }
+    HistogramT load() const {
+      HistogramT res;
+      for (size_t i = 0; i < HistogramT::size; i++) {
+        res.buckets[i] = ActorTypeStatImpl::load(buckets_[i]);
+      }
+      res.count = ActorTypeStatImpl::load(count_);
+      res.sum = ActorTypeStatImpl::load(sum_);
+      return res;
+    }
+
+   private:
+    std::array<std::atomic<td::uint64>, HistogramT::size> buckets_{};
+    std::atomic<td::uint64> count_{0};
+    std::atomic<td::uint64> sum_{0};
+  };
+
   template <class T>
   struct MaxCounterGroup {
     std::atomic<T> max_forever{};
@@ -298,6 +423,12 @@ struct ActorTypeStatImpl {
   MaxCounterGroup<td::uint64> max_message_ticks_;
   MaxCounterGroup<td::uint64> max_execute_ticks_;
   MaxCounterGroup<td::uint64> max_delay_ticks_;
+  MaxCounterGroup<td::uint32> max_messages_per_drain_;
+
+  AtomicHistogram<TicksHistogram> delay_ticks_;
+  AtomicHistogram<TicksHistogram> execute_ticks_;
+  AtomicHistogram<CountHistogram> execute_messages_hist_;
+  AtomicHistogram<CountHistogram> messages_per_drain_;
 
   // execute state
   std::atomic<td::uint64> execute_start_{0};
@@ -328,6 +459,12 @@ class ActorTypeStatRef {
     auto ts = td::Clocks::rdtsc();
     ref_->on_delay(ts, ts - in_queue_since);
   }
+  void pop_from_mailbox(size_t size) {
+    if (!ref_ || size == 0) {
+      return;
+    }
+    ref_->on_mailbox(td::Clocks::rdtsc(), static_cast<td::uint32>(std::min<size_t>(size, 0xffffffff)));
+  }
   void start_execute() {
     if (!ref_) {
       return;
@@ -66,7 +66,24 @@ bool CpuWorker::try_pop_global(SchedulerMessage &message, size_t thread_id) {
   return false;
 }
 
+bool CpuWorker::try_pop_high(SchedulerMessage &message, size_t thread_id) {
+  SchedulerMessage::Raw *raw_message;
+  if (high_queue_.try_pop(raw_message, thread_id)) {
+    message = SchedulerMessage(SchedulerMessage::acquire_t{}, raw_message);
+    return true;
+  }
+  return false;
+}
+
 bool CpuWorker::try_pop(SchedulerMessage &message, size_t thread_id) {
+  if (high_in_row_ < max_high_in_row()) {
+    if (try_pop_high(message, thread_id)) {
+      high_in_row_++;
+      return true;
+    }
+  }
+  high_in_row_ = 0;
+
   if (++cnt_ == 51) {
     cnt_ = 0;
     if (try_pop_global(message, thread_id) || try_pop_local(message)) {
@@ -77,6 +94,10 @@ bool CpuWorker::try_pop(SchedulerMessage &message, size_t thread_id) {
       return true;
     }
   }
+  // the limit of high priority actors in a row was reached, but there is nothing else to do
+  if (try_pop_high(message, thread_id)) {
+    return true;
+  }
 
   for (size_t i = 1; i < local_queues_.size(); i++) {
     size_t pos = (i + id_) % local_queues_.size();
@@ -33,10 +33,30 @@ bool need_debug() {
   return debug.load(std::memory_order_relaxed);
 }
 
+static TD_THREAD_LOCAL int32 scheduler_hint = -1;
+
+SchedulerHintGuard::SchedulerHintGuard(SchedulerId scheduler_id) : old_hint_(scheduler_hint) {
+  if (scheduler_id.is_valid()) {
+    scheduler_hint = scheduler_id.value();
+  }
+}
+
+SchedulerHintGuard::~SchedulerHintGuard() {
+  scheduler_hint = old_hint_;
+}
+
+SchedulerId SchedulerHintGuard::get() {
+  if (scheduler_hint < 0) {
+    return SchedulerId{};
+  }
+  return SchedulerId{static_cast<uint8>(scheduler_hint)};
+}
+
 Scheduler::Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, SchedulerId id, size_t cpu_threads_count,
-                     bool skip_timeouts)
+                     bool skip_timeouts, std::vector<unsigned> cpus)
     : scheduler_group_info_(std::move(scheduler_group_info))
     , cpu_threads_(cpu_threads_count)
+    , cpus_(std::move(cpus))
     , skip_timeouts_(skip_timeouts) {
   scheduler_group_info_->active_scheduler_count++;
   info_ = &scheduler_group_info_->schedulers.at(id.value());
@@ -44,6 +64,7 @@ Scheduler::Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, S
   if (cpu_threads_count != 0) {
     info_->cpu_threads_count = cpu_threads_count;
     info_->cpu_queue = std::make_unique<MpmcQueue<SchedulerMessage::Raw *>>(1024, max_thread_count());
+    info_->cpu_high_queue = std::make_unique<MpmcQueue<SchedulerMessage::Raw *>>(1024, max_thread_count());
     info_->cpu_queue_waiter = std::make_unique<MpmcWaiter>();
 
     info_->cpu_local_queue = std::vector<LocalQueue<SchedulerMessage::Raw *>>(cpu_threads_count);
@@ -79,10 +100,18 @@ void Scheduler::start() {
   for (size_t i = 0; i < cpu_threads_.size(); i++) {
     cpu_threads_[i] = td::thread([this, i] {
       this->run_in_context_impl(*this->info_->cpu_workers[i], [this, i] {
-        CpuWorker(*info_->cpu_queue, *info_->cpu_queue_waiter, i, info_->cpu_local_queue).run();
+        CpuWorker(*info_->cpu_queue, *info_->cpu_high_queue, *info_->cpu_queue_waiter, i, info_->cpu_local_queue)
+            .run();
       });
     });
     cpu_threads_[i].set_name(PSLICE() << "#" << info_->id.value() << ":cpu#" << i);
+    if (!cpus_.empty()) {
+      auto S = cpus_.size() >= cpu_threads_.size() ? cpu_threads_[i].set_affinity({cpus_[i]})
+                                                   : cpu_threads_[i].set_affinity(cpus_);
+      if (S.is_error()) {
+        LOG(WARNING) << "Failed to pin thread #" << info_->id.value() << ":cpu#" << i << ": " << S;
+      }
+    }
   }
 #if TD_PORT_WINDOWS
   // FIXME: use scheduler_id
@@ -161,6 +190,11 @@ void Scheduler::ContextImpl::add_to_queue(ActorInfoPtr actor_info_ptr, Scheduler
   if (need_poll || !info.cpu_queue) {
     info.io_queue->writer_put(std::move(actor_info_ptr));
   } else {
+    if (actor_info_ptr->is_high_priority()) {
+      info.cpu_high_queue->push(actor_info_ptr.release(), get_thread_id());
+      info.cpu_queue_waiter->notify();
+      return;
+    }
     if (scheduler_id == get_scheduler_id() && cpu_worker_id_.is_valid()) {
       // may push local
       CHECK(actor_info_ptr);
@@ -303,8 +337,11 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
           queues_are_empty = false;
         }
       }
-      if (scheduler_info.cpu_queue) {
-        auto &cpu_queue = *scheduler_info.cpu_queue;
+      for (auto *queue : {scheduler_info.cpu_queue.get(), scheduler_info.cpu_high_queue.get()}) {
+        if (!queue) {
+          continue;
+        }
+        auto &cpu_queue = *queue;
         while (true) {
           SchedulerMessage::Raw *raw_message;
           if (!cpu_queue.try_pop(raw_message, get_thread_id())) {
@@ -326,6 +363,7 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
   for (auto &scheduler_info : group_info.schedulers) {
     scheduler_info.io_queue.reset();
     scheduler_info.cpu_queue.reset();
+    scheduler_info.cpu_high_queue.reset();
 
     // Do not destroy worker infos. run_in_context will crash if they are empty
     scheduler_info.io_worker->actor_info_creator.clear();
@@ -81,6 +81,21 @@ struct DebugInfo {
 void set_debug(bool flag);
 bool need_debug();
 
+// Actors created by this thread without an explicit scheduler while the guard is alive are placed on the given
+// scheduler instead of the scheduler of the creator. Their own children stay on the same scheduler.
+class SchedulerHintGuard {
+ public:
+  explicit SchedulerHintGuard(SchedulerId scheduler_id);
+  ~SchedulerHintGuard();
+  SchedulerHintGuard(const SchedulerHintGuard &) = delete;
+  SchedulerHintGuard &operator=(const SchedulerHintGuard &) = delete;
+
+  static SchedulerId get();
+
+ private:
+  int32 old_hint_;
+};
+
 struct Debug {
  public:
   bool is_on() const {
@@ -89,6 +104,7 @@ struct Debug {
   struct Destructor {
     void operator()(Debug *info) {
       info->info_.lock().value().is_active = false;
+      info->busy_ticks_.fetch_add(Clocks::rdtsc() - info->busy_start_, std::memory_order_relaxed);
     }
   };
 
@@ -96,6 +112,11 @@ struct Debug {
     info_.read(info);
   }
 
+  // total time spent in actors by the worker, in rdtsc ticks
+  td::uint64 get_busy_ticks() const {
+    return busy_ticks_.load(std::memory_order_relaxed);
+  }
+
   std::unique_ptr<Debug, Destructor> start(td::Slice name) {
     if (!is_on()) {
       return {};
@@ -107,11 +128,14 @@ struct Debug {
       value.start_at = Time::now();
       value.set_name(name);
     }
+    busy_start_ = Clocks::rdtsc();
     return std::unique_ptr<Debug, Destructor>(this);
   }
 
  private:
   AtomicRead<DebugInfo> info_;
+  td::uint64 busy_start_{0};
+  std::atomic<td::uint64> busy_ticks_{0};
 };
 
 struct WorkerInfo {
@@ -152,6 +176,8 @@ struct SchedulerInfo {
   SchedulerId id;
   // will be read by all workers is any thread
   std::unique_ptr<MpmcQueue<SchedulerMessage::Raw *>> cpu_queue;
+  // actors of high priority, checked by workers before all other queues
+  std::unique_ptr<MpmcQueue<SchedulerMessage::Raw *>> cpu_high_queue;
   std::unique_ptr<MpmcWaiter> cpu_queue_waiter;
 
   std::vector<LocalQueue<SchedulerMessage::Raw *>> cpu_local_queue;
@@ -193,8 +219,10 @@ class Scheduler {
     return thread_id;
   }
 
+  // If cpus are given, worker threads are pinned to them: one cpu per thread if there are enough cpus, otherwise
+  // every thread may run on any of the cpus
   Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, SchedulerId id, size_t cpu_threads_count,
-            bool skip_timeouts = false);
+            bool skip_timeouts = false, std::vector<unsigned> cpus = {});
 
   Scheduler(const Scheduler &) = delete;
   Scheduler &operator=(const Scheduler &) = delete;
@@ -231,6 +259,7 @@ class Scheduler {
   std::shared_ptr<SchedulerGroupInfo> scheduler_group_info_;
   SchedulerInfo *info_;
   std::vector<td::thread> cpu_threads_;
+  std::vector<unsigned> cpus_;
   bool is_stopped_{false};
   Poll poll_;
   KHeap<double> heap_;
@@ -0,0 +1,92 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/actor/coro.h"
+
+#if TD_HAVE_COROUTINES
+#include "td/utils/port/thread_local.h"
+
+#include <array>
+#include <new>
+
+namespace td {
+namespace actor {
+namespace detail {
+
+namespace {
+constexpr size_t frame_size_step = 64;
+constexpr size_t frame_size_classes = 16;
+constexpr size_t max_cached_frames = 64;
+
+struct FrameLists {
+  struct Node {
+    Node *next;
+  };
+  struct List {
+    Node *head{nullptr};
+    size_t size{0};
+  };
+  std::array<List, frame_size_classes> lists;
+
+  ~FrameLists() {
+    for (auto &list : lists) {
+      while (list.head) {
+        ::operator delete(std::exchange(list.head, list.head->next));
+      }
+    }
+  }
+};
+
+TD_THREAD_LOCAL FrameLists *frame_lists;
+
+size_t get_size_class(size_t size) {
+  return (size + frame_size_step - 1) / frame_size_step - 1;
+}
+}  // namespace
+
+void *CoroFrameCache::allocate(size_t size) {
+  auto size_class = get_size_class(size);
+  if (size_class >= frame_size_classes) {
+    return ::operator new(size);
+  }
+  init_thread_local<FrameLists>(frame_lists);
+  auto &list = frame_lists->lists[size_class];
+  if (list.head) {
+    list.size--;
+    return std::exchange(list.head, list.head->next);
+  }
+  return ::operator new((size_class + 1) * frame_size_step);
+}
+
+void CoroFrameCache::deallocate(void *ptr, size_t size) {
+  auto size_class = get_size_class(size);
+  // frame_lists is null also after the thread local storage of the thread is destroyed
+  if (size_class >= frame_size_classes || frame_lists == nullptr ||
+      frame_lists->lists[size_class].size >= max_cached_frames) {
+    ::operator delete(ptr);
+    return;
+  }
+  auto &list = frame_lists->lists[size_class];
+  auto *node = static_cast<FrameLists::Node *>(ptr);
+  node->next = list.head;
+  list.head = node;
+  list.size++;
+}
+
+}  // namespace detail
+}  // namespace actor
+}  // namespace td
+#endif
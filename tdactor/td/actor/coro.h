@@ -0,0 +1,303 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "td/utils/config.h"
+
+#if TD_HAVE_COROUTINES
+#include "td/actor/actor.h"
+#include "td/actor/PromiseFuture.h"
+
+#include "td/utils/Status.h"
+
+#include <coroutine>
+#include <exception>
+
+/*
+ * Coroutines bound to actors.
+ *
+ * Task<T> is a lazy coroutine, which produces Result<T>. It is started with start_task() from an actor; this actor
+ * becomes the owner of the coroutine. After each suspension coroutine is resumed on its owner, so it may access the
+ * actor as usual.
+ *
+ *   Task<int> MyActor::run_query() {
+ *     CO_TRY_RESULT(state, co_await ask<td::Ref<State>>(manager_, &Manager::get_state, id_));
+ *     auto other = co_await compute();  // other task, runs on the same actor
+ *     co_return state->value() + other.move_as_ok();
+ *   }
+ *   ...
+ *   start_task(run_query(), std::move(promise));
+ *
+ * A suspended coroutine is destroyed together with all tasks it awaits, if its owner is destroyed before the result
+ * arrives. In this case the promise passed to start_task() is lost and gets an error.
+ */
+
+#define CO_TRY_STATUS(status)               \
+  {                                         \
+    auto try_status = (status);             \
+    if (try_status.is_error()) {            \
+      co_return try_status.move_as_error(); \
+    }                                       \
+  }
+
+#define CO_TRY_RESULT(name, result) CO_TRY_RESULT_IMPL(TD_CONCAT(TD_CONCAT(r_, name), __LINE__), auto name, result)
+
+#define CO_TRY_RESULT_ASSIGN(name, result) CO_TRY_RESULT_IMPL(TD_CONCAT(r_response, __LINE__), name, result)
+
+#define CO_TRY_RESULT_IMPL(r_name, name, result) \
+  auto r_name = (result);                        \
+  if (r_name.is_error()) {                       \
+    co_return r_name.move_as_error();            \
+  }                                              \
+  name = r_name.move_as_ok();
+
+namespace td {
+namespace actor {
+
+namespace detail {
+
+// Coroutine frames are allocated often and have few distinct sizes, so freed frames are kept in per-thread lists
+class CoroFrameCache {
+ public:
+  static void *allocate(size_t size);
+  static void deallocate(void *ptr, size_t size);
+};
+
+struct CoroRoot {
+  ActorId<> owner;
+  std::coroutine_handle<> handle;
+};
+
+struct CoroPromiseBase {
+  static void *operator new(size_t size) {
+    return CoroFrameCache::allocate(size);
+  }
+  static void operator delete(void *ptr, size_t size) {
+    CoroFrameCache::deallocate(ptr, size);
+  }
+  void unhandled_exception() noexcept {
+    std::terminate();
+  }
+
+  std::coroutine_handle<> continuation_;
+  CoroRoot *root_{nullptr};
+};
+
+// Resumes a suspended coroutine. If it is destroyed unused (e.g. the owner was closed), the whole chain is destroyed.
+class CoroResumer {
+ public:
+  CoroResumer(std::coroutine_handle<> handle, CoroRoot *root) : handle_(handle), root_(root) {
+  }
+  CoroResumer(const CoroResumer &) = delete;
+  CoroResumer &operator=(const CoroResumer &) = delete;
+  CoroResumer(CoroResumer &&other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)), root_(std::exchange(other.root_, nullptr)) {
+  }
+  CoroResumer &operator=(CoroResumer &&) = delete;
+  ~CoroResumer() {
+    if (root_) {
+      root_->handle.destroy();
+    }
+  }
+
+  void resume() {
+    CHECK(handle_);
+    root_ = nullptr;
+    std::exchange(handle_, nullptr).resume();
+  }
+
+ private:
+  std::coroutine_handle<> handle_;
+  CoroRoot *root_;
+};
+
+// Suspends the coroutine until the promise created by start_f is fulfilled, then resumes it on the owner
+template <class T, class StartF>
+class PromiseAwaiter {
+ public:
+  explicit PromiseAwaiter(StartF start_f) : start_f_(std::move(start_f)) {
+  }
+  bool await_ready() const noexcept {
+    return false;
+  }
+  template <class P>
+  void await_suspend(std::coroutine_handle<P> handle) {
+    auto *root = handle.promise().root_;
+    CHECK(root != nullptr);
+    start_f_(Promise<T>([owner = root->owner, resumer = CoroResumer(handle, root),
+                         self = this](Result<T> result) mutable {
+      send_lambda(owner, [resumer = std::move(resumer), self, result = std::move(result)]() mutable {
+        self->result_ = std::move(result);
+        resumer.resume();
+      });
+    }));
+  }
+  Result<T> await_resume() {
+    return std::move(result_);
+  }
+
+ private:
+  StartF start_f_;
+  Result<T> result_;
+};
+
+struct RootTask {
+  struct promise_type : public CoroPromiseBase {
+    promise_type() {
+      root_ = &root_storage_;
+      root_storage_.handle = std::coroutine_handle<promise_type>::from_promise(*this);
+      root_storage_.owner = core::actor_id(&core::ActorExecuteContext::get()->actor());
+    }
+    RootTask get_return_object() {
+      return {};
+    }
+    std::suspend_never initial_suspend() noexcept {
+      return {};
+    }
+    std::suspend_never final_suspend() noexcept {
+      return {};
+    }
+    void return_void() {
+    }
+
+    CoroRoot root_storage_;
+  };
+};
+
+}  // namespace detail
+
+template <class T = Unit>
+class Task {
+ public:
+  struct promise_type : public detail::CoroPromiseBase {
+    struct FinalAwaiter {
+      bool await_ready() const noexcept {
+        return false;
+      }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+        auto continuation = handle.promise().continuation_;
+        return continuation ? continuation : std::noop_coroutine();
+      }
+      void await_resume() noexcept {
+      }
+    };
+
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept {
+      return {};
+    }
+    FinalAwaiter final_suspend() noexcept {
+      return {};
+    }
+    void return_value(Result<T> result) {
+      result_ = std::move(result);
+    }
+
+    Result<T> result_;
+  };
+
+  Task() = default;
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {
+  }
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      reset();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+  ~Task() {
+    reset();
+  }
+
+  bool await_ready() const noexcept {
+    return !handle_ || handle_.done();
+  }
+  template <class P>
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<P> continuation) noexcept {
+    auto &promise = handle_.promise();
+    promise.continuation_ = continuation;
+    promise.root_ = continuation.promise().root_;
+    return handle_;
+  }
+  Result<T> await_resume() {
+    if (!handle_) {
+      return Status::Error("Empty task");
+    }
+    return std::move(handle_.promise().result_);
+  }
+
+ private:
+  std::coroutine_handle<promise_type> handle_;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {
+  }
+  void reset() {
+    if (handle_) {
+      handle_.destroy();
+      handle_ = nullptr;
+    }
+  }
+};
+
+namespace detail {
+template <class T>
+RootTask run_task(Task<T> task, Promise<T> promise) {
+  promise.set_result(co_await std::move(task));
+}
+}  // namespace detail
+
+// Starts the task on the current actor, which must be executing now. The result is passed to the promise.
+template <class T>
+void start_task(Task<T> task, Promise<T> promise = {}) {
+  detail::run_task(std::move(task), std::move(promise));
+}
+
+// co_await with_promise<T>([&](Promise<T> promise) { ... }) adapts any callback-style function
+template <class T, class StartF>
+auto with_promise(StartF &&start_f) {
+  return detail::PromiseAwaiter<T, std::decay_t<StartF>>(std::forward<StartF>(start_f));
+}
+
+// co_await ask<R>(actor_id, &Actor::method, args...) sends a query to an actor, the promise is added as the last argument
+template <class R, class ActorIdT, class FunctionT, class... ArgsT>
+auto ask(ActorIdT &&actor_id, FunctionT function, ArgsT &&...args) {
+  return with_promise<R>([actor_id = std::forward<ActorIdT>(actor_id), function,
+                          args = std::make_tuple(std::forward<ArgsT>(args)...)](Promise<R> promise) mutable {
+    std::apply(
+        [&](auto &&...nargs) {
+          send_closure(std::move(actor_id), function, std::forward<decltype(nargs)>(nargs)..., std::move(promise));
+        },
+        std::move(args));
+  });
+}
+
+}  // namespace actor
+
+template <class T>
+auto operator co_await(Future<T> &&future) {
+  return actor::with_promise<T>([future = std::move(future)](Promise<T> promise) mutable {
+    future.finish(std::move(promise));
+  });
+}
+
+}  // namespace td
+#endif
@@ -857,6 +857,120 @@ TEST(Actor2, SchedulerTwo) {
   });
   scheduler.run();
 }
+TEST(Actor2, SchedulerHint) {
+  Scheduler scheduler({0, 0});
+  scheduler.run_in_context([] {
+    class C : public Actor {
+     public:
+      void start_up() override {
+        CHECK(SchedulerContext::get()->get_scheduler_id() == SchedulerId{1});
+        SchedulerContext::get()->stop();
+      }
+    };
+    class B : public Actor {
+     public:
+      void start_up() override {
+        CHECK(SchedulerContext::get()->get_scheduler_id() == SchedulerId{1});
+        create_actor<C>(ActorOptions().with_name("C").with_poll(false)).release();
+      }
+    };
+    class A : public Actor {
+      void start_up() override {
+        CHECK(SchedulerContext::get()->get_scheduler_id() == SchedulerId{0});
+        SchedulerHintGuard guard(SchedulerId{1});
+        create_actor<B>(ActorOptions().with_name("B").with_poll(false)).release();
+      }
+    };
+    create_actor<A>(ActorOptions().with_name("A").with_poll(false).on_scheduler(SchedulerId{0})).release();
+  });
+  scheduler.run();
+}
+TEST(Actor2, MailboxPriority) {
+  core::ActorMailbox mailbox;
+  std::string order;
+  auto create_message = [&](char c, bool high_priority) {
+    auto message = detail::ActorMessageCreator::lambda([&order, c] { order += c; });
+    if (high_priority) {
+      message.set_high_priority();
+    }
+    return message;
+  };
+  mailbox.push(create_message('a', false));
+  mailbox.push(create_message('B', true));
+  mailbox.push(create_message('c', false));
+  mailbox.push(create_message('D', true));
+  CHECK(mailbox.pop_all() == 4);
+  auto message = mailbox.read();
+  message.run();
+  mailbox.delay(std::move(message));
+  while (auto message = mailbox.read()) {
+    message.run();
+  }
+  ASSERT_STREQ("BBDac", order);
+}
+TEST(Actor2, SchedulerPriority) {
+  Scheduler scheduler({2});
+  scheduler.run_in_context([] {
+    class B : public Actor {
+     public:
+      void ping(int left) {
+        CHECK(!core::ActorExecuteContext::get()->is_high_priority());
+        if (left == 0) {
+          SchedulerContext::get()->stop();
+        }
+      }
+    };
+    class A : public Actor {
+      void start_up() override {
+        CHECK(core::ActorExecuteContext::get()->is_high_priority());
+        b_ = create_actor<B>(ActorOptions().with_name("B").with_poll(false));
+        for (int i = 1000; i >= 0; i--) {
+          send_closure_later(b_, &B::ping, i);
+        }
+      }
+      ActorOwn<B> b_;
+    };
+    create_actor<A>(ActorOptions().with_name("A").with_poll(false).with_high_priority()).release();
+  });
+  scheduler.run();
+}
+TEST(Actor2, SchedulerPriorityOrder) {
+  // with one cpu thread a high priority actor must run before the normal actors queued earlier
+  static constexpr int normal_count = 100;
+  static int normal_done;
+  static int normal_done_before_high;
+  normal_done = 0;
+  normal_done_before_high = -1;
+  Scheduler scheduler({1});
+  scheduler.run_in_context([] {
+    class Task : public Actor {
+     public:
+      explicit Task(bool high) : high_(high) {
+      }
+      void start_up() override {
+        if (high_) {
+          normal_done_before_high = normal_done;
+        } else {
+          normal_done++;
+        }
+        if (normal_done == normal_count && normal_done_before_high >= 0) {
+          SchedulerContext::get()->stop();
+        }
+        stop();
+      }
+
+     private:
+      bool high_;
+    };
+    for (int i = 0; i < normal_count; i++) {
+      create_actor<Task>(ActorOptions().with_name("Normal").with_poll(false), false).release();
+    }
+    create_actor<Task>(ActorOptions().with_name("High").with_poll(false).with_high_priority(), true).release();
+  });
+  scheduler.run();
+  CHECK(normal_done == normal_count);
+  CHECK(normal_done_before_high == 0);
+}
 TEST(Actor2, ActorIdDynamicCast) {
   Scheduler scheduler({0});
   scheduler.run_in_context([] {
@@ -1143,6 +1257,8 @@ TEST(Actor2, test_stats) {
       }
       void alarm() override {
         td::actor::send_closure(stats_, &ActorStats::prepare_stats, td::promise_send_closure(actor_id(this), &Master::on_stats));
+        td::actor::send_closure(stats_, &ActorStats::prepare_prometheus_stats,
+                                td::promise_send_closure(actor_id(this), &Master::on_prometheus_stats));
         alarm_timestamp() = td::Timestamp::in(5);
       }
       void on_stats(td::Result<std::string> r_stats) {
@@ -1151,6 +1267,11 @@ TEST(Actor2, test_stats) {
           stop();
         }
       }
+      void on_prometheus_stats(td::Result<std::string> r_stats) {
+        auto stats = r_stats.move_as_ok();
+        CHECK(stats.find("ton_actor_execute_seconds_bucket{actor=\"") != std::string::npos);
+        CHECK(stats.find("ton_actor_worker_utilization{worker=\"#0:cpu#0\"}") != std::string::npos);
+      }
 
      private:
       std::shared_ptr<td::Destructor> watcher_;
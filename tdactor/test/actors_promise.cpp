@@ -17,6 +17,7 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "td/actor/actor.h"
+#include "td/actor/coro.h"
 #include "td/actor/PromiseFuture.h"
 #include "td/actor/MultiPromise.h"
 #include "td/utils/MovableValue.h"
@@ -382,189 +383,112 @@ TEST(Actor2, MultiPromise) {
 }
 
 #if TD_HAVE_COROUTINES
-#include <experimental/coroutine>
 namespace td {
-template <class T = Unit>
-struct task {
-  struct final_awaiter {
-    bool await_ready() const noexcept {
-      return false;
-    }
-    template <class P>
-    std::experimental::coroutine_handle<> await_suspend(std::experimental::coroutine_handle<P> continuation) noexcept {
-      return continuation.promise().continuation_;
-    }
-    void await_resume() noexcept {
-    }
-  };
-  struct promise_type {
-    task get_return_object() {
-      return task{*this};
-    }
-    std::experimental::suspend_always initial_suspend() {
-      return {};
-    }
-    final_awaiter final_suspend() {
-      return final_awaiter{};
-    }
-    void return_value(T v) {
-      value_ = v;
-    }
-    T move_value() {
-      return std::move(value_.value());
-    }
-    void unhandled_exception() {
-    }
-
-    optional<T> value_;
-    std::experimental::coroutine_handle<> continuation_;
-  };
-
-  // awaiter
-  std::experimental::coroutine_handle<promise_type> coroutine_handle_;
-  task(task &&other) = default;
-  task(promise_type &promise)
-      : coroutine_handle_(std::experimental::coroutine_handle<promise_type>::from_promise(promise)) {
+namespace actor {
+class CoroValues : public Actor {
+ public:
+  void get(int x, Promise<int> promise) {
+    promise.set_value(x * 2);
   }
-
-  bool await_ready() const noexcept {
-    return !coroutine_handle_ || coroutine_handle_.done();
+  void fail(Promise<int> promise) {
+    promise.set_error(Status::Error("fail"));
   }
-  std::experimental::coroutine_handle<> await_suspend(std::experimental::coroutine_handle<> continuation) noexcept {
-    coroutine_handle_.promise().continuation_ = continuation;
-    return coroutine_handle_;
+  void hold(Promise<int> promise) {
+    held_ = std::move(promise);
   }
-  T await_resume() noexcept {
-    return coroutine_handle_.promise().move_value();
+  void release() {
+    held_.set_value(1);
   }
-};
-
-task<int> f() {
-  co_return 1;
-}
-task<int> g() {
-  co_return 2;
-}
-task<int> h() {
-  auto a = co_await f();
-  auto b = co_await g();
-  co_return a + b;
-}
 
-struct immediate_task {
-  struct promise_type {
-    immediate_task get_return_object() {
-      return {};
-    }
-    std::experimental::suspend_never initial_suspend() {
-      return {};
-    }
-    std::experimental::suspend_never final_suspend() {
-      return {};
-    }
-    void return_void() {
-    }
-    void unhandled_exception() {
-    }
-  };
+ private:
+  Promise<int> held_;
 };
 
-struct OnActor {
+class CoroSample : public Actor {
  public:
-  template <class T>
-  OnActor(T &&actor_id) : actor_id_(actor_id.as_actor_ref()) {
-  }
-  bool await_ready() const noexcept {
-    return false;
-  }
-  void await_suspend(std::experimental::coroutine_handle<> continuation) noexcept {
-    //TODO: destroy if lambda is lost
-    send_lambda(actor_id_, [continuation]() mutable { continuation.resume(); });
-  }
-  void await_resume() noexcept {
+  CoroSample(ActorId<CoroValues> values, Promise<int> promise) : values_(values), promise_(std::move(promise)) {
   }
 
  private:
-  actor::detail::ActorRef actor_id_;
-};
-
-immediate_task check_h() {
-  LOG(ERROR) << "check_h: call h";
-  auto c = co_await h();
-  LOG(ERROR) << "check_h: after call h";
-  ASSERT_EQ(3, c);
-}
-
-TEST(ActorCoro, Task) {
-  check_h();
-}
-namespace actor {
-class AsyncQuery {};
+  ActorId<CoroValues> values_;
+  Promise<int> promise_;
 
-class Printer : public Actor {
- public:
-  void f();
-  void print_a() {
-    LOG(ERROR) << "a";
+  void start_up() override {
+    start_task(run(), std::move(promise_));
+  }
+  void check_owner() {
+    CHECK(&core::ActorExecuteContext::get()->actor() == this);
+  }
+  Task<int> f() {
+    co_return 1;
   }
-  void print_b() {
-    LOG(ERROR) << "b";
+  Task<int> g() {
+    auto r = co_await ask<int>(values_, &CoroValues::get, 1);
+    check_owner();
+    co_return r;
+  }
+  Task<int> run() {
+    CO_TRY_RESULT(a, co_await f());
+    CO_TRY_RESULT(b, co_await g());
+    auto pf = make_promise_future<int>();
+    send_closure(values_, &CoroValues::get, 3, std::move(pf.first));
+    CO_TRY_RESULT(c, co_await std::move(pf.second));
+    check_owner();
+    auto r = co_await ask<int>(values_, &CoroValues::fail);
+    CHECK(r.is_error());
+    check_owner();
+    co_return a + b + c;
   }
 };
 
-class SampleActor : public Actor {
+class CoroCancel : public Actor {
  public:
-  SampleActor(std::shared_ptr<td::Destructor> watcher) : watcher_(std::move(watcher)) {
+  CoroCancel(ActorId<CoroValues> values, Promise<int> promise) : values_(values), promise_(std::move(promise)) {
   }
 
  private:
-  std::shared_ptr<Destructor> watcher_;
-  ActorOwn<Printer> printer_;
+  ActorId<CoroValues> values_;
+  Promise<int> promise_;
+
   void start_up() override {
-    printer_ = create_actor<Printer>("Printer");
-    run_coroutine();
-  }
-  task<Unit> print_a() {
-    auto self = actor_id(this);
-    LOG(ERROR) << "enter print_a";
-    co_await OnActor(printer_);
-    detail::current_actor<Printer>().print_a();
-    co_await OnActor(self);
-    LOG(ERROR) << "exit print_a";
-    co_return {};
-  }
-  task<Unit> print_b() {
-    auto self = actor_id(this);
-    LOG(ERROR) << "enter print_b";
-    co_await OnActor(printer_);
-    detail::current_actor<Printer>().print_b();
-    co_await OnActor(self);
-    LOG(ERROR) << "exit print_b";
-    co_return {};
-  }
-
-  immediate_task run_coroutine() {
-    co_await print_a();
-    co_await print_b();
+    start_task(run(), std::move(promise_));
     stop();
   }
+  void tear_down() override {
+    send_closure(values_, &CoroValues::release);
+  }
+  Task<int> run() {
+    auto r = co_await ask<int>(values_, &CoroValues::hold);
+    UNREACHABLE();
+    co_return r;
+  }
 };
 }  // namespace actor
 
-TEST(ActorCoro, Simple) {
+TEST(ActorCoro, Task) {
   using namespace td::actor;
-  using namespace td;
   Scheduler scheduler({1});
-
-  auto watcher = td::create_shared_destructor([] {
-    LOG(ERROR) << "STOP";
-    SchedulerContext::get()->stop();
-  });
-  scheduler.run_in_context([watcher = std::move(watcher)] {
-    create_actor<actor::SampleActor>(ActorOptions().with_name("SampleActor").with_poll(), watcher).release();
+  scheduler.run_in_context([] {
+    auto values = create_actor<CoroValues>("CoroValues").release();
+    create_actor<CoroSample>("CoroSample", values, [](Result<int> r) {
+      ASSERT_EQ(9, r.move_as_ok());
+      SchedulerContext::get()->stop();
+    }).release();
   });
   scheduler.run();
 }
 
+TEST(ActorCoro, CancelOnOwnerClose) {
+  using namespace td::actor;
+  Scheduler scheduler({1});
+  scheduler.run_in_context([] {
+    auto values = create_actor<CoroValues>("CoroValues").release();
+    create_actor<CoroCancel>("CoroCancel", values, [](Result<int> r) {
+      CHECK(r.is_error());
+      SchedulerContext::get()->stop();
+    }).release();
+  });
+  scheduler.run();
+}
 }  // namespace td
 #endif
@@ -38,6 +38,8 @@ class KeyValueAsync {
   };
   KeyValueAsync(std::shared_ptr<KeyValue> key_value);
   void get(KeyT key, Promise<GetResult> promise = {});
+  // Reads the whole database with one sequential scan. KeyT must be a fixed-size type, e.g. td::Bits256
+  void get_all(Promise<std::vector<std::pair<KeyT, ValueT>>> promise);
   void set(KeyT key, ValueT value, Promise<Unit> promise = {}, double sync_delay = 0);
   void erase(KeyT key, Promise<Unit> promise = {}, double sync_delay = 0);
 
@@ -70,6 +72,23 @@ class KeyValueActor : public actor::Actor {
     }
     promise.set_value(std::move(result));
   }
+  void get_all(Promise<std::vector<std::pair<KeyT, ValueT>>> promise) {
+    std::vector<std::pair<KeyT, ValueT>> result;
+    auto status = key_value_->for_each([&](Slice key, Slice value) {
+      KeyT k;
+      if (key.size() != as_slice(k).size()) {
+        return Status::Error(PSLICE() << "unexpected key size " << key.size());
+      }
+      as_slice(k).copy_from(key);
+      result.emplace_back(std::move(k), ValueT(value));
+      return Status::OK();
+    });
+    if (status.is_error()) {
+      promise.set_error(std::move(status));
+      return;
+    }
+    promise.set_value(std::move(result));
+  }
   void set(KeyT key, ValueT value, Promise<Unit> promise, double sync_delay) {
     schedule_sync(std::move(promise), sync_delay);
     key_value_->set(as_slice(key), as_slice(value));
@@ -147,6 +166,10 @@ void KeyValueAsync<KeyT, ValueT>::get(KeyT key, Promise<GetResult> promise) {
   send_closure_later(actor_, &ActorType::get, std::move(key), std::move(promise));
 }
 template <class KeyT, class ValueT>
+void KeyValueAsync<KeyT, ValueT>::get_all(Promise<std::vector<std::pair<KeyT, ValueT>>> promise) {
+  send_closure_later(actor_, &ActorType::get_all, std::move(promise));
+}
+template <class KeyT, class ValueT>
 void KeyValueAsync<KeyT, ValueT>::set(KeyT key, ValueT value, Promise<Unit> promise, double sync_delay) {
   send_closure_later(actor_, &ActorType::set, std::move(key), std::move(value), std::move(promise), sync_delay);
 }
@@ -19,6 +19,7 @@
 #include "td/db/RocksDb.h"
 
 #include "rocksdb/db.h"
+#include "rocksdb/filter_policy.h"
 #include "rocksdb/table.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/write_batch.h"
@@ -41,6 +42,32 @@ static rocksdb::Slice to_rocksdb(Slice slice) {
 }
 }  // namespace
 
+struct RocksDb::ColumnFamilies {
+  struct Family {
+    rocksdb::ColumnFamilyHandle *handle;
+    std::function<bool(Slice)> has_key;
+    // The default column family may hold keys of the family, written before the family was added
+    bool legacy_keys;
+  };
+  std::vector<Family> families;
+
+  const Family *find(Slice key) const {
+    for (auto &family : families) {
+      if (family.has_key(key)) {
+        return &family;
+      }
+    }
+    return nullptr;
+  }
+  std::vector<rocksdb::ColumnFamilyHandle *> handles() const {
+    std::vector<rocksdb::ColumnFamilyHandle *> res;
+    for (auto &family : families) {
+      res.push_back(family.handle);
+    }
+    return res;
+  }
+};
+
 Status RocksDb::destroy(Slice path) {
   return from_rocksdb(rocksdb::DestroyDB(path.str(), {}));
 }
@@ -56,11 +83,12 @@ RocksDb::~RocksDb() {
 }
 
 RocksDb RocksDb::clone() const {
-  return RocksDb{db_, options_};
+  return RocksDb{db_, options_, column_families_};
 }
 
 Result<RocksDb> RocksDb::open(std::string path, RocksDbOptions options) {
   rocksdb::OptimisticTransactionDB *db;
+  std::vector<rocksdb::ColumnFamilyHandle *> family_handles;
   {
     rocksdb::Options db_options;
 
@@ -69,13 +97,19 @@ Result<RocksDb> RocksDb::open(std::string path, RocksDbOptions options) {
       options.block_cache = default_cache;
     }
 
-    rocksdb::BlockBasedTableOptions table_options;
-    if (options.no_block_cache) {
-      table_options.no_block_cache = true;
-    } else {
-      table_options.block_cache = options.block_cache;
-    }
-    db_options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table_options));
+    auto table_factory = [&](int bloom_filter_bits_per_key) {
+      rocksdb::BlockBasedTableOptions table_options;
+      if (options.no_block_cache) {
+        table_options.no_block_cache = true;
+      } else {
+        table_options.block_cache = options.block_cache;
+      }
+      if (bloom_filter_bits_per_key > 0) {
+        table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(bloom_filter_bits_per_key, false));
+      }
+      return rocksdb::NewBlockBasedTableFactory(table_options);
+    };
+    db_options.table_factory.reset(table_factory(options.bloom_filter_bits_per_key));
 
     db_options.use_direct_reads = options.use_direct_reads;
     db_options.manual_wal_flush = true;
@@ -92,15 +126,66 @@ Result<RocksDb> RocksDb::open(std::string path, RocksDbOptions options) {
     rocksdb::ColumnFamilyOptions cf_options(db_options);
     std::vector<rocksdb::ColumnFamilyDescriptor> column_families;
     column_families.push_back(rocksdb::ColumnFamilyDescriptor(rocksdb::kDefaultColumnFamilyName, cf_options));
+    for (auto &family : options.column_families) {
+      rocksdb::ColumnFamilyOptions family_options(cf_options);
+      family_options.table_factory.reset(table_factory(family.bloom_filter_bits_per_key));
+      if (family.write_buffer_size != 0) {
+        family_options.write_buffer_size = family.write_buffer_size;
+      }
+      column_families.push_back(rocksdb::ColumnFamilyDescriptor(family.name, family_options));
+    }
+    db_options.create_missing_column_families = true;
     std::vector<rocksdb::ColumnFamilyHandle *> handles;
     TRY_STATUS(from_rocksdb(rocksdb::OptimisticTransactionDB::Open(db_options, occ_options, std::move(path),
                                                                    column_families, &handles, &db)));
-    CHECK(handles.size() == 1);
+    CHECK(handles.size() == column_families.size());
     // i can delete the handle since DBImpl is always holding a reference to
     // default column family
     delete handles[0];
+    handles.erase(handles.begin());
+    family_handles = std::move(handles);
   }
-  return RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB>(db), std::move(options));
+  // Handles of the other column families must be destroyed before the db
+  auto db_ptr = std::shared_ptr<rocksdb::OptimisticTransactionDB>(
+      db, [family_handles](rocksdb::OptimisticTransactionDB *db) {
+        for (auto *handle : family_handles) {
+          db->DestroyColumnFamilyHandle(handle);
+        }
+        delete db;
+      });
+  if (family_handles.empty()) {
+    return RocksDb(std::move(db_ptr), std::move(options), nullptr);
+  }
+
+  auto column_families = std::make_shared<ColumnFamilies>();
+  for (size_t i = 0; i < family_handles.size(); i++) {
+    column_families->families.push_back({family_handles[i], options.column_families[i].has_key, false});
+  }
+  // A db created before the families were added keeps their keys in the default column family. They are not moved,
+  // reads fall back to the default column family for such families instead.
+  rocksdb::ReadOptions read_options;
+  read_options.fill_cache = false;
+  std::unique_ptr<rocksdb::Iterator> iterator(db->NewIterator(read_options));
+  size_t legacy_families = 0;
+  for (iterator->SeekToFirst(); iterator->Valid() && legacy_families < family_handles.size(); iterator->Next()) {
+    auto key = from_rocksdb(iterator->key());
+    for (auto &family : column_families->families) {
+      if (family.has_key(key)) {
+        legacy_families += !family.legacy_keys;
+        family.legacy_keys = true;
+        break;
+      }
+    }
+  }
+  TRY_STATUS(from_rocksdb(iterator->status()));
+  iterator.reset();
+  for (size_t i = 0; i < family_handles.size(); i++) {
+    if (column_families->families[i].legacy_keys) {
+      LOG(WARNING) << "RocksDb: keys of column family " << options.column_families[i].name
+                   << " are also read from the default column family";
+    }
+  }
+  return RocksDb(std::move(db_ptr), std::move(options), std::move(column_families));
 }
 
 std::shared_ptr<rocksdb::Statistics> RocksDb::create_statistics() {
@@ -129,20 +214,30 @@ std::string RocksDb::stats() const {
   std::string out;
   db_->GetProperty("rocksdb.stats", &out);
   //db_->GetProperty("rocksdb.cur-size-all-mem-tables", &out);
+  if (column_families_) {
+    for (auto *handle : column_families_->handles()) {
+      std::string family_out;
+      db_->GetProperty(handle, "rocksdb.stats", &family_out);
+      out += family_out;
+    }
+  }
   return out;
 }
 
-Result<RocksDb::GetStatus> RocksDb::get(Slice key, std::string &value) {
-  //LOG(ERROR) << "GET";
+rocksdb::ColumnFamilyHandle *RocksDb::default_column_family() const {
+  return db_->DefaultColumnFamily();
+}
+
+Result<RocksDb::GetStatus> RocksDb::get_from(rocksdb::ColumnFamilyHandle *family, Slice key, std::string &value) {
   rocksdb::Status status;
   if (snapshot_) {
     rocksdb::ReadOptions options;
     options.snapshot = snapshot_.get();
-    status = db_->Get(options, to_rocksdb(key), &value);
+    status = db_->Get(options, family, to_rocksdb(key), &value);
   } else if (transaction_) {
-    status = transaction_->Get({}, to_rocksdb(key), &value);
+    status = transaction_->Get({}, family, to_rocksdb(key), &value);
   } else {
-    status = db_->Get({}, to_rocksdb(key), &value);
+    status = db_->Get({}, family, to_rocksdb(key), &value);
   }
   if (status.ok()) {
     return GetStatus::Ok;
@@ -153,86 +248,90 @@ Result<RocksDb::GetStatus> RocksDb::get(Slice key, std::string &value) {
   return from_rocksdb(status);
 }
 
+Result<RocksDb::GetStatus> RocksDb::get(Slice key, std::string &value) {
+  //LOG(ERROR) << "GET";
+  auto family = column_families_ ? column_families_->find(key) : nullptr;
+  if (!family) {
+    return get_from(default_column_family(), key, value);
+  }
+  TRY_RESULT(status, get_from(family->handle, key, value));
+  if (status == GetStatus::NotFound && family->legacy_keys) {
+    return get_from(default_column_family(), key, value);
+  }
+  return status;
+}
+
 Status RocksDb::set(Slice key, Slice value) {
+  auto family = column_families_ ? column_families_->find(key) : nullptr;
+  auto handle = family ? family->handle : default_column_family();
   if (write_batch_) {
-    return from_rocksdb(write_batch_->Put(to_rocksdb(key), to_rocksdb(value)));
+    return from_rocksdb(write_batch_->Put(handle, to_rocksdb(key), to_rocksdb(value)));
   }
   if (transaction_) {
-    return from_rocksdb(transaction_->Put(to_rocksdb(key), to_rocksdb(value)));
+    return from_rocksdb(transaction_->Put(handle, to_rocksdb(key), to_rocksdb(value)));
   }
-  return from_rocksdb(db_->Put({}, to_rocksdb(key), to_rocksdb(value)));
+  return from_rocksdb(db_->Put({}, handle, to_rocksdb(key), to_rocksdb(value)));
 }
 
 Status RocksDb::erase(Slice key) {
-  if (write_batch_) {
-    return from_rocksdb(write_batch_->Delete(to_rocksdb(key)));
+  auto family = column_families_ ? column_families_->find(key) : nullptr;
+  std::vector<rocksdb::ColumnFamilyHandle *> handles;
+  if (family) {
+    handles.push_back(family->handle);
   }
-  if (transaction_) {
-    return from_rocksdb(transaction_->Delete(to_rocksdb(key)));
+  if (!family || family->legacy_keys) {
+    handles.push_back(default_column_family());
   }
-  return from_rocksdb(db_->Delete({}, to_rocksdb(key)));
+  for (auto *handle : handles) {
+    if (write_batch_) {
+      TRY_STATUS(from_rocksdb(write_batch_->Delete(handle, to_rocksdb(key))));
+    } else if (transaction_) {
+      TRY_STATUS(from_rocksdb(transaction_->Delete(handle, to_rocksdb(key))));
+    } else {
+      TRY_STATUS(from_rocksdb(db_->Delete({}, handle, to_rocksdb(key))));
+    }
+  }
+  return Status::OK();
 }
 
 Result<size_t> RocksDb::count(Slice prefix) {
-  rocksdb::ReadOptions options;
-  options.snapshot = snapshot_.get();
-  std::unique_ptr<rocksdb::Iterator> iterator;
-  if (snapshot_ || !transaction_) {
-    iterator.reset(db_->NewIterator(options));
-  } else {
-    iterator.reset(transaction_->GetIterator(options));
-  }
-
   size_t res = 0;
-  for (iterator->Seek(to_rocksdb(prefix)); iterator->Valid(); iterator->Next()) {
-    if (from_rocksdb(iterator->key()).truncate(prefix.size()) != prefix) {
-      break;
-    }
-    res++;
-  }
-  if (!iterator->status().ok()) {
-    return from_rocksdb(iterator->status());
-  }
+  TRY_STATUS(for_each_until(
+      prefix, [&](Slice key) { return key.truncate(prefix.size()) != prefix; },
+      [&](Slice, Slice) {
+        res++;
+        return Status::OK();
+      }));
   return res;
 }
 
 Status RocksDb::for_each(std::function<Status(Slice, Slice)> f) {
-  rocksdb::ReadOptions options;
-  options.snapshot = snapshot_.get();
-  std::unique_ptr<rocksdb::Iterator> iterator;
-  if (snapshot_ || !transaction_) {
-    iterator.reset(db_->NewIterator(options));
-  } else {
-    iterator.reset(transaction_->GetIterator(options));
-  }
-
-  iterator->SeekToFirst();
-  for (; iterator->Valid(); iterator->Next()) {
-    auto key = from_rocksdb(iterator->key());
-    auto value = from_rocksdb(iterator->value());
-    TRY_STATUS(f(key, value));
-  }
-  if (!iterator->status().ok()) {
-    return from_rocksdb(iterator->status());
-  }
-  return Status::OK();
+  return for_each_until(
+      Slice(), [](Slice) { return false; }, f);
 }
 
 Status RocksDb::for_each_in_range(Slice begin, Slice end, std::function<Status(Slice, Slice)> f) {
+  auto comparator = rocksdb::BytewiseComparator();
+  return for_each_until(
+      begin, [&](Slice key) { return comparator->Compare(to_rocksdb(key), to_rocksdb(end)) >= 0; }, f);
+}
+
+Status RocksDb::for_each_in_family(rocksdb::ColumnFamilyHandle *family, Slice begin,
+                                   const std::function<bool(Slice)> &is_end,
+                                   const std::function<Status(Slice, Slice)> &f) {
   rocksdb::ReadOptions options;
   options.snapshot = snapshot_.get();
   std::unique_ptr<rocksdb::Iterator> iterator;
   if (snapshot_ || !transaction_) {
-    iterator.reset(db_->NewIterator(options));
+    iterator.reset(db_->NewIterator(options, family));
   } else {
-    iterator.reset(transaction_->GetIterator(options));
+    iterator.reset(transaction_->GetIterator(options, family));
   }
 
-  auto comparator = rocksdb::BytewiseComparator();
   iterator->Seek(to_rocksdb(begin));
   for (; iterator->Valid(); iterator->Next()) {
     auto key = from_rocksdb(iterator->key());
-    if (comparator->Compare(to_rocksdb(key), to_rocksdb(end)) >= 0) {
+    if (is_end(key)) {
       break;
     }
     auto value = from_rocksdb(iterator->value());
@@ -241,7 +340,30 @@ Status RocksDb::for_each_in_range(Slice begin, Slice end, std::function<Status(S
   if (!iterator->status().ok()) {
     return from_rocksdb(iterator->status());
   }
-  return td::Status::OK();
+  return Status::OK();
+}
+
+// Keys are ordered within a column family, the column families are visited one after another
+Status RocksDb::for_each_until(Slice begin, const std::function<bool(Slice)> &is_end,
+                               const std::function<Status(Slice, Slice)> &f) {
+  if (!column_families_) {
+    return for_each_in_family(default_column_family(), begin, is_end, f);
+  }
+  for (auto *handle : column_families_->handles()) {
+    TRY_STATUS(for_each_in_family(handle, begin, is_end, f));
+  }
+  std::string family_value;
+  return for_each_in_family(default_column_family(), begin, is_end, [&](Slice key, Slice value) -> Status {
+    // A key left in the default column family is outdated once its family has it
+    auto family = column_families_->find(key);
+    if (family && family->legacy_keys) {
+      TRY_RESULT(status, get_from(family->handle, key, family_value));
+      if (status == GetStatus::Ok) {
+        return Status::OK();
+      }
+    }
+    return f(key, value);
+  });
 }
 
 Status RocksDb::begin_write_batch() {
@@ -285,6 +407,11 @@ Status RocksDb::abort_transaction() {
 }
 
 Status RocksDb::flush() {
+  if (column_families_) {
+    auto handles = column_families_->handles();
+    handles.push_back(default_column_family());
+    return from_rocksdb(db_->Flush({}, handles));
+  }
   return from_rocksdb(db_->Flush({}));
 }
 
@@ -306,8 +433,9 @@ Status RocksDb::end_snapshot() {
   return td::Status::OK();
 }
 
-RocksDb::RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB> db, RocksDbOptions options)
-    : db_(std::move(db)), options_(options) {
+RocksDb::RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB> db, RocksDbOptions options,
+                 std::shared_ptr<const ColumnFamilies> column_families)
+    : db_(std::move(db)), options_(options), column_families_(std::move(column_families)) {
 }
 
 void RocksDbSnapshotStatistics::begin_snapshot(const rocksdb::Snapshot *snapshot) {
@@ -32,11 +32,14 @@
 #include <map>
 #include <mutex>
 #include <set>
+#include <string>
+#include <vector>
 
 #include <functional>
 
 namespace rocksdb {
 class Cache;
+class ColumnFamilyHandle;
 class OptimisticTransactionDB;
 class Transaction;
 class WriteBatch;
@@ -63,6 +66,19 @@ struct RocksDbOptions {
   std::shared_ptr<RocksDbSnapshotStatistics> snapshot_statistics = nullptr;
   bool use_direct_reads = false;
   bool no_block_cache = false;
+  // Bloom filters save disk reads on lookups of missing keys, 0 - disabled
+  int bloom_filter_bits_per_key = 0;
+
+  // Keys selected by has_key are kept in a separate column family with its own memtables, compactions and filters.
+  // Such keys written to the default column family before the family was added remain readable and erasable; open()
+  // scans the default column family until it finds such keys or reaches the end.
+  struct ColumnFamily {
+    std::string name;
+    std::function<bool(Slice key)> has_key;
+    int bloom_filter_bits_per_key = 0;
+    size_t write_buffer_size = 0;  // 0 - default
+  };
+  std::vector<ColumnFamily> column_families;
 };
 
 class RocksDb : public KeyValue {
@@ -122,6 +138,17 @@ class RocksDb : public KeyValue {
   };
   std::unique_ptr<const rocksdb::Snapshot, UnreachableDeleter> snapshot_;
 
-  explicit RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB> db, RocksDbOptions options);
+  struct ColumnFamilies;
+  std::shared_ptr<const ColumnFamilies> column_families_;
+
+  RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB> db, RocksDbOptions options,
+          std::shared_ptr<const ColumnFamilies> column_families);
+
+  rocksdb::ColumnFamilyHandle *default_column_family() const;
+  Result<GetStatus> get_from(rocksdb::ColumnFamilyHandle *family, Slice key, std::string &value);
+  Status for_each_in_family(rocksdb::ColumnFamilyHandle *family, Slice begin, const std::function<bool(Slice)> &is_end,
+                            const std::function<Status(Slice, Slice)> &f);
+  Status for_each_until(Slice begin, const std::function<bool(Slice)> &is_end,
+                        const std::function<Status(Slice, Slice)> &f);
 };
 }  // namespace td
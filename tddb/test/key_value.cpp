@@ -24,9 +24,12 @@
 
 #include "td/utils/benchmark.h"
 #include "td/utils/buffer.h"
+#include "td/utils/misc.h"
 #include "td/utils/optional.h"
 #include "td/utils/UInt.h"
 
+#include <map>
+
 TEST(KeyValue, simple) {
   td::Slice db_name = "testdb";
   td::RocksDb::destroy(db_name).ignore();
@@ -76,6 +79,63 @@ TEST(KeyValue, simple) {
   CHECK(!options.snapshot_statistics->oldest_snapshot_timestamp());
 };
 
+TEST(KeyValue, column_families) {
+  td::Slice db_name = "testdb";
+  td::RocksDb::destroy(db_name).ignore();
+
+  std::unique_ptr<td::KeyValue> kv = std::make_unique<td::RocksDb>(td::RocksDb::open(db_name.str()).move_as_ok());
+  auto get_value = [&](td::Slice key) {
+    std::string value;
+    auto status = kv->get(key, value).move_as_ok();
+    return status == td::KeyValue::GetStatus::Ok ? value : "<none>";
+  };
+  auto get_all = [&] {
+    std::map<std::string, std::string> res;
+    kv->for_each([&](td::Slice key, td::Slice value) {
+      CHECK(res.emplace(key.str(), value.str()).second);
+      return td::Status::OK();
+    }).ensure();
+    return res;
+  };
+  // keys "a..." go to a separate column family, the others stay in the default one
+  kv->set("a1", "old1").ensure();
+  kv->set("a2", "old2").ensure();
+  kv->set("b1", "b1").ensure();
+
+  kv.reset();
+  td::RocksDbOptions options;
+  td::RocksDbOptions::ColumnFamily family;
+  family.name = "a";
+  family.has_key = [](td::Slice key) { return td::begins_with(key, "a"); };
+  options.column_families.push_back(family);
+  kv = std::make_unique<td::RocksDb>(td::RocksDb::open(db_name.str(), options).move_as_ok());
+  ASSERT_EQ("old1", get_value("a1"));
+  kv->set("a1", "new1").ensure();
+  kv->set("a3", "new3").ensure();
+  ASSERT_EQ("new1", get_value("a1"));
+  ASSERT_EQ("old2", get_value("a2"));
+  ASSERT_EQ("b1", get_value("b1"));
+  ASSERT_EQ(3u, kv->count("a").move_as_ok());
+  auto all = get_all();
+  ASSERT_EQ(4u, all.size());
+  ASSERT_EQ("new1", all["a1"]);
+
+  kv->begin_write_batch().ensure();
+  kv->erase("a1").ensure();
+  kv->erase("a2").ensure();
+  kv->commit_write_batch().ensure();
+  ASSERT_EQ("<none>", get_value("a1"));
+  ASSERT_EQ("<none>", get_value("a2"));
+  ASSERT_EQ(2u, get_all().size());
+
+  // no keys of the family are left in the default column family now
+  kv.reset();
+  kv = std::make_unique<td::RocksDb>(td::RocksDb::open(db_name.str(), options).move_as_ok());
+  ASSERT_EQ("new3", get_value("a3"));
+  ASSERT_EQ("b1", get_value("b1"));
+  ASSERT_EQ(2u, get_all().size());
+}
+
 TEST(KeyValue, async_simple) {
   td::Slice db_name = "testdb";
   td::RocksDb::destroy(db_name).ignore();
@@ -40,11 +40,12 @@ class MpscLinkQueueImpl {
     head_.store(node, std::memory_order_relaxed);
   }
 
-  void pop_all(Reader &reader) {
+  // returns number of popped nodes
+  size_t pop_all(Reader &reader) {
     return reader.add(head_.exchange(nullptr, std::memory_order_acquire));
   }
 
-  void pop_all_unsafe(Reader &reader) {
+  size_t pop_all_unsafe(Reader &reader) {
     return reader.add(head_.exchange(nullptr, std::memory_order_relaxed));
   }
 
@@ -78,18 +79,20 @@ class MpscLinkQueueImpl {
 
    private:
     friend class MpscLinkQueueImpl;
-    void add(Node *node) {
+    size_t add(Node *node) {
       if (node == nullptr) {
-        return;
+        return 0;
       }
       // Reverse list
       Node *tail = node;
       Node *head = nullptr;
+      size_t size = 0;
       while (node) {
         auto next = node->next_;
         node->next_ = head;
         head = node;
         node = next;
+        size++;
       }
       if (head_ == nullptr) {
         head_ = head;
@@ -97,6 +100,7 @@ class MpscLinkQueueImpl {
         tail_->next_ = head;
       }
       tail_ = tail;
+      return size;
     }
     Node *head_{nullptr};
     Node *tail_{nullptr};
@@ -145,10 +149,10 @@ class MpscLinkQueue {
     }
   };
 
-  void pop_all(Reader &reader) {
+  size_t pop_all(Reader &reader) {
     return impl_.pop_all(reader.impl());
   }
-  void pop_all_unsafe(Reader &reader) {
+  size_t pop_all_unsafe(Reader &reader) {
     return impl_.pop_all_unsafe(reader.impl());
   }
 
@@ -0,0 +1,110 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "td/utils/port/cpu_topology.h"
+
+#include "td/utils/misc.h"
+#include "td/utils/port/config.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/thread.h"
+
+#include <algorithm>
+
+namespace td {
+
+// larger than any cpu or node id the kernel can report, so "cpu <= last" loops always terminate
+static constexpr unsigned MAX_CPU_ID = 1u << 16;
+
+#if TD_LINUX
+namespace {
+// sysfs reports size of every file as a page, so the file is read until EOF
+Result<string> read_sysfs_file(CSlice path) {
+  TRY_RESULT(fd, FileFd::open(path, FileFd::Read));
+  string res;
+  char buf[1024];
+  while (true) {
+    TRY_RESULT(size, fd.read(MutableSlice(buf, sizeof(buf))));
+    if (size == 0) {
+      break;
+    }
+    res.append(buf, size);
+  }
+  return std::move(res);
+}
+}  // namespace
+#endif
+
+Result<std::vector<unsigned>> parse_cpu_list(Slice list) {
+  std::vector<unsigned> res;
+  list = trim(list);
+  if (list.empty()) {
+    return res;
+  }
+  for (auto range : full_split(list, ',')) {
+    auto p = split(trim(range), '-');
+    TRY_RESULT(first, to_integer_safe<unsigned>(p.first));
+    unsigned last = first;
+    if (!p.second.empty()) {
+      TRY_RESULT_ASSIGN(last, to_integer_safe<unsigned>(p.second));
+    }
+    if (last < first || last >= MAX_CPU_ID) {
+      return Status::Error(PSLICE() << "invalid cpu range \"" << range << "\"");
+    }
+    for (unsigned cpu = first; cpu <= last; cpu++) {
+      res.push_back(cpu);
+    }
+  }
+  std::sort(res.begin(), res.end());
+  res.erase(std::unique(res.begin(), res.end()), res.end());
+  return res;
+}
+
+std::vector<NumaNode> get_numa_nodes() {
+  std::vector<NumaNode> res;
+#if TD_LINUX
+  auto r_online = read_sysfs_file("/sys/devices/system/node/online");
+  if (r_online.is_ok()) {
+    auto r_ids = parse_cpu_list(r_online.ok());  // same format as cpu lists
+    if (r_ids.is_ok()) {
+      for (auto id : r_ids.ok()) {
+        auto r_cpus = read_sysfs_file(PSTRING() << "/sys/devices/system/node/node" << id << "/cpulist");
+        if (r_cpus.is_error()) {
+          continue;
+        }
+        auto r_list = parse_cpu_list(r_cpus.ok());
+        if (r_list.is_error() || r_list.ok().empty()) {
+          continue;
+        }
+        NumaNode node;
+        node.id = narrow_cast<int>(id);
+        node.cpus = r_list.move_as_ok();
+        res.push_back(std::move(node));
+      }
+    }
+  }
+#endif
+  if (res.empty()) {
+    NumaNode node;
+    for (unsigned i = 0; i < thread::hardware_concurrency(); i++) {
+      node.cpus.push_back(i);
+    }
+    res.push_back(std::move(node));
+  }
+  return res;
+}
+
+}  // namespace td
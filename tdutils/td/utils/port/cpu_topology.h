@@ -0,0 +1,37 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+struct NumaNode {
+  int id{0};
+  std::vector<unsigned> cpus;  // online cpus of the node
+};
+
+// Parses Linux cpu list format, e.g. "0-7,16-23"
+Result<std::vector<unsigned>> parse_cpu_list(Slice list);
+
+// NUMA nodes of the machine that have online cpus. If topology is unknown, returns a single node with all cpus
+std::vector<NumaNode> get_numa_nodes();
+
+}  // namespace td
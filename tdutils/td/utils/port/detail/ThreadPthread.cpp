@@ -81,6 +81,26 @@ void ThreadPthread::set_name(CSlice name) {
 #endif
 }
 
+Status ThreadPthread::set_affinity(const std::vector<unsigned> &cpus) {
+#if TD_LINUX && defined(CPU_SET)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (auto cpu : cpus) {
+    if (cpu >= CPU_SETSIZE) {
+      return Status::Error(PSLICE() << "cpu " << cpu << " is out of range");
+    }
+    CPU_SET(cpu, &cpu_set);
+  }
+  auto err = pthread_setaffinity_np(thread_, sizeof(cpu_set), &cpu_set);
+  if (err != 0) {
+    return Status::PosixError(err, "pthread_setaffinity_np failed");
+  }
+  return Status::OK();
+#else
+  return Status::Error("thread affinity is not supported");
+#endif
+}
+
 void ThreadPthread::join() {
   if (is_inited_.get()) {
     is_inited_ = false;
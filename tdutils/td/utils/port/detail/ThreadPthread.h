@@ -29,6 +29,7 @@
 #include "td/utils/port/detail/ThreadIdGuard.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Status.h"
 
 #include <tuple>
 #include <type_traits>
@@ -67,6 +68,9 @@ class ThreadPthread {
 
   void set_name(CSlice name);
 
+  // Restricts the thread to the given cpus. Supported only on Linux
+  Status set_affinity(const std::vector<unsigned> &cpus);
+
   void join();
 
   void detach();
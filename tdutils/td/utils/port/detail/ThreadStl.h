@@ -27,6 +27,7 @@
 #include "td/utils/port/detail/ThreadIdGuard.h"
 #include "td/utils/port/thread_local.h"
 #include "td/utils/Slice.h"
+#include "td/utils/Status.h"
 
 #include <thread>
 #include <tuple>
@@ -67,6 +68,9 @@ class ThreadStl {
   }
   void set_name(CSlice name) {
   }
+  Status set_affinity(const std::vector<unsigned> &cpus) {
+    return Status::Error("thread affinity is not supported");
+  }
 
   static unsigned hardware_concurrency() {
     return std::thread::hardware_concurrency();
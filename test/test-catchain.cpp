@@ -40,6 +40,7 @@
 #include "td/utils/port/FileFd.h"
 #include "td/utils/overloaded.h"
 #include "catchain/catchain.h"
+#include "catchain/catchain-receiver.hpp"
 #include "common/errorlog.h"
 
 #if TD_DARWIN || TD_LINUX
@@ -216,6 +217,49 @@ class CatChainInst : public td::actor::Actor {
 static std::vector<Node> nodes;
 static td::uint32 total_nodes = 11;
 
+// Blocks over the limits must be dropped before any signature check is scheduled for them
+static void test_block_limits() {
+  ton::CatChainOptions opts;
+  opts.max_block_height_coeff = 1000;
+  std::vector<ton::catchain::CatChainNode> ids;
+  for (td::uint32 i = 0; i < 4; i++) {
+    auto pub = ton::PrivateKey{ton::privkeys::Ed25519::random()}.compute_public_key();
+    ids.push_back(ton::catchain::CatChainNode{ton::adnl::AdnlNodeIdShort{pub.compute_short_id()}, pub});
+  }
+  ton::catchain::CatChainSessionId unique_id;
+  td::Random::secure_bytes(unique_id.as_slice());
+  ton::catchain::CatChainReceiverImpl receiver(nullptr, opts, {}, {}, {}, ids, ids[0].pub_key.compute_short_id(),
+                                               unique_id, "", "", false);
+  // 4 sources, max_deps = 4: at most 2 blocks per source
+  CHECK(ton::catchain::get_max_block_height(opts, ids.size()) == 2);
+
+  auto make_block = [&](td::int32 height, td::uint32 deps_cnt) {
+    auto prev = ton::create_tl_object<ton::ton_api::catchain_block_dep>(1, height - 1, td::Bits256::zero(),
+                                                                         td::BufferSlice("prev"));
+    std::vector<ton::tl_object_ptr<ton::ton_api::catchain_block_dep>> deps;
+    for (td::uint32 i = 0; i < deps_cnt; i++) {
+      deps.push_back(ton::create_tl_object<ton::ton_api::catchain_block_dep>((i + 2) % 4, 1, td::Bits256::zero(),
+                                                                             td::BufferSlice("dep")));
+    }
+    return ton::create_tl_object<ton::ton_api::catchain_block>(
+        receiver.get_incarnation(), 1, height,
+        ton::create_tl_object<ton::ton_api::catchain_block_data>(std::move(prev), std::move(deps)),
+        td::BufferSlice("sig"));
+  };
+  auto checks_cnt = [&](const ton::tl_object_ptr<ton::ton_api::catchain_block> &block, bool ok) {
+    std::set<ton::catchain::CatChainBlockHash> check_ids;
+    std::vector<ton::catchain::CatChainSignatureChecker::Check> checks;
+    auto S = receiver.add_signature_checks(block, td::Slice("payload"), check_ids, checks);
+    LOG_CHECK(S.is_ok() == ok) << S;
+    return checks.size();
+  };
+
+  CHECK(checks_cnt(make_block(2, 2), true) == 4);
+  CHECK(checks_cnt(make_block(3, 2), false) == 0);
+  CHECK(checks_cnt(make_block(1000000, 0), false) == 0);
+  CHECK(checks_cnt(make_block(2, 5), false) == 0);
+}
+
 int main(int argc, char *argv[]) {
   SET_VERBOSITY_LEVEL(verbosity_INFO);
   td::set_default_failure_signal_handler().ensure();
@@ -240,6 +284,7 @@ int main(int argc, char *argv[]) {
     overlay_manager =
         ton::overlay::Overlays::create(db_root_, keyring.get(), adnl.get(), td::actor::ActorId<ton::dht::Dht>{});
     td::actor::send_closure(adnl, &ton::adnl::Adnl::register_network_manager, network_manager.get());
+    test_block_limits();
   });
 
   for (td::uint32 att = 0; att < 20; att++) {
@@ -0,0 +1,131 @@
+/* 
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission 
+    to link the code of portions of this program with the OpenSSL library. 
+    You must obey the GNU General Public License in all respects for all 
+    of the code used other than OpenSSL. If you modify file(s) with this 
+    exception, you may extend this exception to your version of the file(s), 
+    but you are not obligated to do so. If you do not wish to do so, delete this 
+    exception statement from your version. If you delete this exception statement 
+    from all source files in the program, then also delete it here.
+*/
+#include "validator/impl/liteserver-executor.hpp"
+#include "validator/block-handle.hpp"
+#include "td/utils/port/signals.h"
+
+#include <atomic>
+
+using namespace ton;
+using namespace ton::validator;
+
+struct Counters {
+  std::atomic<int> handles{0};
+  std::atomic<int> data_from_manager{0};
+  std::atomic<int> state_from_manager{0};
+  std::atomic<int> data_from_db{0};
+  std::atomic<int> state_from_db{0};
+  std::atomic<int> answers{0};
+};
+
+class TestCallback : public LiteServerExecutor::Callback {
+ public:
+  TestCallback(std::map<BlockIdExt, BlockHandle> handles, std::shared_ptr<Counters> counters)
+      : handles_(std::move(handles)), counters_(std::move(counters)) {
+  }
+  void get_block_handle(BlockIdExt block_id, td::Promise<ConstBlockHandle> promise) override {
+    counters_->handles++;
+    auto it = handles_.find(block_id);
+    if (it == handles_.end()) {
+      promise.set_error(td::Status::Error(ErrorCode::notready, "unknown block"));
+    } else {
+      promise.set_value(it->second);
+    }
+  }
+  void get_block_data(BlockIdExt block_id, td::Promise<td::Ref<BlockData>> promise) override {
+    counters_->data_from_manager++;
+    promise.set_value(td::Ref<BlockData>{});
+  }
+  void get_block_state(BlockIdExt block_id, td::Promise<td::Ref<ShardState>> promise) override {
+    counters_->state_from_manager++;
+    promise.set_value(td::Ref<ShardState>{});
+  }
+  void get_block_data_from_db(ConstBlockHandle handle, td::Promise<td::Ref<BlockData>> promise) override {
+    CHECK(handle->received());
+    counters_->data_from_db++;
+    promise.set_value(td::Ref<BlockData>{});
+  }
+  void get_block_state_from_db(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise) override {
+    CHECK(handle->received_state());
+    counters_->state_from_db++;
+    promise.set_value(td::Ref<ShardState>{});
+  }
+
+ private:
+  std::map<BlockIdExt, BlockHandle> handles_;
+  std::shared_ptr<Counters> counters_;
+};
+
+static BlockIdExt block_id(BlockSeqno seqno) {
+  return BlockIdExt{masterchainId, shardIdAll, seqno, td::Bits256::zero(), td::Bits256::zero()};
+}
+
+int main() {
+  SET_VERBOSITY_LEVEL(verbosity_INFO);
+  td::set_default_failure_signal_handler().ensure();
+
+  // Block 1 is in the db, block 2 is a nonfinal block: its handle exists, but the data is only in the candidates
+  // buffer of the manager, block 3 is a candidate without a handle
+  auto in_db = BlockHandleImpl::create_empty(block_id(1));
+  in_db->set_received();
+  in_db->set_state_root_hash(td::Bits256::zero());
+  in_db->set_state_boc();
+  in_db->flushed_upto(in_db->version());
+  auto nonfinal = BlockHandleImpl::create_empty(block_id(2));
+  std::map<BlockIdExt, BlockHandle> handles{{in_db->id(), in_db}, {nonfinal->id(), nonfinal}};
+
+  auto counters = std::make_shared<Counters>();
+  td::actor::Scheduler scheduler({1});
+  td::actor::ActorOwn<LiteServerExecutor> executor;
+  scheduler.run_in_context([&] {
+    executor =
+        td::actor::create_actor<LiteServerExecutor>("executor", std::make_unique<TestCallback>(handles, counters));
+    for (BlockSeqno seqno = 1; seqno <= 3; seqno++) {
+      td::actor::send_closure(executor, &LiteServerExecutor::get_block_data_for_litequery, block_id(seqno),
+                              [counters](td::Result<td::Ref<BlockData>> R) {
+                                R.ensure();
+                                counters->answers++;
+                              });
+      td::actor::send_closure(executor, &LiteServerExecutor::get_block_state_for_litequery, block_id(seqno),
+                              [counters](td::Result<td::Ref<ShardState>> R) {
+                                R.ensure();
+                                counters->answers++;
+                              });
+    }
+  });
+  while (counters->answers < 6) {
+    scheduler.run(0.1);
+  }
+  scheduler.run_in_context([&] { executor.reset(); });
+
+  LOG_CHECK(counters->data_from_db == 1) << counters->data_from_db;
+  LOG_CHECK(counters->state_from_db == 1) << counters->state_from_db;
+  LOG_CHECK(counters->data_from_manager == 2) << counters->data_from_manager;
+  LOG_CHECK(counters->state_from_manager == 2) << counters->state_from_manager;
+  // Data and state requests for one block share the handle lookup, unless the handle is not cached
+  LOG_CHECK(counters->handles >= 3) << counters->handles;
+  return 0;
+}
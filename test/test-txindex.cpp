@@ -0,0 +1,188 @@
+/* 
+    This file is part of TON Blockchain source code.
+
+    TON Blockchain is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    TON Blockchain is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with TON Blockchain.  If not, see <http://www.gnu.org/licenses/>.
+
+    In addition, as a special exception, the copyright holders give permission 
+    to link the code of portions of this program with the OpenSSL library. 
+    You must obey the GNU General Public License in all respects for all 
+    of the code used other than OpenSSL. If you modify file(s) with this 
+    exception, you may extend this exception to your version of the file(s), 
+    but you are not obligated to do so. If you do not wish to do so, delete this 
+    exception statement from your version. If you delete this exception statement 
+    from all source files in the program, then also delete it here.
+*/
+#include "validator/db/txindexdb.hpp"
+#include "validator/block-handle.hpp"
+#include "block/block-parse.h"
+#include "vm/boc.h"
+#include "common/bitstring.h"
+#include "common/checksum.h"
+#include "td/utils/port/path.h"
+#include "td/utils/port/signals.h"
+
+#include <atomic>
+
+using namespace ton;
+using namespace ton::validator;
+
+struct TestTransaction {
+  StdSmcAddress addr;
+  LogicalTime lt;
+};
+
+struct TestBlock {
+  BlockIdExt id;
+  td::BufferSlice data;
+  std::map<LogicalTime, td::Bits256> hashes;
+};
+
+static td::Ref<vm::Cell> empty_cell() {
+  return vm::CellBuilder().finalize();
+}
+
+// Only the fields, which are parsed by the index and by the dictionary extra evaluation, are meaningful
+static td::Ref<vm::Cell> make_transaction(const StdSmcAddress &addr, LogicalTime lt) {
+  vm::CellBuilder cb;
+  CHECK(cb.store_long_bool(7, 4)                 // transaction$0111
+        && cb.store_bits_bool(addr)              // account_addr:bits256
+        && cb.store_long_bool(lt, 64)            // lt:uint64
+        && cb.store_zeroes_bool(256 + 64 + 32)   // prev_trans_hash:bits256 prev_trans_lt:uint64 now:uint32
+        && cb.store_zeroes_bool(15 + 2 + 2)      // outmsg_cnt:uint15 orig_status:AccountStatus end_status:AccountStatus
+        && cb.store_ref_bool(empty_cell())       // ^[ in_msg:... out_msg:... ]
+        && cb.store_zeroes_bool(4 + 1)           // total_fees:CurrencyCollection
+        && cb.store_ref_bool(empty_cell())       // state_update:^(HASH_UPDATE Account)
+        && cb.store_ref_bool(empty_cell()));     // description:^TransactionDescr
+  return cb.finalize();
+}
+
+static TestBlock make_block(ShardIdFull shard, BlockSeqno seqno, const std::vector<TestTransaction> &transactions) {
+  TestBlock res;
+  std::map<StdSmcAddress, std::map<LogicalTime, td::Ref<vm::Cell>>> accounts;
+  for (auto &t : transactions) {
+    auto cell = make_transaction(t.addr, t.lt);
+    res.hashes[t.lt] = cell->get_hash().bits();
+    accounts[t.addr][t.lt] = std::move(cell);
+  }
+  vm::AugmentedDictionary acc_dict{256, block::tlb::aug_ShardAccountBlocks};
+  for (auto &p : accounts) {
+    vm::AugmentedDictionary trans_dict{64, block::tlb::aug_AccountTransactions};
+    for (auto &t : p.second) {
+      CHECK(trans_dict.set_ref(td::BitArray<64>{(long long)t.first}, t.second, vm::Dictionary::SetMode::Add));
+    }
+    vm::CellBuilder cb;
+    CHECK(cb.store_long_bool(5, 4) && cb.store_bits_bool(p.first) &&
+          cb.append_cellslice_bool(vm::load_cell_slice(std::move(trans_dict).extract_root_cell())) &&
+          cb.store_ref_bool(empty_cell()));
+    CHECK(acc_dict.set(p.first, vm::load_cell_slice_ref(cb.finalize()), vm::Dictionary::SetMode::Add));
+  }
+  vm::CellBuilder cb;
+  td::Ref<vm::Cell> account_blocks, extra, root;
+  CHECK(cb.append_cellslice_bool(std::move(acc_dict).extract_root()) && cb.finalize_to(account_blocks));
+  CHECK(cb.store_long_bool(0x4a33f6fd, 32)          // block_extra
+        && cb.store_ref_bool(empty_cell())           // in_msg_descr:^InMsgDescr
+        && cb.store_ref_bool(empty_cell())           // out_msg_descr:^OutMsgDescr
+        && cb.store_ref_bool(account_blocks)         // account_blocks:^ShardAccountBlocks
+        && cb.store_zeroes_bool(256 + 256 + 1)       // rand_seed:bits256 created_by:bits256 custom:(Maybe ^McBlockExtra)
+        && cb.finalize_to(extra));
+  CHECK(cb.store_long_bool(0x11ef55aa, 32)          // block
+        && cb.store_long_bool(-239, 32)              // global_id:int32
+        && cb.store_ref_bool(empty_cell())           // info:^BlockInfo
+        && cb.store_ref_bool(empty_cell())           // value_flow:^ValueFlow
+        && cb.store_ref_bool(empty_cell())           // state_update:^(MERKLE_UPDATE ShardState)
+        && cb.store_ref_bool(extra)                  // extra:^BlockExtra
+        && cb.finalize_to(root));
+  res.data = vm::std_boc_serialize(root).move_as_ok();
+  res.id = BlockIdExt{BlockId{shard, seqno}, root->get_hash().bits(), td::sha256_bits256(res.data.as_slice())};
+  return res;
+}
+
+static StdSmcAddress make_address(td::uint8 x) {
+  StdSmcAddress addr;
+  addr.set_zero();
+  addr.bits().store_uint(x, 8);
+  return addr;
+}
+
+int main() {
+  SET_VERBOSITY_LEVEL(verbosity_INFO);
+  td::set_default_failure_signal_handler().ensure();
+
+  std::string db_root = "tmp-dir-test-txindex";
+  td::rmrf(db_root).ignore();
+  td::mkdir(db_root).ensure();
+
+  auto a = make_address(1), b = make_address(2), c = make_address(3);
+  ShardIdFull shard{basechainId, shardIdAll};
+  std::vector<TestBlock> blocks;
+  blocks.push_back(make_block(shard, 1, {{a, 10}, {a, 20}, {b, 15}}));
+  blocks.push_back(make_block(shard, 2, {{a, 30}}));
+  // Masterchain block 1 does not start the backfill: there are no blocks before it
+  blocks.push_back(make_block(ShardIdFull{masterchainId}, 1, {{a, 25}}));
+  // Data, which does not match the block id, is not indexed
+  auto bad = make_block(shard, 3, {{c, 40}});
+  bad.id.root_hash = td::Bits256::zero();
+  blocks.push_back(std::move(bad));
+
+  struct Query {
+    WorkchainId workchain;
+    StdSmcAddress addr;
+    LogicalTime lt;
+    td::uint32 count;
+    // (lt, index of block)
+    std::vector<std::pair<LogicalTime, size_t>> expected;
+  };
+  std::vector<Query> queries = {
+      {basechainId, a, std::numeric_limits<LogicalTime>::max(), 10, {{30, 1}, {20, 0}, {10, 0}}},
+      {basechainId, a, 29, 10, {{20, 0}, {10, 0}}},
+      {basechainId, a, 20, 1, {{20, 0}}},
+      {basechainId, a, 9, 10, {}},
+      {basechainId, b, std::numeric_limits<LogicalTime>::max(), 10, {{15, 0}}},
+      {masterchainId, a, std::numeric_limits<LogicalTime>::max(), 10, {{25, 2}}},
+      {basechainId, c, std::numeric_limits<LogicalTime>::max(), 10, {}},
+  };
+
+  std::atomic<size_t> answers{0};
+  td::actor::Scheduler scheduler({1});
+  td::actor::ActorOwn<TransactionIndexDb> db;
+  scheduler.run_in_context([&] {
+    db = td::actor::create_actor<TransactionIndexDb>("txindexdb", td::actor::ActorId<ArchiveManager>{},
+                                                     db_root + "/txindex/");
+    for (auto &block : blocks) {
+      auto handle = BlockHandleImpl::create_empty(block.id);
+      td::actor::send_closure(db, &TransactionIndexDb::add_block, std::move(handle), block.data.clone());
+    }
+    for (auto &q : queries) {
+      td::actor::send_closure(
+          db, &TransactionIndexDb::get_account_transactions, q.workchain, q.addr, q.lt, q.count,
+          [&, q](td::Result<std::vector<AccountTransactionRef>> R) {
+            auto res = R.move_as_ok();
+            LOG_CHECK(res.size() == q.expected.size()) << res.size() << " " << q.expected.size();
+            for (size_t i = 0; i < res.size(); i++) {
+              auto &block = blocks[q.expected[i].second];
+              CHECK(res[i].lt == q.expected[i].first);
+              CHECK(res[i].block_id == block.id);
+              CHECK(res[i].hash == block.hashes.at(res[i].lt));
+            }
+            answers++;
+          });
+    }
+  });
+  while (answers < queries.size()) {
+    scheduler.run(0.1);
+  }
+  scheduler.run_in_context([&] { db.reset(); });
+  td::rmrf(db_root).ensure();
+  return 0;
+}
@@ -35,6 +35,7 @@
 #include "validator-session/validator-session-description.h"
 #include "validator-session/validator-session-state.h"
 #include "validator-session/validator-session-description.hpp"
+#include "validator-session/validator-session-block-states.h"
 
 #include <limits>
 #include <memory>
@@ -57,6 +58,20 @@ class Description : public ton::validatorsession::ValidatorSessionDescription {
   void clear_temp_memory() override {
     mem_temp_.clear();
   }
+  void start_compaction() override {
+    CHECK(mem_old_perm_.allocated_size() == 0);
+    mem_perm_.swap(mem_old_perm_);
+    for (auto &el : cache_) {
+      Cached v{nullptr};
+      el.store(v, std::memory_order_relaxed);
+    }
+  }
+  void finish_compaction() override {
+    mem_old_perm_.release();
+  }
+  size_t get_persistent_memory_size() const override {
+    return mem_perm_.allocated_size();
+  }
 
   ton::PublicKeyHash get_source_id(td::uint32 idx) const override {
     CHECK(idx < total_nodes_);
@@ -191,7 +206,7 @@ class Description : public ton::validatorsession::ValidatorSessionDescription {
   }
 
   Description(ton::validatorsession::ValidatorSessionOptions opts, td::uint32 total_nodes)
-      : opts_(opts), total_nodes_(total_nodes), mem_perm_(1 << 30), mem_temp_(1 << 22) {
+      : opts_(opts), total_nodes_(total_nodes), mem_perm_(1 << 30), mem_temp_(1 << 22), mem_old_perm_(1 << 30) {
     for (auto &el : cache_) {
       Cached v{nullptr};
       el.store(v, std::memory_order_relaxed);
@@ -212,7 +227,7 @@ class Description : public ton::validatorsession::ValidatorSessionDescription {
   };
   std::array<std::atomic<Cached>, cache_size> cache_;
 
-  ton::validatorsession::ValidatorSessionDescriptionImpl::MemPool mem_perm_, mem_temp_;
+  ton::validatorsession::ValidatorSessionDescriptionImpl::MemPool mem_perm_, mem_temp_, mem_old_perm_;
 };
 
 double myrand() {
@@ -981,6 +996,164 @@ int main() {
     delete descptr;
   }
 
+  {
+    // Compaction in the middle of a round must not change the states of blocks: neither of the ones moved to the new
+    // arena nor of the dropped ones, which are replayed when an old block is referenced again. The same catchain is
+    // built twice, the second copy is never compacted.
+    td::uint32 nodes = 10;
+    auto descptr = new Description(opts, nodes);
+    auto refptr = new Description(opts, nodes);
+    auto &desc = *descptr;
+    auto &ref = *refptr;
+    ton::validatorsession::ValidatorSessionBlockStates states(desc, "", nullptr);
+    ton::validatorsession::ValidatorSessionBlockStates ref_states(ref, "", nullptr);
+
+    std::vector<std::unique_ptr<ton::catchain::CatChainBlock>> blocks, ref_blocks;
+    std::vector<std::vector<size_t>> source_blocks(nodes);
+
+    auto virt_state = ton::validatorsession::ValidatorSessionState::create(desc);
+    virt_state = ton::validatorsession::ValidatorSessionState::move_to_persistent(desc, virt_state);
+    auto ref_virt_state = ton::validatorsession::ValidatorSessionState::create(ref);
+    ref_virt_state = ton::validatorsession::ValidatorSessionState::move_to_persistent(ref, ref_virt_state);
+
+    auto check_block = [&](size_t i) {
+      auto h1 = states.get(blocks[i].get())->get_hash(desc);
+      auto h2 = ref_states.get(ref_blocks[i].get())->get_hash(ref);
+      LOG_CHECK(h1 == h2) << "block " << i << ": " << h1 << " != " << h2;
+    };
+
+    td::uint64 ts = desc.get_ts();
+    td::uint32 compactions = 0;
+    td::uint32 replays = 0;
+    for (td::uint32 i = 0; i < 3000; i++) {
+      td::uint32 x = td::Random::fast(0, nodes - 1);
+      auto att = ref.get_attempt_seqno(ts);
+
+      ton::catchain::CatChainBlock *prev = nullptr, *ref_prev = nullptr;
+      if (!source_blocks[x].empty()) {
+        prev = blocks[source_blocks[x].back()].get();
+        ref_prev = ref_blocks[source_blocks[x].back()].get();
+      }
+      std::vector<ton::catchain::CatChainBlock *> deps, ref_deps;
+      std::set<td::uint32> dep_sources;
+      bool old_dep = false;
+      for (td::uint32 z = 0; z < 3; z++) {
+        td::uint32 y = td::Random::fast(0, nodes - 1);
+        if (y == x || source_blocks[y].empty() || !dep_sources.insert(y).second) {
+          continue;
+        }
+        auto k = source_blocks[y].back();
+        if (z == 0 && compactions > 0 && myrand() < 0.05) {
+          k = source_blocks[y][td::Random::fast(0, static_cast<td::int32>(source_blocks[y].size() - 1))];
+          old_dep |= blocks[k]->extra() == nullptr;
+        }
+        deps.push_back(blocks[k].get());
+        ref_deps.push_back(ref_blocks[k].get());
+      }
+
+      // actions are generated from the uncompacted state, as a node would do it
+      auto s = ref_prev ? ref_states.get(ref_prev) : ton::validatorsession::ValidatorSessionState::create(ref);
+      for (auto dep : ref_deps) {
+        s = ton::validatorsession::ValidatorSessionState::merge(ref, s, ref_states.get(dep));
+      }
+      auto round = s->cur_round_seqno();
+      std::vector<ton::tl_object_ptr<ton::ton_api::validatorSession_round_Message>> actions;
+      auto add_action = [&](ton::tl_object_ptr<ton::ton_api::validatorSession_round_Message> act) {
+        s = ton::validatorsession::ValidatorSessionState::action(ref, s, x, att, act.get());
+        CHECK(s);
+        actions.push_back(std::move(act));
+      };
+      if (ref.get_node_priority(x, round) >= 0 && myrand() <= 0.8 && !s->check_block_is_sent_by(ref, x)) {
+        add_action(ton::create_tl_object<ton::ton_api::validatorSession_message_submittedBlock>(
+            round, ton::Bits256::zero(), ton::Bits256::zero(), ton::Bits256::zero()));
+      }
+      auto vec = s->choose_blocks_to_approve(ref, x);
+      if (vec.size() > 0 && myrand() <= 0.5) {
+        auto B = vec[td::Random::fast(0, static_cast<td::uint32>(vec.size() - 1))];
+        td::BufferSlice sig{B ? 1u : 0u};
+        if (B) {
+          sig.as_slice()[0] = 127;
+        }
+        add_action(ton::create_tl_object<ton::ton_api::validatorSession_message_approvedBlock>(
+            round, ton::validatorsession::SentBlock::get_block_id(B), std::move(sig)));
+      }
+      bool found;
+      auto to_sign = s->choose_block_to_sign(ref, x, found);
+      if (found) {
+        td::BufferSlice sig{to_sign ? 1u : 0u};
+        if (to_sign) {
+          sig.as_slice()[0] = 126;
+        }
+        add_action(ton::create_tl_object<ton::ton_api::validatorSession_message_commit>(
+            round, ton::validatorsession::SentBlock::get_block_id(to_sign), std::move(sig)));
+      }
+      if (s->check_need_generate_vote_for(ref, x, att)) {
+        add_action(s->generate_vote_for(ref, x, att));
+      }
+      while (true) {
+        auto act = s->create_action(ref, x, att);
+        if (act->get_id() == ton::ton_api::validatorSession_message_empty::ID) {
+          break;
+        }
+        add_action(std::move(act));
+      }
+      s = ton::validatorsession::ValidatorSessionState::make_all(ref, s, x, att);
+      auto hash = s->get_hash(ref);
+      auto payload = ton::serialize_tl_object(
+          ton::create_tl_object<ton::ton_api::validatorSession_blockUpdate>(ts, std::move(actions), hash), true);
+
+      td::Bits256 block_hash;
+      td::Random::secure_bytes(block_hash.as_slice());
+      auto height = static_cast<ton::catchain::CatChainBlockHeight>(source_blocks[x].size() + 1);
+      blocks.push_back(ton::catchain::CatChainBlock::create(x, 0, desc.get_source_id(x), height, block_hash,
+                                                            td::SharedSlice{payload.as_slice()}, prev, deps, {}));
+      ref_blocks.push_back(ton::catchain::CatChainBlock::create(x, 0, ref.get_source_id(x), height, block_hash,
+                                                                td::SharedSlice{payload.as_slice()}, ref_prev,
+                                                                ref_deps, {}));
+      source_blocks[x].push_back(blocks.size() - 1);
+      if (old_dep) {
+        replays++;
+      }
+
+      auto ref_state = ref_states.set(ref_blocks.back().get(), ref_states.compute(ref_blocks.back().get(), false));
+      auto state = states.set(blocks.back().get(), states.compute(blocks.back().get(), false));
+      CHECK(ref_state->get_hash(ref) == hash);
+      CHECK(state->get_hash(desc) == hash);
+
+      virt_state = ton::validatorsession::ValidatorSessionState::merge(desc, virt_state, state);
+      virt_state = ton::validatorsession::ValidatorSessionState::move_to_persistent(desc, virt_state);
+      ref_virt_state = ton::validatorsession::ValidatorSessionState::merge(ref, ref_virt_state, ref_state);
+      ref_virt_state = ton::validatorsession::ValidatorSessionState::move_to_persistent(ref, ref_virt_state);
+      desc.clear_temp_memory();
+      ref.clear_temp_memory();
+
+      if (i % 500 == 250) {
+        states.compact(2, {&virt_state});
+        compactions++;
+        CHECK(states.size() <= 2 * nodes);
+        CHECK(desc.get_persistent_memory_size() <= ref.get_persistent_memory_size());
+        CHECK(virt_state->get_hash(desc) == ref_virt_state->get_hash(ref));
+        for (size_t j = 0; j < 5; j++) {
+          check_block(td::Random::fast(0, static_cast<td::int32>(blocks.size() - 1)));
+        }
+      }
+      if (myrand() <= 1.0 / 0.5 / nodes) {
+        ts += 1ull << 32;
+      }
+    }
+    LOG(INFO) << "compaction test: rounds=" << ref_virt_state->cur_round_seqno() << " replays=" << replays;
+    CHECK(ref_virt_state->cur_round_seqno() > 0);
+    CHECK(replays > 0);
+    CHECK(virt_state->get_hash(desc) == ref_virt_state->get_hash(ref));
+    for (size_t i = 0; i < blocks.size(); i++) {
+      check_block(i);
+    }
+    blocks.clear();
+    ref_blocks.clear();
+    delete descptr;
+    delete refptr;
+  }
+
   std::_Exit(0);
   return 0;
 }
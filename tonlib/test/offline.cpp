@@ -28,9 +28,13 @@
 #include "tonlib/utils.h"
 #include "tonlib/TonlibClient.h"
 #include "tonlib/Client.h"
+#include "tonlib/ExtClientLazy.h"
 
 #include "auto/tl/ton_api_json.h"
 #include "auto/tl/tonlib_api_json.h"
+#include "auto/tl/lite_api.h"
+#include "tl-utils/lite-utils.hpp"
+#include "common/errorcode.h"
 
 #include "td/utils/benchmark.h"
 #include "td/utils/filesystem.h"
@@ -39,6 +43,7 @@
 #include "td/utils/port/path.h"
 #include "td/utils/PathView.h"
 #include "td/utils/tests.h"
+#include "td/utils/Timer.h"
 
 // KeyManager
 #include "tonlib/keys/bip39.h"
@@ -47,6 +52,8 @@
 #include "tonlib/keys/Mnemonic.h"
 #include "tonlib/keys/SimpleEncryption.h"
 
+#include <atomic>
+
 TEST(Tonlib, CellString) {
   for (unsigned size :
        {0, 1, 7, 8, 35, 127, 128, 255, 256, (int)vm::CellString::max_bytes - 1, (int)vm::CellString::max_bytes}) {
@@ -692,3 +699,130 @@ TEST(Tonlib, ConfigCache) {
                         make_object<tonlib_api::config>(custom, "testnet", true, false)))
       .ensure_error();
 }
+
+namespace {
+// Liteserver connection for ExtClientLazy tests, which answers queries without network
+class FakeLiteserver : public ton::adnl::AdnlExtClient {
+ public:
+  enum class Mode { Ok, BlockBehind, Silent };
+  struct Stats {
+    std::atomic<int> queries{0};
+  };
+  FakeLiteserver(int id, Mode mode, std::shared_ptr<Stats> stats,
+                 std::unique_ptr<ton::adnl::AdnlExtClient::Callback> callback)
+      : id_(id), mode_(mode), stats_(std::move(stats)), callback_(std::move(callback)) {
+  }
+  void check_ready(td::Promise<td::Unit> promise) override {
+    promise.set_value(td::Unit());
+  }
+  void send_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
+                  td::Promise<td::BufferSlice> promise) override {
+    stats_->queries++;
+    switch (mode_) {
+      case Mode::Ok:
+        promise.set_value(ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_currentTime>(id_),
+                                                   true));
+        break;
+      case Mode::BlockBehind:
+        promise.set_value(ton::serialize_tl_object(
+            ton::create_tl_object<ton::lite_api::liteServer_error>(ton::ErrorCode::notready, "block is not applied"), true));
+        break;
+      case Mode::Silent:
+        pending_.emplace_back(timeout, std::move(promise));
+        alarm_timestamp().relax(timeout);
+        break;
+    }
+  }
+  void alarm() override {
+    for (auto &p : pending_) {
+      if (p.second && p.first.is_in_past()) {
+        p.second.set_error(td::Status::Error(ton::ErrorCode::timeout, "timeout"));
+      } else if (p.second) {
+        alarm_timestamp().relax(p.first);
+      }
+    }
+  }
+
+ private:
+  int id_;
+  Mode mode_;
+  std::shared_ptr<Stats> stats_;
+  std::unique_ptr<ton::adnl::AdnlExtClient::Callback> callback_;
+  std::vector<std::pair<td::Timestamp, td::Promise<td::BufferSlice>>> pending_;
+};
+
+// Sends count getTime queries at once to servers with the given modes and returns the answering servers
+std::vector<int> run_ext_client_lazy(std::vector<FakeLiteserver::Mode> modes, size_t count,
+                                     std::vector<std::shared_ptr<FakeLiteserver::Stats>> &stats) {
+  std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers;
+  for (size_t i = 0; i < modes.size(); i++) {
+    td::IPAddress addr;
+    addr.init_ipv4_port("127.0.0.1", static_cast<int>(10000 + i)).ensure();
+    servers.emplace_back(ton::adnl::AdnlNodeIdFull{ton::PublicKey{ton::pubkeys::Ed25519{td::Bits256::zero()}}}, addr);
+    stats.push_back(std::make_shared<FakeLiteserver::Stats>());
+  }
+  auto factory = [modes, stats](ton::adnl::AdnlNodeIdFull dst, td::IPAddress dst_addr,
+                                std::unique_ptr<ton::adnl::AdnlExtClient::Callback> callback) {
+    int id = dst_addr.get_port() - 10000;
+    return td::actor::ActorOwn<ton::adnl::AdnlExtClient>(td::actor::create_actor<FakeLiteserver>(
+        PSLICE() << "fake" << id, id, modes[id], stats[id], std::move(callback)));
+  };
+
+  std::vector<int> answered_by;
+  std::atomic<size_t> answers{0};
+  td::actor::Scheduler scheduler({1});
+  td::actor::ActorOwn<tonlib::ExtClientLazy> client;
+  scheduler.run_in_context([&] {
+    client = tonlib::ExtClientLazy::create(std::move(servers), td::make_unique<tonlib::ExtClientLazy::Callback>(),
+                                           factory);
+    for (size_t i = 0; i < count; i++) {
+      auto query = ton::serialize_tl_object(
+          ton::create_tl_object<ton::lite_api::liteServer_query>(
+              ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_getTime>(), true)),
+          true);
+      td::actor::send_closure(client, &ton::adnl::AdnlExtClient::send_query, "query", std::move(query),
+                              td::Timestamp::in(10.0), [&](td::Result<td::BufferSlice> R) {
+                                auto answer = ton::fetch_tl_object<ton::lite_api::liteServer_currentTime>(
+                                    R.move_as_ok(), true);
+                                answered_by.push_back(answer.move_as_ok()->now_);
+                                answers++;
+                              });
+    }
+  });
+  while (answers < count) {
+    scheduler.run(0.1);
+  }
+  scheduler.run_in_context([&] { client.reset(); });
+  scheduler.run(0.1);
+  return answered_by;
+}
+}  // namespace
+
+TEST(Tonlib, ExtClientLazyBlockBehind) {
+  using Mode = FakeLiteserver::Mode;
+  std::vector<std::shared_ptr<FakeLiteserver::Stats>> stats;
+  // Concurrent queries are spread over both servers; liteServer.error of the server, which is a block behind, is
+  // retried on the other one
+  auto answered_by = run_ext_client_lazy({Mode::BlockBehind, Mode::Ok}, 4, stats);
+  ASSERT_EQ(4u, answered_by.size());
+  for (auto id : answered_by) {
+    ASSERT_EQ(1, id);
+  }
+  ASSERT_TRUE(stats[0]->queries > 0);
+  ASSERT_EQ(4, stats[1]->queries.load());
+}
+
+TEST(Tonlib, ExtClientLazyTimeout) {
+  using Mode = FakeLiteserver::Mode;
+  std::vector<std::shared_ptr<FakeLiteserver::Stats>> stats;
+  // Queries to the silent server are resent to the other one long before their timeout
+  td::Timer timer;
+  auto answered_by = run_ext_client_lazy({Mode::Silent, Mode::Ok}, 4, stats);
+  ASSERT_TRUE(timer.elapsed() < 5.0);
+  ASSERT_EQ(4u, answered_by.size());
+  for (auto id : answered_by) {
+    ASSERT_EQ(1, id);
+  }
+  ASSERT_TRUE(stats[0]->queries > 0);
+  ASSERT_EQ(4, stats[1]->queries.load());
+}
@@ -58,6 +58,7 @@
 #include "td/utils/optional.h"
 #include "td/utils/overloaded.h"
 #include "td/utils/MpscPollableQueue.h"
+#include "td/utils/Timer.h"
 #include "td/utils/port/path.h"
 
 #include "td/utils/port/signals.h"
@@ -790,6 +791,28 @@ void test_dns(Client& client, const Wallet& giver_wallet) {
   ::dns_resolve(client, A, "C.B.A");
 }
 
+void test_shared_last_block(Client& client, const std::string& global_config_str) {
+  // The second client uses the same config, so it starts from the last block verified by the first one
+  Client client2;
+  sync_send(client2, make_object<tonlib_api::init>(make_object<tonlib_api::options>(
+                         make_object<tonlib_api::config>(global_config_str, "", false, false),
+                         make_object<tonlib_api::keyStoreTypeInMemory>())))
+      .ensure();
+  td::int32 last_seqno = 0;
+  td::int32 last_seqno2 = 0;
+  for (int i = 0; i < 3; i++) {
+    auto block = sync_send(client, make_object<tonlib_api::sync>()).move_as_ok();
+    td::Timer timer;
+    auto block2 = sync_send(client2, make_object<tonlib_api::sync>()).move_as_ok();
+    LOG(INFO) << "second client synced to " << block2->seqno_ << " in " << timer;
+    CHECK(block2->seqno_ >= block->seqno_);
+    CHECK(block->seqno_ >= last_seqno);
+    CHECK(block2->seqno_ >= last_seqno2);
+    last_seqno = block->seqno_;
+    last_seqno2 = block2->seqno_;
+  }
+}
+
 int main(int argc, char* argv[]) {
   td::set_default_failure_signal_handler();
   using tonlib_api::make_object;
@@ -838,6 +861,7 @@ int main(int argc, char* argv[]) {
   // wait till client is synchronized with blockchain.
   // not necessary, but synchronized will be trigged anyway later
   sync(client);
+  test_shared_last_block(client, global_config_str);
 
   // give wallet with some test grams to run test
   auto giver_wallet = import_wallet_from_pkey(client, giver_key_str, giver_key_pwd);
@@ -19,14 +19,33 @@
 #include "ExtClientLazy.h"
 #include "TonlibError.h"
 #include "td/utils/Random.h"
+#include "td/utils/as.h"
+#include "auto/tl/lite_api.h"
+#include "tl-utils/lite-utils.hpp"
+
+#include <limits>
+#include <map>
+
 namespace tonlib {
 
+/*
+ * Keeps connections to several liteservers of the config at once. Each query goes to the server with the lowest
+ * (latency * (1 + queries in flight)). If the answer is late, the same query is sent to one more server and the
+ * first answer is used. A liteServer.error answer (e.g. from a server that is a block behind) is retried on another
+ * server once. Servers that time out or drop the connection are skipped for a while and replaced by the next
+ * server of the list.
+ */
 class ExtClientLazyImp : public ExtClientLazy {
  public:
   ExtClientLazyImp(std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers,
-                   td::unique_ptr<ExtClientLazy::Callback> callback)
-      : servers_(std::move(servers)), callback_(std::move(callback)) {
-    CHECK(!servers_.empty());
+                   td::unique_ptr<ExtClientLazy::Callback> callback, ConnectionFactory connection_factory)
+      : callback_(std::move(callback)), connection_factory_(std::move(connection_factory)) {
+    CHECK(!servers.empty());
+    for (auto& s : servers) {
+      servers_.emplace_back();
+      servers_.back().id = std::move(s.first);
+      servers_.back().addr = s.second;
+    }
   }
 
   void start_up() override {
@@ -35,47 +54,142 @@ class ExtClientLazyImp : public ExtClientLazy {
   }
 
   void check_ready(td::Promise<td::Unit> promise) override {
-    before_query();
-    if (client_.empty()) {
+    auto idx = choose_server(NO_SERVER);
+    if (idx == NO_SERVER) {
       return promise.set_error(TonlibError::Cancelled());
     }
-    send_closure(client_, &ton::adnl::AdnlExtClient::check_ready, std::move(promise));
+    send_closure(servers_[idx].client, &ton::adnl::AdnlExtClient::check_ready, std::move(promise));
   }
 
   void send_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
                   td::Promise<td::BufferSlice> promise) override {
-    before_query();
-    if (client_.empty()) {
+    auto idx = choose_server(NO_SERVER);
+    if (idx == NO_SERVER) {
       return promise.set_error(TonlibError::Cancelled());
     }
-    td::Promise<td::BufferSlice> P = [SelfId = actor_id(this), idx = cur_server_idx_,
-                                      promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
-      if (R.is_error() &&
-          (R.error().code() == ton::ErrorCode::timeout || R.error().code() == ton::ErrorCode::cancelled)) {
-        td::actor::send_closure(SelfId, &ExtClientLazyImp::set_server_bad, idx, true);
-      }
-      promise.set_result(std::move(R));
-    };
-    send_closure(client_, &ton::adnl::AdnlExtClient::send_query, std::move(name), std::move(data), timeout,
-                 std::move(P));
+    auto query_id = next_query_id_++;
+    auto& query = queries_[query_id];
+    query.promise = std::move(promise);
+    query.timeout = timeout;
+    query.server_idx = idx;
+    if (servers_.size() > 1 && can_resend(data)) {
+      query.name = name;
+      query.data = data.clone();
+      query.resend_at = td::Timestamp::in(resend_delay(servers_[idx]));
+      alarm_timestamp().relax(query.resend_at);
+    }
+    send_to_server(query_id, idx, std::move(name), std::move(data));
   }
 
   void force_change_liteserver() override {
-    if (servers_.size() == 1) {
+    if (servers_.size() == 1 || last_server_idx_ == NO_SERVER) {
       return;
     }
-    cur_server_bad_ = cur_server_bad_force_ = true;
+    set_server_bad(last_server_idx_);
   }
 
  private:
-  void before_query() {
+  struct Server {
+    ton::adnl::AdnlNodeIdFull id;
+    td::IPAddress addr;
+    td::actor::ActorOwn<ton::adnl::AdnlExtClient> client;
+    td::uint32 in_flight = 0;
+    double latency = 0.0;  // moving average of answer time, 0 when unknown
+    td::Timestamp bad_until;
+  };
+  struct Query {
+    td::Promise<td::BufferSlice> promise;
+    td::Timestamp timeout;
+    // kept until the query is resent to the second server
+    std::string name;
+    td::BufferSlice data;
+    td::Timestamp resend_at;
+    size_t server_idx = 0;
+    size_t sent = 0;
+    size_t failed = 0;
+    td::BufferSlice error_answer;
+    td::Status error;
+  };
+
+  static constexpr size_t NO_SERVER = std::numeric_limits<size_t>::max();
+  static constexpr size_t MAX_ACTIVE_SERVERS = 3;
+  static constexpr double MAX_NO_QUERIES_TIMEOUT = 100;
+  static constexpr double BAD_SERVER_TIMEOUT = 60;
+  static constexpr double DEFAULT_LATENCY = 0.1;
+
+  std::vector<Server> servers_;
+  size_t last_server_idx_ = NO_SERVER;
+  std::map<td::uint64, Query> queries_;
+  td::uint64 next_query_id_ = 0;
+  td::Timestamp idle_at_;
+
+  td::unique_ptr<ExtClientLazy::Callback> callback_;
+  ConnectionFactory connection_factory_;
+
+  bool is_closing_{false};
+  td::uint32 ref_cnt_{1};
+
+  // sendMessage is not resent: duplicates of an external message are useless at best
+  static bool can_resend(const td::BufferSlice& data) {
+    auto r_query = ton::fetch_tl_object<ton::lite_api::liteServer_query>(data.as_slice(), true);
+    if (r_query.is_error()) {
+      return false;
+    }
+    auto query = r_query.move_as_ok();
+    td::Slice inner = query->data_.as_slice();
+    if (ton::fetch_tl_prefix<ton::lite_api::liteServer_waitMasterchainSeqno>(inner, true).is_error()) {
+      inner = query->data_.as_slice();
+    }
+    return inner.size() >= 4 && td::as<td::int32>(inner.data()) != ton::lite_api::liteServer_sendMessage::ID;
+  }
+
+  static double resend_delay(const Server& server) {
+    return td::clamp((server.latency > 0 ? server.latency : DEFAULT_LATENCY) * 4, 0.3, 3.0);
+  }
+
+  size_t choose_server(size_t exclude) {
     if (is_closing_) {
-      return;
+      return NO_SERVER;
+    }
+    idle_at_ = td::Timestamp::in(MAX_NO_QUERIES_TIMEOUT);
+    if (!alarm_timestamp()) {
+      alarm_timestamp() = idle_at_;
     }
-    alarm_timestamp() = td::Timestamp::in(MAX_NO_QUERIES_TIMEOUT);
-    if (cur_server_bad_) {
-      ++cur_server_idx_;
-    } else if (!client_.empty()) {
+    size_t best = NO_SERVER;
+    double best_score = 0.0;
+    size_t active = 0;
+    for (size_t i = 0; i < servers_.size() && active < MAX_ACTIVE_SERVERS; i++) {
+      auto& server = servers_[i];
+      if (server.bad_until && !server.bad_until.is_in_past()) {
+        continue;
+      }
+      active++;
+      if (i == exclude) {
+        continue;
+      }
+      double score = (server.latency > 0 ? server.latency : DEFAULT_LATENCY) * (1 + server.in_flight);
+      if (best == NO_SERVER || score < best_score) {
+        best = i;
+        best_score = score;
+      }
+    }
+    if (best == NO_SERVER && exclude == NO_SERVER) {
+      // All servers are bad, try the one that failed first
+      for (size_t i = 0; i < servers_.size(); i++) {
+        if (best == NO_SERVER || servers_[i].bad_until < servers_[best].bad_until) {
+          best = i;
+        }
+      }
+    }
+    if (best != NO_SERVER) {
+      connect(best);
+    }
+    return best;
+  }
+
+  void connect(size_t idx) {
+    auto& server = servers_[idx];
+    if (!server.client.empty()) {
       return;
     }
     class Callback : public ton::adnl::AdnlExtClient::Callback {
@@ -84,10 +198,9 @@ class ExtClientLazyImp : public ExtClientLazy {
           : parent_(std::move(parent)), idx_(idx) {
       }
       void on_ready() override {
-        td::actor::send_closure(parent_, &ExtClientLazyImp::set_server_bad, idx_, false);
       }
       void on_stop_ready() override {
-        td::actor::send_closure(parent_, &ExtClientLazyImp::set_server_bad, idx_, true);
+        td::actor::send_closure(parent_, &ExtClientLazyImp::set_server_bad, idx_);
       }
 
      private:
@@ -95,34 +208,118 @@ class ExtClientLazyImp : public ExtClientLazy {
       size_t idx_;
     };
     ref_cnt_++;
-    cur_server_bad_ = false;
-    cur_server_bad_force_ = false;
-    const auto& s = servers_[cur_server_idx_ % servers_.size()];
-    LOG(INFO) << "Connecting to liteserver " << s.second;
-    client_ = ton::adnl::AdnlExtClient::create(
-        s.first, s.second, std::make_unique<Callback>(td::actor::actor_shared(this), cur_server_idx_));
+    LOG(INFO) << "Connecting to liteserver " << server.addr;
+    server.client =
+        connection_factory_(server.id, server.addr, std::make_unique<Callback>(td::actor::actor_shared(this), idx));
+  }
+
+  void send_to_server(td::uint64 query_id, size_t idx, std::string name, td::BufferSlice data) {
+    auto& query = queries_[query_id];
+    query.sent++;
+    servers_[idx].in_flight++;
+    td::Promise<td::BufferSlice> P = [SelfId = actor_id(this), query_id, idx,
+                                      started = td::Timestamp::now()](td::Result<td::BufferSlice> R) mutable {
+      td::actor::send_closure(SelfId, &ExtClientLazyImp::on_query_result, query_id, idx, started, std::move(R));
+    };
+    send_closure(servers_[idx].client, &ton::adnl::AdnlExtClient::send_query, std::move(name), std::move(data),
+                 query.timeout, std::move(P));
   }
 
-  std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers_;
-  size_t cur_server_idx_ = 0;
-  bool cur_server_bad_ = false;
-  bool cur_server_bad_force_ = false;
+  void on_query_result(td::uint64 query_id, size_t idx, td::Timestamp started, td::Result<td::BufferSlice> R) {
+    auto& server = servers_[idx];
+    CHECK(server.in_flight > 0);
+    server.in_flight--;
+    if (R.is_ok()) {
+      double elapsed = td::Timestamp::now().at() - started.at();
+      server.latency = server.latency > 0 ? server.latency * 0.8 + elapsed * 0.2 : elapsed;
+      last_server_idx_ = idx;
+    } else if (R.error().code() == ton::ErrorCode::timeout || R.error().code() == ton::ErrorCode::cancelled) {
+      set_server_bad(idx);
+    }
 
-  td::actor::ActorOwn<ton::adnl::AdnlExtClient> client_;
-  td::unique_ptr<ExtClientLazy::Callback> callback_;
-  static constexpr double MAX_NO_QUERIES_TIMEOUT = 100;
+    auto it = queries_.find(query_id);
+    if (it == queries_.end()) {
+      // answered by another server
+      return;
+    }
+    auto& query = it->second;
+    if (R.is_ok() && !is_error_answer(R.ok())) {
+      query.promise.set_value(R.move_as_ok());
+      queries_.erase(it);
+      return;
+    }
+    query.failed++;
+    if (R.is_ok()) {
+      query.error_answer = R.move_as_ok();
+      if (query.resend_at) {
+        query.resend_at = {};
+        auto other_idx = choose_server(query.server_idx);
+        if (other_idx != NO_SERVER && !query.timeout.is_in_past()) {
+          send_to_server(query_id, other_idx, std::move(query.name), std::move(query.data));
+        }
+        query.data = {};
+      }
+    } else {
+      query.error = R.move_as_error();
+    }
+    if (query.failed < query.sent) {
+      return;
+    }
+    if (!query.error_answer.empty()) {
+      query.promise.set_value(std::move(query.error_answer));
+    } else {
+      query.promise.set_error(std::move(query.error));
+    }
+    queries_.erase(it);
+  }
 
-  bool is_closing_{false};
-  td::uint32 ref_cnt_{1};
+  static bool is_error_answer(const td::BufferSlice& data) {
+    return data.size() >= 4 && td::as<td::int32>(data.data()) == ton::lite_api::liteServer_error::ID;
+  }
 
-  void set_server_bad(size_t idx, bool bad) {
-    if (idx == cur_server_idx_ && servers_.size() > 1 && !cur_server_bad_force_) {
-      cur_server_bad_ = bad;
+  void set_server_bad(size_t idx) {
+    if (servers_.size() == 1) {
+      return;
+    }
+    auto& server = servers_[idx];
+    if (server.bad_until && !server.bad_until.is_in_past()) {
+      return;
+    }
+    LOG(INFO) << "Liteserver " << server.addr << " is not responding, switching to another one";
+    server.bad_until = td::Timestamp::in(BAD_SERVER_TIMEOUT);
+    server.latency = 0.0;
+    server.client.reset();
+    if (last_server_idx_ == idx) {
+      last_server_idx_ = NO_SERVER;
     }
   }
+
   void alarm() override {
-    client_.reset();
+    if (idle_at_ && idle_at_.is_in_past()) {
+      for (auto& server : servers_) {
+        server.client.reset();
+      }
+      idle_at_ = {};
+    }
+    alarm_timestamp() = idle_at_;
+    for (auto& it : queries_) {
+      auto& query = it.second;
+      if (!query.resend_at) {
+        continue;
+      }
+      if (!query.resend_at.is_in_past()) {
+        alarm_timestamp().relax(query.resend_at);
+        continue;
+      }
+      query.resend_at = {};
+      auto idx = choose_server(query.server_idx);
+      if (idx != NO_SERVER && !query.timeout.is_in_past()) {
+        send_to_server(it.first, idx, std::move(query.name), std::move(query.data));
+      }
+      query.data = {};
+    }
   }
+
   void hangup_shared() override {
     ref_cnt_--;
     try_stop();
@@ -130,7 +327,9 @@ class ExtClientLazyImp : public ExtClientLazy {
   void hangup() override {
     is_closing_ = true;
     ref_cnt_--;
-    client_.reset();
+    for (auto& server : servers_) {
+      server.client.reset();
+    }
     try_stop();
   }
   void try_stop() {
@@ -147,6 +346,17 @@ td::actor::ActorOwn<ExtClientLazy> ExtClientLazy::create(ton::adnl::AdnlNodeIdFu
 
 td::actor::ActorOwn<ExtClientLazy> ExtClientLazy::create(
     std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers, td::unique_ptr<Callback> callback) {
-  return td::actor::create_actor<ExtClientLazyImp>("ExtClientLazy", std::move(servers), std::move(callback));
+  return create(std::move(servers), std::move(callback),
+                [](ton::adnl::AdnlNodeIdFull dst, td::IPAddress dst_addr,
+                   std::unique_ptr<ton::adnl::AdnlExtClient::Callback> callback) {
+                  return ton::adnl::AdnlExtClient::create(std::move(dst), dst_addr, std::move(callback));
+                });
+}
+
+td::actor::ActorOwn<ExtClientLazy> ExtClientLazy::create(
+    std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers, td::unique_ptr<Callback> callback,
+    ConnectionFactory connection_factory) {
+  return td::actor::create_actor<ExtClientLazyImp>("ExtClientLazy", std::move(servers), std::move(callback),
+                                                   std::move(connection_factory));
 }
 }  // namespace tonlib
@@ -21,6 +21,8 @@
 
 #include "adnl/adnl-ext-client.h"
 
+#include <functional>
+
 namespace tonlib {
 class ExtClientLazy : public ton::adnl::AdnlExtClient {
  public:
@@ -30,12 +32,20 @@ class ExtClientLazy : public ton::adnl::AdnlExtClient {
     }
   };
 
+  // Creates the connection to one liteserver; tests replace it with fake servers
+  using ConnectionFactory = std::function<td::actor::ActorOwn<ton::adnl::AdnlExtClient>(
+      ton::adnl::AdnlNodeIdFull dst, td::IPAddress dst_addr,
+      std::unique_ptr<ton::adnl::AdnlExtClient::Callback> callback)>;
+
   virtual void force_change_liteserver() = 0;
 
   static td::actor::ActorOwn<ExtClientLazy> create(ton::adnl::AdnlNodeIdFull dst, td::IPAddress dst_addr,
                                                    td::unique_ptr<Callback> callback);
   static td::actor::ActorOwn<ExtClientLazy> create(
       std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers, td::unique_ptr<Callback> callback);
+  static td::actor::ActorOwn<ExtClientLazy> create(
+      std::vector<std::pair<ton::adnl::AdnlNodeIdFull, td::IPAddress>> servers, td::unique_ptr<Callback> callback,
+      ConnectionFactory connection_factory);
 };
 
 }  // namespace tonlib
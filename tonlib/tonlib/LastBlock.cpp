@@ -27,8 +27,24 @@
 
 #include "td/utils/JsonBuilder.h"
 
+#include <map>
+#include <mutex>
+
 namespace tonlib {
 
+namespace {
+// Verified last block states, shared by all tonlib clients of the process
+struct SharedLastBlockState {
+  LastBlockState state;
+  td::Timestamp synced_at;
+};
+std::mutex shared_states_mutex;
+std::map<std::string, SharedLastBlockState> shared_states;
+
+// A state synced by another client this recently is returned without querying liteservers
+constexpr double SHARED_STATE_TTL = 1.0;
+}  // namespace
+
 // init_state <-> last_key_block
 // state.valitated_init_state
 // last_key_block ->
@@ -55,6 +71,9 @@ LastBlock::LastBlock(ExtClientRef client, LastBlockState state, Config config, t
     min_seqno_ = td::min(min_seqno_, config_.init_block_id.id.seqno);
   }
   current_seqno_ = min_seqno_;
+  if (config_.zero_state_id.is_valid()) {
+    shared_state_key_ = PSTRING() << config_.zero_state_id.to_str() << " " << config_.init_block_id.to_str();
+  }
   VLOG(last_block) << "State: " << state_;
 }
 
@@ -64,6 +83,12 @@ void LastBlock::get_last_block(td::Promise<LastBlockState> promise) {
     return;
   }
 
+  if (promises_.empty() && use_shared_state()) {
+    VLOG(last_block) << "sync: use shared state " << state_;
+    promise.set_value(LastBlockState{state_});
+    return;
+  }
+
   if (promises_.empty() && get_last_block_state_ == QueryState::Done) {
     VLOG(last_block) << "sync: start";
     VLOG(last_block) << "get_last_block: reset";
@@ -357,8 +382,61 @@ void LastBlock::update_utime(td::int64 utime) {
   }
 }
 
+bool LastBlock::use_shared_state() {
+  if (shared_state_key_.empty() || has_fatal_error() || get_last_block_state_ == QueryState::Active ||
+      check_init_block_state_ == QueryState::Active) {
+    return false;
+  }
+  LastBlockState shared;
+  {
+    std::lock_guard<std::mutex> guard(shared_states_mutex);
+    auto it = shared_states.find(shared_state_key_);
+    if (it == shared_states.end() || it->second.synced_at.at() + SHARED_STATE_TTL < td::Time::now()) {
+      return false;
+    }
+    shared = it->second.state;
+  }
+  if (state_.zero_state_id.is_valid() && !(state_.zero_state_id == shared.zero_state_id)) {
+    return false;
+  }
+  if (state_.last_block_id.is_valid() && state_.last_block_id.id.seqno > shared.last_block_id.id.seqno) {
+    return false;
+  }
+  // The shared state was checked against the same zero state and init block
+  state_.zero_state_id = shared.zero_state_id;
+  bool is_changed = update_mc_last_block(shared.last_block_id);
+  is_changed |= update_mc_last_key_block(shared.last_key_block_id);
+  update_utime(shared.utime);
+  if (check_init_block_state_ != QueryState::Done) {
+    check_init_block_state_ = QueryState::Done;
+    if (config_.init_block_id.is_valid()) {
+      is_changed |= update_init_block(config_.init_block_id);
+    }
+  }
+  current_seqno_ = td::max(current_seqno_, state_.last_block_id.id.seqno);
+  max_seqno_ = td::max(max_seqno_, current_seqno_);
+  if (is_changed) {
+    save_state();
+  }
+  return true;
+}
+
+void LastBlock::publish_shared_state() {
+  if (shared_state_key_.empty() || check_init_block_state_ != QueryState::Done || !state_.last_block_id.is_valid()) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(shared_states_mutex);
+  auto& shared = shared_states[shared_state_key_];
+  if (shared.state.last_block_id.is_valid() && shared.state.last_block_id.id.seqno > state_.last_block_id.id.seqno) {
+    return;
+  }
+  shared.state = state_;
+  shared.synced_at = td::Timestamp::now();
+}
+
 void LastBlock::on_sync_ok() {
   VLOG(last_block) << "sync: ok " << state_;
+  publish_shared_state();
   for (auto& promise : promises_) {
     auto state = state_;
     promise.set_value(std::move(state));
@@ -174,6 +174,8 @@ class LastBlock : public td::actor::Actor {
   td::CancellationToken cancellation_token_;
 
   td::Status fatal_error_;
+  // last block verified by any LastBlock of the process with the same zero state and init block is shared
+  std::string shared_state_key_;
 
   enum class QueryState { Empty, Active, Done };
   QueryState get_mc_info_state_{QueryState::Empty};       // just to check zero state
@@ -232,6 +234,8 @@ class LastBlock : public td::actor::Actor {
   bool update_init_block(ton::BlockIdExt init_block_id);
 
   void save_state();
+  bool use_shared_state();
+  void publish_shared_state();
   void on_sync_ok();
   void on_sync_error(td::Status status);
   void on_fatal_error(td::Status status);
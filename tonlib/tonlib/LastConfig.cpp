@@ -29,8 +29,41 @@
 
 #include "LastBlock.h"
 
+#include <map>
+#include <mutex>
+
 namespace tonlib {
 
+namespace {
+// Verified configs of the latest masterchain blocks, shared by all tonlib clients of the process
+std::mutex shared_configs_mutex;
+std::map<ton::BlockIdExt, LastConfigState> shared_configs;
+constexpr size_t MAX_SHARED_CONFIGS = 8;
+
+td::optional<LastConfigState> get_shared_config(const ton::BlockIdExt& block_id) {
+  std::lock_guard<std::mutex> guard(shared_configs_mutex);
+  auto it = shared_configs.find(block_id);
+  if (it == shared_configs.end()) {
+    return {};
+  }
+  return it->second;
+}
+
+void add_shared_config(const ton::BlockIdExt& block_id, LastConfigState state) {
+  std::lock_guard<std::mutex> guard(shared_configs_mutex);
+  shared_configs[block_id] = std::move(state);
+  while (shared_configs.size() > MAX_SHARED_CONFIGS) {
+    auto oldest = shared_configs.begin();
+    for (auto it = shared_configs.begin(); it != shared_configs.end(); ++it) {
+      if (it->first.id.seqno < oldest->first.id.seqno) {
+        oldest = it;
+      }
+    }
+    shared_configs.erase(oldest);
+  }
+}
+}  // namespace
+
 // init_state <-> last_key_block
 // state.valitated_init_state
 // last_key_block ->
@@ -62,6 +95,14 @@ void LastConfig::with_last_block(td::Result<LastBlockState> r_last_block) {
   }
 
   auto last_block = r_last_block.move_as_ok();
+  auto shared = get_shared_config(last_block.last_block_id);
+  if (shared) {
+    VLOG(last_config) << "use shared config of " << last_block.last_block_id.to_str();
+    state_ = shared.unwrap();
+    on_ok();
+    get_config_state_ = QueryState::Done;
+    return;
+  }
   client_.send_query(ton::lite_api::liteServer_getConfigAll(block::ConfigInfo::needPrevBlocks,
                                                             create_tl_lite_block_id(last_block.last_block_id)),
                      [this](auto r_config) { this->on_config(std::move(r_config)); });
@@ -113,6 +154,7 @@ td::Status LastConfig::process_config_proof(ton::ton_api::object_ptr<ton::lite_a
   }
   TRY_RESULT_ASSIGN(state_.prev_blocks_info, config->get_prev_blocks_info());
   state_.config.reset(config.release());
+  add_shared_config(blkid, state_);
   return td::Status::OK();
 }
 
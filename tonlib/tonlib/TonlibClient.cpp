@@ -60,10 +60,13 @@
 
 #include "td/utils/tests.h"
 #include "td/utils/port/path.h"
+#include "td/utils/crypto.h"
 
 #include "common/util.h"
 #include "td/actor/MultiPromise.h"
 
+#include <mutex>
+
 template <class Type>
 using lite_api_ptr = ton::lite_api::object_ptr<Type>;
 template <class Type>
@@ -191,6 +194,54 @@ struct RawAccountState {
   ton::BlockIdExt block_id;
 };
 
+namespace {
+// Verified account states and shard proofs, shared by all tonlib clients of the process.
+// Entries are keyed by the reference masterchain block, so each of them is the state of the account at that block
+// and never changes. Only the latest masterchain blocks are kept.
+std::mutex verified_states_mutex;
+std::map<std::tuple<ton::BlockIdExt, ton::WorkchainId, ton::StdSmcAddress>, RawAccountState> verified_account_states;
+std::map<std::pair<ton::BlockIdExt, ton::BlockIdExt>, td::Bits256> verified_shard_proofs;
+constexpr size_t MAX_VERIFIED_ACCOUNT_STATES = 4096;
+constexpr size_t MAX_VERIFIED_SHARD_PROOFS = 256;
+
+td::optional<RawAccountState> get_verified_account_state(const ton::BlockIdExt& block_id,
+                                                         const block::StdAddress& address) {
+  std::lock_guard<std::mutex> guard(verified_states_mutex);
+  auto it = verified_account_states.find(std::make_tuple(block_id, address.workchain, address.addr));
+  if (it == verified_account_states.end()) {
+    return {};
+  }
+  return it->second;
+}
+
+void add_verified_account_state(const block::StdAddress& address, const RawAccountState& state) {
+  std::lock_guard<std::mutex> guard(verified_states_mutex);
+  verified_account_states[std::make_tuple(state.block_id, address.workchain, address.addr)] = state;
+  // all reference blocks are masterchain blocks, so the first entries belong to the oldest block
+  while (verified_account_states.size() > MAX_VERIFIED_ACCOUNT_STATES) {
+    verified_account_states.erase(verified_account_states.begin());
+  }
+}
+
+bool is_shard_proof_verified(const block::AccountState& state) {
+  td::Bits256 hash;
+  td::sha256(state.shard_proof.as_slice(), hash.as_slice());
+  std::lock_guard<std::mutex> guard(verified_states_mutex);
+  auto it = verified_shard_proofs.find(std::make_pair(state.blk, state.shard_blk));
+  return it != verified_shard_proofs.end() && it->second == hash;
+}
+
+void add_verified_shard_proof(const block::AccountState& state) {
+  td::Bits256 hash;
+  td::sha256(state.shard_proof.as_slice(), hash.as_slice());
+  std::lock_guard<std::mutex> guard(verified_states_mutex);
+  verified_shard_proofs[std::make_pair(state.blk, state.shard_blk)] = hash;
+  while (verified_shard_proofs.size() > MAX_VERIFIED_SHARD_PROOFS) {
+    verified_shard_proofs.erase(verified_shard_proofs.begin());
+  }
+}
+}  // namespace
+
 tonlib_api::object_ptr<tonlib_api::internal_transactionId> empty_transaction_id() {
   return tonlib_api::make_object<tonlib_api::internal_transactionId>(0, std::string(32, 0));
 }
@@ -773,6 +824,7 @@ class AccountState {
   }
 
   void set_new_state(ton::SmartContract::State state) {
+    get_method_c7_ = {};
     raw_.code = std::move(state.code);
     raw_.data = std::move(state.data);
     raw_.state = ton::GenericAccount::get_init_state(raw_.code, raw_.data);
@@ -786,6 +838,16 @@ class AccountState {
     return raw_.state;
   }
 
+  // c7 depends only on the account state and the config, so get-methods of one smc share it
+  td::Ref<vm::Tuple> get_method_c7(const ton::SmartContract& smc, const ton::SmartContract::Args& args) {
+    auto config = args.config ? args.config.value() : nullptr;
+    if (get_method_c7_.is_null() || get_method_c7_config_ != config) {
+      get_method_c7_ = smc.prepare_c7(args);
+      get_method_c7_config_ = std::move(config);
+    }
+    return get_method_c7_;
+  }
+
  private:
   block::StdAddress address_;
   RawAccountState raw_;
@@ -793,6 +855,8 @@ class AccountState {
   td::int32 wallet_revision_{0};
   td::uint32 wallet_id_{0};
   bool has_new_state_{false};
+  td::Ref<vm::Tuple> get_method_c7_;
+  std::shared_ptr<const block::Config> get_method_c7_config_;
 
   WalletType guess_type() {
     if (raw_.code.is_null()) {
@@ -1352,6 +1416,9 @@ class GetRawAccountState : public td::actor::Actor {
     TRY_RESULT(raw_account_state, std::move(r_raw_account_state));
     TRY_RESULT_PREFIX(state, TRY_VM(do_with_account_state(std::move(raw_account_state))),
                       TonlibError::ValidateAccountState());
+    if (state.block_id.is_valid_full()) {
+      add_verified_account_state(address_, state);
+    }
     promise_.set_value(std::move(state));
     stop();
     return td::Status::OK();
@@ -1360,7 +1427,11 @@ class GetRawAccountState : public td::actor::Actor {
   td::Result<RawAccountState> do_with_account_state(
       ton::tl_object_ptr<ton::lite_api::liteServer_accountState> raw_account_state) {
     auto account_state = create_account_state(std::move(raw_account_state));
+    account_state.shard_proof_checked = is_shard_proof_verified(account_state);
     TRY_RESULT(info, account_state.validate(block_id_.value(), address_));
+    if (!account_state.shard_proof_checked) {
+      add_verified_shard_proof(account_state);
+    }
     auto serialized_state = account_state.state.clone();
     RawAccountState res;
     res.block_id = block_id_.value();
@@ -1452,6 +1523,12 @@ class GetRawAccountState : public td::actor::Actor {
   }
 
   void with_block_id() {
+    auto cached = get_verified_account_state(block_id_.value(), address_);
+    if (cached) {
+      promise_.set_value(cached.unwrap());
+      stop();
+      return;
+    }
     client_.send_query(
         ton::lite_api::liteServer_getAccountState(
             ton::create_tl_lite_block_id(block_id_.value()),
@@ -4569,6 +4646,8 @@ td::Result<vm::StackEntry> from_tonlib_api(tonlib_api::tvm_StackEntry& entry) {
           }));
 }
 
+constexpr size_t MAX_RESOLVED_LIBRARY_CODES = 4096;
+
 void deep_library_search(std::set<td::Bits256>& set, std::set<vm::Cell::Hash>& visited,
                          vm::Dictionary& libs, td::Ref<vm::Cell> cell, int depth, size_t max_libs = 16) {
   if (depth <= 0 || set.size() >= max_libs || visited.size() >= 256) {
@@ -4803,18 +4882,28 @@ td::Status TonlibClient::do_request(const tonlib_api::smc_runGetMethod& request,
   args.set_now(it->second->get_sync_time());
   args.set_address(it->second->get_address());
 
-  client_.with_last_config([self = this, smc = std::move(smc), args = std::move(args), promise = std::move(promise)
-  ](td::Result<LastConfigState> r_state) mutable {
+  client_.with_last_config([self = this, id = request.id_, smc = std::move(smc), args = std::move(args),
+                            promise = std::move(promise)](td::Result<LastConfigState> r_state) mutable {
     TRY_RESULT_PROMISE(promise, state, std::move(r_state));
     args.set_config(state.config);
     args.set_prev_blocks_info(state.prev_blocks_info);
+    auto it = self->smcs_.find(id);
+    if (it != self->smcs_.end()) {
+      args.set_c7(it->second->get_method_c7(*smc, args));
+    }
 
     auto code = smc->get_state().code;
-    if (code.not_null()) {
+    if (code.not_null() && !self->resolved_library_codes_.count(code->get_hash().bits())) {
       std::set<td::Bits256> librarySet;
       std::set<vm::Cell::Hash> visited;
       deep_library_search(librarySet, visited, self->libraries, code, 24);
       std::vector<td::Bits256> libraryList{librarySet.begin(), librarySet.end()};
+      if (libraryList.empty()) {
+        if (self->resolved_library_codes_.size() >= MAX_RESOLVED_LIBRARY_CODES) {
+          self->resolved_library_codes_.clear();
+        }
+        self->resolved_library_codes_.insert(code->get_hash().bits());
+      }
       if (libraryList.size() > 0) {
         LOG(DEBUG) << "Requesting found libraries in code (" << libraryList.size() << ")";
         self->client_.send_query(
@@ -35,6 +35,7 @@
 #include "smc-envelope/ManualDns.h"
 
 #include <map>
+#include <set>
 
 namespace tonlib {
 namespace int_api {
@@ -111,6 +112,8 @@ class TonlibClient : public td::actor::Actor {
   };
   QueryContext query_context_;
   vm::Dictionary libraries{256};
+  // hashes of contract codes, all libraries of which are already in libraries
+  std::set<td::Bits256> resolved_library_codes_;
 
   // network
   td::actor::ActorOwn<ExtClientLazy> raw_client_;
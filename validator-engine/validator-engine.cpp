@@ -39,6 +39,7 @@
 #include "common/errorlog.h"
 
 #include "crypto/vm/vm.h"
+#include "crypto/vm/cells/MerkleUpdate.h"
 #include "crypto/fift/utils.h"
 
 #include "td/utils/filesystem.h"
@@ -1486,6 +1487,8 @@ td::Status ValidatorEngine::load_global_config() {
     }
   }
   validator_options_.write().set_fast_state_serializer_enabled(fast_state_serializer_enabled_);
+  validator_options_.write().set_transaction_index_enabled(transaction_index_enabled_);
+  validator_options_.write().set_liteserver_io_schedulers(liteserver_io_schedulers_);
 
   return td::Status::OK();
 }
@@ -1786,6 +1789,7 @@ void ValidatorEngine::start() {
 }
 
 void ValidatorEngine::start_adnl() {
+  td::actor::SchedulerHintGuard hint(network_scheduler_);
   adnl_network_manager_ = ton::adnl::AdnlNetworkManager::create(config_.out_port);
   adnl_ = ton::adnl::Adnl::create(db_root_, keyring_.get());
   td::actor::send_closure(adnl_, &ton::adnl::Adnl::register_network_manager, adnl_network_manager_.get());
@@ -1846,6 +1850,7 @@ void ValidatorEngine::started_adnl() {
 }
 
 void ValidatorEngine::add_dht(ton::PublicKeyHash id) {
+  td::actor::SchedulerHintGuard hint(network_scheduler_);
   auto D = ton::dht::Dht::create(ton::adnl::AdnlNodeIdShort{id}, db_root_, dht_config_, keyring_.get(), adnl_.get());
   D.ensure();
 
@@ -1874,6 +1879,7 @@ void ValidatorEngine::started_dht() {
 }
 
 void ValidatorEngine::start_rldp() {
+  td::actor::SchedulerHintGuard hint(network_scheduler_);
   rldp_ = ton::rldp::Rldp::create(adnl_.get());
   rldp2_ = ton::rldp2::Rldp::create(adnl_.get());
   started_rldp();
@@ -1885,6 +1891,7 @@ void ValidatorEngine::started_rldp() {
 
 void ValidatorEngine::start_overlays() {
   if (!default_dht_node_.is_zero()) {
+    td::actor::SchedulerHintGuard hint(network_scheduler_);
     overlay_manager_ =
         ton::overlay::Overlays::create(db_root_, keyring_.get(), adnl_.get(), dht_nodes_[default_dht_node_].get());
   }
@@ -1900,8 +1907,12 @@ void ValidatorEngine::start_validator() {
   validator_options_.write().set_state_serializer_enabled(config_.state_serializer_enabled);
   load_collator_options();
 
-  validator_manager_ = ton::validator::ValidatorManagerFactory::create(
-      validator_options_, db_root_, keyring_.get(), adnl_.get(), rldp_.get(), overlay_manager_.get());
+  {
+    // Validator groups, collators and validate queries are created by the manager and stay on its scheduler
+    td::actor::SchedulerHintGuard hint(validator_scheduler_);
+    validator_manager_ = ton::validator::ValidatorManagerFactory::create(
+        validator_options_, db_root_, keyring_.get(), adnl_.get(), rldp_.get(), overlay_manager_.get());
+  }
 
   for (auto &v : config_.validators) {
     td::actor::send_closure(validator_manager_, &ton::validator::ValidatorManagerInterface::add_permanent_key, v.first,
@@ -1922,6 +1933,7 @@ void ValidatorEngine::started_validator() {
 
 void ValidatorEngine::start_full_node() {
   if (!config_.full_node.is_zero() || config_.full_node_slaves.size() > 0) {
+    td::actor::SchedulerHintGuard hint(network_scheduler_);
     auto pk = ton::PrivateKey{ton::privkeys::Ed25519::random()};
     auto short_id = pk.compute_short_id();
     td::actor::send_closure(keyring_, &ton::keyring::Keyring::add_key, std::move(pk), true, [](td::Unit) {});
@@ -2048,9 +2060,63 @@ void ValidatorEngine::start_full_node_masters() {
 }
 
 void ValidatorEngine::started_full_node_masters() {
+  start_metrics_server();
   started();
 }
 
+void ValidatorEngine::start_metrics_server() {
+  if (metrics_port_ == 0) {
+    return;
+  }
+  class Cb : public ton::http::HttpServer::Callback {
+   public:
+    explicit Cb(td::actor::ActorId<ValidatorEngine> id) : id_(id) {
+    }
+    void receive_request(
+        std::unique_ptr<ton::http::HttpRequest> request, std::shared_ptr<ton::http::HttpPayload> payload,
+        td::Promise<std::pair<std::unique_ptr<ton::http::HttpResponse>, std::shared_ptr<ton::http::HttpPayload>>>
+            promise) override {
+      td::actor::send_closure(id_, &ValidatorEngine::process_metrics_request, std::move(request), std::move(promise));
+    }
+
+   private:
+    td::actor::ActorId<ValidatorEngine> id_;
+  };
+  // Metrics are not authenticated, so they are served only on the loopback interface
+  metrics_server_ = ton::http::HttpServer::create(metrics_port_, std::make_shared<Cb>(actor_id(this)), "127.0.0.1");
+}
+
+void ValidatorEngine::process_metrics_request(
+    std::unique_ptr<ton::http::HttpRequest> request,
+    td::Promise<std::pair<std::unique_ptr<ton::http::HttpResponse>, std::shared_ptr<ton::http::HttpPayload>>>
+        promise) {
+  if (request->method() != "GET") {
+    ton::http::answer_error(ton::http::status_method_not_allowed, "", std::move(promise));
+    return;
+  }
+  if (request->url() != "/metrics") {
+    ton::http::answer_error(ton::http::status_not_found, "", std::move(promise));
+    return;
+  }
+  auto P = td::PromiseCreator::lambda([promise = std::move(promise)](td::Result<std::string> R) mutable {
+    if (R.is_error()) {
+      ton::http::answer_error(ton::http::status_internal_server_error, "", std::move(promise));
+      return;
+    }
+    auto data = R.move_as_ok();
+    auto response = ton::http::HttpResponse::create("HTTP/1.0", 200, "OK", false, false).move_as_ok();
+    response->add_header(ton::http::HttpHeader{"Content-Type", "text/plain; version=0.0.4"});
+    response->add_header(ton::http::HttpHeader{"Content-Length", PSTRING() << data.size()});
+    response->complete_parse_header();
+    auto payload = response->create_empty_payload().move_as_ok();
+    payload->add_chunk(td::BufferSlice(data));
+    payload->complete_parse();
+    promise.set_value(std::make_pair(std::move(response), std::move(payload)));
+  });
+  td::actor::send_closure(validator_manager_, &ton::validator::ValidatorManagerInterface::prepare_actor_stats_prometheus,
+                          std::move(P));
+}
+
 void ValidatorEngine::started() {
   started_ = true;
 }
@@ -4235,6 +4301,23 @@ int main(int argc, char *argv[]) {
         threads = v;
         return td::Status::OK();
       });
+  p.add_checked_option('\0', "metrics-port",
+                       "serve actor statistics in Prometheus text format on 127.0.0.1:<port>/metrics",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT(port, td::to_integer_safe<td::uint16>(arg));
+                         if (port == 0) {
+                           return td::Status::Error("metrics-port should be positive");
+                         }
+                         acts.push_back([&x, port]() {
+                           td::actor::send_closure(x, &ValidatorEngine::set_metrics_port, port);
+                         });
+                         return td::Status::OK();
+                       });
+  bool numa = false;
+  p.add_option('\0', "numa",
+               "run one scheduler per NUMA node with threads pinned to its cpus; network actors (ADNL, DHT, RLDP, "
+               "overlays, full node) are placed on the first node, validator manager on the last one",
+               [&]() { numa = true; });
   p.add_checked_option('u', "user", "change user", [&](td::Slice user) { return td::change_user(user.str()); });
   p.add_checked_option('\0', "shutdown-at", "stop validator at the given time (unix timestamp)", [&](td::Slice arg) {
     TRY_RESULT(at, td::to_integer_safe<td::uint32>(arg));
@@ -4271,6 +4354,20 @@ int main(int argc, char *argv[]) {
   p.add_option('\0', "enable-precompiled-smc",
                "enable exectuion of precompiled contracts (experimental, disabled by default)",
                []() { block::precompiled::set_precompiled_execution_enabled(true); });
+  p.add_option('\0', "cell-arena",
+               "allocate cells of get-method runs from arenas (experimental, disabled by default)",
+               []() { vm::CellArena::set_enabled(true); });
+  p.add_checked_option('\0', "merkle-update-threads",
+                       "number of additional threads used to apply and validate Merkle updates of shard states "
+                       "(default: 0)",
+                       [&](td::Slice s) -> td::Status {
+                         TRY_RESULT(v, td::to_integer_safe<td::uint32>(s));
+                         if (v > 256) {
+                           return td::Status::Error("merkle-update-threads should be at most 256");
+                         }
+                         vm::MerkleUpdate::set_extra_threads(v);
+                         return td::Status::OK();
+                       });
   p.add_option('\0', "disable-rocksdb-stats", "disable gathering rocksdb statistics (enabled by default)", [&]() {
     acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_disable_rocksdb_stats, true); });
   });
@@ -4331,6 +4428,25 @@ int main(int argc, char *argv[]) {
         acts.push_back(
             [&x]() { td::actor::send_closure(x, &ValidatorEngine::set_fast_state_serializer_enabled, true); });
       });
+  p.add_option('\0', "transaction-index",
+               "maintain (account, lt) -> block index of transactions for liteServer.getTransactions, older blocks "
+               "are indexed in background from archive packages",
+               [&]() {
+                 acts.push_back(
+                     [&x]() { td::actor::send_closure(x, &ValidatorEngine::set_transaction_index_enabled, true); });
+               });
+  td::uint32 liteserver_io_threads = 0;
+  p.add_checked_option('\0', "liteserver-io-threads",
+                       "accept and serve liteserver connections on <n> dedicated io threads (default: shared network "
+                       "thread)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT(v, td::to_integer_safe<td::uint32>(arg));
+                         if (v > 64) {
+                           return td::Status::Error("liteserver-io-threads should be at most 64");
+                         }
+                         liteserver_io_threads = v;
+                         return td::Status::OK();
+                       });
   auto S = p.run(argc, argv);
   if (S.is_error()) {
     LOG(ERROR) << "failed to parse options: " << S.move_as_error();
@@ -4341,11 +4457,34 @@ int main(int argc, char *argv[]) {
   td::set_runtime_signal_handler(2, need_scheduler_status).ensure();
 
   td::actor::set_debug(true);
-  td::actor::Scheduler scheduler({threads});
+  std::vector<td::actor::Scheduler::NodeInfo> scheduler_nodes;
+  if (numa) {
+    scheduler_nodes = td::actor::Scheduler::numa_nodes(threads);
+    LOG(INFO) << "Using " << scheduler_nodes.size() << " NUMA nodes";
+  } else {
+    scheduler_nodes.emplace_back(threads);
+  }
+  size_t main_schedulers = scheduler_nodes.size();
+  // Schedulers without cpu threads: all their actors run on their io thread
+  for (td::uint32 i = 0; i < liteserver_io_threads; i++) {
+    scheduler_nodes.emplace_back(0);
+  }
+  td::actor::Scheduler scheduler(scheduler_nodes);
 
   scheduler.run_in_context([&] {
     vm::init_vm().ensure();
     x = td::actor::create_actor<ValidatorEngine>("validator-engine");
+    if (main_schedulers > 1) {
+      td::actor::send_closure(x, &ValidatorEngine::set_schedulers, td::actor::SchedulerId{0},
+                              td::actor::SchedulerId{static_cast<td::uint8>(main_schedulers - 1)});
+    }
+    if (liteserver_io_threads > 0) {
+      std::vector<td::actor::SchedulerId> io_schedulers;
+      for (size_t i = main_schedulers; i < scheduler_nodes.size(); i++) {
+        io_schedulers.push_back(td::actor::SchedulerId{static_cast<td::uint8>(i)});
+      }
+      td::actor::send_closure(x, &ValidatorEngine::set_liteserver_io_schedulers, std::move(io_schedulers));
+    }
     for (auto &act : acts) {
       act();
     }
@@ -37,6 +37,7 @@
 #include "validator/full-node.h"
 #include "validator/full-node-master.h"
 #include "adnl/adnl-ext-client.h"
+#include "http/http-server.h"
 
 #include "td/actor/MultiPromise.h"
 
@@ -150,6 +151,7 @@ class ValidatorEngine : public td::actor::Actor {
   td::actor::ActorOwn<ton::validator::fullnode::FullNode> full_node_;
   std::map<td::uint16, td::actor::ActorOwn<ton::validator::fullnode::FullNodeMaster>> full_node_masters_;
   td::actor::ActorOwn<ton::adnl::AdnlExtServer> control_ext_server_;
+  td::actor::ActorOwn<ton::http::HttpServer> metrics_server_;
 
   std::string local_config_ = "";
   std::string global_config_ = "ton-global.config";
@@ -222,6 +224,10 @@ class ValidatorEngine : public td::actor::Actor {
   ton::BlockSeqno truncate_seqno_{0};
   std::string session_logs_file_;
   bool fast_state_serializer_enabled_ = false;
+  bool transaction_index_enabled_ = false;
+  std::vector<td::actor::SchedulerId> liteserver_io_schedulers_;
+  td::actor::SchedulerId network_scheduler_, validator_scheduler_;
+  td::uint16 metrics_port_ = 0;
 
   std::set<ton::CatchainSeqno> unsafe_catchains_;
   std::map<ton::BlockSeqno, std::pair<ton::CatchainSeqno, td::uint32>> unsafe_catchain_rotations_;
@@ -310,6 +316,19 @@ class ValidatorEngine : public td::actor::Actor {
   void set_fast_state_serializer_enabled(bool value) {
     fast_state_serializer_enabled_ = value;
   }
+  void set_transaction_index_enabled(bool value) {
+    transaction_index_enabled_ = value;
+  }
+  void set_liteserver_io_schedulers(std::vector<td::actor::SchedulerId> schedulers) {
+    liteserver_io_schedulers_ = std::move(schedulers);
+  }
+  void set_metrics_port(td::uint16 port) {
+    metrics_port_ = port;
+  }
+  void set_schedulers(td::actor::SchedulerId network_scheduler, td::actor::SchedulerId validator_scheduler) {
+    network_scheduler_ = network_scheduler;
+    validator_scheduler_ = validator_scheduler;
+  }
   void start_up() override;
   ValidatorEngine() {
   }
@@ -355,6 +374,12 @@ class ValidatorEngine : public td::actor::Actor {
   void start_full_node_masters();
   void started_full_node_masters();
 
+  void start_metrics_server();
+  void process_metrics_request(
+      std::unique_ptr<ton::http::HttpRequest> request,
+      td::Promise<std::pair<std::unique_ptr<ton::http::HttpResponse>, std::shared_ptr<ton::http::HttpPayload>>>
+          promise);
+
   void started();
 
   void alarm() override;
@@ -0,0 +1,144 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "validator-session-block-states.h"
+#include "validator-session-types.h"
+
+#include "auto/tl/ton_api.hpp"
+#include "tl-utils/tl-utils.hpp"
+
+namespace ton {
+
+namespace validatorsession {
+
+const ValidatorSessionState *ValidatorSessionBlockStates::compute(catchain::CatChainBlock *block, bool replay) {
+  auto prev = block->prev();
+  const ValidatorSessionState *state;
+  if (prev) {
+    state = get(prev);
+  } else {
+    state = ValidatorSessionState::create(description_);
+  }
+  auto deps = block->deps();
+  for (auto b : deps) {
+    state = ValidatorSessionState::merge(description_, state, get(b));
+  }
+
+  if (block->payload().size() != 0 || deps.size() != 0) {
+    auto R = fetch_tl_object<ton_api::validatorSession_blockUpdate>(block->payload().clone(), true);
+    if (!R.is_error()) {
+      auto B = R.move_as_ok();
+      auto att = description_.get_attempt_seqno(B->ts_);
+      for (auto &msg : B->actions_) {
+        if (!replay) {
+          VLOG(VALIDATOR_SESSION_INFO) << log_prefix_ << "[node " << description_.get_source_id(block->source())
+                                       << "][block " << block->hash() << "]: applying action " << msg.get();
+          if (on_action_) {
+            on_action_(block->source(), *msg);
+          }
+        }
+        state = ValidatorSessionState::action(description_, state, block->source(), att, msg.get());
+      }
+      state = ValidatorSessionState::make_all(description_, state, block->source(), att);
+      if (!replay && state->get_hash(description_) != static_cast<td::uint32>(B->state_)) {
+        VLOG(VALIDATOR_SESSION_WARNING) << log_prefix_ << "[node " << description_.get_source_id(block->source())
+                                        << "][block " << block->hash()
+                                        << "]: state hash mismatch: computed=" << state->get_hash(description_)
+                                        << " received=" << B->state_;
+        for (auto &msg : B->actions_) {
+          VLOG(VALIDATOR_SESSION_WARNING) << log_prefix_ << "[node " << description_.get_source_id(block->source())
+                                          << "][block " << block->hash() << "]: applied action " << msg.get();
+        }
+      }
+    } else {
+      if (!replay) {
+        VLOG(VALIDATOR_SESSION_WARNING) << log_prefix_ << "[node " << description_.get_source_id(block->source())
+                                        << "][block " << block->hash() << "]: failed to parse: " << R.move_as_error();
+      }
+      state = ValidatorSessionState::make_all(description_, state, block->source(), state->get_ts(block->source()));
+    }
+  }
+  return state;
+}
+
+const ValidatorSessionState *ValidatorSessionBlockStates::set(catchain::CatChainBlock *block,
+                                                             const ValidatorSessionState *state) {
+  state = ValidatorSessionState::move_to_persistent(description_, state);
+  block->set_extra(std::make_unique<BlockExtra>(state));
+  blocks_.push_back(block);
+  return state;
+}
+
+const ValidatorSessionState *ValidatorSessionBlockStates::get(catchain::CatChainBlock *block) {
+  if (!block->extra()) {
+    // The state was dropped by compaction. Honest nodes reference only recent blocks, so this is rare, but the state
+    // may depend on a long chain of dropped states; they are recomputed without recursion.
+    std::vector<catchain::CatChainBlock *> stack{block};
+    while (!stack.empty()) {
+      auto b = stack.back();
+      if (b->extra()) {
+        stack.pop_back();
+        continue;
+      }
+      bool ready = true;
+      if (b->prev() && !b->prev()->extra()) {
+        stack.push_back(b->prev());
+        ready = false;
+      }
+      for (auto dep : b->deps()) {
+        if (!dep->extra()) {
+          stack.push_back(dep);
+          ready = false;
+        }
+      }
+      if (ready) {
+        stack.pop_back();
+        set(b, compute(b, true));
+      }
+    }
+  }
+  auto e = dynamic_cast<const BlockExtra *>(block->extra());
+  CHECK(e != nullptr);
+  return e->get_ref();
+}
+
+void ValidatorSessionBlockStates::compact(catchain::CatChainBlockHeight keep_blocks,
+                                          std::vector<const ValidatorSessionState **> live_states) {
+  std::vector<catchain::CatChainBlockHeight> max_height(description_.get_total_nodes(), 0);
+  for (auto b : blocks_) {
+    max_height[b->source()] = std::max(max_height[b->source()], b->height());
+  }
+  description_.start_compaction();
+  std::vector<catchain::CatChainBlock *> blocks;
+  for (auto b : blocks_) {
+    if (b->height() + keep_blocks > max_height[b->source()]) {
+      auto state = ValidatorSessionState::move_to_persistent(description_, get(b));
+      b->set_extra(std::make_unique<BlockExtra>(state));
+      blocks.push_back(b);
+    } else {
+      b->set_extra(nullptr);
+    }
+  }
+  for (auto state : live_states) {
+    *state = ValidatorSessionState::move_to_persistent(description_, *state);
+  }
+  description_.finish_compaction();
+  blocks_ = std::move(blocks);
+}
+
+}  // namespace validatorsession
+
+}  // namespace ton
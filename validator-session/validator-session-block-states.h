@@ -0,0 +1,77 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "validator-session-state.h"
+
+#include "catchain/catchain.h"
+
+#include <functional>
+
+namespace ton {
+
+namespace validatorsession {
+
+// States of catchain blocks, stored in CatChainBlock::Extra. compact() drops the states of old blocks and moves the
+// rest to a new arena; a dropped state is recomputed from the block payload if the block is referenced again.
+class ValidatorSessionBlockStates {
+ public:
+  // Called for every action of a block when the block is processed for the first time, but not on replay
+  using ActionCallback = std::function<void(td::uint32 src_idx, ton_api::validatorSession_round_Message &action)>;
+
+  ValidatorSessionBlockStates(ValidatorSessionDescription &description, std::string log_prefix,
+                              ActionCallback on_action)
+      : description_(description), log_prefix_(std::move(log_prefix)), on_action_(std::move(on_action)) {
+  }
+
+  // Merges the states of prev and deps and applies the actions of the block
+  const ValidatorSessionState *compute(catchain::CatChainBlock *block, bool replay);
+  // Moves the state to the persistent arena and attaches it to the block
+  const ValidatorSessionState *set(catchain::CatChainBlock *block, const ValidatorSessionState *state);
+  const ValidatorSessionState *get(catchain::CatChainBlock *block);
+
+  // Keeps the states of the last keep_blocks blocks of each source, drops the others. live_states are moved to the
+  // new arena too, no other pointers to persistent objects stay valid.
+  void compact(catchain::CatChainBlockHeight keep_blocks, std::vector<const ValidatorSessionState **> live_states);
+
+  size_t size() const {
+    return blocks_.size();
+  }
+
+ private:
+  class BlockExtra : public catchain::CatChainBlock::Extra {
+   public:
+    const ValidatorSessionState *get_ref() const {
+      return state_;
+    }
+    BlockExtra(const ValidatorSessionState *state) : state_(std::move(state)) {
+    }
+
+   private:
+    const ValidatorSessionState *state_;
+  };
+
+  ValidatorSessionDescription &description_;
+  std::string log_prefix_;
+  ActionCallback on_action_;
+  // blocks with the state stored in BlockExtra
+  std::vector<catchain::CatChainBlock *> blocks_;
+};
+
+}  // namespace validatorsession
+
+}  // namespace ton
@@ -167,6 +167,14 @@ bool ValidatorSessionDescriptionImpl::is_persistent(const void *ptr) const {
   return mem_perm_.contains(ptr);
 }
 
+void ValidatorSessionDescriptionImpl::start_compaction() {
+  CHECK(mem_old_perm_.allocated_size() == 0);
+  mem_perm_.swap(mem_old_perm_);
+  for (auto &c : cache_) {
+    c.store(Cached{nullptr}, std::memory_order_relaxed);
+  }
+}
+
 std::unique_ptr<ValidatorSessionDescription> ValidatorSessionDescription::create(
     ValidatorSessionOptions opts, std::vector<ValidatorSessionNode> &nodes, PublicKeyHash local_id) {
   return std::make_unique<ValidatorSessionDescriptionImpl>(std::move(opts), nodes, local_id);
@@ -212,6 +220,20 @@ void ValidatorSessionDescriptionImpl::MemPool::clear() {
   ptr_ = 0;
 }
 
+void ValidatorSessionDescriptionImpl::MemPool::release() {
+  for (auto &v : data_) {
+    delete[] v;
+  }
+  data_.clear();
+  ptr_ = 0;
+}
+
+void ValidatorSessionDescriptionImpl::MemPool::swap(MemPool &other) {
+  CHECK(chunk_size_ == other.chunk_size_);
+  std::swap(data_, other.data_);
+  std::swap(ptr_, other.ptr_);
+}
+
 bool ValidatorSessionDescriptionImpl::MemPool::contains(const void* ptr) const {
   if (ptr == nullptr) {
     return true;
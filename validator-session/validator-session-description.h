@@ -72,6 +72,11 @@ class ValidatorSessionDescription {
     return is_persistent(static_cast<const void *>(ptr));
   }
   virtual void clear_temp_memory() = 0;
+  // Compaction: after start_compaction() all persistent objects are considered temporary, so move_to_persistent()
+  // copies live ones to a new arena. finish_compaction() frees the old arena, no pointers to it may be left.
+  virtual void start_compaction() = 0;
+  virtual void finish_compaction() = 0;
+  virtual size_t get_persistent_memory_size() const = 0;
 
   virtual ~ValidatorSessionDescription() = default;
 
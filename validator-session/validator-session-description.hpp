@@ -65,7 +65,12 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
     ~MemPool();
     void *alloc(size_t size, size_t align);
     void clear();
+    void release();
+    void swap(MemPool &other);
     bool contains(const void* ptr) const;
+    size_t allocated_size() const {
+      return data_.size() * chunk_size_;
+    }
 
    private:
     size_t chunk_size_;
@@ -76,6 +81,7 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
  private:
   MemPool mem_perm_ = MemPool(mem_chunk_size_perm);
   MemPool mem_temp_ = MemPool(mem_chunk_size_temp);
+  MemPool mem_old_perm_ = MemPool(mem_chunk_size_perm);
 
   std::atomic<td::uint64> reuse_{0};
 
@@ -133,6 +139,13 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
     mem_temp_.clear();
   }
   bool is_persistent(const void *ptr) const override;
+  void start_compaction() override;
+  void finish_compaction() override {
+    mem_old_perm_.release();
+  }
+  size_t get_persistent_memory_size() const override {
+    return mem_perm_.allocated_size();
+  }
   HashType compute_hash(td::Slice data) const override;
   td::Timestamp attempt_start_at(td::uint32 att) const override {
     return td::Timestamp::at_unix(att * opts_.round_attempt_duration);
@@ -49,7 +49,7 @@ struct SessionBlockCandidateSignature : public ValidatorSessionDescription::Root
       return false;
     }
     auto R = static_cast<const SessionBlockCandidateSignature*>(r);
-    return R->hash_ == hash && R->data_.ubegin() == data.ubegin() && R->data_.size() == data.size();
+    return R->hash_ == hash && R->data_ == data;
   }
 
   static auto lookup(ValidatorSessionDescription& desc, td::Slice data, HashType hash, bool temp) {
@@ -72,12 +72,19 @@ struct SessionBlockCandidateSignature : public ValidatorSessionDescription::Root
     if (desc.is_persistent(b)) {
       return b;
     }
-    CHECK(desc.is_persistent(b->data_.ubegin()));
     auto r = lookup(desc, b->data_, b->hash_, false);
     if (r) {
       return r;
     }
-    return new (desc, false) SessionBlockCandidateSignature{desc, b->data_, b->hash_};
+    td::Slice data = b->data_;
+    if (!desc.is_persistent(data.ubegin())) {
+      // signature data was left in the old persistent arena by compaction
+      auto d = static_cast<td::uint8*>(desc.alloc(data.size(), 8, false));
+      td::MutableSlice s{d, data.size()};
+      s.copy_from(data);
+      data = s;
+    }
+    return new (desc, false) SessionBlockCandidateSignature{desc, data, b->hash_};
   }
   static const SessionBlockCandidateSignature* merge(ValidatorSessionDescription& desc,
                                                      const SessionBlockCandidateSignature* l,
@@ -150,6 +150,9 @@ struct ValidatorSessionStats {
   ValidatorWeight signatures_weight = 0;
   td::uint32 approve_signatures = 0;
   ValidatorWeight approve_signatures_weight = 0;
+
+  td::uint64 persistent_memory_size = 0;
+  td::uint32 state_compactions = 0;
 };
 
 struct NewValidatorGroupStats {
@@ -33,9 +33,7 @@ void ValidatorSessionImpl::process_blocks(std::vector<catchain::CatChainBlock *>
   requested_new_block_now_ = false;
 
   for (auto block : blocks) {
-    auto e = dynamic_cast<const BlockExtra *>(block->extra());
-    CHECK(e != nullptr);
-    real_state_ = ValidatorSessionState::merge(description(), real_state_, e->get_ref());
+    real_state_ = ValidatorSessionState::merge(description(), real_state_, block_states_->get(block));
   }
 
   if (real_state_->cur_round_seqno() != cur_round_) {
@@ -131,6 +129,7 @@ void ValidatorSessionImpl::process_blocks(std::vector<catchain::CatChainBlock *>
   virtual_state_ = ValidatorSessionState::merge(description(), virtual_state_, real_state_);
   virtual_state_ = ValidatorSessionState::move_to_persistent(description(), virtual_state_);
   description().clear_temp_memory();
+  maybe_compact_state();
 }
 
 void ValidatorSessionImpl::finished_processing() {
@@ -146,53 +145,9 @@ void ValidatorSessionImpl::preprocess_block(catchain::CatChainBlock *block) {
   td::PerfWarningTimer p_timer{"Loong block preprocess", 0.1};
   td::PerfWarningTimer q_timer{"Looong block preprocess", 0.1};
 
-  auto prev = block->prev();
-  const ValidatorSessionState *state;
-  if (prev) {
-    auto e = dynamic_cast<const BlockExtra *>(prev->extra());
-    CHECK(e != nullptr);
-    state = e->get_ref();
-  } else {
-    state = ValidatorSessionState::create(description());
-  }
-  auto deps = block->deps();
-  for (auto b : deps) {
-    auto e = dynamic_cast<const BlockExtra *>(b->extra());
-    CHECK(e != nullptr);
-    state = ValidatorSessionState::merge(description(), state, e->get_ref());
-  }
-
-  if (block->payload().size() != 0 || deps.size() != 0) {
-    auto R = fetch_tl_object<ton_api::validatorSession_blockUpdate>(block->payload().clone(), true);
-    if (!R.is_error()) {
-      auto B = R.move_as_ok();
-      auto att = description().get_attempt_seqno(B->ts_);
-      for (auto &msg : B->actions_) {
-        VLOG(VALIDATOR_SESSION_INFO) << this << "[node " << description().get_source_id(block->source()) << "][block "
-                                     << block->hash() << "]: applying action " << msg.get();
-        stats_process_action(block->source(), *msg);
-        state = ValidatorSessionState::action(description(), state, block->source(), att, msg.get());
-      }
-      state = ValidatorSessionState::make_all(description(), state, block->source(), att);
-      if (state->get_hash(description()) != static_cast<td::uint32>(B->state_)) {
-        VLOG(VALIDATOR_SESSION_WARNING) << this << "[node " << description().get_source_id(block->source())
-                                        << "][block " << block->hash()
-                                        << "]: state hash mismatch: computed=" << state->get_hash(description())
-                                        << " received=" << B->state_;
-        for (auto &msg : B->actions_) {
-          VLOG(VALIDATOR_SESSION_WARNING) << this << "[node " << description().get_source_id(block->source())
-                                          << "][block " << block->hash() << "]: applied action " << msg.get();
-        }
-      }
-    } else {
-      VLOG(VALIDATOR_SESSION_WARNING) << this << "[node " << description().get_source_id(block->source()) << "][block "
-                                      << block->hash() << "]: failed to parse: " << R.move_as_error();
-      state = ValidatorSessionState::make_all(description(), state, block->source(), state->get_ts(block->source()));
-    }
-  }
+  auto state = block_states_->compute(block, false);
   q_timer.reset();
-  state = ValidatorSessionState::move_to_persistent(description(), state);
-  block->set_extra(std::make_unique<BlockExtra>(state));
+  state = block_states_->set(block, state);
   if (block->source() == local_idx() && !catchain_started_) {
     real_state_ = state;
   }
@@ -208,6 +163,23 @@ void ValidatorSessionImpl::preprocess_block(catchain::CatChainBlock *block) {
                                 << "ms: state=" << state->get_hash(description());
 }
 
+void ValidatorSessionImpl::maybe_compact_state() {
+  auto size = description().get_persistent_memory_size();
+  if (size < COMPACTION_MIN_MEMORY || size <= memory_after_compaction_) {
+    return;
+  }
+  if (size < 2 * memory_after_compaction_ && cur_round_ < last_compaction_round_ + COMPACTION_ROUNDS) {
+    return;
+  }
+  td::Timer timer;
+  block_states_->compact(COMPACTION_KEEP_BLOCKS, {&real_state_, &virtual_state_});
+  memory_after_compaction_ = description().get_persistent_memory_size();
+  last_compaction_round_ = cur_round_;
+  state_compactions_++;
+  LOG(INFO) << this << ": compacted session state: " << size << " -> " << memory_after_compaction_
+            << " bytes, kept states of " << block_states_->size() << " blocks in " << timer.elapsed() << "s";
+}
+
 bool ValidatorSessionImpl::ensure_candidate_unique(td::uint32 src_idx, td::uint32 round,
                                                   ValidatorSessionCandidateId block_id) {
   auto it = src_round_candidate_[src_idx].find(round);
@@ -899,6 +871,8 @@ void ValidatorSessionImpl::on_new_round(td::uint32 round) {
       cur_stats_.signatures_weight = signatures_weight;
       cur_stats_.approve_signatures = (td::uint32)export_approve_sigs.size();
       cur_stats_.approve_signatures_weight = approve_signatures_weight;
+      cur_stats_.persistent_memory_size = description().get_persistent_memory_size();
+      cur_stats_.state_compactions = state_compactions_;
       cur_stats_.creator = description().get_source_id(block->get_src_idx());
       auto stat = stats_get_candidate_stat(cur_round_, cur_stats_.creator);
       if (stat) {
@@ -996,6 +970,11 @@ ValidatorSessionImpl::ValidatorSessionImpl(catchain::CatChainSessionId session_i
     , allow_unsafe_self_blocks_resync_(allow_unsafe_self_blocks_resync) {
   compress_block_candidates_ = opts.proto_version >= 4;
   description_ = ValidatorSessionDescription::create(std::move(opts), nodes, local_id);
+  block_states_ = std::make_unique<ValidatorSessionBlockStates>(
+      description(), PSTRING() << this,
+      [this](td::uint32 src_idx, ton_api::validatorSession_round_Message &action) {
+        stats_process_action(src_idx, action);
+      });
   src_round_candidate_.resize(description_->get_total_nodes());
 }
 
@@ -1024,7 +1003,10 @@ void ValidatorSessionImpl::destroy() {
 }
 
 void ValidatorSessionImpl::get_current_stats(td::Promise<ValidatorSessionStats> promise) {
-  promise.set_result(cur_stats_);
+  auto stats = cur_stats_;
+  stats.persistent_memory_size = description().get_persistent_memory_size();
+  stats.state_compactions = state_compactions_;
+  promise.set_result(std::move(stats));
 }
 
 void ValidatorSessionImpl::get_end_stats(td::Promise<EndValidatorGroupStats> promise) {
@@ -1262,9 +1244,10 @@ td::actor::ActorOwn<ValidatorSession> ValidatorSession::create(
     td::actor::ActorId<keyring::Keyring> keyring, td::actor::ActorId<adnl::Adnl> adnl,
     td::actor::ActorId<rldp::Rldp> rldp, td::actor::ActorId<overlay::Overlays> overlays, std::string db_root,
     std::string db_suffix, bool allow_unsafe_self_blocks_resync) {
-  return td::actor::create_actor<ValidatorSessionImpl>("session", session_id, std::move(opts), local_id,
-                                                       std::move(nodes), std::move(callback), keyring, adnl, rldp,
-                                                       overlays, db_root, db_suffix, allow_unsafe_self_blocks_resync);
+  return td::actor::create_actor<ValidatorSessionImpl>(
+      td::actor::ActorOptions().with_name("session").with_high_priority(), session_id, std::move(opts), local_id,
+      std::move(nodes), std::move(callback), keyring, adnl, rldp, overlays, db_root, db_suffix,
+      allow_unsafe_self_blocks_resync);
 }
 
 td::Bits256 ValidatorSessionOptions::get_hash() const {
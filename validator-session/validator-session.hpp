@@ -25,6 +25,7 @@
 
 #include "validator-session.h"
 #include "validator-session-state.h"
+#include "validator-session-block-states.h"
 
 #include "keys/encryptor.h"
 
@@ -36,23 +37,16 @@ namespace validatorsession {
 
 class ValidatorSessionImpl : public ValidatorSession {
  private:
-  class BlockExtra : public catchain::CatChainBlock::Extra {
-   public:
-    const ValidatorSessionState *get_ref() const {
-      return state_;
-    }
-    BlockExtra(const ValidatorSessionState *state) : state_(std::move(state)) {
-    }
-
-   private:
-    const ValidatorSessionState *state_;
-  };
-
   bool requested_new_block_ = false;
   bool requested_new_block_now_ = false;
   const ValidatorSessionState *real_state_ = nullptr;
   const ValidatorSessionState *virtual_state_ = nullptr;
 
+  std::unique_ptr<ValidatorSessionBlockStates> block_states_;
+  size_t memory_after_compaction_ = 0;
+  td::uint32 last_compaction_round_ = 0;
+  td::uint32 state_compactions_ = 0;
+
   td::uint32 cur_round_ = 0, first_block_round_ = 0;
   td::Timestamp round_started_at_ = td::Timestamp::never();
   td::Timestamp round_debug_at_ = td::Timestamp::never();
@@ -102,6 +96,8 @@ class ValidatorSessionImpl : public ValidatorSession {
   void check_action(td::uint32 att);
   void check_all();
 
+  void maybe_compact_state();
+
   std::unique_ptr<catchain::CatChain::Callback> make_catchain_callback() {
     class cb : public catchain::CatChain::Callback {
      public:
@@ -237,6 +233,9 @@ class ValidatorSessionImpl : public ValidatorSession {
   static const td::int32 MAX_PAST_ROUND_BLOCK = 20;
   constexpr static const double REQUEST_BROADCAST_P2P_DELAY = 2.0;
   static const td::uint32 MAX_CANDIDATE_EXTRA_SIZE = 1024;
+  static const size_t COMPACTION_MIN_MEMORY = (size_t)1 << 28;
+  static const td::uint32 COMPACTION_ROUNDS = 1000;
+  static const catchain::CatChainBlockHeight COMPACTION_KEEP_BLOCKS = 16;
 };
 
 }  // namespace validatorsession
@@ -18,6 +18,7 @@
 */
 #include "archiver.hpp"
 #include "rootdb.hpp"
+#include "txindexdb.hpp"
 #include "ton/ton-tl.hpp"
 
 namespace ton {
@@ -25,8 +26,11 @@ namespace ton {
 namespace validator {
 
 BlockArchiver::BlockArchiver(BlockHandle handle, td::actor::ActorId<ArchiveManager> archive_db,
-                             td::Promise<td::Unit> promise)
-    : handle_(std::move(handle)), archive_(archive_db), promise_(std::move(promise)) {
+                             td::Promise<td::Unit> promise, td::actor::ActorId<TransactionIndexDb> tx_index_db)
+    : handle_(std::move(handle))
+    , archive_(archive_db)
+    , promise_(std::move(promise))
+    , tx_index_db_(std::move(tx_index_db)) {
 }
 
 void BlockArchiver::start_up() {
@@ -108,6 +112,10 @@ void BlockArchiver::written_proof_link() {
 }
 
 void BlockArchiver::got_block_data(td::BufferSlice data) {
+  if (!tx_index_db_.empty()) {
+    // The data is indexed here, while it is loaded; blocks moved to the archive earlier were indexed at that time
+    td::actor::send_closure(tx_index_db_, &TransactionIndexDb::add_block, handle_, data.clone());
+  }
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::Unit> R) {
     R.ensure();
     td::actor::send_closure(SelfId, &BlockArchiver::written_block_data);
@@ -30,10 +30,12 @@ namespace validator {
 
 class RootDb;
 class FileDb;
+class TransactionIndexDb;
 
 class BlockArchiver : public td::actor::Actor {
  public:
-  BlockArchiver(BlockHandle handle, td::actor::ActorId<ArchiveManager> archive_db, td::Promise<td::Unit> promise);
+  BlockArchiver(BlockHandle handle, td::actor::ActorId<ArchiveManager> archive_db, td::Promise<td::Unit> promise,
+                td::actor::ActorId<TransactionIndexDb> tx_index_db = {});
 
   void abort_query(td::Status error);
 
@@ -51,6 +53,7 @@ class BlockArchiver : public td::actor::Actor {
   BlockHandle handle_;
   td::actor::ActorId<ArchiveManager> archive_;
   td::Promise<td::Unit> promise_;
+  td::actor::ActorId<TransactionIndexDb> tx_index_db_;
 };
 
 }  // namespace validator
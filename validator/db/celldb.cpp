@@ -22,6 +22,7 @@
 #include "rootdb.hpp"
 
 #include "td/db/RocksDb.h"
+#include "td/utils/misc.h"
 #include "rocksdb/utilities/optimistic_transaction_db.h"
 
 #include "ton/ton-tl.hpp"
@@ -68,6 +69,24 @@ void CellDbBase::execute_sync(std::function<void()> f) {
   f();
 }
 
+// Cells are stored under their 32-byte hashes, block entries (with the list head gc starts from) under longer "desc"
+// keys. Each kind gets its own column family, so gc and state writes do not compact the other kind's files.
+static void add_column_families(td::RocksDbOptions& options) {
+  td::RocksDbOptions::ColumnFamily cells;
+  cells.name = "cells";
+  cells.has_key = [](td::Slice key) { return key.size() == 32; };
+  // Storing a state looks up every new cell, most of them are not in the db yet
+  cells.bloom_filter_bits_per_key = 10;
+  // Larger memtables mean fewer flushes and less rewriting of cells by compactions
+  cells.write_buffer_size = 128 << 20;
+  options.column_families.push_back(std::move(cells));
+
+  td::RocksDbOptions::ColumnFamily blocks;
+  blocks.name = "blocks";
+  blocks.has_key = [](td::Slice key) { return key.size() != 32 && td::begins_with(key, "desc"); };
+  options.column_families.push_back(std::move(blocks));
+}
+
 CellDbIn::CellDbIn(td::actor::ActorId<RootDb> root_db, td::actor::ActorId<CellDb> parent, std::string path,
                    td::Ref<ValidatorManagerOptions> opts)
     : root_db_(root_db), parent_(parent), path_(std::move(path)), opts_(opts) {
@@ -101,12 +120,16 @@ void CellDbIn::start_up() {
     LOG(WARNING) << "Set CellDb block cache size to " << td::format::as_size(opts_->get_celldb_cache_size().value());
   }
   db_options.use_direct_reads = opts_->get_celldb_direct_io();
+  // Dbs created before the column families were added keep their cells in the default column family
+  db_options.bloom_filter_bits_per_key = 10;
+  add_column_families(db_options);
 
   if (opts_->get_celldb_in_memory()) {
     td::RocksDbOptions read_db_options;
     read_db_options.use_direct_reads = true;
     read_db_options.no_block_cache = true;
     read_db_options.block_cache = {};
+    add_column_families(read_db_options);
     LOG(WARNING) << "Loading all cells in memory (because of --celldb-in-memory)";
     td::Timer timer;
     auto read_cell_db =
@@ -180,77 +203,117 @@ void CellDbIn::load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promi
 }
 
 void CellDbIn::store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise) {
+  pending_stores_.push_back(
+      PendingStore{block_id, std::move(cell), std::move(promise), td::PerfWarningTimer{"storecell", 0.1}});
+  if (!store_scheduled_) {
+    store_scheduled_ = true;
+    store_pending_cells();
+  }
+}
+
+void CellDbIn::store_pending_cells() {
   if (db_busy_) {
-    action_queue_.push(
-        [self = this, block_id, cell = std::move(cell), promise = std::move(promise)](td::Result<td::Unit> R) mutable {
-          R.ensure();
-          self->store_cell(block_id, std::move(cell), std::move(promise));
-        });
+    action_queue_.push([self = this](td::Result<td::Unit> R) mutable {
+      R.ensure();
+      self->store_pending_cells();
+    });
     return;
   }
-  td::PerfWarningTimer timer{"storecell", 0.1};
-  auto key_hash = get_key_hash(block_id);
-  auto R = get_block(key_hash);
-  // duplicate
-  if (R.is_ok()) {
-    promise.set_result(boc_->load_cell(cell->get_hash().as_slice()));
+  // States that arrived while the previous commit was in progress are committed together, in one write batch
+  std::vector<PendingStore> batch;
+  std::set<KeyHash> keys;
+  while (!pending_stores_.empty() && batch.size() < max_store_batch_size()) {
+    auto store = std::move(pending_stores_.front());
+    pending_stores_.pop_front();
+    auto key_hash = get_key_hash(store.block_id);
+    if (get_block(key_hash).is_ok()) {
+      // duplicate
+      store.promise.set_result(boc_->load_cell(store.cell->get_hash().as_slice()));
+      continue;
+    }
+    if (keys.insert(key_hash).second) {
+      boc_->inc(store.cell);
+    } else {
+      store.duplicate = true;
+    }
+    batch.push_back(std::move(store));
+  }
+  store_scheduled_ = !pending_stores_.empty();
+  if (batch.empty()) {
     return;
   }
 
-  boc_->inc(cell);
   db_busy_ = true;
-  boc_->prepare_commit_async(async_executor, [=, this, SelfId = actor_id(this), timer = std::move(timer),
-                                              timer_prepare = td::Timer{}, promise = std::move(promise),
-                                              cell = std::move(cell)](td::Result<td::Unit> Res) mutable {
+  if (store_scheduled_) {
+    store_pending_cells();  // queued after the current batch
+  }
+  boc_->prepare_commit_async(async_executor, [SelfId = actor_id(this), batch = std::move(batch),
+                                              timer_prepare = td::Timer{}](td::Result<td::Unit> Res) mutable {
     Res.ensure();
     timer_prepare.pause();
-    td::actor::send_lambda(
-        SelfId, [=, this, timer = std::move(timer), promise = std::move(promise), cell = std::move(cell)]() mutable {
-          TD_PERF_COUNTER(celldb_store_cell);
-          auto empty = get_empty_key_hash();
-          auto ER = get_block(empty);
-          ER.ensure();
-          auto E = ER.move_as_ok();
-
-          auto PR = get_block(E.prev);
-          PR.ensure();
-          auto P = PR.move_as_ok();
-          CHECK(P.next == empty);
-
-          DbEntry D{block_id, E.prev, empty, cell->get_hash().bits()};
-
-          E.prev = key_hash;
-          P.next = key_hash;
-
-          if (P.is_empty()) {
-            E.next = key_hash;
-            P.prev = key_hash;
-          }
-          td::Timer timer_write;
-          vm::CellStorer stor{*cell_db_};
-          cell_db_->begin_write_batch().ensure();
-          boc_->commit(stor).ensure();
-          set_block(get_empty_key_hash(), std::move(E));
-          set_block(D.prev, std::move(P));
-          set_block(key_hash, std::move(D));
-          cell_db_->commit_write_batch().ensure();
-          timer_write.pause();
+    td::actor::send_closure(SelfId, &CellDbIn::commit_stored_cells, std::move(batch), timer_prepare.elapsed());
+  });
+}
 
-          if (!opts_->get_celldb_in_memory()) {
-            boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), on_load_callback_)).ensure();
-            td::actor::send_closure(parent_, &CellDb::update_snapshot, cell_db_->snapshot());
-          }
+void CellDbIn::commit_stored_cells(std::vector<PendingStore> batch, double prepare_time) {
+  TD_PERF_COUNTER(celldb_store_cell);
+  auto empty = get_empty_key_hash();
+  auto ER = get_block(empty);
+  ER.ensure();
+  auto E = ER.move_as_ok();
+  // Blocks are appended to the list one after another; each entry is written once its next pointer is known
+  KeyHash last_key = E.prev;
+  std::optional<DbEntry> last;
+  if (last_key != empty) {
+    auto PR = get_block(last_key);
+    PR.ensure();
+    last = PR.move_as_ok();
+    CHECK(last->next == empty);
+  }
+
+  td::Timer timer_write;
+  vm::CellStorer stor{*cell_db_};
+  cell_db_->begin_write_batch().ensure();
+  boc_->commit(stor).ensure();
+  for (auto& store : batch) {
+    if (store.duplicate) {
+      continue;
+    }
+    auto key_hash = get_key_hash(store.block_id);
+    DbEntry D{store.block_id, last_key, empty, store.cell->get_hash().bits()};
+    if (last) {
+      last->next = key_hash;
+      set_block(last_key, std::move(last.value()));
+    } else {
+      E.next = key_hash;
+    }
+    E.prev = key_hash;
+    last_key = key_hash;
+    last = std::move(D);
+  }
+  set_block(last_key, std::move(last.value()));
+  set_block(empty, std::move(E));
+  cell_db_->commit_write_batch().ensure();
+  timer_write.pause();
 
-          promise.set_result(boc_->load_cell(cell->get_hash().as_slice()));
-          if (!opts_->get_disable_rocksdb_stats()) {
-            cell_db_statistics_.store_cell_time_.insert(timer.elapsed() * 1e6);
-            cell_db_statistics_.store_cell_prepare_time_.insert(timer_prepare.elapsed() * 1e6);
-            cell_db_statistics_.store_cell_write_time_.insert(timer_write.elapsed() * 1e6);
-          }
-          LOG(DEBUG) << "Stored state " << block_id.to_str();
-          release_db();
-        });
-  });
+  if (!opts_->get_celldb_in_memory()) {
+    boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), on_load_callback_)).ensure();
+    td::actor::send_closure(parent_, &CellDb::update_snapshot, cell_db_->snapshot());
+  }
+
+  for (auto& store : batch) {
+    store.promise.set_result(boc_->load_cell(store.cell->get_hash().as_slice()));
+    if (!opts_->get_disable_rocksdb_stats()) {
+      cell_db_statistics_.store_cell_time_.insert(store.timer.elapsed() * 1e6);
+    }
+    LOG(DEBUG) << "Stored state " << store.block_id.to_str();
+  }
+  if (!opts_->get_disable_rocksdb_stats()) {
+    cell_db_statistics_.store_cell_prepare_time_.insert(prepare_time * 1e6);
+    cell_db_statistics_.store_cell_write_time_.insert(timer_write.elapsed() * 1e6);
+    cell_db_statistics_.store_cell_batch_size_.insert((double)batch.size());
+  }
+  release_db();
 }
 
 void CellDbIn::get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) {
@@ -279,7 +342,7 @@ std::vector<std::pair<std::string, std::string>> CellDbIn::prepare_stats() {
   auto r_mem_stat = td::mem_stat();
   auto r_total_mem_stat = td::get_total_mem_stat();
   td::uint64 celldb_size = 0;
-  bool ok_celldb_size = rocks_db_->GetIntProperty("rocksdb.total-sst-files-size", &celldb_size);
+  bool ok_celldb_size = rocks_db_->GetAggregatedIntProperty("rocksdb.total-sst-files-size", &celldb_size);
   if (celldb_size > 0 && r_mem_stat.is_ok() && r_total_mem_stat.is_ok() && ok_celldb_size) {
     auto mem_stat = r_mem_stat.move_as_ok();
     auto total_mem_stat = r_total_mem_stat.move_as_ok();
@@ -684,6 +747,7 @@ std::vector<std::pair<std::string, std::string>> CellDbIn::CellDbStatistics::pre
   stats.emplace_back("store_cell.micros", PSTRING() << store_cell_time_.to_string());
   stats.emplace_back("store_cell.prepare.micros", PSTRING() << store_cell_prepare_time_.to_string());
   stats.emplace_back("store_cell.write.micros", PSTRING() << store_cell_write_time_.to_string());
+  stats.emplace_back("store_cell.batch_size", PSTRING() << store_cell_batch_size_.to_string());
   stats.emplace_back("gc_cell.micros", PSTRING() << gc_cell_time_.to_string());
   stats.emplace_back("total_time.micros", PSTRING() << (td::Timestamp::now().at() - stats_start_time_.at()) * 1e6);
   stats.emplace_back("in_memory", PSTRING() << bool(in_memory_load_time_));
@@ -29,6 +29,7 @@
 #include "db-utils.h"
 #include "td/db/RocksDb.h"
 
+#include <deque>
 #include <optional>
 #include <queue>
 
@@ -102,6 +103,22 @@ class CellDbIn : public CellDbBase {
   static BlockIdExt get_empty_key();
   KeyHash get_empty_key_hash();
 
+  struct PendingStore {
+    BlockIdExt block_id;
+    td::Ref<vm::Cell> cell;
+    td::Promise<td::Ref<vm::DataCell>> promise;
+    td::PerfWarningTimer timer;
+    bool duplicate = false;
+  };
+  std::deque<PendingStore> pending_stores_;
+  bool store_scheduled_ = false;
+
+  void store_pending_cells();
+  void commit_stored_cells(std::vector<PendingStore> batch, double prepare_time);
+  static size_t max_store_batch_size() {
+    return 16;
+  }
+
   void gc(BlockIdExt block_id);
   void gc_cont(BlockHandle handle);
   void gc_cont2(BlockHandle handle);
@@ -139,6 +156,7 @@ class CellDbIn : public CellDbBase {
     PercentileStats store_cell_time_;
     PercentileStats store_cell_prepare_time_;
     PercentileStats store_cell_write_time_;
+    PercentileStats store_cell_batch_size_;
     PercentileStats gc_cell_time_;
     td::Timestamp stats_start_time_ = td::Timestamp::now();
     std::optional<double> in_memory_load_time_;
@@ -347,7 +347,8 @@ void RootDb::try_get_static_file(FileHash file_hash, td::Promise<td::BufferSlice
 }
 
 void RootDb::apply_block(BlockHandle handle, td::Promise<td::Unit> promise) {
-  td::actor::create_actor<BlockArchiver>("archiver", std::move(handle), archive_db_.get(), std::move(promise))
+  td::actor::create_actor<BlockArchiver>("archiver", std::move(handle), archive_db_.get(), std::move(promise),
+                                         tx_index_db_.get())
       .release();
 }
 
@@ -355,6 +356,16 @@ void RootDb::get_block_by_lt(AccountIdPrefixFull account, LogicalTime lt, td::Pr
   td::actor::send_closure(archive_db_, &ArchiveManager::get_block_by_lt, account, lt, std::move(promise));
 }
 
+void RootDb::get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, td::uint32 count,
+                                      td::Promise<std::vector<AccountTransactionRef>> promise) {
+  if (tx_index_db_.empty()) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "transaction index is disabled"));
+    return;
+  }
+  td::actor::send_closure(tx_index_db_, &TransactionIndexDb::get_account_transactions, workchain, addr, lt, count,
+                          std::move(promise));
+}
+
 void RootDb::get_block_by_unix_time(AccountIdPrefixFull account, UnixTime ts, td::Promise<ConstBlockHandle> promise) {
   td::actor::send_closure(archive_db_, &ArchiveManager::get_block_by_unix_time, account, ts, std::move(promise));
 }
@@ -418,6 +429,10 @@ void RootDb::start_up() {
   state_db_ = td::actor::create_actor<StateDb>("statedb", actor_id(this), root_path_ + "/state/");
   static_files_db_ = td::actor::create_actor<StaticFilesDb>("staticfilesdb", actor_id(this), root_path_ + "/static/");
   archive_db_ = td::actor::create_actor<ArchiveManager>("archive", actor_id(this), root_path_, opts_);
+  if (opts_->get_transaction_index_enabled()) {
+    tx_index_db_ =
+        td::actor::create_actor<TransactionIndexDb>("txindexdb", archive_db_.get(), root_path_ + "/txindex/");
+  }
 }
 
 void RootDb::archive(BlockHandle handle, td::Promise<td::Unit> promise) {
@@ -25,6 +25,7 @@
 #include "celldb.hpp"
 #include "statedb.hpp"
 #include "staticfilesdb.hpp"
+#include "txindexdb.hpp"
 #include "archive-manager.hpp"
 #include "validator.h"
 
@@ -92,6 +93,8 @@ class RootDb : public Db {
 
   void apply_block(BlockHandle handle, td::Promise<td::Unit> promise) override;
   void get_block_by_lt(AccountIdPrefixFull account, LogicalTime lt, td::Promise<ConstBlockHandle> promise) override;
+  void get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, td::uint32 count,
+                                td::Promise<std::vector<AccountTransactionRef>> promise) override;
   void get_block_by_unix_time(AccountIdPrefixFull account, UnixTime ts, td::Promise<ConstBlockHandle> promise) override;
   void get_block_by_seqno(AccountIdPrefixFull account, BlockSeqno seqno,
                           td::Promise<ConstBlockHandle> promise) override;
@@ -148,6 +151,7 @@ class RootDb : public Db {
   td::actor::ActorOwn<StateDb> state_db_;
   td::actor::ActorOwn<StaticFilesDb> static_files_db_;
   td::actor::ActorOwn<ArchiveManager> archive_db_;
+  td::actor::ActorOwn<TransactionIndexDb> tx_index_db_;
 };
 
 }  // namespace validator
@@ -0,0 +1,368 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "txindexdb.hpp"
+#include "archive-manager.hpp"
+#include "fileref.hpp"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "vm/boc.h"
+#include "td/db/RocksDb.h"
+#include "td/utils/as.h"
+#include "td/utils/overloaded.h"
+#include "common/errorcode.h"
+
+namespace ton {
+
+namespace validator {
+
+namespace {
+
+constexpr td::uint32 package_header_size = 4;
+constexpr td::uint16 package_entry_header_magic = 0x1e8b;
+
+// Value: transaction hash, then block id (workchain, shard, seqno, root hash, file hash)
+constexpr size_t value_size = 32 + 4 + 8 + 4 + 32 + 32;
+
+std::string serialize_value(const td::Bits256 &hash, const BlockIdExt &block_id) {
+  std::string value(value_size, '\0');
+  char *ptr = &value[0];
+  td::as<td::Bits256>(ptr) = hash;
+  td::as<td::int32>(ptr + 32) = block_id.id.workchain;
+  td::as<td::uint64>(ptr + 36) = block_id.id.shard;
+  td::as<td::uint32>(ptr + 44) = block_id.id.seqno;
+  td::as<td::Bits256>(ptr + 48) = block_id.root_hash;
+  td::as<td::Bits256>(ptr + 80) = block_id.file_hash;
+  return value;
+}
+
+td::Result<AccountTransactionRef> parse_value(LogicalTime lt, td::Slice value) {
+  if (value.size() != value_size) {
+    return td::Status::Error(ErrorCode::protoviolation, "bad transaction index entry");
+  }
+  const char *ptr = value.data();
+  AccountTransactionRef ref;
+  ref.lt = lt;
+  ref.hash = td::as<td::Bits256>(ptr);
+  ref.block_id.id.workchain = td::as<td::int32>(ptr + 32);
+  ref.block_id.id.shard = td::as<td::uint64>(ptr + 36);
+  ref.block_id.id.seqno = td::as<td::uint32>(ptr + 44);
+  ref.block_id.root_hash = td::as<td::Bits256>(ptr + 48);
+  ref.block_id.file_hash = td::as<td::Bits256>(ptr + 80);
+  return ref;
+}
+
+void store_big_endian(std::string &s, td::uint64 x, int bytes) {
+  for (int i = bytes - 1; i >= 0; --i) {
+    s.push_back(static_cast<char>((x >> (8 * i)) & 0xff));
+  }
+}
+
+td::uint64 load_big_endian(td::Slice s) {
+  td::uint64 x = 0;
+  for (auto c : s) {
+    x = (x << 8) | static_cast<td::uint8>(c);
+  }
+  return x;
+}
+
+}  // namespace
+
+TransactionIndexDb::TransactionIndexDb(td::actor::ActorId<ArchiveManager> archive_db, std::string db_path)
+    : archive_db_(archive_db), db_path_(std::move(db_path)) {
+}
+
+// Transactions of an account are ordered by decreasing lt, so that a page of history is read by a forward scan
+std::string TransactionIndexDb::account_key(WorkchainId workchain, const StdSmcAddress &addr, LogicalTime lt) {
+  std::string key = "a";
+  store_big_endian(key, static_cast<td::uint32>(workchain), 4);
+  key.append(addr.as_slice().begin(), addr.as_slice().size());
+  store_big_endian(key, ~lt, 8);
+  return key;
+}
+
+void TransactionIndexDb::start_up() {
+  td::RocksDbOptions db_options;
+  db_options.bloom_filter_bits_per_key = 10;
+  kv_ = std::make_shared<td::RocksDb>(td::RocksDb::open(db_path_, std::move(db_options)).move_as_ok());
+
+  std::string value;
+  auto R = kv_->get("backfill", value);
+  R.ensure();
+  if (R.move_as_ok() == td::KeyValue::GetStatus::Ok) {
+    backfill_seqno_ = td::to_integer<BlockSeqno>(value);
+    start_backfill();
+  }
+}
+
+void TransactionIndexDb::add_block(ConstBlockHandle handle, td::BufferSlice data) {
+  if (handle->id().seqno() == 0) {
+    return;
+  }
+  Entries entries;
+  auto S = parse_block(handle->id(), data, entries);
+  if (S.is_error()) {
+    LOG(WARNING) << "failed to index transactions of block " << handle->id().to_str() << ": " << S;
+    return;
+  }
+  kv_->begin_write_batch().ensure();
+  store_entries(entries);
+  if (handle->id().is_masterchain() && !backfill_seqno_) {
+    // Everything before the first indexed masterchain block is taken from archive packages
+    set_backfill_seqno(handle->id().seqno() - 1);
+  }
+  kv_->commit_write_batch().ensure();
+  start_backfill();
+}
+
+td::Status TransactionIndexDb::parse_block(const BlockIdExt &block_id, td::Slice data, Entries &entries) {
+  TRY_RESULT(root, vm::std_boc_deserialize(data));
+  if (root->get_hash().as_slice() != block_id.root_hash.as_slice()) {
+    return td::Status::Error(ErrorCode::protoviolation, "block root hash mismatch");
+  }
+  auto old_size = entries.size();
+  try {
+    block::gen::Block::Record blk;
+    block::gen::BlockExtra::Record extra;
+    if (!(tlb::unpack_cell(root, blk) && tlb::unpack_cell(std::move(blk.extra), extra))) {
+      return td::Status::Error(ErrorCode::protoviolation, "cannot unpack block");
+    }
+    vm::AugmentedDictionary acc_dict{vm::load_cell_slice_ref(extra.account_blocks), 256,
+                                     block::tlb::aug_ShardAccountBlocks};
+    bool ok = acc_dict.check_for_each_extra([&](td::Ref<vm::CellSlice> value, td::Ref<vm::CellSlice>,
+                                                td::ConstBitPtr key, int key_len) {
+      block::gen::AccountBlock::Record acc_blk;
+      if (!tlb::csr_unpack(std::move(value), acc_blk)) {
+        return false;
+      }
+      vm::AugmentedDictionary trans_dict{vm::DictNonEmpty(), std::move(acc_blk.transactions), 64,
+                                         block::tlb::aug_AccountTransactions};
+      return trans_dict.check_for_each_extra([&](td::Ref<vm::CellSlice> tvalue, td::Ref<vm::CellSlice>,
+                                                 td::ConstBitPtr tkey, int tkey_len) {
+        auto trans_root = tvalue->prefetch_ref();
+        if (trans_root.is_null()) {
+          return false;
+        }
+        LogicalTime lt = tkey.get_uint(64);
+        entries.emplace_back(account_key(block_id.id.workchain, acc_blk.account_addr, lt),
+                             serialize_value(trans_root->get_hash().bits(), block_id));
+        return true;
+      });
+    });
+    if (!ok) {
+      entries.resize(old_size);
+      return td::Status::Error(ErrorCode::protoviolation, "invalid account blocks");
+    }
+  } catch (vm::VmError &err) {
+    entries.resize(old_size);
+    return td::Status::Error(ErrorCode::protoviolation, PSLICE() << "error while parsing block: " << err.get_msg());
+  }
+  return td::Status::OK();
+}
+
+void TransactionIndexDb::store_entries(const Entries &entries) {
+  for (auto &e : entries) {
+    kv_->set(e.first, e.second).ensure();
+  }
+}
+
+void TransactionIndexDb::get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt,
+                                                  td::uint32 count,
+                                                  td::Promise<std::vector<AccountTransactionRef>> promise) {
+  std::vector<AccountTransactionRef> res;
+  auto begin = account_key(workchain, addr, lt);
+  auto end = account_key(workchain, addr, 0);
+  auto prefix_size = end.size() - 8;
+  td::Status error;
+  auto S = kv_->for_each_in_range(begin, end, [&](td::Slice key, td::Slice value) -> td::Status {
+    auto R = parse_value(~load_big_endian(key.substr(prefix_size)), value);
+    if (R.is_error()) {
+      error = R.move_as_error();
+      return error.clone();
+    }
+    res.push_back(R.move_as_ok());
+    if (res.size() >= count) {
+      // stops the scan
+      return td::Status::Error();
+    }
+    return td::Status::OK();
+  });
+  if (S.is_error() && (error.is_error() || res.size() < count)) {
+    promise.set_error(error.is_error() ? std::move(error) : std::move(S));
+    return;
+  }
+  promise.set_value(std::move(res));
+}
+
+void TransactionIndexDb::store_backfill_entries(Entries entries, td::optional<BlockSeqno> seqno,
+                                                td::Promise<td::Unit> promise) {
+  kv_->begin_write_batch().ensure();
+  store_entries(entries);
+  if (seqno) {
+    set_backfill_seqno(seqno.value());
+  }
+  kv_->commit_write_batch().ensure();
+  promise.set_value(td::Unit());
+}
+
+void TransactionIndexDb::set_backfill_seqno(BlockSeqno seqno) {
+  backfill_seqno_ = seqno;
+  kv_->set("backfill", td::to_string(seqno)).ensure();
+}
+
+void TransactionIndexDb::start_backfill() {
+  if (!backfill_.empty() || !backfill_seqno_ || backfill_seqno_.value() == 0) {
+    return;
+  }
+  backfill_ = td::actor::create_actor<TransactionIndexBackfill>("txindexbackfill", archive_db_, actor_id(this),
+                                                                backfill_seqno_.value());
+}
+
+TransactionIndexBackfill::TransactionIndexBackfill(td::actor::ActorId<ArchiveManager> archive_db,
+                                                   td::actor::ActorId<TransactionIndexDb> db, BlockSeqno seqno)
+    : archive_db_(archive_db), db_(db), seqno_(seqno) {
+}
+
+void TransactionIndexBackfill::start_up() {
+  next_archive();
+}
+
+void TransactionIndexBackfill::next_archive() {
+  td::actor::send_closure(archive_db_, &ArchiveManager::get_archive_id, seqno_,
+                          [SelfId = actor_id(this)](td::Result<td::uint64> R) {
+                            td::actor::send_closure(SelfId, &TransactionIndexBackfill::got_archive_id, std::move(R));
+                          });
+}
+
+void TransactionIndexBackfill::got_archive_id(td::Result<td::uint64> R) {
+  if (R.is_error()) {
+    LOG(INFO) << "transaction index backfill finished at masterchain seqno " << seqno_ << ": " << R.move_as_error();
+    td::actor::send_closure(db_, &TransactionIndexDb::store_backfill_entries, TransactionIndexDb::Entries{},
+                            td::optional<BlockSeqno>{0}, [](td::Unit) {});
+    stop();
+    return;
+  }
+  archive_id_ = R.move_as_ok();
+  offset_ = package_header_size;
+  buffer_.clear();
+  min_seqno_ = seqno_ + 1;
+  request_slice();
+}
+
+void TransactionIndexBackfill::request_slice() {
+  td::actor::send_closure(archive_db_, &ArchiveManager::get_archive_slice, archive_id_, offset_, slice_size(),
+                          [SelfId = actor_id(this)](td::Result<td::BufferSlice> R) {
+                            td::actor::send_closure(SelfId, &TransactionIndexBackfill::got_slice, std::move(R));
+                          });
+}
+
+void TransactionIndexBackfill::got_slice(td::Result<td::BufferSlice> R) {
+  if (R.is_error()) {
+    // The saved seqno is kept, so the backfill is retried after restart
+    LOG(WARNING) << "transaction index backfill: failed to read archive " << archive_id_ << ": " << R.move_as_error();
+    stop();
+    return;
+  }
+  auto data = R.move_as_ok();
+  offset_ += data.size();
+  buffer_.append(data.as_slice().begin(), data.size());
+  TransactionIndexDb::Entries entries;
+  auto S = process_buffer(entries);
+  if (S.is_error()) {
+    LOG(WARNING) << "transaction index backfill: bad archive " << archive_id_ << ": " << S;
+    td::actor::send_closure(db_, &TransactionIndexDb::store_backfill_entries, TransactionIndexDb::Entries{},
+                            td::optional<BlockSeqno>{0}, [](td::Unit) {});
+    stop();
+    return;
+  }
+
+  td::optional<BlockSeqno> seqno;
+  bool archive_done = data.size() != slice_size();
+  if (archive_done) {
+    // The whole package is processed, continue with the previous one
+    if (min_seqno_ > seqno_) {
+      LOG(INFO) << "transaction index backfill: archive " << archive_id_ << " has no masterchain block " << seqno_
+                << ", stopping";
+      seqno = 0;
+    } else {
+      LOG(INFO) << "transaction index backfill: processed archive " << archive_id_ << ", masterchain seqno "
+                << min_seqno_ << ".." << seqno_;
+      seqno = min_seqno_ > 0 ? min_seqno_ - 1 : 0;
+    }
+  }
+  td::actor::send_closure(db_, &TransactionIndexDb::store_backfill_entries, std::move(entries), seqno,
+                          [SelfId = actor_id(this), seqno, archive_done](td::Result<td::Unit> R) {
+                            R.ensure();
+                            td::actor::send_closure(SelfId, &TransactionIndexBackfill::stored_entries, seqno,
+                                                    archive_done);
+                          });
+}
+
+void TransactionIndexBackfill::stored_entries(td::optional<BlockSeqno> seqno, bool archive_done) {
+  if (!archive_done) {
+    request_slice();
+    return;
+  }
+  if (seqno.value() == 0) {
+    stop();
+    return;
+  }
+  seqno_ = seqno.value();
+  next_archive();
+}
+
+td::Status TransactionIndexBackfill::process_buffer(TransactionIndexDb::Entries &entries) {
+  td::Slice buf = buffer_;
+  while (buf.size() >= 8) {
+    auto header0 = td::as<td::uint32>(buf.data());
+    auto data_size = td::as<td::uint32>(buf.data() + 4);
+    if ((header0 & 0xffff) != package_entry_header_magic) {
+      return td::Status::Error(ErrorCode::protoviolation, "bad entry magic");
+    }
+    size_t filename_size = header0 >> 16;
+    if (buf.size() < 8 + filename_size + data_size) {
+      break;
+    }
+    auto filename = buf.substr(8, filename_size).str();
+    auto data = buf.substr(8 + filename_size, data_size);
+    buf.remove_prefix(8 + filename_size + data_size);
+
+    auto F = FileReference::create(filename);
+    if (F.is_error()) {
+      continue;
+    }
+    BlockIdExt block_id;
+    F.ok_ref().ref().visit(td::overloaded([&](const fileref::Block &b) { block_id = b.block_id; },
+                                          [&](const auto &) {}));
+    if (!block_id.is_valid()) {
+      continue;
+    }
+    auto S = TransactionIndexDb::parse_block(block_id, data, entries);
+    if (S.is_error()) {
+      LOG(WARNING) << "transaction index backfill: failed to index block " << block_id.to_str() << ": " << S;
+      continue;
+    }
+    if (block_id.is_masterchain() && block_id.seqno() < min_seqno_) {
+      min_seqno_ = block_id.seqno();
+    }
+  }
+  buffer_.erase(0, buffer_.size() - buf.size());
+  return td::Status::OK();
+}
+
+}  // namespace validator
+
+}  // namespace ton
@@ -0,0 +1,108 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "td/actor/actor.h"
+#include "td/db/KeyValue.h"
+#include "ton/ton-types.h"
+
+#include "validator/interfaces/db.h"
+
+namespace ton {
+
+namespace validator {
+
+class ArchiveManager;
+class TransactionIndexBackfill;
+
+/*
+ * Index of account transactions: (workchain, account, lt) -> (transaction hash, block id).
+ *
+ * Blocks are added as they are applied, together with their data. Blocks that were applied before the index was
+ * enabled are read from archive packages by TransactionIndexBackfill, going back from the first indexed masterchain
+ * block until the oldest package.
+ * Entries are only hints for liteserver: transactions are always looked up and checked in the block itself.
+ */
+class TransactionIndexDb : public td::actor::Actor {
+ public:
+  using Entries = std::vector<std::pair<std::string, std::string>>;
+
+  TransactionIndexDb(td::actor::ActorId<ArchiveManager> archive_db, std::string db_path);
+
+  void start_up() override;
+
+  void add_block(ConstBlockHandle handle, td::BufferSlice data);
+  void get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, td::uint32 count,
+                                td::Promise<std::vector<AccountTransactionRef>> promise);
+  // Stores entries read by the backfill; seqno is set when an archive package is finished
+  void store_backfill_entries(Entries entries, td::optional<BlockSeqno> seqno, td::Promise<td::Unit> promise);
+
+  static td::Status parse_block(const BlockIdExt &block_id, td::Slice data, Entries &entries);
+
+ private:
+  td::actor::ActorId<ArchiveManager> archive_db_;
+  std::string db_path_;
+  std::shared_ptr<td::KeyValue> kv_;
+
+  // masterchain seqno, which is backfilled next (blocks with greater seqno are already indexed), 0 when done
+  td::optional<BlockSeqno> backfill_seqno_;
+  td::actor::ActorOwn<TransactionIndexBackfill> backfill_;
+
+  void store_entries(const Entries &entries);
+  void set_backfill_seqno(BlockSeqno seqno);
+  void start_backfill();
+
+  static std::string account_key(WorkchainId workchain, const StdSmcAddress &addr, LogicalTime lt);
+};
+
+/*
+ * Reads archive packages one slice at a time, starting from the package of masterchain block seqno and going back.
+ * Blocks are parsed here, so that lookups in TransactionIndexDb are not delayed by the backfill; the next slice is
+ * requested only after the entries of the previous one are stored.
+ */
+class TransactionIndexBackfill : public td::actor::Actor {
+ public:
+  TransactionIndexBackfill(td::actor::ActorId<ArchiveManager> archive_db, td::actor::ActorId<TransactionIndexDb> db,
+                           BlockSeqno seqno);
+
+  void start_up() override;
+
+ private:
+  td::actor::ActorId<ArchiveManager> archive_db_;
+  td::actor::ActorId<TransactionIndexDb> db_;
+  BlockSeqno seqno_;
+
+  td::uint64 archive_id_ = 0;
+  td::uint64 offset_ = 0;
+  std::string buffer_;
+  BlockSeqno min_seqno_ = 0;
+
+  void next_archive();
+  void got_archive_id(td::Result<td::uint64> R);
+  void request_slice();
+  void got_slice(td::Result<td::BufferSlice> R);
+  void stored_entries(td::optional<BlockSeqno> seqno, bool archive_done);
+  td::Status process_buffer(TransactionIndexDb::Entries &entries);
+
+  static constexpr td::uint32 slice_size() {
+    return 1 << 22;
+  }
+};
+
+}  // namespace validator
+
+}  // namespace ton
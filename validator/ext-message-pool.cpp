@@ -0,0 +1,205 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ext-message-pool.hpp"
+#include "fabric.h"
+#include "interfaces/validator-manager.h"
+#include "ton/ton-shard.h"
+
+#include "td/utils/Random.h"
+
+namespace ton {
+
+namespace validator {
+
+void ExtMessagePoolImpl::Messages::erase(
+    std::map<MessageId<ExtMessage>, std::unique_ptr<MessageExt<ExtMessage>>>::iterator it) {
+  auto it2 = ext_addr_messages_.find(it->second->address());
+  CHECK(it2 != ext_addr_messages_.end());
+  if (--it2->second == 0) {
+    ext_addr_messages_.erase(it2);
+  }
+  ext_messages_.erase(it);
+}
+
+void ExtMessagePoolImpl::erase(Bucket &bucket, int priority, const MessageId<ExtMessage> &id) {
+  auto &msgs = bucket.msgs[priority];
+  auto it = msgs.ext_messages_.find(id);
+  CHECK(it != msgs.ext_messages_.end());
+  msgs.erase(it);
+  size_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ExtMessagePoolImpl::set_ready(bool ready, block::SizeLimitsConfig::ExtMsgLimits limits) {
+  std::lock_guard<std::mutex> guard(limits_mutex_);
+  ready_ = ready;
+  limits_ = limits;
+}
+
+void ExtMessagePoolImpl::new_external_message(td::BufferSlice data, int priority) {
+  block::SizeLimitsConfig::ExtMsgLimits limits;
+  {
+    std::lock_guard<std::mutex> guard(limits_mutex_);
+    if (!ready_) {
+      dropped_not_ready_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    limits = limits_;
+  }
+  auto R = create_ext_message(std::move(data), limits);
+  if (R.is_error()) {
+    dropped_bad_.fetch_add(1, std::memory_order_relaxed);
+    VLOG(VALIDATOR_NOTICE) << "dropping bad ext message: " << R.move_as_error();
+    return;
+  }
+  add_external_message(R.move_as_ok(), priority);
+}
+
+ExtMessagePoolImpl::AddResult ExtMessagePoolImpl::add_external_message(td::Ref<ExtMessage> msg, int priority) {
+  auto message = std::make_unique<MessageExt<ExtMessage>>(std::move(msg));
+  auto id = message->ext_id();
+  auto address = message->address();
+  auto &bucket = buckets_[get_bucket_idx(id.dst)];
+  std::lock_guard<std::mutex> guard(bucket.mutex);
+  auto &msgs = bucket.msgs[priority];
+  if (msgs.ext_messages_.size() >= max_bucket_size_.load(std::memory_order_relaxed)) {
+    dropped_full_.fetch_add(1, std::memory_order_relaxed);
+    return mempool_full;
+  }
+  auto it = msgs.ext_addr_messages_.find(address);
+  if (it != msgs.ext_addr_messages_.end() && it->second >= max_messages_per_address()) {
+    dropped_per_address_.fetch_add(1, std::memory_order_relaxed);
+    return per_address_limit;
+  }
+  auto it2 = bucket.hashes.find(id.hash);
+  if (it2 != bucket.hashes.end()) {
+    int old_priority = it2->second.first;
+    if (old_priority >= priority) {
+      duplicate_.fetch_add(1, std::memory_order_relaxed);
+      return duplicate;
+    }
+    erase(bucket, old_priority, id);
+  }
+  msgs.ext_messages_.emplace(id, std::move(message));
+  msgs.ext_addr_messages_[address]++;
+  bucket.hashes[id.hash] = {priority, id};
+  size_.fetch_add(1, std::memory_order_relaxed);
+  added_.fetch_add(1, std::memory_order_relaxed);
+  return added;
+}
+
+std::vector<std::pair<td::Ref<ExtMessage>, int>> ExtMessagePoolImpl::get_external_messages(ShardIdFull shard) {
+  MessageId<ExtMessage> left{AccountIdPrefixFull{shard.workchain, shard.shard & (shard.shard - 1)}, Bits256::zero()};
+  size_t first_bucket = get_bucket_idx(left.dst);
+  size_t last_bucket = get_bucket_idx(AccountIdPrefixFull{shard.workchain, shard.shard | (shard.shard - 1)});
+
+  std::map<int, std::vector<std::pair<td::Ref<ExtMessage>, int>>> res_by_priority;
+  for (size_t i = first_bucket; i <= last_bucket; ++i) {
+    auto &bucket = buckets_[i];
+    std::lock_guard<std::mutex> guard(bucket.mutex);
+    for (auto &p : bucket.msgs) {
+      int priority = p.first;
+      auto &msgs = p.second;
+      auto &cur_res = res_by_priority[priority];
+      auto it = msgs.ext_messages_.lower_bound(left);
+      while (it != msgs.ext_messages_.end()) {
+        if (!shard_contains(shard, it->first.dst)) {
+          break;
+        }
+        if (it->second->expired()) {
+          bucket.hashes.erase(it->first.hash);
+          auto next = std::next(it);
+          msgs.erase(it);
+          it = next;
+          size_.fetch_sub(1, std::memory_order_relaxed);
+          expired_.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+        if (it->second->is_active()) {
+          cur_res.emplace_back(it->second->message(), priority);
+        }
+        it++;
+      }
+    }
+  }
+
+  std::vector<std::pair<td::Ref<ExtMessage>, int>> res;
+  td::Random::Fast rnd;
+  for (auto it = res_by_priority.rbegin(); it != res_by_priority.rend(); ++it) {
+    auto &cur_res = it->second;
+    td::random_shuffle(td::as_mutable_span(cur_res), rnd);
+    res.insert(res.end(), cur_res.begin(), cur_res.end());
+  }
+  return res;
+}
+
+void ExtMessagePoolImpl::complete_external_messages(std::vector<ExtMessage::Hash> to_delay,
+                                                    std::vector<ExtMessage::Hash> to_delete) {
+  // Hash does not tell the bucket, but the lookup in a bucket is O(1)
+  for (auto &bucket : buckets_) {
+    complete_external_messages(bucket, to_delay, to_delete);
+  }
+}
+
+void ExtMessagePoolImpl::complete_external_messages(Bucket &bucket, const std::vector<ExtMessage::Hash> &to_delay,
+                                                    const std::vector<ExtMessage::Hash> &to_delete) {
+  std::lock_guard<std::mutex> guard(bucket.mutex);
+  if (bucket.hashes.empty()) {
+    return;
+  }
+  for (auto &hash : to_delete) {
+    auto it = bucket.hashes.find(hash);
+    if (it != bucket.hashes.end()) {
+      erase(bucket, it->second.first, it->second.second);
+      bucket.hashes.erase(it);
+      completed_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  for (auto &hash : to_delay) {
+    auto it = bucket.hashes.find(hash);
+    if (it != bucket.hashes.end()) {
+      auto &msgs = bucket.msgs[it->second.first];
+      auto it2 = msgs.ext_messages_.find(it->second.second);
+      CHECK(it2 != msgs.ext_messages_.end());
+      if (msgs.ext_messages_.size() < soft_bucket_limit() && it2->second->can_postpone()) {
+        it2->second->postpone();
+      } else {
+        msgs.erase(it2);
+        bucket.hashes.erase(it);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        completed_.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+ExtMessagePoolImpl::Stats ExtMessagePoolImpl::get_stats() const {
+  Stats stats;
+  stats.size = size_.load(std::memory_order_relaxed);
+  stats.added = added_.load(std::memory_order_relaxed);
+  stats.duplicate = duplicate_.load(std::memory_order_relaxed);
+  stats.dropped_bad = dropped_bad_.load(std::memory_order_relaxed);
+  stats.dropped_not_ready = dropped_not_ready_.load(std::memory_order_relaxed);
+  stats.dropped_full = dropped_full_.load(std::memory_order_relaxed);
+  stats.dropped_per_address = dropped_per_address_.load(std::memory_order_relaxed);
+  stats.expired = expired_.load(std::memory_order_relaxed);
+  stats.completed = completed_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace validator
+
+}  // namespace ton
@@ -0,0 +1,198 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "validator.h"
+#include "interfaces/external-message.h"
+#include "td/utils/HashMap.h"
+#include "td/utils/Time.h"
+#include "td/utils/as.h"
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+
+namespace ton {
+
+namespace validator {
+
+template <class MType>
+struct MessageId {
+  AccountIdPrefixFull dst;
+  typename MType::Hash hash;
+
+  bool operator<(const MessageId &msg) const {
+    if (dst < msg.dst) {
+      return true;
+    }
+    if (msg.dst < dst) {
+      return false;
+    }
+    return hash < msg.hash;
+  }
+};
+
+template <class MType>
+class MessageExt {
+ public:
+  auto shard() const {
+    return message_->shard();
+  }
+  auto ext_id() const {
+    auto shard = message_->shard();
+    return MessageId<MType>{shard, message_->hash()};
+  }
+  auto message() const {
+    return message_;
+  }
+  auto hash() const {
+    return message_->hash();
+  }
+  auto address() const {
+    return std::make_pair(message_->wc(), message_->addr());
+  }
+  bool is_active() {
+    if (!active_) {
+      if (reactivate_at_.is_in_past()) {
+        active_ = true;
+        generation_++;
+      }
+    }
+    return active_;
+  }
+  bool can_postpone() const {
+    return generation_ <= 2;
+  }
+  void postpone() {
+    if (!active_) {
+      return;
+    }
+    active_ = false;
+    reactivate_at_ = td::Timestamp::in(generation_ * 5.0);
+  }
+  bool expired() const {
+    return delete_at_.is_in_past();
+  }
+  MessageExt(td::Ref<MType> msg) : message_(std::move(msg)) {
+    delete_at_ = td::Timestamp::in(600);
+  }
+
+ private:
+  td::Ref<MType> message_;
+  td::uint32 generation_ = 0;
+  bool active_ = true;
+  td::Timestamp reactivate_at_;
+  td::Timestamp delete_at_;
+};
+
+/*
+ * Mempool of external messages.
+ *
+ * Messages are split into buckets by the top bits of the destination account prefix, each bucket has its own
+ * lock. Workers of full node overlays add messages directly, without going through the validator manager actor.
+ * Collators take a snapshot of messages for their shard through the manager.
+ */
+class ExtMessagePoolImpl : public ExtMessagePool {
+ public:
+  enum AddResult { added, duplicate, per_address_limit, mempool_full };
+
+  struct Stats {
+    td::uint64 size = 0;
+    td::uint64 added = 0;
+    td::uint64 duplicate = 0;
+    td::uint64 dropped_bad = 0;
+    td::uint64 dropped_not_ready = 0;
+    td::uint64 dropped_full = 0;
+    td::uint64 dropped_per_address = 0;
+    td::uint64 expired = 0;
+    td::uint64 completed = 0;
+  };
+
+  explicit ExtMessagePoolImpl(size_t max_mempool_num) {
+    set_max_mempool_num(max_mempool_num);
+  }
+
+  void new_external_message(td::BufferSlice data, int priority) override;
+  AddResult add_external_message(td::Ref<ExtMessage> message, int priority);
+
+  // Messages to shard ordered by priority (highest first) and shuffled inside one priority. Removes expired messages.
+  std::vector<std::pair<td::Ref<ExtMessage>, int>> get_external_messages(ShardIdFull shard);
+  void complete_external_messages(std::vector<ExtMessage::Hash> to_delay, std::vector<ExtMessage::Hash> to_delete);
+
+  // New messages are accepted only when the node is a validator and has a masterchain state
+  void set_ready(bool ready, block::SizeLimitsConfig::ExtMsgLimits limits);
+  void set_max_mempool_num(size_t max_mempool_num) {
+    max_bucket_size_.store(std::max<size_t>(max_mempool_num / buckets_count, 1), std::memory_order_relaxed);
+  }
+
+  Stats get_stats() const;
+
+  static constexpr size_t buckets_count = 16;
+
+ private:
+  struct Messages {
+    std::map<MessageId<ExtMessage>, std::unique_ptr<MessageExt<ExtMessage>>> ext_messages_;
+    std::map<std::pair<ton::WorkchainId, ton::StdSmcAddress>, size_t> ext_addr_messages_;
+    void erase(std::map<MessageId<ExtMessage>, std::unique_ptr<MessageExt<ExtMessage>>>::iterator it);
+  };
+  struct MessageHashF {
+    size_t operator()(const ExtMessage::Hash &hash) const {
+      return td::as<size_t>(hash.data());
+    }
+  };
+  struct Bucket {
+    std::mutex mutex;
+    std::map<int, Messages> msgs;  // priority -> messages
+    td::HashMap<ExtMessage::Hash, std::pair<int, MessageId<ExtMessage>>, MessageHashF> hashes;  // hash -> priority
+  };
+
+  static size_t get_bucket_idx(const AccountIdPrefixFull &dst) {
+    return (size_t)(dst.account_id_prefix >> 60);
+  }
+  void erase(Bucket &bucket, int priority, const MessageId<ExtMessage> &id);
+  void complete_external_messages(Bucket &bucket, const std::vector<ExtMessage::Hash> &to_delay,
+                                  const std::vector<ExtMessage::Hash> &to_delete);
+
+  static size_t max_messages_per_address() {
+    return 256;
+  }
+  static size_t soft_bucket_limit() {
+    return 1024 / buckets_count;
+  }
+
+  std::array<Bucket, buckets_count> buckets_;
+  std::atomic<size_t> max_bucket_size_{0};
+
+  std::mutex limits_mutex_;
+  bool ready_ = false;
+  block::SizeLimitsConfig::ExtMsgLimits limits_;
+
+  std::atomic<td::uint64> size_{0};
+  std::atomic<td::uint64> added_{0};
+  std::atomic<td::uint64> duplicate_{0};
+  std::atomic<td::uint64> dropped_bad_{0};
+  std::atomic<td::uint64> dropped_not_ready_{0};
+  std::atomic<td::uint64> dropped_full_{0};
+  std::atomic<td::uint64> dropped_per_address_{0};
+  std::atomic<td::uint64> expired_{0};
+  std::atomic<td::uint64> completed_{0};
+};
+
+}  // namespace validator
+
+}  // namespace ton
@@ -247,6 +247,10 @@ void FullNodeCustomOverlay::process_broadcast(PublicKeyHash src, ton_api::tonNod
   }
   VLOG(FULL_NODE_DEBUG) << "Got external message in custom overlay \"" << name_ << "\" from " << src
                         << " (priority=" << it->second << ")";
+  if (ext_msg_pool_) {
+    ext_msg_pool_->new_external_message(std::move(query.message_->data_), it->second);
+    return;
+  }
   td::actor::send_closure(validator_manager_, &ValidatorManagerInterface::new_external_message,
                           std::move(query.message_->data_), it->second);
 }
@@ -360,6 +364,12 @@ void FullNodeCustomOverlay::start_up() {
   b.as_slice().copy_from(as_slice(X));
   overlay_id_full_ = overlay::OverlayIdFull{std::move(b)};
   overlay_id_ = overlay_id_full_.compute_short_id();
+  auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<std::shared_ptr<ExtMessagePool>> R) {
+    if (R.is_ok()) {
+      td::actor::send_closure(SelfId, &FullNodeCustomOverlay::set_ext_message_pool, R.move_as_ok());
+    }
+  });
+  td::actor::send_closure(validator_manager_, &ValidatorManagerInterface::get_ext_message_pool, std::move(P));
   try_init();
 }
 
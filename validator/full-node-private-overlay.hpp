@@ -121,6 +121,9 @@ class FullNodeCustomOverlay : public td::actor::Actor {
   }
 
   void start_up() override;
+  void set_ext_message_pool(std::shared_ptr<ExtMessagePool> pool) {
+    ext_msg_pool_ = std::move(pool);
+  }
   void tear_down() override;
 
   FullNodeCustomOverlay(adnl::AdnlNodeIdShort local_id, CustomOverlayParams params, FileHash zero_state_file_hash,
@@ -160,6 +163,7 @@ class FullNodeCustomOverlay : public td::actor::Actor {
   td::actor::ActorId<rldp2::Rldp> rldp2_;
   td::actor::ActorId<overlay::Overlays> overlays_;
   td::actor::ActorId<ValidatorManagerInterface> validator_manager_;
+  std::shared_ptr<ExtMessagePool> ext_msg_pool_;
   td::actor::ActorId<FullNode> full_node_;
 
   bool inited_ = false;
@@ -637,6 +637,11 @@ void FullNodeShardImpl::process_broadcast(PublicKeyHash src, ton_api::tonNode_ih
 }
 
 void FullNodeShardImpl::process_broadcast(PublicKeyHash src, ton_api::tonNode_externalMessageBroadcast &query) {
+  if (ext_msg_pool_) {
+    // Parse and add the message here, not in the validator manager actor
+    ext_msg_pool_->new_external_message(std::move(query.message_->data_), 0);
+    return;
+  }
   td::actor::send_closure(validator_manager_, &ValidatorManagerInterface::new_external_message,
                           std::move(query.message_->data_), 0);
 }
@@ -928,6 +933,12 @@ void FullNodeShardImpl::start_up() {
     rules_ = overlay::OverlayPrivacyRules{overlay::Overlays::max_fec_broadcast_size()};
 
     create_overlay();
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<std::shared_ptr<ExtMessagePool>> R) {
+      if (R.is_ok()) {
+        td::actor::send_closure(SelfId, &FullNodeShardImpl::set_ext_message_pool, R.move_as_ok());
+      }
+    });
+    td::actor::send_closure(validator_manager_, &ValidatorManagerInterface::get_ext_message_pool, std::move(P));
 
     reload_neighbours_at_ = td::Timestamp::now();
     ping_neighbours_at_ = td::Timestamp::now();
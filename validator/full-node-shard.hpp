@@ -183,6 +183,9 @@ class FullNodeShardImpl : public FullNodeShard {
   void set_handle(BlockHandle handle, td::Promise<td::Unit> promise) override;
 
   void start_up() override;
+  void set_ext_message_pool(std::shared_ptr<ExtMessagePool> pool) {
+    ext_msg_pool_ = std::move(pool);
+  }
   void alarm() override;
 
   void update_validators(std::vector<PublicKeyHash> public_key_hashes, PublicKeyHash local_hash) override;
@@ -239,6 +242,7 @@ class FullNodeShardImpl : public FullNodeShard {
   td::actor::ActorId<rldp2::Rldp> rldp2_;
   td::actor::ActorId<overlay::Overlays> overlays_;
   td::actor::ActorId<ValidatorManagerInterface> validator_manager_;
+  std::shared_ptr<ExtMessagePool> ext_msg_pool_;
   td::actor::ActorId<adnl::AdnlExtClient> client_;
   td::actor::ActorId<FullNode> full_node_;
 
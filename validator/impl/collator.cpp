@@ -2510,6 +2510,8 @@ td::Result<block::Account*> Collator::make_account(td::ConstBitPtr addr, bool fo
  */
 bool Collator::combine_account_transactions() {
   vm::AugmentedDictionary dict{256, block::tlb::aug_ShardAccountBlocks};
+  // both dictionaries are updated in one pass each, so that shared upper levels are rebuilt only once
+  std::vector<vm::DictionaryFixed::BatchOp> acc_blocks, acc_updates;
   for (auto& z : accounts) {
     block::Account& acc = *(z.second);
     CHECK(acc.addr == z.first);
@@ -2538,10 +2540,7 @@ bool Collator::combine_account_transactions() {
         return fatal_error(std::string{"new AccountBlock for "} + z.first.to_hex() +
                            " failed to pass handwritten validation tests");
       }
-      if (!dict.set(z.first, csr, vm::Dictionary::SetMode::Add)) {
-        return fatal_error(std::string{"new AccountBlock for "} + z.first.to_hex() +
-                           " could not be added to ShardAccountBlocks");
-      }
+      acc_blocks.push_back({z.first.cbits(), std::move(csr), vm::Dictionary::SetMode::Add});
       // update account_dict
       if (acc.total_state->get_hash() != acc.orig_total_state->get_hash()) {
         // account changed
@@ -2549,35 +2548,35 @@ bool Collator::combine_account_transactions() {
           // account created
           CHECK(acc.status != block::Account::acc_nonexist);
           vm::CellBuilder cb;
+          Ref<vm::Cell> descr;
           if (!(cb.store_ref_bool(acc.total_state)             // account_descr$_ account:^Account
                 && cb.store_bits_bool(acc.last_trans_hash_)    // last_trans_hash:bits256
                 && cb.store_long_bool(acc.last_trans_lt_, 64)  // last_trans_lt:uint64
-                && account_dict->set_builder(acc.addr, cb, vm::Dictionary::SetMode::Add))) {
-            return fatal_error(std::string{"cannot add newly-created account "} + acc.addr.to_hex() +
-                               " into ShardAccounts");
+                && cb.finalize_to(descr))) {
+            return fatal_error(std::string{"cannot serialize newly-created account "} + acc.addr.to_hex());
           }
+          acc_updates.push_back({acc.addr.cbits(), vm::load_cell_slice_ref(descr), vm::Dictionary::SetMode::Add});
         } else if (acc.status == block::Account::acc_nonexist) {
           // account deleted
           if (verbosity > 2) {
             std::cerr << "deleting account " << acc.addr.to_hex() << " with empty new value ";
             block::gen::t_Account.print_ref(std::cerr, acc.total_state);
           }
-          if (account_dict->lookup_delete(acc.addr).is_null()) {
-            return fatal_error(std::string{"cannot delete account "} + acc.addr.to_hex() + " from ShardAccounts");
-          }
+          acc_updates.push_back({acc.addr.cbits(), {}});
         } else {
           // existing account modified
           if (verbosity > 4) {
             std::cerr << "modifying account " << acc.addr.to_hex() << " to ";
             block::gen::t_Account.print_ref(std::cerr, acc.total_state);
           }
+          Ref<vm::Cell> descr;
           if (!(cb.store_ref_bool(acc.total_state)             // account_descr$_ account:^Account
                 && cb.store_bits_bool(acc.last_trans_hash_)    // last_trans_hash:bits256
                 && cb.store_long_bool(acc.last_trans_lt_, 64)  // last_trans_lt:uint64
-                && account_dict->set_builder(acc.addr, cb, vm::Dictionary::SetMode::Replace))) {
-            return fatal_error(std::string{"cannot modify existing account "} + acc.addr.to_hex() +
-                               " in ShardAccounts");
+                && cb.finalize_to(descr))) {
+            return fatal_error(std::string{"cannot serialize modified account "} + acc.addr.to_hex());
           }
+          acc_updates.push_back({acc.addr.cbits(), vm::load_cell_slice_ref(descr), vm::Dictionary::SetMode::Replace});
         }
       }
     } else {
@@ -2587,6 +2586,12 @@ bool Collator::combine_account_transactions() {
       }
     }
   }
+  if (!dict.apply_batch(std::move(acc_blocks), 256)) {
+    return fatal_error("new AccountBlocks could not be added to ShardAccountBlocks");
+  }
+  if (!account_dict->apply_batch(std::move(acc_updates), 256)) {
+    return fatal_error("cannot apply account changes to ShardAccounts (an account was created twice or is missing)");
+  }
   vm::CellBuilder cb;
   if (!(cb.append_cellslice_bool(std::move(dict).extract_root()) && cb.finalize_to(shard_account_blocks_))) {
     return fatal_error("cannot serialize ShardAccountBlocks");
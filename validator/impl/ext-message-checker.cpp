@@ -0,0 +1,325 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ext-message-checker.hpp"
+#include "external-message.hpp"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "td/utils/port/thread.h"
+
+namespace ton::validator {
+
+void ExtMessageChecker::start_up() {
+  size_t workers = std::min<size_t>(std::max<size_t>(td::thread::hardware_concurrency() / 4, 1), 8);
+  for (size_t i = 0; i < workers; ++i) {
+    workers_.push_back(td::actor::create_actor<Worker>(PSTRING() << "extmsgcheck" << i));
+  }
+  alarm_timestamp() = td::Timestamp::in(rejected_ttl());
+}
+
+void ExtMessageChecker::alarm() {
+  for (auto it = rejected_.begin(); it != rejected_.end();) {
+    if (it->second.is_in_past()) {
+      it = rejected_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  alarm_timestamp() = td::Timestamp::in(rejected_ttl());
+}
+
+void ExtMessageChecker::check_message(td::Ref<ExtMessage> message, td::Promise<td::Ref<ExtMessage>> promise) {
+  auto body_hash = get_body_hash(message->root_cell());
+  pending_.push_back({std::move(message), body_hash, std::move(promise)});
+  if (waiting_state_) {
+    return;
+  }
+  // All messages received while waiting for the state are processed together
+  waiting_state_ = true;
+  td::actor::send_closure(manager_, &ValidatorManager::get_last_liteserver_state_block,
+                          [SelfId = actor_id(this)](td::Result<std::pair<td::Ref<MasterchainState>, BlockIdExt>> R) {
+                            td::actor::send_closure(SelfId, &ExtMessageChecker::got_masterchain_state, std::move(R));
+                          });
+}
+
+void ExtMessageChecker::got_masterchain_state(td::Result<std::pair<td::Ref<MasterchainState>, BlockIdExt>> R) {
+  waiting_state_ = false;
+  auto queries = std::move(pending_);
+  pending_.clear();
+  if (R.is_error()) {
+    for (auto &q : queries) {
+      q.promise.set_error(td::Status::Error(PSLICE() << "Failed to get account state"));
+    }
+    return;
+  }
+  auto state = std::move(R.ok_ref().first);
+  if (mc_state_.is_null() || mc_state_->get_block_id() != state->get_block_id()) {
+    mc_state_ = std::move(state);
+    shards_ = mc_state_->get_shards();
+    // Accounts and shard states that are still being loaded keep their waiters
+    for (auto it = accounts_.begin(); it != accounts_.end();) {
+      if (it->second.loaded) {
+        it = accounts_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (auto it = shard_states_.begin(); it != shard_states_.end();) {
+      if (it->second.state.not_null()) {
+        it = shard_states_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  std::map<AccountKey, std::vector<Query>> ready;
+  for (auto &q : queries) {
+    AccountKey key{q.message->wc(), q.message->addr()};
+    auto &account = accounts_[key];
+    if (account.loaded) {
+      ready[key].push_back(std::move(q));
+      continue;
+    }
+    account.waiting.push_back(std::move(q));
+    if (!account.requested) {
+      account.requested = true;
+      load_account(key);
+    }
+  }
+  for (auto &p : ready) {
+    run_queries(p.first, std::move(p.second));
+  }
+}
+
+void ExtMessageChecker::load_account(const AccountKey &key) {
+  if (key.first == masterchainId) {
+    account_loaded(key, td::Ref<ShardState>{mc_state_});
+    return;
+  }
+  auto prefix = extract_addr_prefix(key.first, key.second);
+  BlockIdExt block_id;
+  for (auto &shard : shards_) {
+    if (shard_contains(shard->shard(), prefix)) {
+      block_id = shard->top_block_id();
+      break;
+    }
+  }
+  if (!block_id.is_valid()) {
+    account_loaded(key,
+                   td::Status::Error(PSLICE() << "no shard for account " << key.first << ":" << key.second.to_hex()));
+    return;
+  }
+  auto &entry = shard_states_[block_id];
+  if (entry.state.not_null()) {
+    account_loaded(key, entry.state);
+    return;
+  }
+  entry.waiting.push_back(key);
+  if (!entry.requested) {
+    entry.requested = true;
+    td::actor::send_closure(manager_, &ValidatorManager::get_shard_state_from_db_short, block_id,
+                            [SelfId = actor_id(this), block_id](td::Result<td::Ref<ShardState>> R) {
+                              td::actor::send_closure(SelfId, &ExtMessageChecker::got_shard_state, block_id,
+                                                      std::move(R));
+                            });
+  }
+}
+
+void ExtMessageChecker::got_shard_state(BlockIdExt block_id, td::Result<td::Ref<ShardState>> R) {
+  auto it = shard_states_.find(block_id);
+  CHECK(it != shard_states_.end());
+  auto waiting = std::move(it->second.waiting);
+  if (R.is_error()) {
+    shard_states_.erase(it);
+  } else {
+    it->second.state = R.ok();
+  }
+  for (auto &key : waiting) {
+    if (R.is_error()) {
+      account_loaded(key, R.error().clone());
+    } else {
+      account_loaded(key, R.ok());
+    }
+  }
+}
+
+void ExtMessageChecker::account_loaded(const AccountKey &key, td::Result<td::Ref<ShardState>> R) {
+  auto it = accounts_.find(key);
+  CHECK(it != accounts_.end());
+  auto &account = it->second;
+  auto waiting = std::move(account.waiting);
+  if (R.is_error()) {
+    LOG(DEBUG) << "failed to load account " << key.first << ":" << key.second.to_hex() << " : " << R.error();
+    accounts_.erase(it);
+    for (auto &q : waiting) {
+      q.promise.set_error(td::Status::Error(PSLICE() << "Failed to get account state"));
+    }
+    return;
+  }
+  auto state = R.move_as_ok();
+  block::gen::ShardStateUnsplit::Record sstate;
+  if (!tlb::unpack_cell(state->root_cell(), sstate)) {
+    accounts_.erase(it);
+    for (auto &q : waiting) {
+      q.promise.set_error(td::Status::Error(PSLICE() << "Failed to get account state"));
+    }
+    return;
+  }
+  vm::AugmentedDictionary accounts_dict{vm::load_cell_slice_ref(sstate.accounts), 256, block::tlb::aug_ShardAccounts};
+  account.shard_account = accounts_dict.lookup(key.second);
+  account.utime = sstate.gen_utime;
+  account.lt = sstate.gen_lt;
+  account.mc_state = mc_state_;
+  account.loaded = true;
+  if (account.shard_account.not_null()) {
+    // account$1 or account_none$0: the hash of ^Account changes with every transaction
+    auto account_root = account.shard_account->prefetch_ref();
+    if (account_root.not_null()) {
+      account.state_hash = account_root->get_hash().bits();
+    }
+  }
+  run_queries(key, std::move(waiting));
+}
+
+void ExtMessageChecker::run_queries(const AccountKey &key, std::vector<Query> queries) {
+  auto it = accounts_.find(key);
+  CHECK(it != accounts_.end() && it->second.loaded);
+  auto &account = it->second;
+  bool use_cache = !account.state_hash.is_zero();
+  std::vector<Query> to_run;
+  std::vector<td::Ref<ExtMessage>> messages;
+  for (auto &q : queries) {
+    if (use_cache) {
+      auto it2 = rejected_.find({key, account.state_hash, q.body_hash});
+      if (it2 != rejected_.end() && !it2->second.is_in_past()) {
+        q.promise.set_error(td::Status::Error("External message was not accepted\nrejected recently"));
+        continue;
+      }
+    }
+    messages.push_back(q.message);
+    to_run.push_back(std::move(q));
+  }
+  if (to_run.empty()) {
+    return;
+  }
+  auto &worker = workers_[next_worker_];
+  next_worker_ = (next_worker_ + 1) % workers_.size();
+  td::actor::send_closure(worker, &Worker::run, std::move(messages), account.shard_account, account.utime, account.lt,
+                          account.mc_state,
+                          [SelfId = actor_id(this), key, state_hash = account.state_hash,
+                           queries = std::move(to_run)](td::Result<std::vector<td::Status>> R) mutable {
+                            td::actor::send_closure(SelfId, &ExtMessageChecker::got_result, key, state_hash,
+                                                    std::move(queries), std::move(R));
+                          });
+}
+
+void ExtMessageChecker::got_result(AccountKey key, td::Bits256 state_hash, std::vector<Query> queries,
+                                   td::Result<std::vector<td::Status>> R) {
+  if (R.is_error()) {
+    for (auto &q : queries) {
+      q.promise.set_error(R.error().clone());
+    }
+    return;
+  }
+  auto results = R.move_as_ok();
+  CHECK(results.size() == queries.size());
+  for (size_t i = 0; i < queries.size(); ++i) {
+    auto &q = queries[i];
+    if (results[i].is_ok()) {
+      q.promise.set_value(std::move(q.message));
+      continue;
+    }
+    // -701: the message was rejected by the account itself, which is determined by its state and the message.
+    // Other errors (e.g. config params) may go away and are not cached.
+    if (results[i].code() == -701 && !state_hash.is_zero() && rejected_.size() < max_rejected_size()) {
+      rejected_[{key, state_hash, q.body_hash}] = td::Timestamp::in(rejected_ttl());
+    }
+    q.promise.set_error(std::move(results[i]));
+  }
+}
+
+td::Bits256 ExtMessageChecker::get_body_hash(const td::Ref<vm::Cell> &msg_root) {
+  vm::CellSlice cs{vm::NoVmOrd{}, msg_root};
+  // message$_ info:CommonMsgInfo init:(Maybe (Either StateInit ^StateInit)) body:(Either X ^X)
+  bool ok = block::tlb::t_CommonMsgInfo.skip(cs);
+  if (ok) {
+    switch ((int)cs.prefetch_ulong(2)) {
+      case 2:
+        ok = cs.advance(2) && block::gen::t_StateInit.skip(cs);
+        break;
+      case 3:
+        ok = cs.advance_ext(2, 1);
+        break;
+      default:
+        ok = cs.advance(1);
+    }
+  }
+  if (ok) {
+    switch ((int)cs.fetch_ulong(1)) {
+      case 0: {
+        vm::CellBuilder cb;
+        td::Ref<vm::Cell> body;
+        if (cb.append_cellslice_bool(cs) && cb.finalize_to(body)) {
+          return body->get_hash().bits();
+        }
+        break;
+      }
+      case 1:
+        if (cs.have_refs()) {
+          return cs.prefetch_ref()->get_hash().bits();
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  return msg_root->get_hash().bits();
+}
+
+void ExtMessageChecker::Worker::run(std::vector<td::Ref<ExtMessage>> messages, td::Ref<vm::CellSlice> shard_account,
+                                    UnixTime utime, LogicalTime lt, td::Ref<MasterchainState> mc_state,
+                                    td::Promise<std::vector<td::Status>> promise) {
+  if (!config_ || config_block_id_ != mc_state->get_block_id()) {
+    auto R = block::ConfigInfo::extract_config(mc_state->root_cell(), 0xFFFF);
+    if (R.is_error()) {
+      config_ = nullptr;
+      promise.set_error(R.move_as_error_prefix("cannot extract config: "));
+      return;
+    }
+    config_ = R.move_as_ok();
+    config_block_id_ = mc_state->get_block_id();
+    config_->set_block_id_ext(config_block_id_);
+  }
+  std::vector<td::Status> res;
+  for (auto &message : messages) {
+    WorkchainId wc = message->wc();
+    bool special = wc == masterchainId && config_->is_special_smartcontract(message->addr());
+    block::Account acc;
+    if (shard_account.is_null() || !acc.unpack(td::Ref<vm::CellSlice>{true, *shard_account}, utime, special)) {
+      res.push_back(td::Status::Error("Failed to unpack account state"));
+      continue;
+    }
+    auto status = ExtMessageQ::run_message_on_account(wc, &acc, utime, lt + 1, message->root_cell(), *config_);
+    if (status.is_error()) {
+      status = td::Status::Error(status.code(), PSLICE() << "External message was not accepted\n" << status.message());
+    }
+    res.push_back(std::move(status));
+  }
+  promise.set_value(std::move(res));
+}
+
+}  // namespace ton::validator
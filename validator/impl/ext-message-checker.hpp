@@ -0,0 +1,116 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "ton/ton-types.h"
+#include "td/actor/actor.h"
+#include "interfaces/validator-manager.h"
+#include "block/mc-config.h"
+
+namespace ton::validator {
+
+/*
+ * Checks that external messages are accepted by their destination accounts (liteServer.sendMessage).
+ *
+ * Messages are grouped by account, each account is loaded once per masterchain block. Accept phase is run by a
+ * pool of worker actors. A message whose body was recently rejected by the same state of its account (exit code
+ * -701, the account did not accept it) is refused without running TVM.
+ */
+class ExtMessageChecker : public td::actor::Actor {
+ public:
+  explicit ExtMessageChecker(td::actor::ActorId<ValidatorManager> manager) : manager_(std::move(manager)) {
+  }
+
+  void start_up() override;
+  void alarm() override;
+
+  void check_message(td::Ref<ExtMessage> message, td::Promise<td::Ref<ExtMessage>> promise);
+
+  class Worker : public td::actor::Actor {
+   public:
+    void run(std::vector<td::Ref<ExtMessage>> messages, td::Ref<vm::CellSlice> shard_account, UnixTime utime,
+             LogicalTime lt, td::Ref<MasterchainState> mc_state, td::Promise<std::vector<td::Status>> promise);
+
+   private:
+    BlockIdExt config_block_id_;
+    std::unique_ptr<block::ConfigInfo> config_;
+  };
+
+ private:
+  td::actor::ActorId<ValidatorManager> manager_;
+  std::vector<td::actor::ActorOwn<Worker>> workers_;
+  size_t next_worker_ = 0;
+
+  using AccountKey = std::pair<WorkchainId, StdSmcAddress>;
+
+  struct Query {
+    td::Ref<ExtMessage> message;
+    td::Bits256 body_hash;
+    td::Promise<td::Ref<ExtMessage>> promise;
+  };
+  std::vector<Query> pending_;
+  bool waiting_state_ = false;
+
+  td::Ref<MasterchainState> mc_state_;
+  std::vector<td::Ref<McShardHash>> shards_;
+
+  struct Account {
+    bool loaded = false;
+    bool requested = false;
+    td::Ref<vm::CellSlice> shard_account;
+    UnixTime utime = 0;
+    LogicalTime lt = 0;
+    td::Ref<MasterchainState> mc_state;
+    td::Bits256 state_hash = td::Bits256::zero();
+    std::vector<Query> waiting;
+  };
+  std::map<AccountKey, Account> accounts_;
+
+  struct ShardStateEntry {
+    bool requested = false;
+    td::Ref<ShardState> state;
+    std::vector<AccountKey> waiting;
+  };
+  std::map<BlockIdExt, ShardStateEntry> shard_states_;
+
+  struct RejectedKey {
+    AccountKey account;
+    td::Bits256 state_hash;
+    td::Bits256 body_hash;
+    bool operator<(const RejectedKey &other) const {
+      return std::tie(account, state_hash, body_hash) < std::tie(other.account, other.state_hash, other.body_hash);
+    }
+  };
+  std::map<RejectedKey, td::Timestamp> rejected_;
+
+  void got_masterchain_state(td::Result<std::pair<td::Ref<MasterchainState>, BlockIdExt>> R);
+  void load_account(const AccountKey &key);
+  void got_shard_state(BlockIdExt block_id, td::Result<td::Ref<ShardState>> R);
+  void account_loaded(const AccountKey &key, td::Result<td::Ref<ShardState>> R);
+  void run_queries(const AccountKey &key, std::vector<Query> queries);
+  void got_result(AccountKey key, td::Bits256 state_hash, std::vector<Query> queries, td::Result<std::vector<td::Status>> R);
+
+  static td::Bits256 get_body_hash(const td::Ref<vm::Cell> &msg_root);
+
+  static double rejected_ttl() {
+    return 10.0;
+  }
+  static size_t max_rejected_size() {
+    return 1 << 17;
+  }
+};
+
+}  // namespace ton::validator
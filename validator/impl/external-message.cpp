@@ -86,49 +86,11 @@ td::Result<Ref<ExtMessageQ>> ExtMessageQ::create_ext_message(td::BufferSlice dat
   return Ref<ExtMessageQ>{true, std::move(data), std::move(ext_msg), dest_prefix, wc, addr};
 }
 
-void ExtMessageQ::run_message(td::Ref<ExtMessage> message, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-                              td::Promise<td::Ref<ExtMessage>> promise) {
-  auto root = message->root_cell();
-  block::gen::CommonMsgInfo::Record_ext_in_msg_info info;
-  tlb::unpack_cell_inexact(root, info);  // checked in create message
-  ton::StdSmcAddress addr = message->addr();
-  ton::WorkchainId wc = message->wc();
-
-  run_fetch_account_state(
-      wc, addr, manager,
-      [promise = std::move(promise), msg_root = root, wc, addr, message](
-          td::Result<std::tuple<td::Ref<vm::CellSlice>, UnixTime, LogicalTime, std::unique_ptr<block::ConfigInfo>>>
-              res) mutable {
-        if (res.is_error()) {
-          promise.set_error(td::Status::Error(PSLICE() << "Failed to get account state"));
-        } else {
-          auto tuple = res.move_as_ok();
-          block::Account acc;
-          auto shard_acc = std::move(std::get<0>(tuple));
-          auto utime = std::get<1>(tuple);
-          auto lt = std::get<2>(tuple);
-          auto config = std::move(std::get<3>(tuple));
-          bool special = wc == masterchainId && config->is_special_smartcontract(addr);
-          if (!acc.unpack(shard_acc, utime, special)) {
-            promise.set_error(td::Status::Error(PSLICE() << "Failed to unpack account state"));
-          } else {
-            auto status = run_message_on_account(wc, &acc, utime, lt + 1, msg_root, std::move(config));
-            if (status.is_ok()) {
-              promise.set_value(std::move(message));
-            } else {
-              promise.set_error(td::Status::Error(PSLICE() << "External message was not accepted\n"
-                                                           << status.message()));
-            }
-          }
-        }
-      });
-}
-
 td::Status ExtMessageQ::run_message_on_account(ton::WorkchainId wc,
                                                block::Account* acc,
                                                UnixTime utime, LogicalTime lt,
                                                td::Ref<vm::Cell> msg_root,
-                                               std::unique_ptr<block::ConfigInfo> config) {
+                                               const block::ConfigInfo& config) {
 
    Ref<vm::Cell> old_mparams;
    std::vector<block::StoragePrices> storage_prices_;
@@ -138,7 +100,7 @@ td::Status ExtMessageQ::run_message_on_account(ton::WorkchainId wc,
    block::ActionPhaseConfig action_phase_cfg_;
    td::RefInt256 masterchain_create_fee, basechain_create_fee;
 
-   auto fetch_res = block::FetchConfigParams::fetch_config_params(*config, &old_mparams,
+   auto fetch_res = block::FetchConfigParams::fetch_config_params(config, &old_mparams,
                                                                   &storage_prices_, &storage_phase_cfg_,
                                                                   &rand_seed_, &compute_phase_cfg_,
                                                                   &action_phase_cfg_, &masterchain_create_fee,
@@ -148,7 +110,7 @@ td::Status ExtMessageQ::run_message_on_account(ton::WorkchainId wc,
      LOG(DEBUG) << "Cannot fetch config params: " << error.message();
      return error.move_as_error_prefix("Cannot fetch config params: ");
    }
-   compute_phase_cfg_.libraries = std::make_unique<vm::Dictionary>(config->get_libraries_root(), 256);
+   compute_phase_cfg_.libraries = std::make_unique<vm::Dictionary>(config.get_libraries_root(), 256);
    compute_phase_cfg_.with_vm_log = true;
    compute_phase_cfg_.stop_on_accept_message = true;
 
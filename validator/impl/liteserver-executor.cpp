@@ -0,0 +1,224 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "liteserver-executor.hpp"
+#include "common/errorcode.h"
+
+namespace ton::validator {
+
+LiteServerExecutor::LiteServerExecutor(td::actor::ActorId<ValidatorManager> manager, td::actor::ActorId<Db> db) {
+  class Cb : public Callback {
+   public:
+    Cb(td::actor::ActorId<ValidatorManager> manager, td::actor::ActorId<Db> db)
+        : manager_(std::move(manager)), db_(std::move(db)) {
+    }
+    void get_block_handle(BlockIdExt block_id, td::Promise<ConstBlockHandle> promise) override {
+      td::actor::send_closure(manager_, &ValidatorManager::get_block_handle_for_litequery, block_id,
+                              std::move(promise));
+    }
+    void get_block_data(BlockIdExt block_id, td::Promise<td::Ref<BlockData>> promise) override {
+      td::actor::send_closure(manager_, &ValidatorManager::get_block_data_for_litequery, block_id, std::move(promise));
+    }
+    void get_block_state(BlockIdExt block_id, td::Promise<td::Ref<ShardState>> promise) override {
+      td::actor::send_closure(manager_, &ValidatorManager::get_block_state_for_litequery, block_id,
+                              std::move(promise));
+    }
+    void get_block_data_from_db(ConstBlockHandle handle, td::Promise<td::Ref<BlockData>> promise) override {
+      td::actor::send_closure(db_, &Db::get_block_data, std::move(handle), std::move(promise));
+    }
+    void get_block_state_from_db(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise) override {
+      td::actor::send_closure(db_, &Db::get_block_state, std::move(handle), std::move(promise));
+    }
+
+   private:
+    td::actor::ActorId<ValidatorManager> manager_;
+    td::actor::ActorId<Db> db_;
+  };
+  callback_ = std::make_unique<Cb>(std::move(manager), std::move(db));
+}
+
+void LiteServerExecutor::start_up() {
+  alarm_timestamp() = td::Timestamp::in(data_ttl());
+}
+
+void LiteServerExecutor::alarm() {
+  gc_cache(handles_);
+  gc_cache(blocks_);
+  gc_cache(states_);
+  alarm_timestamp() = td::Timestamp::in(data_ttl());
+}
+
+void LiteServerExecutor::update_state(td::Ref<MasterchainState> state) {
+  state_ = std::move(state);
+}
+
+void LiteServerExecutor::get_last_liteserver_state_block(
+    td::Promise<std::pair<td::Ref<MasterchainState>, BlockIdExt>> promise) {
+  if (state_.is_null()) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "not started"));
+    return;
+  }
+  promise.set_result(std::pair<td::Ref<MasterchainState>, BlockIdExt>{state_, state_->get_block_id()});
+}
+
+void LiteServerExecutor::get_block_handle_for_litequery(BlockIdExt block_id, td::Promise<ConstBlockHandle> promise) {
+  auto &entry = handles_[block_id];
+  if (entry.ready) {
+    entry.ttl = td::Timestamp::in(handle_ttl());
+    promise.set_value(ConstBlockHandle{entry.value});
+    return;
+  }
+  entry.waiting.push_back(std::move(promise));
+  if (entry.waiting.size() > 1) {
+    return;
+  }
+  callback_->get_block_handle(block_id, [SelfId = actor_id(this), block_id](td::Result<ConstBlockHandle> R) {
+    td::actor::send_closure(SelfId, &LiteServerExecutor::got_block_handle, block_id, std::move(R));
+  });
+}
+
+void LiteServerExecutor::got_block_handle(BlockIdExt block_id, td::Result<ConstBlockHandle> R) {
+  // Handles of blocks that are not applied yet are not cached: they are returned only with nonfinal queries enabled
+  bool keep = R.is_ok() && R.ok()->is_applied();
+  finish_entry(handles_, block_id, std::move(R), keep, handle_ttl(), max_handles());
+}
+
+void LiteServerExecutor::get_block_data_for_litequery(BlockIdExt block_id, td::Promise<td::Ref<BlockData>> promise) {
+  auto &entry = blocks_[block_id];
+  if (entry.ready) {
+    entry.ttl = td::Timestamp::in(data_ttl());
+    promise.set_value(td::Ref<BlockData>{entry.value});
+    return;
+  }
+  entry.waiting.push_back(std::move(promise));
+  if (entry.waiting.size() > 1) {
+    return;
+  }
+  get_block_handle_for_litequery(block_id, [SelfId = actor_id(this), block_id](td::Result<ConstBlockHandle> R) {
+    td::actor::send_closure(SelfId, &LiteServerExecutor::load_block_data, block_id, std::move(R));
+  });
+}
+
+void LiteServerExecutor::load_block_data(BlockIdExt block_id, td::Result<ConstBlockHandle> R) {
+  auto P = [SelfId = actor_id(this), block_id](td::Result<td::Ref<BlockData>> R) {
+    td::actor::send_closure(SelfId, &LiteServerExecutor::got_block_data, block_id, std::move(R));
+  };
+  if (R.is_error() || !R.ok()->received()) {
+    // Block candidates have no handles, and with nonfinal queries the handle of a block that is not applied yet may
+    // have no data in the db. Manager looks such blocks up in the candidates buffer.
+    callback_->get_block_data(block_id, std::move(P));
+    return;
+  }
+  callback_->get_block_data_from_db(R.move_as_ok(), std::move(P));
+}
+
+void LiteServerExecutor::get_block_data_from_db(ConstBlockHandle handle, td::Promise<td::Ref<BlockData>> promise) {
+  auto block_id = handle->id();
+  if (handle->is_applied() && !handles_.count(block_id) && handles_.size() < max_handles()) {
+    auto &handle_entry = handles_[block_id];
+    handle_entry.value = handle;
+    handle_entry.ready = true;
+    handle_entry.ttl = td::Timestamp::in(handle_ttl());
+  }
+  auto &entry = blocks_[block_id];
+  if (entry.ready) {
+    entry.ttl = td::Timestamp::in(data_ttl());
+    promise.set_value(td::Ref<BlockData>{entry.value});
+    return;
+  }
+  entry.waiting.push_back(std::move(promise));
+  if (entry.waiting.size() > 1) {
+    return;
+  }
+  callback_->get_block_data_from_db(std::move(handle),
+                                    [SelfId = actor_id(this), block_id](td::Result<td::Ref<BlockData>> R) {
+                                      td::actor::send_closure(SelfId, &LiteServerExecutor::got_block_data, block_id,
+                                                              std::move(R));
+                                    });
+}
+
+void LiteServerExecutor::got_block_data(BlockIdExt block_id, td::Result<td::Ref<BlockData>> R) {
+  bool keep = R.is_ok();
+  finish_entry(blocks_, block_id, std::move(R), keep, data_ttl(), max_blocks());
+}
+
+void LiteServerExecutor::get_block_state_for_litequery(BlockIdExt block_id,
+                                                       td::Promise<td::Ref<ShardState>> promise) {
+  auto &entry = states_[block_id];
+  if (entry.ready) {
+    entry.ttl = td::Timestamp::in(data_ttl());
+    promise.set_value(td::Ref<ShardState>{entry.value});
+    return;
+  }
+  entry.waiting.push_back(std::move(promise));
+  if (entry.waiting.size() > 1) {
+    return;
+  }
+  get_block_handle_for_litequery(block_id, [SelfId = actor_id(this), block_id](td::Result<ConstBlockHandle> R) {
+    td::actor::send_closure(SelfId, &LiteServerExecutor::load_block_state, block_id, std::move(R));
+  });
+}
+
+void LiteServerExecutor::load_block_state(BlockIdExt block_id, td::Result<ConstBlockHandle> R) {
+  auto P = [SelfId = actor_id(this), block_id](td::Result<td::Ref<ShardState>> R) {
+    td::actor::send_closure(SelfId, &LiteServerExecutor::got_block_state, block_id, std::move(R));
+  };
+  if (R.is_error() || !R.ok()->received_state()) {
+    callback_->get_block_state(block_id, std::move(P));
+    return;
+  }
+  callback_->get_block_state_from_db(R.move_as_ok(), std::move(P));
+}
+
+void LiteServerExecutor::got_block_state(BlockIdExt block_id, td::Result<td::Ref<ShardState>> R) {
+  bool keep = R.is_ok();
+  finish_entry(states_, block_id, std::move(R), keep, data_ttl(), max_states());
+}
+
+template <class T>
+void LiteServerExecutor::finish_entry(std::map<BlockIdExt, CacheEntry<T>> &cache, const BlockIdExt &block_id,
+                                      td::Result<T> R, bool keep, double ttl, size_t max_size) {
+  auto it = cache.find(block_id);
+  CHECK(it != cache.end());
+  auto waiting = std::move(it->second.waiting);
+  if (keep && cache.size() < max_size) {
+    it->second.value = R.ok();
+    it->second.ready = true;
+    it->second.ttl = td::Timestamp::in(ttl);
+  } else {
+    cache.erase(it);
+  }
+  for (auto &promise : waiting) {
+    if (R.is_error()) {
+      promise.set_error(R.error().clone());
+    } else {
+      promise.set_value(T{R.ok()});
+    }
+  }
+}
+
+template <class T>
+void LiteServerExecutor::gc_cache(std::map<BlockIdExt, CacheEntry<T>> &cache) {
+  for (auto it = cache.begin(); it != cache.end();) {
+    if (it->second.ready && it->second.ttl.is_in_past()) {
+      it = cache.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}  // namespace ton::validator
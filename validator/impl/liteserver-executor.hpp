@@ -0,0 +1,110 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "ton/ton-types.h"
+#include "td/actor/actor.h"
+#include "interfaces/validator-manager.h"
+#include "interfaces/db.h"
+
+#include <map>
+
+namespace ton::validator {
+
+/*
+ * Answers requests of liteserver queries for states, blocks and block handles.
+ *
+ * Manager runs several executors and assigns each lite query to one of them, so these requests are served by
+ * several threads instead of the manager actor. The latest liteserver masterchain state is pushed by the manager.
+ * Applied block handles, block data and shard states are cached; concurrent requests for the same block share one
+ * load. Blocks and states that are in the db are read from it directly. Block handles that are not cached, and
+ * blocks that are not in the db yet (nonfinal queries), are requested from the manager.
+ */
+class LiteServerExecutor : public td::actor::Actor {
+ public:
+  // Where the data that is not cached comes from
+  class Callback {
+   public:
+    virtual ~Callback() = default;
+    virtual void get_block_handle(BlockIdExt block_id, td::Promise<ConstBlockHandle> promise) = 0;
+    // Also returns block candidates, which are not in the db
+    virtual void get_block_data(BlockIdExt block_id, td::Promise<td::Ref<BlockData>> promise) = 0;
+    virtual void get_block_state(BlockIdExt block_id, td::Promise<td::Ref<ShardState>> promise) = 0;
+    virtual void get_block_data_from_db(ConstBlockHandle handle, td::Promise<td::Ref<BlockData>> promise) = 0;
+    virtual void get_block_state_from_db(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise) = 0;
+  };
+
+  explicit LiteServerExecutor(std::unique_ptr<Callback> callback) : callback_(std::move(callback)) {
+  }
+  LiteServerExecutor(td::actor::ActorId<ValidatorManager> manager, td::actor::ActorId<Db> db);
+
+  void start_up() override;
+  void alarm() override;
+
+  void update_state(td::Ref<MasterchainState> state);
+
+  void get_last_liteserver_state_block(td::Promise<std::pair<td::Ref<MasterchainState>, BlockIdExt>> promise);
+  void get_block_handle_for_litequery(BlockIdExt block_id, td::Promise<ConstBlockHandle> promise);
+  void get_block_data_for_litequery(BlockIdExt block_id, td::Promise<td::Ref<BlockData>> promise);
+  void get_block_state_for_litequery(BlockIdExt block_id, td::Promise<td::Ref<ShardState>> promise);
+  void get_block_data_from_db(ConstBlockHandle handle, td::Promise<td::Ref<BlockData>> promise);
+
+ private:
+  std::unique_ptr<Callback> callback_;
+  td::Ref<MasterchainState> state_;
+
+  template <class T>
+  struct CacheEntry {
+    T value;
+    bool ready = false;
+    td::Timestamp ttl;
+    std::vector<td::Promise<T>> waiting;
+  };
+  std::map<BlockIdExt, CacheEntry<ConstBlockHandle>> handles_;
+  std::map<BlockIdExt, CacheEntry<td::Ref<BlockData>>> blocks_;
+  std::map<BlockIdExt, CacheEntry<td::Ref<ShardState>>> states_;
+
+  void got_block_handle(BlockIdExt block_id, td::Result<ConstBlockHandle> R);
+  void load_block_data(BlockIdExt block_id, td::Result<ConstBlockHandle> R);
+  void got_block_data(BlockIdExt block_id, td::Result<td::Ref<BlockData>> R);
+  void load_block_state(BlockIdExt block_id, td::Result<ConstBlockHandle> R);
+  void got_block_state(BlockIdExt block_id, td::Result<td::Ref<ShardState>> R);
+
+  template <class T>
+  static void finish_entry(std::map<BlockIdExt, CacheEntry<T>> &cache, const BlockIdExt &block_id, td::Result<T> R,
+                           bool keep, double ttl, size_t max_size);
+  template <class T>
+  static void gc_cache(std::map<BlockIdExt, CacheEntry<T>> &cache);
+
+  static double handle_ttl() {
+    return 300.0;
+  }
+  static double data_ttl() {
+    return 30.0;
+  }
+  static size_t max_handles() {
+    return 4096;
+  }
+  static size_t max_blocks() {
+    return 256;
+  }
+  // Shard states pin large cell trees, and every executor keeps its own cache
+  static size_t max_states() {
+    return 32;
+  }
+};
+
+}  // namespace ton::validator
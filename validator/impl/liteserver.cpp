@@ -56,27 +56,40 @@ td::int32 get_tl_tag(td::Slice slice) {
 }
 
 void LiteQuery::run_query(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                          td::actor::ActorId<LiteServerCache> cache,
+                          td::actor::ActorId<LiteServerCache> cache, td::actor::ActorId<LiteServerExecutor> executor,
                           td::Promise<td::BufferSlice> promise) {
   td::actor::create_actor<LiteQuery>("litequery", std::move(data), std::move(manager), std::move(cache),
-                                     std::move(promise))
+                                     std::move(executor), std::move(promise))
       .release();
 }
 
 void LiteQuery::fetch_account_state(WorkchainId wc, StdSmcAddress  acc_addr, td::actor::ActorId<ton::validator::ValidatorManager> manager,
+                                 td::actor::ActorId<LiteServerExecutor> executor,
                                  td::Promise<std::tuple<td::Ref<vm::CellSlice>,UnixTime,LogicalTime,std::unique_ptr<block::ConfigInfo>>> promise) {
-  td::actor::create_actor<LiteQuery>("litequery", wc, acc_addr, std::move(manager), std::move(promise)).release();
+  td::actor::create_actor<LiteQuery>("litequery", wc, acc_addr, std::move(manager), std::move(executor),
+                                     std::move(promise))
+      .release();
 }
 
 LiteQuery::LiteQuery(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
-                     td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise)
-    : query_(std::move(data)), manager_(std::move(manager)), cache_(std::move(cache)), promise_(std::move(promise)) {
+                     td::actor::ActorId<LiteServerCache> cache, td::actor::ActorId<LiteServerExecutor> executor,
+                     td::Promise<td::BufferSlice> promise)
+    : query_(std::move(data))
+    , manager_(std::move(manager))
+    , cache_(std::move(cache))
+    , executor_(std::move(executor))
+    , promise_(std::move(promise)) {
   timeout_ = td::Timestamp::in(default_timeout_msec * 0.001);
 }
 
 LiteQuery::LiteQuery(WorkchainId wc, StdSmcAddress  acc_addr, td::actor::ActorId<ValidatorManager> manager,
+                     td::actor::ActorId<LiteServerExecutor> executor,
                      td::Promise<std::tuple<td::Ref<vm::CellSlice>,UnixTime,LogicalTime,std::unique_ptr<block::ConfigInfo>>> promise)
-    : manager_(std::move(manager)), acc_state_promise_(std::move(promise)), acc_workchain_(wc), acc_addr_(acc_addr) {
+    : manager_(std::move(manager))
+    , executor_(std::move(executor))
+    , acc_state_promise_(std::move(promise))
+    , acc_workchain_(wc)
+    , acc_addr_(acc_addr) {
   timeout_ = td::Timestamp::in(default_timeout_msec * 0.001);
 }
 
@@ -321,7 +334,7 @@ void LiteQuery::perform_getMasterchainInfo(int mode) {
     return;
   }
   td::actor::send_closure_later(
-      manager_, &ton::validator::ValidatorManager::get_last_liteserver_state_block,
+      executor_, &LiteServerExecutor::get_last_liteserver_state_block,
       [Self = actor_id(this), return_state = bool(acc_state_promise_), mode](td::Result<std::pair<Ref<ton::validator::MasterchainState>, BlockIdExt>> res) {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -365,7 +378,7 @@ void LiteQuery::perform_getBlock(BlockIdExt blkid) {
     fatal_error("invalid BlockIdExt");
     return;
   }
-  td::actor::send_closure(manager_, &ValidatorManager::get_block_data_for_litequery, blkid,
+  td::actor::send_closure(executor_, &LiteServerExecutor::get_block_data_for_litequery, blkid,
                           [Self = actor_id(this), blkid](td::Result<Ref<ton::validator::BlockData>> res) {
                             if (res.is_error()) {
                               td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -391,7 +404,7 @@ void LiteQuery::perform_getBlockHeader(BlockIdExt blkid, int mode) {
     fatal_error("invalid BlockIdExt");
     return;
   }
-  td::actor::send_closure(manager_, &ValidatorManager::get_block_data_for_litequery, blkid,
+  td::actor::send_closure(executor_, &LiteServerExecutor::get_block_data_for_litequery, blkid,
                           [Self = actor_id(this), blkid, mode](td::Result<Ref<ton::validator::BlockData>> res) {
                             if (res.is_error()) {
                               td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -506,7 +519,7 @@ void LiteQuery::perform_getState(BlockIdExt blkid) {
     return;
   }
   if (blkid.id.seqno) {
-    td::actor::send_closure(manager_, &ValidatorManager::get_block_state_for_litequery, blkid,
+    td::actor::send_closure(executor_, &LiteServerExecutor::get_block_state_for_litequery, blkid,
                             [Self = actor_id(this), blkid](td::Result<Ref<ShardState>> res) {
                               if (res.is_error()) {
                                 td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -574,7 +587,7 @@ void LiteQuery::perform_sendMessage(td::BufferSlice data) {
 }
 
 void LiteQuery::get_block_handle_checked(BlockIdExt blkid, td::Promise<ConstBlockHandle> promise) {
-  td::actor::send_closure(manager_, &ValidatorManager::get_block_handle_for_litequery, blkid, std::move(promise));
+  td::actor::send_closure(executor_, &LiteServerExecutor::get_block_handle_for_litequery, blkid, std::move(promise));
 }
 
 bool LiteQuery::request_mc_block_data(BlockIdExt blkid) {
@@ -587,7 +600,7 @@ bool LiteQuery::request_mc_block_data(BlockIdExt blkid) {
   base_blk_id_ = blkid;
   ++pending_;
   td::actor::send_closure_later(
-      manager_, &ValidatorManager::get_block_data_for_litequery, blkid,
+      executor_, &LiteServerExecutor::get_block_data_for_litequery, blkid,
       [Self = actor_id(this), blkid](td::Result<Ref<BlockData>> res) {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_query,
@@ -645,7 +658,7 @@ bool LiteQuery::request_mc_block_state(BlockIdExt blkid) {
   base_blk_id_ = blkid;
   ++pending_;
   td::actor::send_closure_later(
-      manager_, &ValidatorManager::get_block_state_for_litequery, blkid,
+      executor_, &LiteServerExecutor::get_block_state_for_litequery, blkid,
       [Self = actor_id(this), blkid](td::Result<Ref<ShardState>> res) {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_query,
@@ -675,7 +688,7 @@ bool LiteQuery::request_block_state(BlockIdExt blkid) {
   }
   blk_id_ = blkid;
   ++pending_;
-  td::actor::send_closure(manager_, &ValidatorManager::get_block_state_for_litequery, blkid,
+  td::actor::send_closure(executor_, &LiteServerExecutor::get_block_state_for_litequery, blkid,
                           [Self = actor_id(this), blkid](td::Result<Ref<ShardState>> res) {
                             if (res.is_error()) {
                               td::actor::send_closure(
@@ -697,7 +710,7 @@ bool LiteQuery::request_block_data(BlockIdExt blkid) {
   }
   blk_id_ = blkid;
   ++pending_;
-  td::actor::send_closure(manager_, &ValidatorManager::get_block_data_for_litequery, blkid,
+  td::actor::send_closure(executor_, &LiteServerExecutor::get_block_data_for_litequery, blkid,
                           [Self = actor_id(this), blkid](td::Result<Ref<BlockData>> res) {
                             if (res.is_error()) {
                               td::actor::send_closure(
@@ -827,7 +840,7 @@ void LiteQuery::perform_getAccountState(BlockIdExt blkid, WorkchainId workchain,
   } else {
     LOG(INFO) << "sending a get_last_liteserver_state_block query to manager";
     td::actor::send_closure_later(
-        manager_, &ton::validator::ValidatorManager::get_last_liteserver_state_block,
+        executor_, &LiteServerExecutor::get_last_liteserver_state_block,
         [Self = actor_id(this)](td::Result<std::pair<Ref<ton::validator::MasterchainState>, BlockIdExt>> res) -> void {
           if (res.is_error()) {
             td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -904,7 +917,7 @@ void LiteQuery::perform_getLibraries(std::vector<td::Bits256> library_list) {
   sort( library_list.begin(), library_list.end() );
   library_list.erase( unique( library_list.begin(), library_list.end() ), library_list.end() );
   td::actor::send_closure_later(
-      manager_, &ton::validator::ValidatorManager::get_last_liteserver_state_block,
+      executor_, &LiteServerExecutor::get_last_liteserver_state_block,
       [Self = actor_id(this), library_list](td::Result<std::pair<Ref<ton::validator::MasterchainState>, BlockIdExt>> res) -> void {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -984,7 +997,7 @@ void LiteQuery::continue_getLibrariesWithProof(std::vector<td::Bits256> library_
     return;
   }
 
-  vm::MerkleProofBuilder pb{mc_state_->root_cell()};
+  auto& pb = state_proof_builder(mc_state_->root_cell());
   block::gen::ShardStateUnsplit::Record state;
   if (!tlb::unpack_cell(pb.root(), state)) {
     fatal_error("cannot unpack header of shardchain state "s + base_blk_id_.to_str());
@@ -1207,7 +1220,7 @@ bool LiteQuery::make_state_root_proof(Ref<vm::Cell>& proof, Ref<vm::Cell> state_
 
 bool LiteQuery::make_shard_info_proof(Ref<vm::Cell>& proof, Ref<block::McShardHash>& info, ShardIdFull shard,
                                       ShardIdFull& true_shard, Ref<vm::Cell>& leaf, bool& found, bool exact) {
-  vm::MerkleProofBuilder pb{mc_state_->root_cell()};
+  auto& pb = state_proof_builder(mc_state_->root_cell());
   block::gen::ShardStateUnsplit::Record sstate;
   if (!(tlb::unpack_cell(pb.root(), sstate))) {
     return fatal_error("cannot unpack state header");
@@ -1257,8 +1270,19 @@ bool LiteQuery::make_shard_info_proof(Ref<vm::Cell>& proof, BlockIdExt& blkid, A
   return true;
 }
 
+vm::MerkleProofBuilder& LiteQuery::state_proof_builder(Ref<vm::Cell> state_root) {
+  // several proofs of the same state in one query reuse the pruned branches of the previous ones
+  if (state_pb_root_.not_null() && state_pb_root_ == state_root) {
+    state_pb_.restart();
+  } else {
+    state_pb_root_ = state_root;
+    state_pb_.init(std::move(state_root));
+  }
+  return state_pb_;
+}
+
 bool LiteQuery::make_ancestor_block_proof(Ref<vm::Cell>& proof, Ref<vm::Cell> state_root, const BlockIdExt& old_blkid) {
-  vm::MerkleProofBuilder mpb{std::move(state_root)};
+  auto& mpb = state_proof_builder(std::move(state_root));
   auto rconfig = block::ConfigInfo::extract_config(mpb.root(), block::ConfigInfo::needPrevBlocks);
   if (rconfig.is_error()) {
     return fatal_error(
@@ -1316,7 +1340,7 @@ void LiteQuery::finish_getAccountState(td::BufferSlice shard_proof) {
   if (!make_state_root_proof(proof1)) {
     return;
   }
-  vm::MerkleProofBuilder pb{state_->root_cell()};
+  auto& pb = state_proof_builder(state_->root_cell());
   block::gen::ShardStateUnsplit::Record sstate;
   if (!tlb::unpack_cell(pb.root(), sstate)) {
     fatal_error("cannot unpack state header");
@@ -1347,7 +1371,6 @@ void LiteQuery::finish_getAccountState(td::BufferSlice shard_proof) {
     return;
   }
   auto proof = vm::std_boc_serialize_multi({std::move(proof1), std::move(proof2)});
-  pb.clear();
   if (proof.is_error()) {
     fatal_error(proof.move_as_error());
     return;
@@ -1699,18 +1722,25 @@ void LiteQuery::continue_getTransactions(unsigned remaining, bool exact) {
     finish_getTransactions();
     return;
   }
+  if (use_transaction_index(remaining)) {
+    return;
+  }
+  request_getTransactions_block(remaining);
+}
+
+void LiteQuery::request_getTransactions_block(unsigned remaining) {
   ++pending_;
   LOG(DEBUG) << "sending get_block_by_lt_from_db() query to manager for " << acc_workchain_ << ":" << acc_addr_.to_hex()
              << " " << trans_lt_;
   td::actor::send_closure_later(
       manager_, &ValidatorManager::get_block_by_lt_for_litequery, ton::extract_addr_prefix(acc_workchain_, acc_addr_),
-      trans_lt_, [Self = actor_id(this), remaining, manager = manager_](td::Result<ConstBlockHandle> res) {
+      trans_lt_, [Self = actor_id(this), remaining, executor = executor_](td::Result<ConstBlockHandle> res) {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_getTransactions, res.move_as_error(), ton::BlockIdExt{});
         } else {
           auto handle = res.move_as_ok();
           LOG(DEBUG) << "requesting data for block " << handle->id().to_str();
-          td::actor::send_closure_later(manager, &ValidatorManager::get_block_data_from_db, handle,
+          td::actor::send_closure_later(executor, &LiteServerExecutor::get_block_data_from_db, handle,
                                         [Self, blkid = handle->id(), remaining](td::Result<Ref<BlockData>> res) {
                                           if (res.is_error()) {
                                             td::actor::send_closure(Self, &LiteQuery::abort_getTransactions,
@@ -1734,6 +1764,84 @@ void LiteQuery::continue_getTransactions_2(BlockIdExt blkid, Ref<BlockData> bloc
   continue_getTransactions(remaining, true);
 }
 
+// The transaction index gives blocks of the next transactions at once, so that they are loaded in parallel.
+// Returns false if the block with transaction trans_lt_ must be looked up by lt.
+bool LiteQuery::use_transaction_index(unsigned remaining) {
+  auto it = trans_index_hints_.find(trans_lt_);
+  if (it != trans_index_hints_.end()) {
+    auto it2 = trans_index_blocks_.find(it->second);
+    if (it2 == trans_index_blocks_.end() || (block_.not_null() && block_->block_id() == it->second)) {
+      return false;
+    }
+    block_ = it2->second;
+    blk_id_ = it->second;
+    continue_getTransactions(remaining, true);
+    return true;
+  }
+  if (trans_index_disabled_ || trans_index_missed_lt_ == trans_lt_) {
+    return false;
+  }
+  ++pending_;
+  td::actor::send_closure_later(
+      manager_, &ValidatorManager::get_account_transactions_for_litequery, acc_workchain_, acc_addr_, trans_lt_,
+      remaining, [Self = actor_id(this), remaining](td::Result<std::vector<AccountTransactionRef>> res) {
+        td::actor::send_closure(Self, &LiteQuery::got_transaction_index, std::move(res), remaining);
+      });
+  return true;
+}
+
+void LiteQuery::got_transaction_index(td::Result<std::vector<AccountTransactionRef>> res, unsigned remaining) {
+  --pending_;
+  if (res.is_error()) {
+    LOG(DEBUG) << "transaction index is not available: " << res.move_as_error();
+    trans_index_disabled_ = true;
+    request_getTransactions_block(remaining);
+    return;
+  }
+  auto refs = res.move_as_ok();
+  if (refs.empty() || refs[0].lt != trans_lt_) {
+    trans_index_missed_lt_ = trans_lt_;
+  }
+  std::set<BlockIdExt> blocks;
+  for (const auto& ref : refs) {
+    trans_index_hints_[ref.lt] = ref.block_id;
+    if (!trans_index_blocks_.count(ref.block_id)) {
+      blocks.insert(ref.block_id);
+    }
+  }
+  LOG(DEBUG) << "transaction index returned " << refs.size() << " transactions in " << blocks.size()
+             << " new blocks";
+  if (blocks.empty()) {
+    if (!use_transaction_index(remaining)) {
+      request_getTransactions_block(remaining);
+    }
+    return;
+  }
+  pending_ += (int)blocks.size();
+  for (const auto& blkid : blocks) {
+    td::actor::send_closure_later(executor_, &LiteServerExecutor::get_block_data_for_litequery, blkid,
+                                  [Self = actor_id(this), blkid, remaining](td::Result<Ref<BlockData>> res) {
+                                    td::actor::send_closure(Self, &LiteQuery::got_transaction_index_block, blkid,
+                                                            std::move(res), remaining);
+                                  });
+  }
+}
+
+void LiteQuery::got_transaction_index_block(BlockIdExt blkid, td::Result<Ref<BlockData>> res, unsigned remaining) {
+  --pending_;
+  if (res.is_error()) {
+    LOG(DEBUG) << "cannot load block " << blkid.to_str() << " from transaction index: " << res.move_as_error();
+  } else {
+    trans_index_blocks_[blkid] = Ref<BlockQ>(res.move_as_ok());
+  }
+  if (pending_) {
+    return;
+  }
+  if (!use_transaction_index(remaining)) {
+    request_getTransactions_block(remaining);
+  }
+}
+
 void LiteQuery::abort_getTransactions(td::Status error, ton::BlockIdExt blkid) {
   LOG(INFO) << "getTransactions() : got error " << error.message() << " from manager";
   if (roots_.empty()) {
@@ -1776,7 +1884,7 @@ void LiteQuery::perform_getShardInfo(BlockIdExt blkid, ShardIdFull shard, bool e
 }
 
 void LiteQuery::load_prevKeyBlock(ton::BlockIdExt blkid, td::Promise<std::pair<BlockIdExt, Ref<BlockQ>>> promise) {
-  td::actor::send_closure_later(manager_, &ton::validator::ValidatorManager::get_last_liteserver_state_block,
+  td::actor::send_closure_later(executor_, &LiteServerExecutor::get_last_liteserver_state_block,
                                 [Self = actor_id(this), blkid, promise = std::move(promise)](
                                     td::Result<std::pair<Ref<MasterchainState>, BlockIdExt>> res) mutable {
                                   td::actor::send_closure_later(Self, &LiteQuery::continue_loadPrevKeyBlock, blkid,
@@ -1880,7 +1988,11 @@ void LiteQuery::continue_getConfigParams(int mode, std::vector<int> param_list)
     return;
   }
 
-  vm::MerkleProofBuilder mpb{keyblk ? block : mc_state_->root_cell()};
+  vm::MerkleProofBuilder block_mpb;
+  auto& mpb = keyblk ? block_mpb : state_proof_builder(mc_state_->root_cell());
+  if (keyblk) {
+    block_mpb.init(block);
+  }
   if (keyblk) {
     auto res = block::check_block_header_proof(mpb.root(), base_blk_id_);
     if (res.is_error()) {
@@ -2053,7 +2165,7 @@ void LiteQuery::perform_lookupBlockWithProof(BlockId blkid, BlockIdExt mc_blkid,
 
   ton::AccountIdPrefixFull pfx{blkid.workchain, blkid.shard};
   auto P = td::PromiseCreator::lambda(
-    [Self = actor_id(this), mc_blkid, manager = manager_, pfx](td::Result<ConstBlockHandle> res) {
+    [Self = actor_id(this), mc_blkid, executor = executor_, pfx](td::Result<ConstBlockHandle> res) {
       if (res.is_error()) {
         td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
         return;
@@ -2068,7 +2180,7 @@ void LiteQuery::perform_lookupBlockWithProof(BlockId blkid, BlockIdExt mc_blkid,
         return;
       }
       LOG(DEBUG) << "requesting data for block " << handle->id().to_str();
-      td::actor::send_closure_later(manager, &ValidatorManager::get_block_data_from_db, handle,
+      td::actor::send_closure_later(executor, &LiteServerExecutor::get_block_data_from_db, handle,
                                     [Self, mc_ref_blkid = handle->masterchain_ref_block(), pfx](td::Result<Ref<BlockData>> res) {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -2124,12 +2236,12 @@ void LiteQuery::continue_lookupBlockWithProof_getHeaderProof(Ref<ton::validator:
       }
     }
     CHECK(prev_blkid.is_valid());
-    get_block_handle_checked(prev_blkid, [Self = actor_id(this), masterchain_ref_seqno, manager = manager_](td::Result<ConstBlockHandle> R) mutable {
+    get_block_handle_checked(prev_blkid, [Self = actor_id(this), masterchain_ref_seqno, executor = executor_](td::Result<ConstBlockHandle> R) mutable {
       if (R.is_error()) {
         td::actor::send_closure(Self, &LiteQuery::abort_query, R.move_as_error());
         return;
       }
-      td::actor::send_closure(manager, &ValidatorManager::get_block_data_from_db, R.move_as_ok(), 
+      td::actor::send_closure(executor, &LiteServerExecutor::get_block_data_from_db, R.move_as_ok(), 
                               [Self, masterchain_ref_seqno](td::Result<Ref<BlockData>> res) mutable {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -2168,12 +2280,12 @@ void LiteQuery::continue_lookupBlockWithProof_gotPrevBlockData(Ref<BlockData> pr
   if (!blk_id_.is_masterchain()) {
     ton::AccountIdPrefixFull pfx{ton::masterchainId, ton::shardIdAll};
     td::actor::send_closure_later(manager_, &ValidatorManager::get_block_by_seqno_from_db, pfx, masterchain_ref_seqno, 
-        [manager = manager_, Self = actor_id(this)](td::Result<ConstBlockHandle> R) mutable {
+        [executor = executor_, Self = actor_id(this)](td::Result<ConstBlockHandle> R) mutable {
       if (R.is_error()) {
         td::actor::send_closure(Self, &LiteQuery::abort_query, R.move_as_error());
         return;
       }
-      td::actor::send_closure(manager, &ValidatorManager::get_block_data_from_db, R.move_as_ok(), 
+      td::actor::send_closure(executor, &LiteServerExecutor::get_block_data_from_db, R.move_as_ok(), 
                               [Self](td::Result<Ref<BlockData>> res) mutable {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -2279,7 +2391,7 @@ void LiteQuery::continue_lookupBlockWithProof_getMcBlockPrev(std::vector<std::pa
   td::BufferSlice mc_state_proof_buf, client_mc_blk_proof_buf;
   
   if (base_blk_id_alt_ != base_blk_id_) {
-    vm::MerkleProofBuilder mpb{mc_state_->root_cell()};
+    auto& mpb = state_proof_builder(mc_state_->root_cell());
     auto prev_blocks_dict = block::get_prev_blocks_dict(mpb.root());
     if (!prev_blocks_dict) {
       fatal_error(td::Status::Error("cannot extract prev_blocks from mc state"));
@@ -2341,13 +2453,13 @@ void LiteQuery::perform_lookupBlock(BlockId blkid, int mode, LogicalTime lt, Uni
   LOG(INFO) << "performing a lookupBlock(" << blkid.to_str() << ", " << mode << ", " << lt << ", " << utime
             << ") query";
   auto P = td::PromiseCreator::lambda(
-      [Self = actor_id(this), manager = manager_, mode = (mode >> 4)](td::Result<ConstBlockHandle> res) {
+      [Self = actor_id(this), executor = executor_, mode = (mode >> 4)](td::Result<ConstBlockHandle> res) {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
         } else {
           auto handle = res.move_as_ok();
           LOG(DEBUG) << "requesting data for block " << handle->id().to_str();
-          td::actor::send_closure_later(manager, &ValidatorManager::get_block_data_from_db, handle,
+          td::actor::send_closure_later(executor, &LiteServerExecutor::get_block_data_from_db, handle,
                                         [Self, blkid = handle->id(), mode](td::Result<Ref<BlockData>> res) {
                                           if (res.is_error()) {
                                             td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -2712,7 +2824,7 @@ void LiteQuery::perform_getBlockProof(ton::BlockIdExt from, ton::BlockIdExt to,
                                     });
     } else {
       td::actor::send_closure_later(
-          manager_, &ton::validator::ValidatorManager::get_last_liteserver_state_block,
+          executor_, &LiteServerExecutor::get_last_liteserver_state_block,
           [Self = actor_id(this), from, to, mode](td::Result<std::pair<Ref<MasterchainState>, BlockIdExt>> res) {
             if (res.is_error()) {
               td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -2725,7 +2837,7 @@ void LiteQuery::perform_getBlockProof(ton::BlockIdExt from, ton::BlockIdExt to,
     }
   } else if (mode & 2) {
     td::actor::send_closure_later(
-        manager_, &ton::validator::ValidatorManager::get_last_liteserver_state_block,
+        executor_, &LiteServerExecutor::get_last_liteserver_state_block,
         [Self = actor_id(this), from, mode](td::Result<std::pair<Ref<MasterchainState>, BlockIdExt>> res) {
           if (res.is_error()) {
             td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -3150,7 +3262,7 @@ void LiteQuery::continue_getValidatorStats(int mode, int limit, Bits256 start_af
   if (!make_mc_state_root_proof(proof1)) {
     return;
   }
-  vm::MerkleProofBuilder mpb{mc_state_->root_cell()};
+  auto& mpb = state_proof_builder(mc_state_->root_cell());
   int count;
   bool complete = false, allow_eq = (mode & 3) != 1;
   limit = std::min(limit, 1000);
@@ -3206,7 +3318,7 @@ void LiteQuery::perform_getShardBlockProof(BlockIdExt blkid) {
     return;
   }
   blk_id_ = blkid;
-  get_block_handle_checked(blkid, [manager = manager_, Self = actor_id(this)](td::Result<ConstBlockHandle> R) {
+  get_block_handle_checked(blkid, [manager = manager_, executor = executor_, Self = actor_id(this)](td::Result<ConstBlockHandle> R) {
     if (R.is_error()) {
       td::actor::send_closure(Self, &LiteQuery::abort_query, R.move_as_error());
       return;
@@ -3219,13 +3331,13 @@ void LiteQuery::perform_getShardBlockProof(BlockIdExt blkid) {
     AccountIdPrefixFull pfx{masterchainId, shardIdAll};
     td::actor::send_closure_later(
         manager, &ValidatorManager::get_block_by_seqno_for_litequery, pfx, handle->masterchain_ref_block(),
-        [Self, manager](td::Result<ConstBlockHandle> R) {
+        [Self, executor](td::Result<ConstBlockHandle> R) {
           if (R.is_error()) {
             td::actor::send_closure(Self, &LiteQuery::abort_query, R.move_as_error());
           } else {
             ConstBlockHandle handle = R.move_as_ok();
             td::actor::send_closure_later(
-                manager, &ValidatorManager::get_block_data_from_db, handle, [Self](td::Result<Ref<BlockData>> R) {
+                executor, &LiteServerExecutor::get_block_data_from_db, handle, [Self](td::Result<Ref<BlockData>> R) {
                   if (R.is_error()) {
                     td::actor::send_closure(Self, &LiteQuery::abort_query, R.move_as_error());
                   } else {
@@ -3325,7 +3437,7 @@ void LiteQuery::continue_getShardBlockProof(Ref<BlockData> cur_block,
 void LiteQuery::perform_getOutMsgQueueSizes(td::optional<ShardIdFull> shard) {
   LOG(INFO) << "started a getOutMsgQueueSizes" << (shard ? shard.value().to_str() : "") << " liteserver query";
   td::actor::send_closure_later(
-      manager_, &ton::validator::ValidatorManager::get_last_liteserver_state_block,
+      executor_, &LiteServerExecutor::get_last_liteserver_state_block,
       [Self = actor_id(this), shard](td::Result<std::pair<Ref<MasterchainState>, BlockIdExt>> res) {
         if (res.is_error()) {
           td::actor::send_closure(Self, &LiteQuery::abort_query, res.move_as_error());
@@ -26,7 +26,9 @@
 #include "block.hpp"
 #include "shard.hpp"
 #include "proof.hpp"
+#include "liteserver-executor.hpp"
 #include "block/block-auto.h"
+#include "vm/cells/MerkleProof.h"
 #include "auto/tl/lite_api.h"
 
 namespace ton {
@@ -38,6 +40,7 @@ class LiteQuery : public td::actor::Actor {
   td::BufferSlice query_;
   td::actor::ActorId<ton::validator::ValidatorManager> manager_;
   td::actor::ActorId<LiteServerCache> cache_;
+  td::actor::ActorId<LiteServerExecutor> executor_;
   td::Timestamp timeout_;
   td::Promise<td::BufferSlice> promise_;
 
@@ -66,7 +69,13 @@ class LiteQuery : public td::actor::Actor {
   std::vector<Ref<vm::Cell>> roots_;
   std::vector<Ref<td::CntObject>> aux_objs_;
   std::vector<ton::BlockIdExt> blk_ids_;
+  std::map<LogicalTime, BlockIdExt> trans_index_hints_;
+  std::map<BlockIdExt, Ref<BlockQ>> trans_index_blocks_;
+  bool trans_index_disabled_{false};
+  LogicalTime trans_index_missed_lt_{0};
   std::unique_ptr<block::BlockProofChain> chain_;
+  vm::MerkleProofBuilder state_pb_;
+  Ref<vm::Cell> state_pb_root_;
   Ref<vm::Stack> stack_;
 
   td::BufferSlice lookup_header_proof_;
@@ -83,13 +92,17 @@ class LiteQuery : public td::actor::Actor {
     ls_capabilities = 7
   };  // version 1.1; +1 = build block proof chains, +2 = masterchainInfoExt, +4 = runSmcMethod
   LiteQuery(td::BufferSlice data, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-            td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise);
+            td::actor::ActorId<LiteServerCache> cache, td::actor::ActorId<LiteServerExecutor> executor,
+            td::Promise<td::BufferSlice> promise);
   LiteQuery(WorkchainId wc, StdSmcAddress  acc_addr, td::actor::ActorId<ton::validator::ValidatorManager> manager,
+            td::actor::ActorId<LiteServerExecutor> executor,
             td::Promise<std::tuple<td::Ref<vm::CellSlice>,UnixTime,LogicalTime,std::unique_ptr<block::ConfigInfo>>> promise);
   static void run_query(td::BufferSlice data, td::actor::ActorId<ton::validator::ValidatorManager> manager,
-                        td::actor::ActorId<LiteServerCache> cache, td::Promise<td::BufferSlice> promise);
+                        td::actor::ActorId<LiteServerCache> cache, td::actor::ActorId<LiteServerExecutor> executor,
+                        td::Promise<td::BufferSlice> promise);
 
   static void fetch_account_state(WorkchainId wc, StdSmcAddress  acc_addr, td::actor::ActorId<ton::validator::ValidatorManager> manager,
+                                  td::actor::ActorId<LiteServerExecutor> executor,
                                   td::Promise<std::tuple<td::Ref<vm::CellSlice>,UnixTime,LogicalTime,std::unique_ptr<block::ConfigInfo>>> promise);
 
  private:
@@ -134,6 +147,10 @@ class LiteQuery : public td::actor::Actor {
   void perform_getTransactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, Bits256 hash, unsigned count);
   void continue_getTransactions(unsigned remaining, bool exact);
   void continue_getTransactions_2(BlockIdExt blkid, Ref<BlockData> block, unsigned remaining);
+  void request_getTransactions_block(unsigned remaining);
+  bool use_transaction_index(unsigned remaining);
+  void got_transaction_index(td::Result<std::vector<AccountTransactionRef>> res, unsigned remaining);
+  void got_transaction_index_block(BlockIdExt blkid, td::Result<Ref<BlockData>> res, unsigned remaining);
   void abort_getTransactions(td::Status error, ton::BlockIdExt blkid);
   void finish_getTransactions();
   void perform_getShardInfo(BlockIdExt blkid, ShardIdFull shard, bool exact);
@@ -222,6 +239,7 @@ class LiteQuery : public td::actor::Actor {
   bool make_shard_info_proof(Ref<vm::Cell>& proof, Ref<block::McShardHash>& info, ShardIdFull shard, bool exact = true);
   bool make_shard_info_proof(Ref<vm::Cell>& proof, Ref<block::McShardHash>& info, AccountIdPrefixFull prefix);
   bool make_shard_info_proof(Ref<vm::Cell>& proof, BlockIdExt& blkid, AccountIdPrefixFull prefix);
+  vm::MerkleProofBuilder& state_proof_builder(Ref<vm::Cell> state_root);
   bool make_ancestor_block_proof(Ref<vm::Cell>& proof, Ref<vm::Cell> state_root, const BlockIdExt& old_blkid);
 };
 
@@ -2937,9 +2937,17 @@ bool ValidateQuery::precheck_one_account_block(td::ConstBitPtr acc_id, Ref<vm::C
     return reject_query("AccountBlock of account "s + acc_id.to_hex(256) + " appears to belong to another account " +
                         acc_blk.account_addr.to_hex());
   }
+  Ref<vm::CellSlice> old_acc, new_acc;
+  auto it = account_states_prefetched_.find(StdSmcAddress{acc_id});
+  if (it != account_states_prefetched_.end()) {
+    old_acc = it->second.first;
+    new_acc = it->second.second;
+  } else {
+    old_acc = ps_.account_dict_->lookup(acc_id, 256);
+    new_acc = ns_.account_dict_->lookup(acc_id, 256);
+  }
   block::tlb::ShardAccount::Record old_state, new_state;
-  if (!(old_state.unpack(ps_.account_dict_->lookup(acc_id, 256)) &&
-        new_state.unpack(ns_.account_dict_->lookup(acc_id, 256)))) {
+  if (!(old_state.unpack(std::move(old_acc)) && new_state.unpack(std::move(new_acc)))) {
     return reject_query("cannot extract Account from the ShardAccount of "s + acc_id.to_hex(256));
   }
   if (hash_upd.old_hash != old_state.account->get_hash().bits()) {
@@ -2999,6 +3007,34 @@ bool ValidateQuery::precheck_one_account_block(td::ConstBitPtr acc_id, Ref<vm::C
   return true;
 }
 
+/**
+ * Looks up the old and the new states of all accounts having AccountBlocks in the new block.
+ * All keys are looked up in one batch, so that the upper levels of ShardAccounts are visited only once.
+ *
+ * @returns True if the keys of ShardAccountBlocks could be enumerated, false otherwise.
+ */
+bool ValidateQuery::prefetch_account_states() {
+  std::vector<StdSmcAddress> addrs;
+  if (!account_blocks_dict_->check_for_each([&addrs](Ref<vm::CellSlice>, td::ConstBitPtr key, int key_len) {
+        CHECK(key_len == 256);
+        addrs.emplace_back(key);
+        return true;
+      })) {
+    return false;
+  }
+  std::vector<td::ConstBitPtr> keys;
+  keys.reserve(addrs.size());
+  for (const auto& addr : addrs) {
+    keys.push_back(addr.cbits());
+  }
+  auto old_states = ps_.account_dict_->lookup_batch(keys, 256);
+  auto new_states = ns_.account_dict_->lookup_batch(keys, 256);
+  for (std::size_t i = 0; i < addrs.size(); i++) {
+    account_states_prefetched_.emplace(addrs[i], std::make_pair(std::move(old_states[i]), std::move(new_states[i])));
+  }
+  return true;
+}
+
 /**
  * Pre-validates all account blocks.
  *
@@ -3008,6 +3044,9 @@ bool ValidateQuery::precheck_account_transactions() {
   LOG(INFO) << "pre-checking all AccountBlocks, and all transactions of all accounts";
   try {
     CHECK(account_blocks_dict_);
+    if (!prefetch_account_states()) {
+      return reject_query("cannot enumerate accounts of ShardAccountBlocks in the new block "s + id_.to_str());
+    }
     if (!account_blocks_dict_->validate_check_extra(
             [this](Ref<vm::CellSlice> value, Ref<vm::CellSlice> extra, td::ConstBitPtr key, int key_len) {
               CHECK(key_len == 256);
@@ -218,6 +218,8 @@ class ValidateQuery : public td::actor::Actor {
   unsigned block_create_total_{0};
 
   std::unique_ptr<vm::AugmentedDictionary> in_msg_dict_, out_msg_dict_, account_blocks_dict_;
+  // (old ShardAccount, new ShardAccount) of every account with an AccountBlock, looked up in one batch
+  std::map<StdSmcAddress, std::pair<Ref<vm::CellSlice>, Ref<vm::CellSlice>>> account_states_prefetched_;
   block::ValueFlow value_flow_;
   block::CurrencyCollection import_created_, transaction_fees_, total_burned_{0}, fees_burned_{0};
   td::RefInt256 import_fees_;
@@ -339,6 +341,7 @@ class ValidateQuery : public td::actor::Actor {
                                 unsigned& prev_trans_lt_len, ton::Bits256& acc_state_hash);
   bool precheck_one_account_block(td::ConstBitPtr acc_id, Ref<vm::CellSlice> acc_blk);
   bool precheck_account_transactions();
+  bool prefetch_account_states();
   Ref<vm::Cell> lookup_transaction(const ton::StdSmcAddress& addr, ton::LogicalTime lt) const;
   bool is_valid_transaction_ref(Ref<vm::Cell> trans_ref) const;
   bool precheck_one_message_queue_update(td::ConstBitPtr out_msg_id, Ref<vm::CellSlice> old_value,
@@ -80,6 +80,8 @@ class Db : public td::actor::Actor {
 
   virtual void apply_block(BlockHandle handle, td::Promise<td::Unit> promise) = 0;
   virtual void get_block_by_lt(AccountIdPrefixFull account, LogicalTime lt, td::Promise<ConstBlockHandle> promise) = 0;
+  virtual void get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, td::uint32 count,
+                                        td::Promise<std::vector<AccountTransactionRef>> promise) = 0;
   virtual void get_block_by_unix_time(AccountIdPrefixFull account, UnixTime ts,
                                       td::Promise<ConstBlockHandle> promise) = 0;
   virtual void get_block_by_seqno(AccountIdPrefixFull account, BlockSeqno seqno,
@@ -52,6 +52,13 @@ struct AsyncSerializerState {
   UnixTime last_written_block_ts;
 };
 
+// Entry of the account transaction index: transaction (account, lt) was found in block_id
+struct AccountTransactionRef {
+  LogicalTime lt;
+  td::Bits256 hash;
+  BlockIdExt block_id;
+};
+
 struct CollationStats {
   td::uint32 bytes, gas, lt_delta;
   int cat_bytes, cat_gas, cat_lt_delta;
@@ -198,6 +205,12 @@ class ValidatorManager : public ValidatorManagerInterface {
                                                 td::Promise<ConstBlockHandle> promise) = 0;
   virtual void get_block_candidate_for_litequery(PublicKey source, BlockIdExt block_id, FileHash collated_data_hash,
                                                  td::Promise<BlockCandidate> promise) = 0;
+  // Returns at most count transactions of the account with logical time <= lt, in decreasing order of lt
+  virtual void get_account_transactions_for_litequery(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt,
+                                                      td::uint32 count,
+                                                      td::Promise<std::vector<AccountTransactionRef>> promise) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "transaction index is disabled"));
+  }
   virtual void get_validator_groups_info_for_litequery(
       td::optional<ShardIdFull> shard,
       td::Promise<tl_object_ptr<lite_api::liteServer_nonfinal_validatorGroups>> promise) = 0;
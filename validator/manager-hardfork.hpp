@@ -149,6 +149,9 @@ class ValidatorManagerImpl : public ValidatorManager {
   void get_key_block_proof_link(BlockIdExt block_id, td::Promise<td::BufferSlice> promise) override;
 
   void new_external_message(td::BufferSlice data, int priority) override;
+  void get_ext_message_pool(td::Promise<std::shared_ptr<ExtMessagePool>> promise) override {
+    promise.set_error(td::Status::Error(ErrorCode::error, "external message pool is not available"));
+  }
   void check_external_message(td::BufferSlice data, td::Promise<td::Ref<ExtMessage>> promise) override {
     UNREACHABLE();
   }
@@ -440,6 +443,10 @@ class ValidatorManagerImpl : public ValidatorManager {
     UNREACHABLE();
  }
 
+  void prepare_actor_stats_prometheus(td::Promise<std::string> promise) override {
+    UNREACHABLE();
+  }
+
   void prepare_perf_timer_stats(td::Promise<std::vector<PerfTimerStats>> promise) override {
     UNREACHABLE();
   }
@@ -41,6 +41,7 @@
 
 #include "td/utils/Random.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/JsonBuilder.h"
 
 #include "common/delay.h"
@@ -377,46 +378,17 @@ void ValidatorManagerImpl::get_key_block_proof_link(BlockIdExt block_id, td::Pro
 }
 
 void ValidatorManagerImpl::new_external_message(td::BufferSlice data, int priority) {
-  if (!is_validator()) {
-    return;
-  }
-  if (last_masterchain_state_.is_null()) {
-    VLOG(VALIDATOR_NOTICE) << "dropping ext message: validator is not ready";
-    return;
-  }
-  if (ext_msgs_[priority].ext_messages_.size() > (size_t)max_mempool_num()) {
-    return;
-  }
-  auto R = create_ext_message(std::move(data), last_masterchain_state_->get_ext_msg_limits());
-  if (R.is_error()) {
-    VLOG(VALIDATOR_NOTICE) << "dropping bad ext message: " << R.move_as_error();
-    return;
-  }
-  add_external_message(R.move_as_ok(), priority);
+  ext_msg_pool_->new_external_message(std::move(data), priority);
 }
 
-void ValidatorManagerImpl::add_external_message(td::Ref<ExtMessage> msg, int priority) {
-  auto &msgs = ext_msgs_[priority];
-  auto message = std::make_unique<MessageExt<ExtMessage>>(msg);
-  auto id = message->ext_id();
-  auto address = message->address();
-  unsigned long per_address_limit = 256;
-  auto it = msgs.ext_addr_messages_.find(address);
-  if (it != msgs.ext_addr_messages_.end() && it->second.size() >= per_address_limit) {
-    return;
-  }
-  auto it2 = ext_messages_hashes_.find(id.hash);
-  if (it2 != ext_messages_hashes_.end()) {
-    int old_priority = it2->second.first;
-    if (old_priority >= priority) {
-      return;
-    }
-    ext_msgs_[old_priority].erase(id);
+void ValidatorManagerImpl::update_ext_message_pool() {
+  if (last_masterchain_state_.is_null()) {
+    ext_msg_pool_->set_ready(false, {});
+  } else {
+    ext_msg_pool_->set_ready(is_validator(), last_masterchain_state_->get_ext_msg_limits());
   }
-  msgs.ext_messages_.emplace(id, std::move(message));
-  msgs.ext_addr_messages_[address].emplace(id.hash, id);
-  ext_messages_hashes_[id.hash] = {priority, id};
 }
+
 void ValidatorManagerImpl::check_external_message(td::BufferSlice data, td::Promise<td::Ref<ExtMessage>> promise) {
   auto state = do_get_last_liteserver_state();
   if (state.is_null()) {
@@ -453,7 +425,7 @@ void ValidatorManagerImpl::check_external_message(td::BufferSlice data, td::Prom
     });
   };
   ++ls_stats_check_ext_messages_;
-  run_check_external_message(std::move(message), actor_id(this), std::move(promise));
+  td::actor::send_closure(ext_msg_checker_, &ExtMessageChecker::check_message, std::move(message), std::move(promise));
 }
 
 void ValidatorManagerImpl::new_ihr_message(td::BufferSlice data) {
@@ -610,6 +582,10 @@ void ValidatorManagerImpl::add_ext_server_port(td::uint16 port) {
 
 void ValidatorManagerImpl::created_ext_server(td::actor::ActorOwn<adnl::AdnlExtServer> server) {
   lite_server_ = std::move(server);
+  auto io_schedulers = opts_->get_liteserver_io_schedulers();
+  if (!io_schedulers.empty()) {
+    td::actor::send_closure(lite_server_, &adnl::AdnlExtServer::set_io_schedulers, std::move(io_schedulers));
+  }
   for (auto &id : pending_ext_ids_) {
     td::actor::send_closure(lite_server_, &adnl::AdnlExtServer::add_local_id, id);
   }
@@ -649,27 +625,40 @@ void ValidatorManagerImpl::run_ext_query(td::BufferSlice data, td::Promise<td::B
 
   auto E = fetch_tl_prefix<lite_api::liteServer_waitMasterchainSeqno>(data, true);
   if (E.is_error()) {
-    run_liteserver_query(std::move(data), actor_id(this), lite_server_cache_.get(), std::move(P));
+    run_lite_server_query(std::move(data), std::move(P));
   } else {
     auto e = E.move_as_ok();
     if (static_cast<BlockSeqno>(e->seqno_) <= min_confirmed_masterchain_seqno_) {
-      run_liteserver_query(std::move(data), actor_id(this), lite_server_cache_.get(), std::move(P));
+      run_lite_server_query(std::move(data), std::move(P));
     } else {
       auto t = e->timeout_ms_ < 10000 ? e->timeout_ms_ * 0.001 : 10.0;
-      auto Q =
-          td::PromiseCreator::lambda([data = std::move(data), SelfId = actor_id(this), cache = lite_server_cache_.get(),
-                                      promise = std::move(P)](td::Result<td::Unit> R) mutable {
+      auto Q = td::PromiseCreator::lambda(
+          [data = std::move(data), SelfId = actor_id(this), promise = std::move(P)](td::Result<td::Unit> R) mutable {
             if (R.is_error()) {
               promise.set_error(R.move_as_error());
               return;
             }
-            run_liteserver_query(std::move(data), SelfId, cache, std::move(promise));
+            td::actor::send_closure(SelfId, &ValidatorManagerImpl::run_lite_server_query, std::move(data),
+                                    std::move(promise));
           });
       wait_shard_client_state(e->seqno_, td::Timestamp::in(t), std::move(Q));
     }
   }
 }
 
+void ValidatorManagerImpl::run_lite_server_query(td::BufferSlice data, td::Promise<td::BufferSlice> promise) {
+  auto state = do_get_last_liteserver_state();
+  if (state.not_null() && state != lite_server_executors_state_) {
+    lite_server_executors_state_ = state;
+    for (auto &executor : lite_server_executors_) {
+      td::actor::send_closure(executor, &LiteServerExecutor::update_state, state);
+    }
+  }
+  auto &executor = lite_server_executors_[next_lite_server_executor_];
+  next_lite_server_executor_ = (next_lite_server_executor_ + 1) % lite_server_executors_.size();
+  run_liteserver_query(std::move(data), actor_id(this), lite_server_cache_.get(), executor.get(), std::move(promise));
+}
+
 void ValidatorManagerImpl::wait_block_state(BlockHandle handle, td::uint32 priority, td::Timestamp timeout,
                                             td::Promise<td::Ref<ShardState>> promise) {
   auto it0 = block_state_cache_.find(handle->id());
@@ -872,41 +861,11 @@ void ValidatorManagerImpl::wait_block_message_queue_short(BlockIdExt block_id, t
 void ValidatorManagerImpl::get_external_messages(
     ShardIdFull shard, td::Promise<std::vector<std::pair<td::Ref<ExtMessage>, int>>> promise) {
   td::Timer t;
-  size_t processed = 0, deleted = 0;
-  std::vector<std::pair<td::Ref<ExtMessage>, int>> res;
-  MessageId<ExtMessage> left{AccountIdPrefixFull{shard.workchain, shard.shard & (shard.shard - 1)}, Bits256::zero()};
-  size_t total_msgs = 0;
-  td::Random::Fast rnd;
-  for (auto iter = ext_msgs_.rbegin(); iter != ext_msgs_.rend(); ++iter) {
-    std::vector<std::pair<td::Ref<ExtMessage>, int>> cur_res;
-    int priority = iter->first;
-    auto &msgs = iter->second;
-    auto it = msgs.ext_messages_.lower_bound(left);
-    while (it != msgs.ext_messages_.end()) {
-      auto s = it->first;
-      if (!shard_contains(shard, s.dst)) {
-        break;
-      }
-      ++processed;
-      if (it->second->expired()) {
-        msgs.ext_addr_messages_[it->second->address()].erase(it->first.hash);
-        ext_messages_hashes_.erase(it->first.hash);
-        it = msgs.ext_messages_.erase(it);
-        ++deleted;
-        continue;
-      }
-      if (it->second->is_active()) {
-        cur_res.emplace_back(it->second->message(), priority);
-      }
-      it++;
-    }
-    td::random_shuffle(td::as_mutable_span(cur_res), rnd);
-    res.insert(res.end(), cur_res.begin(), cur_res.end());
-    total_msgs += msgs.ext_messages_.size();
-  }
+  auto res = ext_msg_pool_->get_external_messages(shard);
+  auto stats = ext_msg_pool_->get_stats();
   LOG(WARNING) << "get_external_messages to shard " << shard.to_str() << " : time=" << t.elapsed()
-               << " result_size=" << res.size() << " processed=" << processed << " expired=" << deleted
-               << " total_size=" << total_msgs;
+               << " result_size=" << res.size() << " total_size=" << stats.size << " expired=" << stats.expired
+               << " dropped_full=" << stats.dropped_full << " dropped_per_address=" << stats.dropped_per_address;
   promise.set_value(std::move(res));
 }
 
@@ -943,31 +902,7 @@ void ValidatorManagerImpl::get_shard_blocks(BlockIdExt masterchain_block_id,
 
 void ValidatorManagerImpl::complete_external_messages(std::vector<ExtMessage::Hash> to_delay,
                                                       std::vector<ExtMessage::Hash> to_delete) {
-  for (auto &hash : to_delete) {
-    auto it = ext_messages_hashes_.find(hash);
-    if (it != ext_messages_hashes_.end()) {
-      int priority = it->second.first;
-      auto msg_id = it->second.second;
-      ext_msgs_[priority].erase(msg_id);
-      ext_messages_hashes_.erase(it);
-    }
-  }
-  unsigned long soft_mempool_limit = 1024;
-  for (auto &hash : to_delay) {
-    auto it = ext_messages_hashes_.find(hash);
-    if (it != ext_messages_hashes_.end()) {
-      int priority = it->second.first;
-      auto msg_id = it->second.second;
-      auto &msgs = ext_msgs_[priority];
-      auto it2 = msgs.ext_messages_.find(msg_id);
-      if ((msgs.ext_messages_.size() < soft_mempool_limit) && it2->second->can_postpone()) {
-        it2->second->postpone();
-      } else {
-        msgs.erase(msg_id);
-        ext_messages_hashes_.erase(it);
-      }
-    }
-  }
+  ext_msg_pool_->complete_external_messages(std::move(to_delay), std::move(to_delete));
 }
 
 void ValidatorManagerImpl::complete_ihr_messages(std::vector<IhrMessage::Hash> to_delay,
@@ -1599,7 +1534,7 @@ void ValidatorManagerImpl::send_get_next_key_blocks_request(BlockIdExt block_id,
 
 void ValidatorManagerImpl::send_external_message(td::Ref<ExtMessage> message) {
   callback_->send_ext_message(message->shard(), message->serialize());
-  add_external_message(std::move(message), 0);
+  ext_msg_pool_->add_external_message(std::move(message), 0);
 }
 
 void ValidatorManagerImpl::send_ihr_message(td::Ref<IhrMessage> message) {
@@ -1628,9 +1563,16 @@ void ValidatorManagerImpl::start_up() {
   db_ = create_db_actor(actor_id(this), db_root_, opts_);
   actor_stats_ = td::actor::create_actor<td::actor::ActorStats>("actor_stats");
   lite_server_cache_ = create_liteserver_cache_actor(actor_id(this), db_root_);
+  size_t lite_server_executors = std::min<size_t>(std::max<size_t>(td::thread::hardware_concurrency() / 4, 1), 8);
+  for (size_t i = 0; i < lite_server_executors; ++i) {
+    lite_server_executors_.push_back(
+        td::actor::create_actor<LiteServerExecutor>(PSTRING() << "lsexecutor" << i, actor_id(this), db_.get()));
+  }
   token_manager_ = td::actor::create_actor<TokenManager>("tokenmanager");
+  ext_msg_checker_ = td::actor::create_actor<ExtMessageChecker>("extmsgchecker", actor_id(this));
   td::mkdir(db_root_ + "/tmp/").ensure();
   td::mkdir(db_root_ + "/catchains/").ensure();
+  ext_msg_pool_ = std::make_shared<ExtMessagePoolImpl>((size_t)max_mempool_num());
 
   auto Q =
       td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::actor::ActorOwn<adnl::AdnlExtServer>> R) {
@@ -1934,6 +1876,7 @@ void ValidatorManagerImpl::new_masterchain_block() {
 
   update_shards();
   update_shard_blocks();
+  update_ext_message_pool();
 
   if (!shard_client_.empty()) {
     td::actor::send_closure(shard_client_, &ShardClient::new_masterchain_block_notification,
@@ -2770,6 +2713,10 @@ void ValidatorManagerImpl::prepare_actor_stats(td::Promise<std::string> promise)
   send_closure(actor_stats_, &td::actor::ActorStats::prepare_stats, std::move(promise));
 }
 
+void ValidatorManagerImpl::prepare_actor_stats_prometheus(td::Promise<std::string> promise) {
+  send_closure(actor_stats_, &td::actor::ActorStats::prepare_prometheus_stats, std::move(promise));
+}
+
 void ValidatorManagerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
   auto merger = StatsMerger::create(std::move(promise));
 
@@ -2788,6 +2735,16 @@ void ValidatorManagerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::
   td::NamedThreadSafeCounter::get_default().for_each([&](auto key, auto value) {
     vec.emplace_back("counter." + key, PSTRING() << value);
   });
+  auto mempool_stats = ext_msg_pool_->get_stats();
+  vec.emplace_back("mempool.size", td::to_string(mempool_stats.size));
+  vec.emplace_back("mempool.added", td::to_string(mempool_stats.added));
+  vec.emplace_back("mempool.duplicate", td::to_string(mempool_stats.duplicate));
+  vec.emplace_back("mempool.droppedbad", td::to_string(mempool_stats.dropped_bad));
+  vec.emplace_back("mempool.droppednotready", td::to_string(mempool_stats.dropped_not_ready));
+  vec.emplace_back("mempool.droppedfull", td::to_string(mempool_stats.dropped_full));
+  vec.emplace_back("mempool.droppedperaddress", td::to_string(mempool_stats.dropped_per_address));
+  vec.emplace_back("mempool.expired", td::to_string(mempool_stats.expired));
+  vec.emplace_back("mempool.completed", td::to_string(mempool_stats.completed));
 
   if (!shard_client_.empty()) {
     auto P = td::PromiseCreator::lambda([promise = merger.make_promise("")](td::Result<BlockSeqno> R) mutable {
@@ -2904,7 +2861,9 @@ void ValidatorManagerImpl::log_validator_session_stats(BlockIdExt block_id,
   file << s << "\n";
   file.close();
 
-  LOG(INFO) << "Writing validator session stats for " << block_id.id.to_str();
+  LOG(INFO) << "Writing validator session stats for " << block_id.id.to_str()
+            << " (state memory: " << stats.persistent_memory_size << " bytes, "
+            << stats.state_compactions << " compactions)";
 }
 
 void ValidatorManagerImpl::log_new_validator_group_stats(validatorsession::NewValidatorGroupStats stats) {
@@ -3155,6 +3114,16 @@ void ValidatorManagerImpl::get_block_candidate_for_litequery(PublicKey source, B
   get_block_candidate_from_db(source, block_id, collated_data_hash, std::move(promise));
 }
 
+void ValidatorManagerImpl::get_account_transactions_for_litequery(
+    WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, td::uint32 count,
+    td::Promise<std::vector<AccountTransactionRef>> promise) {
+  if (!opts_->get_transaction_index_enabled()) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "transaction index is disabled"));
+    return;
+  }
+  td::actor::send_closure(db_, &Db::get_account_transactions, workchain, addr, lt, count, std::move(promise));
+}
+
 void ValidatorManagerImpl::get_validator_groups_info_for_litequery(
     td::optional<ShardIdFull> shard,
     td::Promise<tl_object_ptr<lite_api::liteServer_nonfinal_validatorGroups>> promise) {
@@ -3228,6 +3197,7 @@ void ValidatorManagerImpl::update_options(td::Ref<ValidatorManagerOptions> opts)
     td::actor::send_closure(group.second.actor, &ValidatorGroup::update_options, opts);
   }
   opts_ = std::move(opts);
+  ext_msg_pool_->set_max_mempool_num((size_t)max_mempool_num());
 }
 
 td::actor::ActorOwn<ValidatorManagerInterface> ValidatorManagerFactory::create(
@@ -35,6 +35,9 @@
 #include "token-manager.h"
 #include "queue-size-counter.hpp"
 #include "impl/candidates-buffer.hpp"
+#include "impl/ext-message-checker.hpp"
+#include "impl/liteserver-executor.hpp"
+#include "ext-message-pool.hpp"
 
 #include <map>
 #include <set>
@@ -50,75 +53,6 @@ class WaitZeroState;
 class WaitShardState;
 class WaitBlockData;
 
-template <class MType>
-struct MessageId {
-  AccountIdPrefixFull dst;
-  typename MType::Hash hash;
-
-  bool operator<(const MessageId &msg) const {
-    if (dst < msg.dst) {
-      return true;
-    }
-    if (msg.dst < dst) {
-      return false;
-    }
-    return hash < msg.hash;
-  }
-};
-
-template <class MType>
-class MessageExt {
- public:
-  auto shard() const {
-    return message_->shard();
-  }
-  auto ext_id() const {
-    auto shard = message_->shard();
-    return MessageId<MType>{shard, message_->hash()};
-  }
-  auto message() const {
-    return message_;
-  }
-  auto hash() const {
-    return message_->hash();
-  }
-  auto address() const {
-    return std::make_pair(message_->wc(), message_->addr());
-  }
-  bool is_active() {
-    if (!active_) {
-      if (reactivate_at_.is_in_past()) {
-        active_ = true;
-        generation_++;
-      }
-    }
-    return active_;
-  }
-  bool can_postpone() const {
-    return generation_ <= 2;
-  }
-  void postpone() {
-    if (!active_) {
-      return;
-    }
-    active_ = false;
-    reactivate_at_ = td::Timestamp::in(generation_ * 5.0);
-  }
-  bool expired() const {
-    return delete_at_.is_in_past();
-  }
-  MessageExt(td::Ref<MType> msg) : message_(std::move(msg)) {
-    delete_at_ = td::Timestamp::in(600);
-  }
-
- private:
-  td::Ref<MType> message_;
-  td::uint32 generation_ = 0;
-  bool active_ = true;
-  td::Timestamp reactivate_at_;
-  td::Timestamp delete_at_;
-};
-
 class BlockHandleLru : public td::ListNode {
  public:
   BlockHandle handle() const {
@@ -230,19 +164,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   std::map<BlockIdExt, ReceivedBlock> cached_block_candidates_;
   std::list<BlockIdExt> cached_block_candidates_lru_;
 
-  struct ExtMessages {
-    std::map<MessageId<ExtMessage>, std::unique_ptr<MessageExt<ExtMessage>>> ext_messages_;
-    std::map<std::pair<ton::WorkchainId, ton::StdSmcAddress>, std::map<ExtMessage::Hash, MessageId<ExtMessage>>>
-        ext_addr_messages_;
-    void erase(const MessageId<ExtMessage>& id) {
-      auto it = ext_messages_.find(id);
-      CHECK(it != ext_messages_.end());
-      ext_addr_messages_[it->second->address()].erase(id.hash);
-      ext_messages_.erase(it);
-    }
-  };
-  std::map<int, ExtMessages> ext_msgs_;  // priority -> messages
-  std::map<ExtMessage::Hash, std::pair<int, MessageId<ExtMessage>>> ext_messages_hashes_;  // hash -> priority
+  std::shared_ptr<ExtMessagePoolImpl> ext_msg_pool_;
   td::Timestamp cleanup_mempool_at_;
   // IHR ?
   std::map<MessageId<IhrMessage>, std::unique_ptr<MessageExt<IhrMessage>>> ihr_messages_;
@@ -335,18 +257,22 @@ class ValidatorManagerImpl : public ValidatorManager {
 
   void add_permanent_key(PublicKeyHash key, td::Promise<td::Unit> promise) override {
     permanent_keys_.insert(key);
+    update_ext_message_pool();
     promise.set_value(td::Unit());
   }
   void add_temp_key(PublicKeyHash key, td::Promise<td::Unit> promise) override {
     temp_keys_.insert(key);
+    update_ext_message_pool();
     promise.set_value(td::Unit());
   }
   void del_permanent_key(PublicKeyHash key, td::Promise<td::Unit> promise) override {
     permanent_keys_.erase(key);
+    update_ext_message_pool();
     promise.set_value(td::Unit());
   }
   void del_temp_key(PublicKeyHash key, td::Promise<td::Unit> promise) override {
     temp_keys_.erase(key);
+    update_ext_message_pool();
     promise.set_value(td::Unit());
   }
 
@@ -382,7 +308,10 @@ class ValidatorManagerImpl : public ValidatorManager {
   //void get_block_description(BlockIdExt block_id, td::Promise<BlockDescription> promise) override;
 
   void new_external_message(td::BufferSlice data, int priority) override;
-  void add_external_message(td::Ref<ExtMessage> message, int priority);
+  void get_ext_message_pool(td::Promise<std::shared_ptr<ExtMessagePool>> promise) override {
+    promise.set_value(ext_msg_pool_);
+  }
+  void update_ext_message_pool();
   void check_external_message(td::BufferSlice data, td::Promise<td::Ref<ExtMessage>> promise) override;
 
   void new_ihr_message(td::BufferSlice data) override;
@@ -586,6 +515,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) override;
 
   void prepare_actor_stats(td::Promise<std::string> promise) override;
+  void prepare_actor_stats_prometheus(td::Promise<std::string> promise) override;
 
   void prepare_perf_timer_stats(td::Promise<std::vector<PerfTimerStats>> promise) override;
   void add_perf_timer_stat(std::string name, double duration) override;
@@ -628,6 +558,9 @@ class ValidatorManagerImpl : public ValidatorManager {
                                                 td::Promise<ConstBlockHandle> promise);
   void get_block_candidate_for_litequery(PublicKey source, BlockIdExt block_id, FileHash collated_data_hash,
                                          td::Promise<BlockCandidate> promise) override;
+  void get_account_transactions_for_litequery(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt,
+                                              td::uint32 count,
+                                              td::Promise<std::vector<AccountTransactionRef>> promise) override;
   void get_validator_groups_info_for_litequery(
       td::optional<ShardIdFull> shard,
       td::Promise<tl_object_ptr<lite_api::liteServer_nonfinal_validatorGroups>> promise) override;
@@ -657,10 +590,14 @@ class ValidatorManagerImpl : public ValidatorManager {
  private:
   td::actor::ActorOwn<adnl::AdnlExtServer> lite_server_;
   td::actor::ActorOwn<LiteServerCache> lite_server_cache_;
+  std::vector<td::actor::ActorOwn<LiteServerExecutor>> lite_server_executors_;
+  size_t next_lite_server_executor_ = 0;
+  td::Ref<MasterchainState> lite_server_executors_state_;
   std::vector<td::uint16> pending_ext_ports_;
   std::vector<adnl::AdnlNodeIdShort> pending_ext_ids_;
 
   void created_ext_server(td::actor::ActorOwn<adnl::AdnlExtServer> lite_server);
+  void run_lite_server_query(td::BufferSlice data, td::Promise<td::BufferSlice> promise);
 
  private:
   td::actor::ActorOwn<ShardClient> shard_client_;
@@ -717,6 +654,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   td::uint32 ls_stats_check_ext_messages_{0};
 
   td::actor::ActorOwn<CandidatesBuffer> candidates_buffer_;
+  td::actor::ActorOwn<ExtMessageChecker> ext_msg_checker_;
 
   struct RecordedBlockStats {
     double collator_work_time_ = -1.0;
@@ -156,6 +156,12 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   bool get_fast_state_serializer_enabled() const override {
     return fast_state_serializer_enabled_;
   }
+  bool get_transaction_index_enabled() const override {
+    return transaction_index_enabled_;
+  }
+  std::vector<td::actor::SchedulerId> get_liteserver_io_schedulers() const override {
+    return liteserver_io_schedulers_;
+  }
 
   void set_zero_block_id(BlockIdExt block_id) override {
     zero_block_id_ = block_id;
@@ -251,6 +257,12 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_fast_state_serializer_enabled(bool value) override {
     fast_state_serializer_enabled_ = value;
   }
+  void set_transaction_index_enabled(bool value) override {
+    transaction_index_enabled_ = value;
+  }
+  void set_liteserver_io_schedulers(std::vector<td::actor::SchedulerId> value) override {
+    liteserver_io_schedulers_ = std::move(value);
+  }
 
   ValidatorManagerOptionsImpl *make_copy() const override {
     return new ValidatorManagerOptionsImpl(*this);
@@ -306,6 +318,8 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   bool state_serializer_enabled_ = true;
   td::Ref<CollatorOptions> collator_options_{true};
   bool fast_state_serializer_enabled_ = false;
+  bool transaction_index_enabled_ = false;
+  std::vector<td::actor::SchedulerId> liteserver_io_schedulers_;
 };
 
 }  // namespace validator
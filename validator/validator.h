@@ -46,6 +46,13 @@ class DownloadToken {
   virtual ~DownloadToken() = default;
 };
 
+class ExtMessagePool {
+ public:
+  virtual ~ExtMessagePool() = default;
+  // Can be called from any thread
+  virtual void new_external_message(td::BufferSlice data, int priority) = 0;
+};
+
 struct PerfTimerStats {
   std::string name;
   std::deque<std::pair<double, double>> stats; // <Time::now(), duration>
@@ -115,6 +122,8 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual bool get_state_serializer_enabled() const = 0;
   virtual td::Ref<CollatorOptions> get_collator_options() const = 0;
   virtual bool get_fast_state_serializer_enabled() const = 0;
+  virtual bool get_transaction_index_enabled() const = 0;
+  virtual std::vector<td::actor::SchedulerId> get_liteserver_io_schedulers() const = 0;
 
   virtual void set_zero_block_id(BlockIdExt block_id) = 0;
   virtual void set_init_block_id(BlockIdExt block_id) = 0;
@@ -148,6 +157,8 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual void set_state_serializer_enabled(bool value) = 0;
   virtual void set_collator_options(td::Ref<CollatorOptions> value) = 0;
   virtual void set_fast_state_serializer_enabled(bool value) = 0;
+  virtual void set_transaction_index_enabled(bool value) = 0;
+  virtual void set_liteserver_io_schedulers(std::vector<td::actor::SchedulerId> value) = 0;
 
   static td::Ref<ValidatorManagerOptions> create(
       BlockIdExt zero_block_id, BlockIdExt init_block_id,
@@ -241,6 +252,7 @@ class ValidatorManagerInterface : public td::actor::Actor {
   virtual void write_handle(BlockHandle handle, td::Promise<td::Unit> promise) = 0;
 
   virtual void new_external_message(td::BufferSlice data, int priority) = 0;
+  virtual void get_ext_message_pool(td::Promise<std::shared_ptr<ExtMessagePool>> promise) = 0;
   virtual void check_external_message(td::BufferSlice data, td::Promise<td::Ref<ExtMessage>> promise) = 0;
   virtual void new_ihr_message(td::BufferSlice data) = 0;
   virtual void new_shard_block(BlockIdExt block_id, CatchainSeqno cc_seqno, td::BufferSlice data) = 0;
@@ -278,6 +290,7 @@ class ValidatorManagerInterface : public td::actor::Actor {
   virtual void run_ext_query(td::BufferSlice data, td::Promise<td::BufferSlice> promise) = 0;
   virtual void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) = 0;
   virtual void prepare_actor_stats(td::Promise<std::string> promise) = 0;
+  virtual void prepare_actor_stats_prometheus(td::Promise<std::string> promise) = 0;
 
   virtual void prepare_perf_timer_stats(td::Promise<std::vector<PerfTimerStats>> promise) = 0;
   virtual void add_perf_timer_stat(std::string name, double duration) = 0;